@@ -0,0 +1,112 @@
+// Per-tick transient allocations: event lists built in a FrameArena versus
+// fresh std::vectors every tick, and what recording events costs sim_step.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "core/arena.h"
+#include "core/rng.h"
+#include "sim/game_sim.h"
+#include "sim/tick_events.h"
+#include "tower/level_text.h"
+
+using namespace toppler;
+
+#ifndef TT_SOURCE_DIR
+#define TT_SOURCE_DIR "."
+#endif
+
+namespace {
+
+// A busy tick: a burst of contacts, a few popups and a crumbling row.
+constexpr int kContacts = 24;
+constexpr int kScores = 6;
+constexpr int kBricks = 4;
+
+InputMask bot_input(uint32_t& rng) {
+    uint32_t r = rng_next(rng);
+    InputMask m = (r & 7) < 5 ? kInputRight : kInputLeft;
+    if ((r >> 3) % 7 == 0) m |= kInputJump;
+    if ((r >> 8) % 3 == 0) m |= kInputFire;
+    return m;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bench::Report report("arena_bench", argc, argv);
+
+    report.add(bench::measure("tick lists, std::vector per tick", [](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            std::vector<Contact> contacts;
+            std::vector<ScoreEvent> scores;
+            std::vector<BrickEvent> bricks;
+            for (int k = 0; k < kContacts; ++k) contacts.push_back(Contact{ContactKind::ShotEnemy, 0, 1.0f, 2.0f});
+            for (int k = 0; k < kScores; ++k) scores.push_back(ScoreEvent{1.0f, 2.0f, 100});
+            for (int k = 0; k < kBricks; ++k) bricks.push_back(BrickEvent{3, 4, Tile::Crumble});
+            bench::do_not_optimize(contacts.data());
+            bench::do_not_optimize(scores.data());
+            bench::do_not_optimize(bricks.data());
+        }
+    }));
+    FrameArena arena;
+    TickEvents events;
+    report.add(bench::measure("tick lists, FrameArena", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            arena.reset();
+            events.reset(arena);
+            for (int k = 0; k < kContacts; ++k) {
+                events.contacts.push_back(Contact{ContactKind::ShotEnemy, 0, 1.0f, 2.0f});
+            }
+            for (int k = 0; k < kScores; ++k) events.scores.push_back(ScoreEvent{1.0f, 2.0f, 100});
+            for (int k = 0; k < kBricks; ++k) events.bricks.push_back(BrickEvent{3, 4, Tile::Crumble});
+            bench::do_not_optimize(events.contacts.begin());
+        }
+    }));
+    report.line("arena: capacity %zu bytes, high water %zu, overflows %llu", arena.capacity(), arena.high_water(),
+                static_cast<unsigned long long>(arena.overflows()));
+
+    // Recording events must not change the simulation.
+    LevelData data = load_level_text(std::string(TT_SOURCE_DIR) + "/levels/campaign/04_eye_spire.tower");
+    Level level = data.view();
+    SimState plain, recorded;
+    sim_init(level, 3, plain);
+    sim_init(level, 3, recorded);
+    uint32_t rng = rng_seed(9);
+    size_t total_events = 0;
+    for (int t = 0; t < 3600; ++t) {
+        InputMask m = bot_input(rng);
+        arena.reset();
+        events.reset(arena);
+        sim_step(level, plain, m);
+        sim_step(level, recorded, m, &events);
+        total_events += events.contacts.size() + events.scores.size() + events.bricks.size();
+    }
+    report.line("events recorded over 3600 ticks: %zu, state identical: %s", total_events,
+                std::memcmp(&plain, &recorded, sizeof plain) == 0 ? "yes" : "NO");
+
+    auto run = [&](bool with_events) {
+        return [&, with_events](uint64_t iters) {
+            SimState s;
+            sim_init(level, 3, s);
+            uint32_t r = rng_seed(9);
+            for (uint64_t i = 0; i < iters; ++i) {
+                if ((i & 4095) == 0) sim_init(level, 3, s);
+                InputMask m = bot_input(r);
+                if (with_events) {
+                    arena.reset();
+                    events.reset(arena);
+                    sim_step(level, s, m, &events);
+                } else {
+                    sim_step(level, s, m);
+                }
+            }
+            bench::do_not_optimize(s.session.score);
+        };
+    };
+    report.add(bench::measure("sim_step", run(false)));
+    report.add(bench::measure("sim_step + events in FrameArena", run(true)));
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Audio path costs: the command ring, one mixed block with the voice pool
+// empty and full, and a live run of the audio thread while the game thread
+// fires effects, allocates and takes locks, which must not cost the mixer
+// a single deadline.
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "audio/audio_thread.h"
+#include "audio/mixer.h"
+#include "audio/sound_bank.h"
+#include "bench.h"
+#include "core/rng.h"
+#include "core/spsc_ring.h"
+
+using namespace toppler;
+
+namespace {
+
+constexpr size_t kBlockFrames = 256;  // 5.8 ms at 44.1 kHz
+
+SoundId random_effect(uint32_t& rng) {
+    return static_cast<SoundId>(rng_below(rng, static_cast<uint32_t>(SoundId::TowerTheme)));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bench::Report report("audio_bench", argc, argv);
+    SoundBank bank;
+    report.line("sound bank: %zu KiB of samples, mixer %zu bytes", bank.size_bytes() / 1024, sizeof(Mixer));
+
+    SpscRing<AudioCommand, Mixer::kCommandCapacity> ring;
+    report.add(bench::measure("ring push+pop, one thread", [&](uint64_t iters) {
+        AudioCommand cmd{AudioCommand::Op::Play, SoundId::Shot, 0, 0, 1.0f, 0.0f, 1};
+        for (uint64_t i = 0; i < iters; ++i) {
+            cmd.voice = static_cast<VoiceId>(i);
+            ring.push(cmd);
+            ring.pop(cmd);
+        }
+        bench::do_not_optimize(cmd);
+    }));
+
+    std::vector<int16_t> block(kBlockFrames * 2);
+    {
+        Mixer mixer(bank);
+        report.add(bench::measure("mix block, silent", [&](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) mixer.mix(block.data(), kBlockFrames);
+            bench::do_not_optimize(block.data());
+        }));
+    }
+    {
+        // Every voice busy with a looping effect, plus music.
+        Mixer mixer(bank);
+        uint32_t rng = 7;
+        for (int v = 0; v < Mixer::kMaxVoices; ++v) mixer.play(random_effect(rng), 0.5f, -1.0f + v / 16.0f, true);
+        mixer.set_music(SoundId::TowerTheme);
+        report.add(bench::measure("mix block, 32 voices + music", [&](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) mixer.mix(block.data(), kBlockFrames);
+            bench::do_not_optimize(block.data());
+        }));
+        report.line("  block budget %.0f us", kBlockFrames * 1e6 / kAudioSampleRate);
+    }
+
+    // Live run: two seconds of the audio thread against a game thread that
+    // plays a few sounds per 60 Hz frame (and bursts of 40 now and then, so
+    // stealing kicks in) while doing the things that used to stall the mixer.
+    {
+        Mixer mixer(bank);
+        NullAudioSink sink(kBlockFrames);
+        std::mutex game_lock;
+        uint32_t rng = 11;
+        AudioThreadStats stats;
+        {
+            AudioThread audio(mixer, sink);
+            mixer.set_music(SoundId::TowerTheme, 0.6f);
+            auto frame = std::chrono::steady_clock::now();
+            for (int f = 0; f < 120; ++f) {
+                int sounds = f % 30 == 0 ? 40 : 3;
+                std::lock_guard<std::mutex> lock(game_lock);
+                std::vector<float> garbage(4096 + f);
+                for (int s = 0; s < sounds; ++s) mixer.play(random_effect(rng), 0.7f, (s % 5 - 2) * 0.5f);
+                bench::do_not_optimize(garbage.data());
+                frame += std::chrono::microseconds(16667);
+                std::this_thread::sleep_until(frame);
+            }
+            stats = audio.stats();
+        }
+        MixerStats ms = mixer.stats();
+        report.line("live run: %llu blocks, %llu late, max mix %.1f us, realtime %s",
+                    static_cast<unsigned long long>(stats.blocks), static_cast<unsigned long long>(stats.late_blocks),
+                    stats.max_mix_us, stats.realtime ? "yes" : "no (no rtprio)");
+        report.line("  commands dropped %llu, voices stolen %llu",
+                    static_cast<unsigned long long>(ms.commands_dropped),
+                    static_cast<unsigned long long>(ms.voices_stolen));
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+// SimBatch throughput: session-ticks per second for a training-sized batch,
+// stepped per object versus batched, and batched across 1..N threads.
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "core/rng.h"
+#include "core/thread_pool.h"
+#include "sim/enemy_kernel.h"
+#include "sim/game_sim.h"
+#include "sim/sim_batch.h"
+
+using namespace toppler;
+
+namespace {
+
+constexpr size_t kSessions = 4096;
+
+// A zig-zag staircase with an elevator and a handful of enemies, roughly the
+// density of a mid-campaign tower.
+LevelData make_level() {
+    LevelData d;
+    d.name = "bench";
+    d.grid = TowerGrid(64);
+    d.grid.fill_row(0, 0, kTowerColumns, Tile::Ledge);
+    for (int r = 1; r < 63; ++r) d.grid.fill_row(r, r * 3, 3, r % 5 == 0 ? Tile::Crumble : Tile::Ledge);
+    d.grid.set(1, 6, Tile::Wall);
+    d.grid.set(12, 2, Tile::Door);
+    d.grid.set(63, 0, Tile::Exit);
+    d.elevators.push_back(ElevatorDef{9, 0, 1, 20, 0});
+    for (int i = 0; i < 12; ++i) {
+        EnemyKind kind = static_cast<EnemyKind>(i % 3);
+        d.spawns.push_back(EnemySpawn{static_cast<uint16_t>(1 + i * 5), static_cast<uint8_t>(i * 7),
+                                      kind, 3, 240});
+    }
+    d.time_limit = 600;
+    return d;
+}
+
+// A community-style mega tower: the same staircase and spawn density as
+// make_level, but at the row limit. Spawn bookkeeping is banded by row, so a
+// tick here should cost about the same as on the short tower.
+LevelData make_mega_level() {
+    LevelData d;
+    d.name = "mega";
+    d.grid = TowerGrid(kMaxTowerRows);
+    d.grid.fill_row(0, 0, kTowerColumns, Tile::Ledge);
+    for (int r = 1; r < kMaxTowerRows - 1; ++r) d.grid.fill_row(r, r * 3, 3, r % 5 == 0 ? Tile::Crumble : Tile::Ledge);
+    d.grid.set(kMaxTowerRows - 1, 0, Tile::Exit);
+    for (int i = 0; 1 + i * 5 < kMaxTowerRows - 1; ++i) {
+        d.spawns.push_back(EnemySpawn{static_cast<uint16_t>(1 + i * 5), static_cast<uint8_t>(i * 7 % kTowerColumns),
+                                      static_cast<EnemyKind>(i % 3), 3, 240});
+    }
+    d.time_limit = 600;
+    return d;
+}
+
+// Bot-ish input: mostly walking one way with occasional jumps and shots.
+InputMask bot_input(uint32_t& rng) {
+    uint32_t r = rng_next(rng);
+    InputMask m = (r & 7) < 5 ? kInputRight : kInputLeft;
+    if ((r >> 3) % 23 == 0) m |= kInputJump;
+    if ((r >> 8) % 11 == 0) m |= kInputFire;
+    if ((r >> 12) % 4 == 0) m |= kInputUp;
+    return m;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bench::Report report("batch_bench", argc, argv);
+    LevelData data = make_level();
+    Level level = data.view();
+
+    std::vector<uint32_t> input_rng(kSessions);
+    std::vector<InputMask> inputs(kSessions);
+    auto next_inputs = [&] {
+        for (size_t i = 0; i < kSessions; ++i) inputs[i] = bot_input(input_rng[i]);
+    };
+    auto reset_inputs = [&] {
+        for (size_t i = 0; i < kSessions; ++i) input_rng[i] = rng_seed(static_cast<uint32_t>(i * 7919 + 1));
+    };
+
+    // Sanity check: the batch must reproduce independent sim_step runs exactly.
+    {
+        SimBatch batch(kSessions);
+        std::vector<SimState> single(kSessions);
+        for (size_t i = 0; i < kSessions; ++i) {
+            batch.reset(i, level, static_cast<uint32_t>(i + 1));
+            sim_init(level, static_cast<uint32_t>(i + 1), single[i]);
+        }
+        reset_inputs();
+        ThreadPool pool(4);  // always exercise the threaded path
+        for (int t = 0; t < 600; ++t) {
+            next_inputs();
+            batch.step(inputs.data(), &pool);
+            for (size_t i = 0; i < kSessions; ++i) sim_step(level, single[i], inputs[i]);
+        }
+        size_t mismatched = 0;
+        SimState gathered;
+        for (size_t i = 0; i < kSessions; ++i) {
+            batch.gather(i, gathered);
+            mismatched += std::memcmp(&gathered, &single[i], sizeof gathered) != 0;
+        }
+        report.line("sessions=%zu  batch-vs-single mismatches after 600 ticks: %zu", kSessions,
+                    mismatched);
+        report.expect(mismatched == 0, "batch sessions differ from single-session stepping");
+    }
+
+    std::vector<SimState> objects(kSessions);
+    auto per_object = [&](const char* name, const Level& on) {
+        for (size_t i = 0; i < kSessions; ++i) sim_init(on, static_cast<uint32_t>(i + 1), objects[i]);
+        reset_inputs();
+        report.add(bench::measure(name, [&](uint64_t iters) {
+            for (uint64_t n = 0; n < iters; ++n) {
+                next_inputs();
+                for (size_t i = 0; i < kSessions; ++i) sim_step(on, objects[i], inputs[i]);
+            }
+        }, kSessions));
+    };
+    per_object("session_tick/per_object_1t", level);
+    LevelData mega_data = make_mega_level();
+    Level mega = mega_data.view();
+    validate_level(mega);
+    report.line("mega tower: %d rows, %u spawns", mega.grid.rows, mega.spawn_count);
+    per_object("session_tick/per_object_1t_mega_tower", mega);
+
+    // Enemy kernel per instruction set, on a fully populated lane block.
+    EnemyLanes lanes;
+    std::memset(&lanes, 0, sizeof lanes);
+    lanes.pool.init();
+    for (int i = 0; i < kMaxEnemies; ++i) {
+        lanes.pool.acquire();
+        lanes.alive[i] = 1;
+        lanes.angle[i] = static_cast<float>(i) * 0.25f;
+        lanes.height[i] = lanes.lo[i] = static_cast<float>(i);
+        lanes.hi[i] = static_cast<float>(i) + 3.0f;
+        lanes.vangle[i] = (i & 1) ? 1.0f / 32.0f : -3.0f / 64.0f;
+        lanes.vheight[i] = 1.0f / 64.0f;
+    }
+    EnemyLanes reference = lanes;
+    set_kernel_isa(KernelIsa::Scalar);
+    for (int t = 0; t < 1000; ++t) enemy_update(reference);
+    KernelIsa best = best_kernel_isa();
+    for (int isa = 0; isa <= static_cast<int>(best); ++isa) {
+        KernelIsa k = set_kernel_isa(static_cast<KernelIsa>(isa));
+        EnemyLanes work = lanes;
+        for (int t = 0; t < 1000; ++t) enemy_update(work);
+        report.line("kernel %-6s matches scalar after 1000 updates: %s", kernel_isa_name(k),
+                    std::memcmp(&work, &reference, sizeof work) == 0 ? "yes" : "NO");
+        std::string prefix = std::string("enemy_kernel/") + kernel_isa_name(k);
+        report.add(bench::measure(prefix + "/update_64_lanes", [&](uint64_t iters) {
+            for (uint64_t n = 0; n < iters; ++n) enemy_update(work);
+            bench::clobber_memory();
+        }));
+        uint64_t hits = 0;
+        report.add(bench::measure(prefix + "/overlap_64_lanes", [&](uint64_t iters) {
+            for (uint64_t n = 0; n < iters; ++n) {
+                float y = static_cast<float>(n & 63);
+                hits += enemy_overlap_mask(work, OverlapBox{3.0f, kPlayerHalfWidth, y, y + kPlayerHeight});
+            }
+        }));
+        bench::do_not_optimize(hits);
+    }
+    set_kernel_isa(best);
+
+    unsigned hw = std::thread::hardware_concurrency();
+    if (hw == 0) hw = 1;
+    double base = 0.0;
+    for (unsigned threads = 1;; threads = threads * 2 > hw && threads < hw ? hw : threads * 2) {
+        ThreadPool pool(threads);
+        SimBatch batch(kSessions);
+        for (size_t i = 0; i < kSessions; ++i) batch.reset(i, level, static_cast<uint32_t>(i + 1));
+        reset_inputs();
+        char name[64];
+        std::snprintf(name, sizeof name, "session_tick/batch_%ut", threads);
+        bench::Result r = bench::measure(name, [&](uint64_t iters) {
+            for (uint64_t n = 0; n < iters; ++n) {
+                next_inputs();
+                batch.step(inputs.data(), &pool);
+            }
+        }, kSessions);
+        report.add(r);
+        if (threads == 1) base = r.ns_per_op;
+        report.line("  speedup vs 1 thread: %.2fx", base / r.ns_per_op);
+        if (threads >= hw) break;
+    }
+    return report.status();
+}
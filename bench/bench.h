@@ -0,0 +1,110 @@
+#pragma once
+
+// Minimal in-tree benchmark harness. Each measurement auto-calibrates its
+// iteration count to a time budget and reports ns/op; results go to stdout
+// and, with `--out PATH`, to a file. tower_bench, the pre-deploy regression
+// run, writes bench_output.txt at the repo root unless told otherwise; the
+// narrower benches print only, so running one never replaces that report.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace toppler::bench {
+
+// Keeps the optimizer from discarding a computed value.
+template <class T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber_memory() { asm volatile("" : : : "memory"); }
+
+struct Result {
+    std::string name;
+    uint64_t iterations = 0;
+    double ns_per_op = 0.0;
+};
+
+// Runs body(iterations) with growing iteration counts until one run takes at
+// least min_seconds. Each iteration counts as ops_per_iter operations.
+template <class Body>
+Result measure(const std::string& name, Body&& body, uint64_t ops_per_iter = 1,
+               double min_seconds = 0.2) {
+    using clock = std::chrono::steady_clock;
+    uint64_t iters = 1;
+    for (;;) {
+        auto start = clock::now();
+        body(iters);
+        double secs = std::chrono::duration<double>(clock::now() - start).count();
+        if (secs >= min_seconds || iters >= (uint64_t{1} << 40)) {
+            double ops = static_cast<double>(iters) * static_cast<double>(ops_per_iter);
+            return Result{name, iters * ops_per_iter, secs * 1e9 / ops};
+        }
+        double scale = secs > 0.0 ? min_seconds * 1.4 / secs : 100.0;
+        if (scale > 100.0) scale = 100.0;
+        uint64_t next = static_cast<uint64_t>(static_cast<double>(iters) * scale);
+        iters = next > iters ? next : iters + 1;
+    }
+}
+
+// Collects results and mirrors them to stdout and the output file.
+class Report {
+public:
+    // Parses `--out PATH`; anything else is left for the caller. Without
+    // it, results go to `default_path`, or to stdout only if that is null.
+    Report(const char* suite, int argc, char** argv, const char* default_path = nullptr) {
+        const char* path = default_path;
+        for (int i = 1; i + 1 < argc; ++i) {
+            if (std::strcmp(argv[i], "--out") == 0) path = argv[i + 1];
+        }
+        if (path) {
+            file_ = std::fopen(path, "w");
+            if (!file_) std::fprintf(stderr, "bench: cannot open %s, printing only\n", path);
+        }
+        line("# %s", suite);
+    }
+    ~Report() {
+        if (file_) std::fclose(file_);
+    }
+    Report(const Report&) = delete;
+    Report& operator=(const Report&) = delete;
+
+    void add(const Result& r) {
+        line("%-48s %14.2f ns/op %12.0f op/s  (%llu iters)", r.name.c_str(), r.ns_per_op,
+             r.ns_per_op > 0.0 ? 1e9 / r.ns_per_op : 0.0,
+             static_cast<unsigned long long>(r.iterations));
+    }
+
+    // Free-form metric line, e.g. memory footprints.
+    template <class... Args>
+    void line(const char* fmt, Args... args) {
+        char buf[512];
+        if constexpr (sizeof...(Args) == 0) {
+            std::snprintf(buf, sizeof buf, "%s", fmt);
+        } else {
+            std::snprintf(buf, sizeof buf, fmt, args...);
+        }
+        std::printf("%s\n", buf);
+        if (file_) std::fprintf(file_, "%s\n", buf);
+    }
+
+    // Records a correctness check (batch vs single, round trip, per-pixel
+    // match). A failed one is reported and makes status() nonzero, so the
+    // suite fails instead of printing a mismatch count and exiting 0.
+    void expect(bool ok, const char* what) {
+        if (ok) return;
+        failed_ = true;
+        line("FAILED: %s", what);
+    }
+    // What main() returns.
+    int status() const { return failed_ ? 1 : 0; }
+
+private:
+    std::FILE* file_ = nullptr;
+    bool failed_ = false;
+};
+
+}  // namespace toppler::bench
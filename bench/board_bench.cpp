@@ -0,0 +1,223 @@
+// Leaderboard store: submission throughput into the log and skip-list index,
+// top-K and rank queries against sorting the board per query, reopening
+// from log and from snapshot, and background compaction under load. Every
+// board is checked against a brute-force model first.
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "board/leaderboard.h"
+#include "core/rng.h"
+
+using namespace toppler;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kTowers = 16;
+constexpr uint32_t kPlayers = 50000;
+
+uint64_t tower_id(uint32_t i) { return 0x9e3779b97f4a7c15ull * (i + 1); }
+
+// Scores and times spread the way a live board's do: most runs are
+// unremarkable, a few set bests.
+std::vector<ScoreSubmission> make_submissions(size_t n, uint32_t seed) {
+    std::vector<ScoreSubmission> out(n);
+    uint32_t rng = rng_seed(seed);
+    for (ScoreSubmission& s : out) {
+        s.tower = tower_id(rng_below(rng, kTowers));
+        s.player = 1 + rng_below(rng, kPlayers);
+        s.score = rng_below(rng, 100000);
+        s.ticks = rng_below(rng, 4) == 0 ? 0 : 3000 + rng_below(rng, 20000);
+    }
+    return out;
+}
+
+struct Model {
+    std::map<std::pair<uint64_t, uint64_t>, std::pair<uint32_t, uint32_t>> bests;  // score, ticks
+
+    void submit(const ScoreSubmission& s) {
+        auto& b = bests[{s.tower, s.player}];
+        b.first = std::max(b.first, s.score);
+        if (s.ticks && (!b.second || s.ticks < b.second)) b.second = s.ticks;
+    }
+
+    // The whole board, sorted best first: what a flat table does per query.
+    std::vector<BoardEntry> board(BoardId id) const {
+        std::map<uint64_t, uint64_t> values;
+        for (const auto& [key, b] : bests) {
+            if (id.kind == BoardKind::Total) {
+                values[key.second] += b.first;
+            } else if (key.first == id.tower) {
+                uint64_t v = id.kind == BoardKind::TowerTime ? b.second : b.first;
+                if (v) values[key.second] = v;
+            }
+        }
+        std::vector<BoardEntry> out;
+        for (const auto& [player, v] : values) {
+            if (v) out.push_back(BoardEntry{player, v, 0});
+        }
+        bool ascending = id.kind == BoardKind::TowerTime;
+        std::sort(out.begin(), out.end(), [&](const BoardEntry& a, const BoardEntry& b) {
+            if (a.value != b.value) return ascending ? a.value < b.value : a.value > b.value;
+            return a.player < b.player;
+        });
+        for (size_t i = 0; i < out.size(); ++i) out[i].rank = static_cast<uint32_t>(i + 1);
+        return out;
+    }
+};
+
+std::vector<BoardId> all_boards() {
+    std::vector<BoardId> ids{total_score_board()};
+    for (uint32_t t = 0; t < kTowers; ++t) {
+        ids.push_back(tower_time_board(tower_id(t)));
+        ids.push_back(tower_score_board(tower_id(t)));
+    }
+    return ids;
+}
+
+// Every board's size, top 10 and a sample of ranks against the model.
+bool matches_model(const Leaderboard& board, const Model& model) {
+    std::vector<BoardEntry> top;
+    for (BoardId id : all_boards()) {
+        std::vector<BoardEntry> want = model.board(id);
+        if (board.board_size(id) != want.size()) return false;
+        board.top(id, 10, top);
+        if (top.size() != std::min<size_t>(10, want.size())) return false;
+        for (size_t i = 0; i < top.size(); ++i) {
+            if (top[i].player != want[i].player || top[i].value != want[i].value || top[i].rank != want[i].rank) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < want.size(); i += 97) {
+            BoardEntry e = board.find(id, want[i].player);
+            if (e.rank != want[i].rank || e.value != want[i].value) return false;
+        }
+    }
+    return true;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bench::Report report("board_bench", argc, argv);
+    std::string dir = (fs::temp_directory_path() / "toppler_board_bench").string();
+    fs::remove_all(dir);
+
+    std::vector<ScoreSubmission> subs = make_submissions(500000, 1);
+    Model model;
+    for (const ScoreSubmission& s : subs) model.submit(s);
+
+    // Load, check, reopen from the log, compact, reopen from the snapshot.
+    {
+        LeaderboardOptions opts;
+        opts.compact_after = UINT32_MAX;  // one log, so reopening replays all of it
+        auto t0 = std::chrono::steady_clock::now();
+        size_t improved = 0;
+        {
+            Leaderboard board(dir, opts);
+            for (const ScoreSubmission& s : subs) improved += board.submit(s);
+            board.sync();
+            double secs = seconds_since(t0);
+            LeaderboardStats st = board.stats();
+            report.line("load: %zu submissions (%zu personal bests, %llu entries) in %.0f ms: %.2fM/s, "
+                        "matches model: %s",
+                        subs.size(), improved, static_cast<unsigned long long>(st.entries), secs * 1e3,
+                        subs.size() / secs / 1e6, matches_model(board, model) ? "yes" : "NO");
+        }
+        t0 = std::chrono::steady_clock::now();
+        {
+            Leaderboard board(dir, opts);
+            double secs = seconds_since(t0);
+            report.line("reopen from log (%zu records): %.0f ms, matches model: %s", improved, secs * 1e3,
+                        matches_model(board, model) ? "yes" : "NO");
+            board.compact(true);
+        }
+        t0 = std::chrono::steady_clock::now();
+        {
+            Leaderboard board(dir, opts);
+            double secs = seconds_since(t0);
+            report.line("reopen from snapshot (%llu records): %.0f ms, matches model: %s",
+                        static_cast<unsigned long long>(model.bests.size()), secs * 1e3,
+                        matches_model(board, model) ? "yes" : "NO");
+        }
+    }
+
+    // Queries on the loaded boards, against a flat table sorted per query.
+    {
+        Leaderboard board(dir);
+        BoardId total = total_score_board();
+        std::vector<BoardEntry> top;
+        report.add(bench::measure("top10/total (" + std::to_string(board.board_size(total)) + " players)",
+                                  [&](uint64_t iters) {
+                                      for (uint64_t i = 0; i < iters; ++i) board.top(total, 10, top);
+                                      bench::do_not_optimize(top.data());
+                                  }));
+        uint32_t rng = rng_seed(3);
+        report.add(bench::measure("rank/total", [&](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) bench::do_not_optimize(board.find(total, 1 + rng_below(rng, kPlayers)));
+        }));
+        BoardId tower = tower_time_board(tower_id(0));
+        report.add(bench::measure("rank/tower_time", [&](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) bench::do_not_optimize(board.find(tower, 1 + rng_below(rng, kPlayers)));
+        }));
+
+        std::vector<BoardEntry> flat = model.board(total);
+        std::vector<BoardEntry> scratch;
+        report.add(bench::measure("baseline: sort total per query", [&](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                scratch = flat;
+                std::sort(scratch.begin(), scratch.end(), [](const BoardEntry& a, const BoardEntry& b) {
+                    return a.value != b.value ? a.value > b.value : a.player < b.player;
+                });
+                bench::do_not_optimize(scratch.data());
+            }
+        }));
+    }
+
+    // Steady submissions with compaction running behind them.
+    {
+        fs::remove_all(dir);
+        LeaderboardOptions opts;
+        opts.compact_after = 100000;
+        Leaderboard board(dir, opts);
+        for (const ScoreSubmission& s : subs) board.submit(s);
+        std::vector<ScoreSubmission> more = make_submissions(1000000, 2);
+        size_t next = 0;
+        double worst_us = 0.0;
+        bench::Result r = bench::measure("submit (with background compaction)", [&](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                auto t0 = std::chrono::steady_clock::now();
+                board.submit(more[next]);
+                worst_us = std::max(worst_us, seconds_since(t0) * 1e6);
+                next = next + 1 == more.size() ? 0 : next + 1;
+            }
+        });
+        report.add(r);
+        board.compact(true);
+        LeaderboardStats st = board.stats();
+        report.line("  %llu compactions, %llu failed, worst submit %.0f us (log rotation + fdatasync)",
+                    static_cast<unsigned long long>(st.compactions),
+                    static_cast<unsigned long long>(st.compaction_failures), worst_us);
+        report.add(bench::measure("submit + sync each (fdatasync per record)", [&](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                ScoreSubmission s = more[next];
+                s.score = 200000 + static_cast<uint32_t>(i);  // always a best, so always logged
+                board.submit(s);
+                board.sync();
+                next = next + 1 == more.size() ? 0 : next + 1;
+            }
+        }, 1, 0.05));
+    }
+    fs::remove_all(dir);
+    return 0;
+}
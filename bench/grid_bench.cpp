@@ -0,0 +1,124 @@
+// Compares the flat TowerGrid against the vector-of-rows layout it replaces,
+// on the access pattern the sim, renderer and AI share: every frame, read the
+// few rows around the player on each of many resident towers.
+
+#include <cstdint>
+#include <vector>
+
+#include "bench.h"
+#include "tower/tower_grid.h"
+
+using namespace toppler;
+
+namespace {
+
+constexpr int kTowers = 300;
+constexpr int kRows = 256;
+constexpr int kWindow = 5;  // rows read around the player
+
+// The layout being replaced: one heap block per row.
+struct RowObject {
+    std::vector<Tile> tiles;
+    Tile at(int col) const { return tiles[col & kTowerColumnMask]; }
+};
+using RowTower = std::vector<RowObject>;
+
+uint32_t next_random(uint32_t& s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+Tile random_tile(uint32_t& rng) {
+    uint32_t r = next_random(rng) % 8;
+    return r < 5 ? Tile::Empty : static_cast<Tile>(r - 4);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bench::Report report("grid_bench", argc, argv);
+
+    std::vector<TowerGrid> flat;
+    std::vector<RowTower> rows;
+    flat.reserve(kTowers);
+    rows.reserve(kTowers);
+    uint32_t rng = 0x1234567u;
+    for (int t = 0; t < kTowers; ++t) {
+        TowerGrid grid(kRows);
+        RowTower legacy(kRows);
+        for (int r = 0; r < kRows; ++r) {
+            legacy[r].tiles.resize(kTowerColumns);
+            for (int c = 0; c < kTowerColumns; ++c) {
+                Tile tile = random_tile(rng);
+                grid.set(r, c, tile);
+                legacy[r].tiles[c] = tile;
+            }
+        }
+        flat.push_back(std::move(grid));
+        rows.push_back(std::move(legacy));
+    }
+
+    // Each tower's player climbs at its own pace so towers touch different rows.
+    std::vector<int> player_row(kTowers);
+    for (int t = 0; t < kTowers; ++t) player_row[t] = static_cast<int>(next_random(rng) % kRows);
+
+    report.line("towers=%d rows=%d window=%d", kTowers, kRows, kWindow);
+    report.line("flat grid bytes/tower: %zu", flat[0].size_bytes());
+    report.line("row-vector bytes/tower (payload + headers): %zu",
+                static_cast<size_t>(kRows) * (kTowerColumns + sizeof(RowObject)) + sizeof(RowTower));
+
+    report.add(bench::measure("window_scan/flat_grid", [&](uint64_t iters) {
+        uint32_t solid = 0;
+        for (uint64_t i = 0; i < iters; ++i) {
+            int t = static_cast<int>(i % kTowers);
+            TowerGridView view = flat[t].view();
+            int base = (player_row[t] + static_cast<int>(i / kTowers)) % kRows;
+            for (int r = base - kWindow / 2; r <= base + kWindow / 2; ++r) {
+                for (int c = 0; c < kTowerColumns; ++c) solid += view.at(r, c) != Tile::Empty;
+            }
+        }
+        bench::do_not_optimize(solid);
+    }));
+
+    report.add(bench::measure("window_scan/row_vector", [&](uint64_t iters) {
+        uint32_t solid = 0;
+        for (uint64_t i = 0; i < iters; ++i) {
+            int t = static_cast<int>(i % kTowers);
+            const RowTower& tower = rows[t];
+            int base = (player_row[t] + static_cast<int>(i / kTowers)) % kRows;
+            for (int r = base - kWindow / 2; r <= base + kWindow / 2; ++r) {
+                if (r < 0 || r >= kRows) continue;
+                for (int c = 0; c < kTowerColumns; ++c) solid += tower[r].at(c) != Tile::Empty;
+            }
+        }
+        bench::do_not_optimize(solid);
+    }));
+
+    // Collision-style point probes, including wrapped columns either side of 0.
+    report.add(bench::measure("point_probe/flat_grid", [&](uint64_t iters) {
+        uint32_t solid = 0;
+        uint32_t s = 0x9e3779b9u;
+        for (uint64_t i = 0; i < iters; ++i) {
+            uint32_t r = next_random(s);
+            const TowerGrid& g = flat[r % kTowers];
+            solid += g.at(static_cast<int>((r >> 9) % kRows), static_cast<int>(r >> 24) - 128) !=
+                     Tile::Empty;
+        }
+        bench::do_not_optimize(solid);
+    }));
+
+    report.add(bench::measure("point_probe/row_vector", [&](uint64_t iters) {
+        uint32_t solid = 0;
+        uint32_t s = 0x9e3779b9u;
+        for (uint64_t i = 0; i < iters; ++i) {
+            uint32_t r = next_random(s);
+            const RowTower& tower = rows[r % kTowers];
+            solid += tower[(r >> 9) % kRows].at(static_cast<int>(r >> 24) - 128) != Tile::Empty;
+        }
+        bench::do_not_optimize(solid);
+    }));
+
+    return 0;
+}
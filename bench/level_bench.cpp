@@ -0,0 +1,116 @@
+// Cold-start cost of getting every campaign tower ready to play: parsing the
+// .tower text versus mapping the binary pack and viewing towers in place,
+// plus the frame-loop cost of a tower change with and without prefetch, and
+// the cost of generating a procedural tower.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "tower/level_pack.h"
+#include "tower/level_text.h"
+#include "tower/tower_gen.h"
+#include "tower/tower_streamer.h"
+
+using namespace toppler;
+
+#ifndef TT_SOURCE_DIR
+#define TT_SOURCE_DIR "."
+#endif
+
+namespace {
+
+const char* const kCampaign[] = {
+    "01_first_steps.tower",
+    "02_crumbling_heights.tower",
+    "03_lift_works.tower",
+    "04_eye_spire.tower",
+};
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream buf;
+    buf << in.rdbuf();
+    return buf.str();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bench::Report report("level_bench", argc, argv);
+
+    std::vector<std::string> paths, texts;
+    for (const char* file : kCampaign) {
+        paths.push_back(std::string(TT_SOURCE_DIR) + "/levels/campaign/" + file);
+        texts.push_back(read_file(paths.back()));
+    }
+    std::vector<LevelData> towers;
+    for (size_t i = 0; i < texts.size(); ++i) towers.push_back(parse_level_text(texts[i], paths[i]));
+    std::vector<uint8_t> bytes = build_level_pack(towers);
+    std::string pack_path = "level_bench.ttpk";
+    write_level_pack(pack_path, towers);
+    report.line("campaign: %zu towers, %zu text bytes, %zu pack bytes", towers.size(),
+                [&] { size_t n = 0; for (auto& t : texts) n += t.size(); return n; }(), bytes.size());
+
+    // Text already in memory, so this is parse cost alone (no file I/O).
+    report.add(bench::measure("parse text, all towers (in memory)", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            for (size_t t = 0; t < texts.size(); ++t) bench::do_not_optimize(parse_level_text(texts[t]));
+        }
+    }));
+    report.add(bench::measure("read + parse text files", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            for (const std::string& p : paths) bench::do_not_optimize(load_level_text(p));
+        }
+    }));
+    report.add(bench::measure("mmap pack + view all towers", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            LevelPack pack = LevelPack::open(pack_path);
+            for (size_t t = 0; t < pack.size(); ++t) bench::do_not_optimize(pack.tower(t));
+        }
+    }));
+    LevelPack pack = LevelPack::from_bytes(bytes);
+    report.add(bench::measure("view all towers of an open pack", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            for (size_t t = 0; t < pack.size(); ++t) bench::do_not_optimize(pack.tower(t));
+        }
+    }));
+    // Tower changes as the frame loop sees them: enter() latency with and
+    // without a prefetch issued while the previous tower was being played.
+    {
+        LevelPack mapped = LevelPack::open(pack_path);
+        BackgroundLoader loader;
+        for (bool prefetch : {false, true}) {
+            TowerStreamer streamer(mapped, loader);
+            double worst = 0.0, total = 0.0;
+            const int kLaps = 200;
+            for (int lap = 0; lap < kLaps; ++lap) {
+                for (size_t t = 0; t < mapped.size(); ++t) {
+                    auto start = std::chrono::steady_clock::now();
+                    bench::do_not_optimize(streamer.enter(t).level);
+                    double us = std::chrono::duration<double, std::micro>(
+                                    std::chrono::steady_clock::now() - start).count();
+                    worst = std::max(worst, us);
+                    total += us;
+                    if (prefetch) streamer.prefetch((t + 1) % mapped.size());
+                    loader.wait_idle();  // stands in for playing the tower
+                }
+            }
+            report.line("tower change, %-12s mean %6.2f us  worst %7.2f us  (%u prefetched, %u inline)",
+                        prefetch ? "prefetched:" : "inline load:", total / (kLaps * mapped.size()), worst,
+                        streamer.stats().prefetched, streamer.stats().inline_loads);
+        }
+    }
+    // Generating a daily-challenge candidate, before the planner screens it.
+    uint32_t gen_seed = 0;
+    report.add(bench::measure("generate one 48-row tower", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) bench::do_not_optimize(generate_tower(TowerGenConfig{}, ++gen_seed));
+    }));
+    std::remove(pack_path.c_str());
+    return 0;
+}
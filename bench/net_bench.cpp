@@ -0,0 +1,310 @@
+// Head-to-head race netcode: two RaceSessions exchanging real UDP datagrams
+// over loopback, with WAN latency and loss emulated on delivery. Reports
+// rollback depth and frequency, stalls and bytes on the wire, checks that
+// both peers end with bit-identical copies of both runs, that a doctored
+// tower is caught as a desync on the tick it first matters, and what the
+// worst-case rollback costs. Then loads a RaceServer with a few thousand
+// matches' worth of clients and reports its CPU cost per tick.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "core/rng.h"
+#include "net/race_peer.h"
+#include "net/race_server.h"
+#include "net/race_session.h"
+#include "net/udp_socket.h"
+#include "sim/game_sim.h"
+#include "sim/rewind.h"
+#include "sim/state_hash.h"
+#include "tower/level_text.h"
+
+using namespace toppler;
+
+#ifndef TT_SOURCE_DIR
+#define TT_SOURCE_DIR "."
+#endif
+
+namespace {
+
+constexpr uint32_t kTicks = 60 * kTicksPerSecond;
+
+// Held inputs of a few frames to a second, roughly how people play.
+std::vector<InputMask> human_inputs(uint32_t seed) {
+    std::vector<InputMask> out;
+    uint32_t rng = rng_seed(seed);
+    while (out.size() < kTicks) {
+        uint32_t r = rng_next(rng);
+        InputMask m = (r & 3) == 0 ? kInputLeft : kInputRight;
+        if ((r >> 2) % 3 == 0) m |= kInputJump;
+        if ((r >> 4) % 5 == 0) m |= kInputFire;
+        uint32_t hold = 4 + rng_below(rng, 40);
+        for (uint32_t i = 0; i < hold && out.size() < kTicks; ++i) out.push_back(m);
+    }
+    return out;
+}
+
+struct Link {
+    uint32_t latency;  // ticks, one way
+    uint32_t loss;     // per mille
+};
+
+struct Datagram {
+    uint64_t deliver_at;
+    size_t size;
+    uint8_t bytes[kMaxRacePacketBytes];
+};
+
+struct Peer {
+    RaceSession session;
+    UdpSocket socket;
+    RacePeer link;
+    std::deque<Datagram> in_flight;
+    const std::vector<InputMask>* inputs;
+
+    Peer(const Level& level, const std::vector<InputMask>& in)
+        : session(level, 7), socket(0, "127.0.0.1"), link(session, 1), inputs(&in) {}
+};
+
+struct RaceResult {
+    RaceStats a, b;
+    uint64_t packets, bytes;
+    bool identical;
+    uint32_t desync_a, desync_b;
+};
+
+// Frame loop of both players. Each frame a peer reads its socket (holding
+// datagrams until their emulated arrival time), advances if it may, sends.
+RaceResult run_race(const Level& level_a, const Level& level_b, const std::vector<InputMask>& in_a,
+                    const std::vector<InputMask>& in_b, Link link, uint32_t loss_seed) {
+    Peer a(level_a, in_a), b(level_b, in_b);
+    NetAddress addr_a = parse_address("127.0.0.1:" + std::to_string(a.socket.port()));
+    NetAddress addr_b = parse_address("127.0.0.1:" + std::to_string(b.socket.port()));
+    uint32_t rng = rng_seed(loss_seed);
+    uint64_t frame = 0, packets = 0, bytes = 0;
+    auto pump = [&](Peer& self, const NetAddress& to) {
+        Datagram d;
+        long n;
+        while ((n = self.socket.receive(d.bytes, sizeof d.bytes)) >= 0) {
+            if (rng_below(rng, 1000) < link.loss) continue;
+            d.size = static_cast<size_t>(n);
+            d.deliver_at = frame + link.latency;
+            self.in_flight.push_back(d);
+        }
+        while (!self.in_flight.empty() && self.in_flight.front().deliver_at <= frame) {
+            self.link.handle_packet(self.in_flight.front().bytes, self.in_flight.front().size);
+            self.in_flight.pop_front();
+        }
+        uint32_t t = self.session.tick();
+        if (t < kTicks) self.session.advance((*self.inputs)[t]);
+        else self.session.resolve();
+        uint8_t out[kMaxRacePacketBytes];
+        size_t size = self.link.build_packet(out);
+        self.socket.send(to, out, size);
+        ++packets;
+        bytes += size;
+    };
+    // Runs until both have every remote input (a few round trips past the end).
+    while (a.session.confirmed_tick() < kTicks || b.session.confirmed_tick() < kTicks || a.session.tick() < kTicks ||
+           b.session.tick() < kTicks) {
+        pump(a, addr_b);
+        pump(b, addr_a);
+        ++frame;
+        if (frame > 20 * kTicks) break;
+    }
+    a.session.resolve();
+    b.session.resolve();
+    RaceResult r;
+    r.a = a.session.stats();
+    r.b = b.session.stats();
+    r.packets = packets;
+    r.bytes = bytes;
+    r.identical = std::memcmp(&a.session.local(), &b.session.remote(), sizeof(SimState)) == 0 &&
+                  std::memcmp(&b.session.local(), &a.session.remote(), sizeof(SimState)) == 0;
+    r.desync_a = a.session.desync_tick();
+    r.desync_b = b.session.desync_tick();
+    return r;
+}
+
+// Server load: both players of every match send one packet per tick, as
+// clients on a good link do. The clients are not simulated; their packets
+// are built from one run recorded up front, which is just as valid for the
+// server to check. Match `kTamperedMatch` lies about one hash.
+constexpr uint16_t kTamperedMatch = 5;
+constexpr uint32_t kTamperedTick = 100;
+constexpr uint32_t kServerTicks = 180;
+
+void run_server_load(bench::Report& report, const Level& level, const std::vector<InputMask>& inputs, unsigned shards,
+                     unsigned matches) {
+    std::vector<uint64_t> hashes(kServerTicks + 1);
+    SimState state;
+    sim_init(level, 7, state);
+    hashes[0] = tick_hash(state);
+    for (uint32_t t = 1; t <= kServerTicks; ++t) {
+        sim_step(level, state, inputs[t - 1]);
+        hashes[t] = tick_hash(state);
+    }
+
+    RaceServerConfig config;
+    config.port = 0;
+    config.bind_host = "127.0.0.1";
+    config.shards = shards;
+    RaceDesync caught{0, 0, 0};
+    config.on_desync = [&](const RaceDesync& d) { caught = d; };
+    RaceServer server(config);
+    for (unsigned m = 1; m <= matches; ++m) server.open_match(static_cast<uint16_t>(m), level, 7);
+    NetAddress to = parse_address("127.0.0.1:" + std::to_string(server.port()));
+
+    std::vector<std::unique_ptr<UdpSocket>> clients;
+    for (unsigned i = 0; i < 2 * matches; ++i) clients.push_back(std::make_unique<UdpSocket>(0, "127.0.0.1"));
+
+    RaceServerStats before = server.stats();
+    uint64_t sent = 0, relayed_seen = 0;
+    RacePacket p;
+    uint8_t bytes[kMaxRacePacketBytes];
+    for (uint32_t t = 1; t <= kServerTicks; ++t) {
+        for (unsigned m = 1; m <= matches; ++m) {
+            p.match = static_cast<uint16_t>(m);
+            p.ack = t - 1;
+            p.first = t;
+            p.count = 1;
+            p.inputs[0] = inputs[t - 1];
+            p.hash_tick = t;
+            for (unsigned side = 0; side < 2; ++side) {
+                p.hash = hashes[t] ^ (m == kTamperedMatch && side == 1 && t == kTamperedTick);
+                size_t size = encode_race_packet(p, bytes);
+                clients[2 * (m - 1) + side]->send(to, bytes, size);
+                ++sent;
+            }
+        }
+        // Let the server catch up before the next tick's burst.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (server.stats().packets_in - before.packets_in < sent && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        for (auto& c : clients) {
+            while (c->receive(bytes, sizeof bytes) >= 0) ++relayed_seen;
+        }
+    }
+    server.stop();
+    RaceServerStats s = server.stats();
+    uint64_t in = s.packets_in - before.packets_in;
+    double busy_us = static_cast<double>(s.busy_ns - before.busy_ns) / 1e3;
+    double per_tick = busy_us / kServerTicks;
+    report.line("server, %u shard%s, %u matches: %.0f us CPU per tick (%.1f%% of one core at %u Hz), "
+                "%.2f us per packet, %.1f packets per batch",
+                server.shards(), server.shards() == 1 ? "" : "s", matches, per_tick,
+                per_tick * kTicksPerSecond / 1e4, kTicksPerSecond, busy_us / static_cast<double>(in),
+                static_cast<double>(in) / static_cast<double>(s.receive_batches - before.receive_batches));
+    report.line("  %llu sent, %llu received, %llu relayed and %llu of them seen, %llu rejected, %llu sim ticks; "
+                "desync in match %u player %u tick %u",
+                static_cast<unsigned long long>(sent), static_cast<unsigned long long>(in),
+                static_cast<unsigned long long>(s.packets_relayed - before.packets_relayed),
+                static_cast<unsigned long long>(relayed_seen),
+                static_cast<unsigned long long>(s.packets_rejected - before.packets_rejected),
+                static_cast<unsigned long long>(s.sim_ticks - before.sim_ticks), caught.match, caught.player,
+                caught.tick);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bench::Report report("net_bench", argc, argv);
+    LevelData data = load_level_text(std::string(TT_SOURCE_DIR) + "/levels/campaign/04_eye_spire.tower");
+    Level level = data.view();
+    std::vector<InputMask> in_a = human_inputs(1), in_b = human_inputs(2);
+
+    report.line("race: %u ticks per player, max rollback %u ticks", kTicks, RaceSession::kDefaultMaxRollback);
+    for (Link link : {Link{0, 0}, Link{3, 0}, Link{5, 50}, Link{8, 100}}) {
+        RaceResult r = run_race(level, level, in_a, in_b, link, 99);
+        double mean = r.a.rollbacks ? static_cast<double>(r.a.resimulated_ticks) / r.a.rollbacks : 0.0;
+        report.line("rtt %3u ms, loss %2u%%: %4llu rollbacks (mean %.1f, max %2u ticks), %3llu stalls, "
+                    "%.1f bytes/packet, %s, desync %s",
+                    link.latency * 2 * 1000 / kTicksPerSecond, link.loss / 10,
+                    static_cast<unsigned long long>(r.a.rollbacks), mean, r.a.max_rollback,
+                    static_cast<unsigned long long>(r.a.stalls + r.b.stalls),
+                    static_cast<double>(r.bytes) / static_cast<double>(r.packets),
+                    r.identical ? "runs identical" : "RUNS DIFFER",
+                    r.desync_a == RaceSession::kNoDesync && r.desync_b == RaceSession::kNoDesync ? "none" : "FOUND");
+    }
+
+    // Desync detection: B's copy of the tower has one tile flipped, which
+    // B's run first walks into half a minute in. That tick is found offline
+    // by running B's inputs on both towers; A must flag exactly it.
+    {
+        LevelData tampered = data;
+        Tile tile = tampered.grid.at(1, 9);
+        tampered.grid.set(1, 9, tile == Tile::Empty ? Tile::Ledge : Tile::Empty);
+        Level level_b = tampered.view();
+        uint32_t truth = RaceSession::kNoDesync;
+        SimState x, y;
+        sim_init(level, 7, x);
+        sim_init(level_b, 7, y);
+        for (uint32_t t = 1; t <= kTicks && truth == RaceSession::kNoDesync; ++t) {
+            sim_step(level, x, in_b[t - 1]);
+            sim_step(level_b, y, in_b[t - 1]);
+            if (tick_hash(x) != tick_hash(y)) truth = t;
+        }
+        RaceResult r = run_race(level, level_b, in_a, in_b, Link{5, 50}, 5);
+        report.line("tampered tower: runs first differ at tick %u, race flagged tick %u", truth, r.desync_a);
+    }
+
+    // Worst case per frame: a correction at the edge of the window, i.e.
+    // restore, then re-run kDefaultMaxRollback ticks with snapshots and hashes.
+    {
+        constexpr uint32_t kDepth = RaceSession::kDefaultMaxRollback;
+        RewindBuffer history(kDepth + 1);
+        SimState state;
+        sim_init(level, 7, state);
+        for (uint32_t t = 0; t < 600; ++t) sim_step(level, state, in_a[t]);
+        for (uint32_t t = 0; t <= kDepth; ++t) {
+            sim_step(level, state, in_a[600 + t]);
+            history.push(state);
+        }
+        uint64_t hashes = 0;
+        report.add(bench::measure("rollback 10 ticks: restore + re-run + snapshot + hash", [&](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                history.rewind(kDepth, state);
+                for (uint32_t t = 0; t < kDepth; ++t) {
+                    sim_step(level, state, in_a[601 + t] ^ kInputJump);
+                    history.push(state);
+                    hashes ^= tick_hash(state);
+                }
+            }
+        }));
+        bench::do_not_optimize(hashes);
+    }
+
+    {
+        UdpSocket sa(0, "127.0.0.1"), sb(0, "127.0.0.1");
+        NetAddress to = parse_address("127.0.0.1:" + std::to_string(sb.port()));
+        uint8_t buf[64] = {};
+        report.add(bench::measure("udp loopback send + receive, 40 bytes", [&](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                sa.send(to, buf, 40);
+                bench::do_not_optimize(sb.receive(buf, sizeof buf));
+            }
+        }));
+    }
+
+    // Two client sockets per match; ask for the hard descriptor limit.
+    rlimit files{};
+    getrlimit(RLIMIT_NOFILE, &files);
+    files.rlim_cur = files.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &files);
+    getrlimit(RLIMIT_NOFILE, &files);
+    unsigned matches = static_cast<unsigned>(std::min<rlim_t>(2048, (files.rlim_cur - 64) / 2));
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    run_server_load(report, level, in_a, 1, matches);
+    run_server_load(report, level, in_a, std::max(4u, hw), matches);
+    return 0;
+}
@@ -0,0 +1,251 @@
+// Tower draw cost: the projection-table renderer against evaluating sin/cos
+// for every brick of every column each frame; then the cost of profiling a
+// whole frame loop, and of drawing interpolated snapshots of a sim running
+// on its own thread, and of rasterizing frames on the CPU. `--trace PATH` also writes the profiled frames as a
+// Chrome trace.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "bench.h"
+#include "core/profiler.h"
+#include "render/interpolate.h"
+#include "render/renderer.h"
+#include "render/software_backend.h"
+#include "render/tower_renderer.h"
+#include "sim/game_sim.h"
+#include "sim/sim_thread.h"
+
+using namespace toppler;
+
+namespace {
+
+LevelData make_level() {
+    LevelData d;
+    d.grid = TowerGrid(128);
+    for (int r = 0; r < 128; ++r) {
+        for (int c = 0; c < kTowerColumns; ++c) {
+            int v = (r * 7 + c * 3) % 11;
+            d.grid.set(r, c, v < 6 ? Tile::Empty : static_cast<Tile>(v - 5));
+        }
+    }
+    d.start_row = 60;
+    return d;
+}
+
+// What the table replaces: trigonometry per brick, back faces culled after
+// the fact.
+void draw_with_trig(const ScreenLayout& screen, const Level& level, const SimState& state,
+                    DrawList& out) {
+    constexpr double kTwoPi = 6.283185307179586;
+    const double step = kTwoPi / kTowerColumns;
+    double view = state.session.tower_angle * step;
+    float camera = state.player.height + 1.0f;
+    int half_rows = screen.height / (2 * screen.row_height) + 1;
+    for (int row = 0; row < level.grid.rows; ++row) {
+        if (std::abs(row - static_cast<int>(camera)) > half_rows) continue;
+        int y = static_cast<int>(screen.height / 2 - (row + 1.0f - camera) * screen.row_height);
+        for (int col = 0; col < kTowerColumns; ++col) {
+            double a0 = col * step - view;
+            double a1 = a0 + step;
+            double mid = (a0 + a1) * 0.5;
+            if (std::cos(mid) <= 0.0) continue;
+            int x0 = screen.tower.center_x + static_cast<int>(screen.tower.radius * std::sin(a0));
+            int x1 = screen.tower.center_x + static_cast<int>(screen.tower.radius * std::sin(a1));
+            uint8_t shade = static_cast<uint8_t>(64 + 191 * std::cos(mid));
+            out.push(Quad{static_cast<int16_t>(x0), static_cast<int16_t>(y),
+                          static_cast<int16_t>(x1 - x0), static_cast<int16_t>(screen.row_height),
+                          tile_sprite(level.grid.at(row, col)), Layer::Tower, shade});
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bench::Report report("render_bench", argc, argv);
+    LevelData data = make_level();
+    Level level = data.view();
+    SimState state;
+    sim_init(level, 1, state);
+
+    int worst = 0;
+    for (int i = 0; i < kAngleSteps; ++i) {
+        double ref = std::sin(6.283185307179586 * i / kAngleSteps) * kTrigOne;
+        worst = std::max(worst, static_cast<int>(std::lround(std::fabs(ref - sin_q14(i)))));
+    }
+    report.line("constexpr sine table: %d entries, max error %d/%d", kAngleSteps, worst, kTrigOne);
+
+    TowerRenderer renderer;
+    report.line("projection table bytes: %zu", sizeof(ProjectedRing) * kAngleSteps);
+
+    DrawList list;
+    list.reserve(4096);
+    uint64_t quads = 0;
+    report.add(bench::measure("tower_draw/projection_table", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            state.session.tower_angle = static_cast<float>(i % 1024) / 64.0f;
+            list.clear();
+            renderer.draw(level, state, list);
+            quads += list.size();
+        }
+    }));
+    report.add(bench::measure("tower_draw/trig_per_brick", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            state.session.tower_angle = static_cast<float>(i % 1024) / 64.0f;
+            list.clear();
+            draw_with_trig(renderer.screen(), level, state, list);
+            quads += list.size();
+        }
+    }));
+    bench::do_not_optimize(quads);
+
+    // Full frames through the atlas batcher.
+    NullBackend backend;
+    Renderer frame(backend, renderer.screen());
+    report.line("atlas: %dx%d, %d sprites", frame.atlas().image().width, frame.atlas().image().height,
+                static_cast<int>(SpriteId::kCount));
+    frame.render(level, state);
+    report.line("frame: %u quads in %u draw calls (one blit per sprite would be %u calls)",
+                frame.stats().quads, frame.stats().draw_calls, frame.stats().quads);
+    report.add(bench::measure("frame/build_and_batch", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            state.session.tower_angle = static_cast<float>(i % 1024) / 64.0f;
+            frame.render(level, state);
+        }
+    }));
+
+    // A game frame (one sim tick, one render) with and without the profiler
+    // bound and its overlay on screen.
+    const char* trace_path = nullptr;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--trace") == 0) trace_path = argv[i + 1];
+    }
+    GameSim game(level, 3);
+    auto game_frame = [&](uint64_t i) {
+        game.step((i / 40) % 3 == 0 ? kInputLeft : kInputRight | ((i % 29) == 0 ? kInputJump : 0));
+        if (game.finished()) game.reset(3);
+        frame.render(level, game.state());
+    };
+    report.add(bench::measure("game_frame/unprofiled", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) game_frame(i);
+    }));
+    Profiler profiler;
+    frame.set_profiler(&profiler);
+    {
+        ProfilerBinding bind(&profiler);
+        auto profiled = [&](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                profiler.begin_frame();
+                game_frame(i);
+                profiler.end_frame();
+            }
+        };
+        report.add(bench::measure("game_frame/profiled", profiled));
+        frame.toggle_profiler_overlay();
+        report.add(bench::measure("game_frame/profiled_with_overlay", profiled));
+    }
+    double mean_us[kProfileZones];
+    profiler.zone_averages_us(mean_us, 240);
+    for (int z = 0; z < kProfileZones; ++z) {
+        report.line("  %-14s %8.2f us/frame", profile_zone_name(static_cast<ProfileZone>(z)), mean_us[z]);
+    }
+    report.line("overlay frame: %u quads in %u draw calls", frame.stats().quads, frame.stats().draw_calls);
+    if (trace_path) {
+        write_chrome_trace(profiler, trace_path);
+        report.line("trace written to %s", trace_path);
+    }
+    frame.toggle_profiler_overlay();
+    frame.set_profiler(nullptr);
+
+    // The HUD is rebuilt only when its numbers change (the clock, once a
+    // second), the backdrop never; both cost one or two quads otherwise.
+    uint64_t hud_before = frame.hud_layer().uploads();
+    for (uint64_t i = 0; i < 600; ++i) game_frame(i);
+    report.line("cached layers: hud redrawn %llu times in 600 frames",
+                static_cast<unsigned long long>(frame.hud_layer().uploads() - hud_before));
+
+    // CPU rasterizer: per-pixel blitting against run-based SIMD spans, then
+    // the spans across threads. Every frame must match per-pixel exactly.
+    for (const ScreenLayout& layout : {ScreenLayout{}, ScreenLayout{960, 600, 48, TowerLayout{480, 288}}}) {
+        std::string size = std::to_string(layout.width) + "x" + std::to_string(layout.height);
+        SoftwareBackendOptions per_pixel;
+        per_pixel.per_pixel = true;
+        SoftwareBackendOptions threaded;
+        threaded.threads = 0;
+        SoftwareBackend ref(layout.width, layout.height, per_pixel);
+        SoftwareBackend spans(layout.width, layout.height);
+        SoftwareBackend bands(layout.width, layout.height, threaded);
+        Renderer ref_frame(ref, layout), span_frame(spans, layout), band_frame(bands, layout);
+        GameSim sim(level, 5);
+        int mismatched = 0;
+        for (int i = 0; i < 240; ++i) {
+            sim.step((i / 50) % 2 ? kInputLeft : kInputRight | ((i % 37) == 0 ? kInputJump : 0));
+            ref_frame.render(level, sim.state());
+            span_frame.render(level, sim.state());
+            band_frame.render(level, sim.state());
+            mismatched += ref.frame().pixels != spans.frame().pixels || ref.frame().pixels != bands.frame().pixels;
+        }
+        report.line("software %s: %d of 240 frames differ from per-pixel (%u quads/frame)", size.c_str(), mismatched,
+                    span_frame.stats().quads);
+        report.expect(mismatched == 0, "span or banded rasterizer differs from per-pixel");
+        SimState shown = sim.state();
+        auto frames = [&](Renderer& r) {
+            return [&](uint64_t iters) {
+                for (uint64_t i = 0; i < iters; ++i) {
+                    shown.session.tower_angle = static_cast<float>(i % 1024) / 64.0f;
+                    r.render(level, shown);
+                }
+            };
+        };
+        report.add(bench::measure("software_frame/" + size + "/per_pixel", frames(ref_frame)));
+        report.add(bench::measure("software_frame/" + size + "/spans_1t", frames(span_frame)));
+        report.add(bench::measure("software_frame/" + size + "/spans_" + std::to_string(bands.threads()) + "t",
+                                  frames(band_frame)));
+    }
+
+    // Sim on its own thread at 60 Hz, frames drawn from interpolated
+    // snapshots at display rates that do not divide it.
+    SimState a = game.state();
+    game.step(kInputRight);
+    SimState b = game.state();
+    SimState blended;
+    report.add(bench::measure("interpolate_state", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            interpolate_state(a, b, static_cast<float>(i & 15) / 16.0f, blended);
+            bench::do_not_optimize(blended.player.angle);
+        }
+    }));
+    for (int hz : {144, 50}) {
+        using clock = std::chrono::steady_clock;
+        SimThread sim(level, 3);
+        FrameArena arena;
+        TickEvents events;
+        auto period = std::chrono::nanoseconds(1000000000 / hz);
+        auto start = clock::now();
+        auto next = start;
+        int frames = 0;
+        uint32_t shown = 0, last_tick = 0;
+        for (; frames < hz; ++frames) {
+            sim.set_input((frames / (hz / 2)) % 2 ? kInputLeft : kInputRight);
+            while (sim.pop_tick_events(arena, events)) frame.add_events(events);
+            if (const SimSnapshot* snap = sim.snapshot()) {
+                shown += snap->current.session.tick != last_tick;
+                last_tick = snap->current.session.tick;
+                interpolate_state(snap->previous, snap->current, SimThread::alpha(*snap, clock::now()), blended);
+                frame.render(level, blended);
+            }
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+        double secs = std::chrono::duration<double>(clock::now() - start).count();
+        SimThreadStats st = sim.stats();
+        report.line("decoupled %3d Hz display: %d frames, %.1f sim ticks/s, %u distinct ticks drawn, %llu skipped",
+                    hz, frames, st.ticks / secs, shown, static_cast<unsigned long long>(st.skipped_ticks));
+    }
+    return report.status();
+}
@@ -0,0 +1,261 @@
+// Replay size and speed: input-only encoding versus full-state recording,
+// encode / decode cost, seeking with and without keyframes, the cost of
+// snapshotting and rolling back a SimState, per-tick desync hashing, and the
+// submarine stage's tick and verification cost.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "core/rng.h"
+#include "replay/replay.h"
+#include "replay/verify.h"
+#include "sim/game_sim.h"
+#include "sim/rewind.h"
+#include "sim/state_hash.h"
+#include "sim/sub_stage.h"
+#include "tower/level_text.h"
+
+using namespace toppler;
+
+#ifndef TT_SOURCE_DIR
+#define TT_SOURCE_DIR "."
+#endif
+
+namespace {
+
+constexpr uint32_t kTicks = 2 * 60 * kTicksPerSecond;  // a two minute climb
+constexpr uint32_t kKeyframeInterval = 10 * kTicksPerSecond;
+
+// Held inputs of a few frames to a second, roughly how people play.
+std::vector<InputMask> human_inputs(uint32_t seed) {
+    std::vector<InputMask> out;
+    uint32_t rng = rng_seed(seed);
+    while (out.size() < kTicks) {
+        uint32_t r = rng_next(rng);
+        InputMask m = (r & 3) == 0 ? kInputLeft : kInputRight;
+        if ((r >> 2) % 3 == 0) m |= kInputJump;
+        if ((r >> 4) % 5 == 0) m |= kInputFire;
+        if ((r >> 7) % 7 == 0) m = kInputUp;
+        uint32_t hold = 4 + rng_below(rng, 40);
+        for (uint32_t i = 0; i < hold && out.size() < kTicks; ++i) out.push_back(m);
+    }
+    return out;
+}
+
+Replay record(const Level& level, const std::vector<InputMask>& inputs, uint32_t interval) {
+    ReplayRecorder rec(level, 7, interval);
+    SimState state;
+    sim_init(level, 7, state);
+    for (InputMask m : inputs) {
+        sim_step(level, state, m);
+        rec.record(m, state);
+    }
+    return rec.finish(state);
+}
+
+// Submarine stage autopilot: line up with the nearest fish ahead and fire.
+InputMask sub_pilot(const SubState& s) {
+    float x = s.scroll + s.sub.x, best = 1e9f, target = s.sub.y;
+    for (int i = 0; i < s.fish.pool.count; ++i) {
+        if (s.fish.x[i] > x && s.fish.x[i] < best) {
+            best = s.fish.x[i];
+            target = s.fish.y[i];
+        }
+    }
+    InputMask m = kInputFire;
+    if (target > s.sub.y + 0.1f) m |= kInputUp;
+    if (target < s.sub.y - 0.1f) m |= kInputDown;
+    return m;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bench::Report report("replay_bench", argc, argv);
+    LevelData data = load_level_text(std::string(TT_SOURCE_DIR) + "/levels/campaign/04_eye_spire.tower");
+    Level level = data.view();
+    std::vector<InputMask> inputs = human_inputs(1);
+
+    Replay plain = record(level, inputs, 0);
+    Replay seekable = record(level, inputs, kKeyframeInterval);
+    std::vector<uint8_t> plain_bytes = encode_replay(plain);
+    std::vector<uint8_t> seekable_bytes = encode_replay(seekable);
+    size_t full_state = size_t{kTicks} * sizeof(SimState);
+
+    // Round trip and seeking must reproduce straight playback exactly.
+    int mismatches = 0;
+    {
+        Replay decoded = decode_replay(seekable_bytes.data(), seekable_bytes.size());
+        if (decoded.input_ticks() != kTicks || decoded.keyframes.size() != seekable.keyframes.size()) ++mismatches;
+        for (size_t i = 0; i < decoded.keyframes.size() && i < seekable.keyframes.size(); ++i) {
+            if (std::memcmp(&decoded.keyframes[i].state, &seekable.keyframes[i].state, sizeof(SimState)) != 0) {
+                ++mismatches;
+            }
+        }
+        ReplayPlayer linear(level, plain);
+        ReplayPlayer seeking(level, decoded);
+        for (uint32_t t : {kTicks / 3, kTicks - 1, 100u, kTicks}) {
+            linear.seek(t);
+            seeking.seek(t);
+            if (std::memcmp(&linear.state(), &seeking.state(), sizeof(SimState)) != 0) ++mismatches;
+        }
+        if (linear.state().session.score != plain.result.score) ++mismatches;
+    }
+    report.line("round trip + seek check: %d mismatches", mismatches);
+    report.expect(mismatches == 0, "replay round trip or seek differs from straight playback");
+
+    report.line("%u ticks, %zu input runs, SimState %zu bytes", kTicks, plain.inputs.size(), sizeof(SimState));
+    report.line("full-state recording                 %9zu bytes", full_state);
+    report.line("input-only replay                    %9zu bytes  (%.0fx smaller)", plain_bytes.size(),
+                static_cast<double>(full_state) / static_cast<double>(plain_bytes.size()));
+    report.line("with keyframes every %4u ticks      %9zu bytes  (%zu keyframes)", kKeyframeInterval,
+                seekable_bytes.size(), seekable.keyframes.size());
+
+    report.add(bench::measure("encode input-only replay", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) bench::do_not_optimize(encode_replay(plain));
+    }));
+    report.add(bench::measure("decode input-only replay", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            bench::do_not_optimize(decode_replay(plain_bytes.data(), plain_bytes.size()));
+        }
+    }));
+    report.add(bench::measure("decode replay with keyframes", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            bench::do_not_optimize(decode_replay(seekable_bytes.data(), seekable_bytes.size()));
+        }
+    }));
+
+    // Jump to the last few seconds, as when checking how a run ended.
+    uint32_t target = kTicks - 3 * kTicksPerSecond;
+    report.add(bench::measure("seek near end, from tick 0", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            ReplayPlayer p(level, plain);
+            p.seek(target);
+            bench::do_not_optimize(p.state().session.score);
+        }
+    }));
+    report.add(bench::measure("seek near end, via keyframe", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            ReplayPlayer p(level, seekable);
+            p.seek(target);
+            bench::do_not_optimize(p.state().session.score);
+        }
+    }));
+
+    // Branching (planner), seeking and rewind all come down to these copies.
+    ReplayPlayer mid(level, plain);
+    mid.seek(kTicks / 2);
+    SimState live = mid.state(), snapshot;
+    report.add(bench::measure("snapshot + restore SimState", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            snapshot = live;
+            bench::clobber_memory();
+            live = snapshot;
+            bench::clobber_memory();
+        }
+    }));
+    RewindBuffer rewind;
+    GameSim game(level, 7);
+    size_t next_input = 0;
+    report.add(bench::measure("sim tick + rewind snapshot", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            game.step(inputs[next_input]);
+            next_input = next_input + 1 == inputs.size() ? 0 : next_input + 1;
+            if (game.finished()) game.reset(7);
+            rewind.push(game.state());
+        }
+    }));
+    // Step back a second, restore, and resume recording from there.
+    report.add(bench::measure("rewind 1 s + restore + resume, per tick", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            rewind.rewind(kTicksPerSecond, snapshot);
+            game.restore(snapshot);
+            for (uint32_t k = 0; k < kTicksPerSecond; ++k) rewind.push(game.state());
+        }
+    }, kTicksPerSecond));
+
+    // Desync hashing. The incremental world hash must match a recount on
+    // every tick, and a one-ulp change to any live value must change that
+    // tick's hash.
+    {
+        int drift = 0, missed = 0;
+        SimState state;
+        sim_init(level, 7, state);
+        for (uint32_t t = 0; t < kTicks; ++t) {
+            sim_step(level, state, inputs[t]);
+            if (state.session.world_hash != world_hash(state)) ++drift;
+            if (t % 97 == 0) {
+                SimState bent = state;
+                if (bent.enemies.pool.count) {
+                    uint32_t u;
+                    std::memcpy(&u, &bent.enemies.height[t % bent.enemies.pool.count], 4);
+                    u ^= 1;
+                    std::memcpy(&bent.enemies.height[t % bent.enemies.pool.count], &u, 4);
+                } else {
+                    bent.player.vy = std::nextafter(bent.player.vy, 1.0f);
+                }
+                if (tick_hash(bent) == tick_hash(state)) ++missed;
+            }
+        }
+        report.line("world hash drift: %d ticks, single-ulp changes missed: %d", drift, missed);
+    }
+    report.add(bench::measure("state_hash (whole SimState)", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            bench::do_not_optimize(state_hash(live));
+            bench::clobber_memory();
+        }
+    }));
+    report.add(bench::measure("tick_hash (incremental)", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            bench::do_not_optimize(tick_hash(live));
+            bench::clobber_memory();
+        }
+    }));
+    report.line("  %d live enemies in the hashed state", live.enemies.pool.count);
+
+    // Submarine stage: record an autopiloted run, verify it, and time a tick.
+    // A ten-minute stage shows the state stays the same flat block.
+    for (uint16_t seconds : {uint16_t{40}, uint16_t{600}}) {
+        SubStage stage = sub_stage_after(3);
+        stage.time_limit = seconds;
+        ReplayRecorder rec(stage, 7);
+        SubState sub;
+        sub_init(stage, 7, sub);
+        int most_fish = 0;
+        while (sub.session.status == SimStatus::Playing) {
+            InputMask m = sub_pilot(sub);
+            sub_step(stage, sub, m);
+            rec.record(m, sub);
+            most_fish = std::max(most_fish, static_cast<int>(sub.fish.pool.count));
+        }
+        Replay run = rec.finish(sub);
+        std::vector<uint8_t> bytes = encode_replay(run);
+        Replay decoded = decode_replay(bytes.data(), bytes.size());
+        Verdict v = verify_replay(stage, decoded);
+        report.line("submarine %3us: %u ticks, score %u, %u fish shot, %u hits, <= %d fish live, %u segments; "
+                    "SubState %zu bytes; verify %s",
+                    seconds, sub.session.tick, sub.session.score, sub.session.fish_shot, sub.session.hits, most_fish,
+                    sub.first_segment + kSubRingSegments, sizeof(SubState), verdict_status_name(v.status));
+    }
+    SubStage stage = sub_stage_after(3);
+    SubState sub;
+    sub_init(stage, 7, sub);
+    report.add(bench::measure("submarine stage tick", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            if (sub.session.status != SimStatus::Playing) sub_init(stage, 7, sub);
+            sub_step(stage, sub, sub_pilot(sub));
+        }
+    }));
+    report.add(bench::measure("tower sim tick, for comparison", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            game.step(inputs[next_input]);
+            next_input = next_input + 1 == inputs.size() ? 0 : next_input + 1;
+            if (game.finished()) game.reset(7);
+        }
+    }));
+    return report.status();
+}
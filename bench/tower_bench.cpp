@@ -0,0 +1,227 @@
+// The regression suite run before a build goes to cabinets: one target, one
+// report (bench_output.txt). Covers sim ticks per second on every campaign
+// tower, tower projection / frame build time, level load time, replay encode
+// and decode throughput, and batch-sim scaling from 1 to N threads.
+//
+// Every tower is played along a route found by the planner, so the sim runs
+// the jumps, lifts and enemies a real climb does rather than idling at the
+// start. The narrower *_bench targets dig into single subsystems.
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai/planner.h"
+#include "bench.h"
+#include "core/rng.h"
+#include "core/thread_pool.h"
+#include "render/renderer.h"
+#include "replay/replay.h"
+#include "sim/enemy_kernel.h"
+#include "sim/game_sim.h"
+#include "sim/sim_batch.h"
+#include "tower/level_pack.h"
+#include "tower/level_text.h"
+
+// Set by the build to the repo-root report path.
+#ifndef TT_BENCH_OUTPUT
+#define TT_BENCH_OUTPUT "bench_output.txt"
+#endif
+
+using namespace toppler;
+namespace fs = std::filesystem;
+
+#ifndef TT_SOURCE_DIR
+#define TT_SOURCE_DIR "."
+#endif
+
+namespace {
+
+constexpr size_t kBatchSessions = 4096;
+
+struct Tower {
+    std::string file;
+    std::string text;
+    LevelData data;
+    Level level;
+    std::vector<InputMask> route;  // empty if the planner found none
+};
+
+std::vector<Tower> load_campaign() {
+    std::vector<std::string> files;
+    for (const auto& entry : fs::directory_iterator(std::string(TT_SOURCE_DIR) + "/levels/campaign")) {
+        if (entry.path().extension() == ".tower") files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+    std::vector<Tower> towers(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        towers[i].file = files[i];
+        towers[i].data = load_level_text(files[i]);
+        towers[i].text = format_level_text(towers[i].data);
+        towers[i].level = towers[i].data.view();
+    }
+    return towers;
+}
+
+// Inputs for `ticks` of play: the route, then idling if it ends sooner.
+InputMask route_input(const Tower& t, uint64_t tick) { return tick < t.route.size() ? t.route[tick] : 0; }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bench::Report report("tower_bench", argc, argv, TT_BENCH_OUTPUT);
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    report.line("build: %s, sim version %u, enemy kernel %s, %u hardware threads", __VERSION__, kSimVersion,
+                kernel_isa_name(kernel_isa()), hw);
+
+    std::vector<Tower> towers = load_campaign();
+    Planner planner;
+    for (Tower& t : towers) {
+        PlanResult plan = planner.plan(t.level);
+        t.route = std::move(plan.inputs);
+        report.line("tower %-24s %3d rows, %2u spawns, route %5zu ticks%s", t.data.name.c_str(), t.level.grid.rows,
+                    t.level.spawn_count, t.route.size(), plan.solved ? "" : " (unsolved)");
+    }
+
+    // --- sim ---------------------------------------------------------------
+    for (const Tower& t : towers) {
+        GameSim game(t.level, 1);
+        uint64_t tick = 0;
+        report.add(bench::measure("sim_tick/" + t.data.name, [&](uint64_t iters) {
+            for (uint64_t n = 0; n < iters; ++n) {
+                if (game.finished() || tick == t.route.size()) {
+                    game.reset(1);
+                    tick = 0;
+                }
+                game.step(route_input(t, tick++));
+            }
+        }));
+    }
+
+    // --- projection and frame build -----------------------------------------
+    NullBackend backend;
+    Renderer renderer(backend);
+    DrawList list;
+    list.reserve(4096);
+    for (const Tower& t : towers) {
+        // Frames sampled along the route so the camera climbs the tower.
+        std::vector<SimState> frames;
+        GameSim game(t.level, 1);
+        for (uint64_t tick = 0; tick < t.route.size() && !game.finished(); ++tick) {
+            game.step(t.route[tick]);
+            if (tick % 30 == 0) frames.push_back(game.state());
+        }
+        if (frames.empty()) frames.push_back(game.state());
+        size_t next = 0;
+        report.add(bench::measure("tower_draw/" + t.data.name, [&](uint64_t iters) {
+            for (uint64_t n = 0; n < iters; ++n) {
+                list.clear();
+                renderer.tower().draw(t.level, frames[next], list);
+                next = next + 1 == frames.size() ? 0 : next + 1;
+            }
+            bench::do_not_optimize(list.size());
+        }));
+        report.add(bench::measure("frame/" + t.data.name, [&](uint64_t iters) {
+            for (uint64_t n = 0; n < iters; ++n) {
+                renderer.render(t.level, frames[next]);
+                next = next + 1 == frames.size() ? 0 : next + 1;
+            }
+        }));
+    }
+
+    // --- level load ----------------------------------------------------------
+    std::vector<LevelData> datas;
+    size_t text_bytes = 0;
+    for (const Tower& t : towers) {
+        datas.push_back(t.data);
+        text_bytes += t.text.size();
+    }
+    std::vector<uint8_t> pack_bytes = build_level_pack(datas);
+    report.line("campaign: %zu towers, %zu text bytes, %zu pack bytes", towers.size(), text_bytes, pack_bytes.size());
+    report.add(bench::measure("level_load/parse_text_all", [&](uint64_t iters) {
+        for (uint64_t n = 0; n < iters; ++n) {
+            for (const Tower& t : towers) bench::do_not_optimize(parse_level_text(t.text, t.file).grid.rows());
+        }
+    }));
+    std::string pack_path = (fs::temp_directory_path() / "tower_bench.ttpk").string();
+    write_level_pack(pack_path, datas);
+    report.add(bench::measure("level_load/mmap_pack_all", [&](uint64_t iters) {
+        for (uint64_t n = 0; n < iters; ++n) {
+            LevelPack pack = LevelPack::open(pack_path);
+            for (size_t i = 0; i < pack.size(); ++i) bench::do_not_optimize(pack.tower(i).grid.rows);
+        }
+    }));
+    fs::remove(pack_path);
+
+    // --- replays ---------------------------------------------------------------
+    std::vector<Replay> replays;
+    size_t replay_ticks = 0;
+    for (const Tower& t : towers) {
+        ReplayRecorder recorder(t.level, 1);
+        SimState state;
+        sim_init(t.level, 1, state);
+        for (InputMask m : t.route) {
+            sim_step(t.level, state, m);
+            recorder.record(m, state);
+        }
+        replays.push_back(recorder.finish(state));
+        replay_ticks += t.route.size();
+    }
+    size_t encoded_bytes = 0;
+    std::vector<std::vector<uint8_t>> encoded;
+    for (const Replay& r : replays) {
+        encoded.push_back(encode_replay(r));
+        encoded_bytes += encoded.back().size();
+    }
+    report.line("replays: %zu routes, %zu ticks, %zu bytes encoded", replays.size(), replay_ticks, encoded_bytes);
+    bench::Result enc = bench::measure("replay/encode_all", [&](uint64_t iters) {
+        for (uint64_t n = 0; n < iters; ++n) {
+            for (const Replay& r : replays) bench::do_not_optimize(encode_replay(r).size());
+        }
+    });
+    report.add(enc);
+    bench::Result dec = bench::measure("replay/decode_all", [&](uint64_t iters) {
+        for (uint64_t n = 0; n < iters; ++n) {
+            for (const std::vector<uint8_t>& b : encoded) bench::do_not_optimize(decode_replay(b.data(), b.size()).seed);
+        }
+    });
+    report.add(dec);
+    report.line("  encode %.1f MB/s, decode %.1f MB/s of replay data", encoded_bytes * 1e3 / enc.ns_per_op,
+                encoded_bytes * 1e3 / dec.ns_per_op);
+
+    // --- batch scaling -----------------------------------------------------------
+    // Sessions spread over the campaign towers, each following its route.
+    std::vector<InputMask> inputs(kBatchSessions);
+    std::vector<uint64_t> ticks(kBatchSessions);
+    double base = 0.0;
+    for (unsigned threads = 1;; threads = threads * 2 > hw && threads < hw ? hw : threads * 2) {
+        ThreadPool pool(threads);
+        SimBatch batch(kBatchSessions);
+        for (size_t i = 0; i < kBatchSessions; ++i) {
+            batch.reset(i, towers[i % towers.size()].level, static_cast<uint32_t>(i + 1));
+            ticks[i] = 0;
+        }
+        char name[64];
+        std::snprintf(name, sizeof name, "batch_tick/%ut", threads);
+        bench::Result r = bench::measure(name, [&](uint64_t iters) {
+            for (uint64_t n = 0; n < iters; ++n) {
+                for (size_t i = 0; i < kBatchSessions; ++i) {
+                    const Tower& t = towers[i % towers.size()];
+                    if (batch.finished(i) || ticks[i] >= t.route.size()) {
+                        batch.reset(i, t.level, static_cast<uint32_t>(i + 1));
+                        ticks[i] = 0;
+                    }
+                    inputs[i] = route_input(t, ticks[i]++);
+                }
+                batch.step(inputs.data(), &pool);
+            }
+        }, kBatchSessions);
+        report.add(r);
+        if (threads == 1) base = r.ns_per_op;
+        report.line("  speedup vs 1 thread: %.2fx", base / r.ns_per_op);
+        if (threads >= hw) break;
+    }
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include "ai/planner.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "sim/game_sim.h"
+
+namespace toppler {
+
+namespace {
+
+// Inputs tried from every node. Fixed order, so plans are reproducible.
+constexpr InputMask kActions[] = {
+    kInputRight,
+    kInputLeft,
+    kInputRight | kInputJump,
+    kInputLeft | kInputJump,
+    kInputJump,
+    kInputUp,
+    kInputUp | kInputRight,
+    kInputUp | kInputLeft,
+    kInputDown,
+    kInputRight | kInputFire,
+    kInputLeft | kInputFire,
+    0,
+};
+constexpr uint32_t kActionCount = sizeof kActions / sizeof kActions[0];
+
+constexpr uint32_t kNoTrail = 0xffffffffu;
+constexpr int kMaxProbes = 16;
+
+// Climb progress: the highest row reached, then the current height.
+int64_t progress(const SimState& s) {
+    return int64_t{s.player.best_row} * 1024 + static_cast<int64_t>(s.player.height * 16.0f);
+}
+
+inline uint64_t mix(uint64_t h, uint64_t v) {
+    h = (h ^ v) * 0xff51afd7ed558ccdull;
+    return h ^ (h >> 29);
+}
+
+}  // namespace
+
+uint64_t plan_key(const SimState& state) {
+    const PlayerState& p = state.player;
+    // Eighth-of-a-column / eighth-of-a-row cells: finer than one tick of
+    // walking, coarse enough that float noise does not defeat the table.
+    uint64_t where = uint64_t{static_cast<uint8_t>(static_cast<int>(p.angle * 8.0f))} |
+                     uint64_t{static_cast<uint16_t>(static_cast<int>(p.height * 8.0f))} << 8 |
+                     uint64_t{static_cast<uint8_t>(static_cast<int>(p.vy * 16.0f))} << 24 |
+                     uint64_t{static_cast<uint8_t>(p.mode)} << 32 | uint64_t{static_cast<uint8_t>(p.facing)} << 40 |
+                     uint64_t{p.elevator} << 48 | uint64_t{state.session.lives} << 56;
+    uint64_t h = mix(0x9e3779b97f4a7c15ull, where);
+    h = mix(h, uint64_t{p.timer} >> 2 | uint64_t{p.invulnerable > 0} << 16);
+    const unsigned char* broken = reinterpret_cast<const unsigned char*>(state.broken.rows);
+    for (size_t i = 0; i < sizeof state.broken.rows; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, broken + i, 8);
+        if (w) h = mix(h, w ^ i);
+    }
+    return h | 1;  // 0 marks an empty table slot
+}
+
+Planner::Planner(PlannerConfig config)
+    : config_(config),
+      table_(size_t{1} << config.table_bits),
+      table_mask_((uint64_t{1} << config.table_bits) - 1),
+      beam_(config.beam_width),
+      next_(size_t{config.beam_width} * kActionCount),
+      keys_(next_.size()) {
+    order_.reserve(next_.size());
+}
+
+bool Planner::seen_before(uint64_t key) const {
+    for (int i = 0; i < kMaxProbes; ++i) {
+        uint64_t slot = table_[(key + i) & table_mask_];
+        if (slot == key) return true;
+        if (slot == 0) return false;
+    }
+    return false;
+}
+
+// Returns false if `key` was already there. A crowded probe run evicts its
+// first entry: the table is a cache, losing a key only costs re-expansion.
+bool Planner::remember(uint64_t key) {
+    for (int i = 0; i < kMaxProbes; ++i) {
+        uint64_t& slot = table_[(key + i) & table_mask_];
+        if (slot == key) return false;
+        if (slot == 0) {
+            slot = key;
+            return true;
+        }
+    }
+    table_[key & table_mask_] = key;
+    return true;
+}
+
+std::vector<InputMask> Planner::route(uint32_t trail, InputMask last, uint32_t last_ticks) const {
+    std::vector<InputMask> held;
+    for (uint32_t t = trail; t != kNoTrail; t = trail_[t].parent) held.push_back(trail_[t].input);
+    std::vector<InputMask> inputs;
+    inputs.reserve(held.size() * config_.hold_ticks + last_ticks);
+    for (auto it = held.rbegin(); it != held.rend(); ++it) inputs.insert(inputs.end(), config_.hold_ticks, *it);
+    inputs.insert(inputs.end(), last_ticks, last);
+    return inputs;
+}
+
+PlanResult Planner::plan(const Level& level) {
+    PlanResult result;
+    PlanStats& stats = result.stats;
+    std::fill(table_.begin(), table_.end(), 0);
+    trail_.clear();
+
+    uint32_t limit = config_.max_ticks ? config_.max_ticks : uint32_t{level.time_limit} * kTicksPerSecond;
+    sim_init(level, config_.seed, beam_[0].state);
+    beam_[0].trail = kNoTrail;
+    remember(plan_key(beam_[0].state));
+    uint8_t lives = beam_[0].state.session.lives;
+    uint8_t min_lives = static_cast<uint8_t>(lives - std::min(config_.max_lives_lost, lives));
+    result.best_row = beam_[0].state.player.best_row;
+
+    size_t beam_count = 1;
+    while (beam_count > 0) {
+        ++stats.layers;
+        order_.clear();
+        size_t n = 0;
+        for (size_t b = 0; b < beam_count; ++b) {
+            ++stats.expanded;
+            for (InputMask input : kActions) {
+                Node& c = next_[n];
+                c.state = beam_[b].state;
+                uint32_t held = 0;
+                while (held < config_.hold_ticks && c.state.session.status == SimStatus::Playing) {
+                    sim_step(level, c.state, input);
+                    ++held;
+                }
+                stats.ticks += held;
+                const SessionState& session = c.state.session;
+                result.best_row = std::max<int>(result.best_row, c.state.player.best_row);
+                if (session.status == SimStatus::Complete && session.tick <= limit) {
+                    result.solved = true;
+                    result.ticks = session.tick;
+                    result.score = session.score;
+                    result.inputs = route(beam_[b].trail, input, held);
+                    return result;
+                }
+                if (session.status != SimStatus::Playing || session.lives < min_lives || session.tick >= limit) {
+                    ++stats.dead;
+                    continue;
+                }
+                uint64_t key = plan_key(c.state);
+                if (seen_before(key)) {
+                    ++stats.transpositions;
+                    continue;
+                }
+                keys_[n] = key;
+                order_.push_back(Candidate{progress(c.state), static_cast<uint32_t>(n), beam_[b].trail, input});
+                ++n;
+            }
+        }
+
+        std::sort(order_.begin(), order_.end(), [](const Candidate& a, const Candidate& b) {
+            return a.value != b.value ? a.value > b.value : a.index < b.index;
+        });
+        beam_count = 0;
+        for (const Candidate& c : order_) {
+            if (!remember(keys_[c.index])) {
+                ++stats.transpositions;  // a sibling in this layer got there first
+                continue;
+            }
+            Node& node = beam_[beam_count];
+            node.state = next_[c.index].state;
+            trail_.push_back(TrailStep{c.parent, c.input});
+            node.trail = static_cast<uint32_t>(trail_.size() - 1);
+            if (++beam_count == config_.beam_width) break;
+        }
+    }
+    return result;
+}
+
+}  // namespace toppler
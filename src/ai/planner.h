@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "sim/input.h"
+#include "sim/sim_state.h"
+#include "tower/level.h"
+
+namespace toppler {
+
+// Headless route planner: finds inputs that climb a tower to its exit.
+//
+// Beam search over the real sim. Every node holds a full SimState (plain
+// data, so branching is a memcpy) and is expanded by holding each of a
+// fixed set of inputs for a few ticks; timed jumps, lift rides and tunnels
+// come out of the sim itself rather than special cases here. The best nodes
+// by climb progress survive each layer.
+//
+// A transposition table of compact state keys (quantized player position,
+// motion mode, crumbled bricks, lives) keeps the search from expanding a
+// situation it has already reached: a later visit can only be slower, so it
+// is dropped. One Planner reuses its buffers and table across towers;
+// use one per thread.
+
+struct PlannerConfig {
+    uint32_t beam_width = 64;
+    uint32_t hold_ticks = 6;     // ticks each input is held before branching again
+    uint32_t max_ticks = 0;      // 0: the tower's time limit
+    uint32_t table_bits = 18;    // transposition table of 2^table_bits keys
+    uint8_t max_lives_lost = 0;  // routes losing more lives than this are pruned
+    uint32_t seed = 1;           // session seed the route is planned for
+};
+
+struct PlanStats {
+    uint32_t layers = 0;
+    uint64_t expanded = 0;       // nodes branched from
+    uint64_t ticks = 0;          // sim ticks run
+    uint64_t transpositions = 0; // candidates dropped as already seen
+    uint64_t dead = 0;           // candidates dropped for lost lives / game over
+};
+
+struct PlanResult {
+    bool solved = false;
+    uint32_t ticks = 0;              // to the exit, if solved
+    uint32_t score = 0;              // final score, if solved
+    int best_row = 0;                // highest standing row any node reached
+    std::vector<InputMask> inputs;   // one per tick, from sim_init; empty unless solved
+    PlanStats stats;
+};
+
+class Planner {
+public:
+    explicit Planner(PlannerConfig config = {});
+
+    const PlannerConfig& config() const { return config_; }
+
+    // Plans a route through `level` (which must be valid).
+    PlanResult plan(const Level& level);
+
+private:
+    struct Node {
+        SimState state;
+        uint32_t trail;  // index into trail_ of the step that reached it
+    };
+    // How a surviving node was reached, for reading the route back.
+    struct TrailStep {
+        uint32_t parent;
+        InputMask input;
+    };
+    // A child in next_ waiting to be ranked.
+    struct Candidate {
+        int64_t value;
+        uint32_t index;   // into next_ and keys_
+        uint32_t parent;  // trail of the node it came from
+        InputMask input;
+    };
+
+    bool seen_before(uint64_t key) const;
+    bool remember(uint64_t key);
+    std::vector<InputMask> route(uint32_t trail, InputMask last, uint32_t last_ticks) const;
+
+    PlannerConfig config_;
+    std::vector<uint64_t> table_;  // open addressing, 0 = empty
+    uint64_t table_mask_;
+    std::vector<Node> beam_, next_;
+    std::vector<uint64_t> keys_;
+    std::vector<Candidate> order_;
+    std::vector<TrailStep> trail_;
+};
+
+// The key the planner deduplicates on. Exposed for tools and benches.
+uint64_t plan_key(const SimState& state);
+
+}  // namespace toppler
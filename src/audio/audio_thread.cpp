@@ -0,0 +1,63 @@
+#include "audio/audio_thread.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "core/profiler.h"
+
+namespace toppler {
+
+namespace {
+
+// Real-time FIFO scheduling, a little above the lowest RT priority. Needs CAP_SYS_NICE or
+// an rtprio limit; without either the thread keeps the default policy.
+bool make_realtime() {
+    sched_param param{};
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+}  // namespace
+
+void NullAudioSink::write(const int16_t*, size_t frames) {
+    using clock = std::chrono::steady_clock;
+    auto now = clock::now();
+    if (next_ < now) next_ = now;
+    next_ += std::chrono::nanoseconds(static_cast<int64_t>(frames * 1e9 / kAudioSampleRate));
+    std::this_thread::sleep_until(next_);
+}
+
+AudioThread::AudioThread(Mixer& mixer, AudioSink& sink, Profiler* profiler)
+    : mixer_(mixer), sink_(sink), profiler_(profiler), block_(new int16_t[sink.block_frames() * 2]),
+      thread_([this] { run(); }) {}
+
+AudioThread::~AudioThread() {
+    stop_.store(true, std::memory_order_relaxed);
+    thread_.join();
+}
+
+void AudioThread::run() {
+    using clock = std::chrono::steady_clock;
+    realtime_.store(make_realtime(), std::memory_order_relaxed);
+    ProfilerBinding binding(profiler_);
+    size_t frames = sink_.block_frames();
+    uint64_t budget_ns = static_cast<uint64_t>(frames * 1e9 / sink_.sample_rate());
+    while (!stop_.load(std::memory_order_relaxed)) {
+        auto start = clock::now();
+        mixer_.mix(block_.get(), frames);
+        uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start)
+                                                .count());
+        if (ns > max_mix_ns_.load(std::memory_order_relaxed)) max_mix_ns_.store(ns, std::memory_order_relaxed);
+        if (ns > budget_ns) late_.fetch_add(1, std::memory_order_relaxed);
+        blocks_.fetch_add(1, std::memory_order_relaxed);
+        sink_.write(block_.get(), frames);
+    }
+}
+
+AudioThreadStats AudioThread::stats() const {
+    return AudioThreadStats{blocks_.load(std::memory_order_relaxed), late_.load(std::memory_order_relaxed),
+                            static_cast<double>(max_mix_ns_.load(std::memory_order_relaxed)) / 1e3,
+                            realtime_.load(std::memory_order_relaxed)};
+}
+
+}  // namespace toppler
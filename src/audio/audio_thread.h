@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "audio/mixer.h"
+
+namespace toppler {
+
+class Profiler;
+
+// Where mixed blocks go: the platform's audio device, or nothing. write()
+// blocks until the device can take the block, which is what paces the
+// audio thread.
+class AudioSink {
+public:
+    virtual ~AudioSink() = default;
+    virtual int sample_rate() const = 0;
+    virtual size_t block_frames() const = 0;
+    // `frames` interleaved stereo samples.
+    virtual void write(const int16_t* samples, size_t frames) = 0;
+};
+
+// Discards audio at the rate a device would consume it, for headless runs
+// and benches.
+class NullAudioSink : public AudioSink {
+public:
+    explicit NullAudioSink(size_t block_frames = 256) : block_frames_(block_frames) {}
+
+    int sample_rate() const override { return kAudioSampleRate; }
+    size_t block_frames() const override { return block_frames_; }
+    void write(const int16_t* samples, size_t frames) override;
+
+private:
+    size_t block_frames_;
+    std::chrono::steady_clock::time_point next_{};
+};
+
+struct AudioThreadStats {
+    uint64_t blocks;
+    uint64_t late_blocks;  // mixing took longer than the block plays for
+    double max_mix_us;
+    bool realtime;         // got a real-time scheduling class
+};
+
+// Runs Mixer::mix() on its own thread, one block at a time, straight into
+// the sink. The block buffer is allocated up front; the loop itself only
+// mixes, times itself and writes.
+//
+// A profiler passed here is bound to the audio thread so its blocks show up
+// as AudioMix zones. Binding claims the thread's own event ring before the
+// loop starts; recording into it takes no lock and allocates nothing.
+class AudioThread {
+public:
+    AudioThread(Mixer& mixer, AudioSink& sink, Profiler* profiler = nullptr);
+    // Finishes the block being mixed and joins.
+    ~AudioThread();
+
+    AudioThread(const AudioThread&) = delete;
+    AudioThread& operator=(const AudioThread&) = delete;
+
+    AudioThreadStats stats() const;
+
+private:
+    void run();
+
+    Mixer& mixer_;
+    AudioSink& sink_;
+    Profiler* profiler_;
+    std::unique_ptr<int16_t[]> block_;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> blocks_{0};
+    std::atomic<uint64_t> late_{0};
+    std::atomic<uint64_t> max_mix_ns_{0};
+    std::atomic<bool> realtime_{false};
+    std::thread thread_;
+};
+
+}  // namespace toppler
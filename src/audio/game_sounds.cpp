@@ -0,0 +1,37 @@
+#include "audio/game_sounds.h"
+
+#include <cmath>
+
+#include "tower/tower_grid.h"
+
+namespace toppler {
+
+namespace {
+
+// Pan from the event's angle around the tower: centred in front of the
+// camera, hard left or right a quarter turn away, fading round the back.
+float pan_for(float angle, const SimState& state) {
+    float d = std::remainder(angle - state.session.tower_angle, static_cast<float>(kTowerColumns));
+    float quarter = kTowerColumns / 4.0f;
+    float pan = d / quarter;
+    if (pan > 1.0f) pan = 2.0f - pan;
+    if (pan < -1.0f) pan = -2.0f - pan;
+    return pan;
+}
+
+}  // namespace
+
+void play_tick_sounds(Mixer& mixer, const TickEvents& events, const SimState& state) {
+    for (const Contact& c : events.contacts) {
+        SoundId id = c.kind == ContactKind::PlayerEnemy ? SoundId::Knocked
+                     : c.kind == ContactKind::ShotEnemy ? SoundId::ShotHit
+                                                        : SoundId::ShotThud;
+        mixer.play(id, 1.0f, pan_for(c.angle, state));
+    }
+    // One crumble per tick however many bricks went: a row breaking at once
+    // would otherwise eat the whole voice pool for a single sound.
+    if (events.bricks.size()) mixer.play(SoundId::Crumble, 0.8f, 0.0f);
+    for (const ScoreEvent& s : events.scores) mixer.play(SoundId::Score, 0.7f, pan_for(s.angle, state));
+}
+
+}  // namespace toppler
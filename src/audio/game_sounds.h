@@ -0,0 +1,14 @@
+#pragma once
+
+#include "audio/mixer.h"
+#include "sim/sim_state.h"
+#include "sim/tick_events.h"
+
+namespace toppler {
+
+// Turns one tick's events into sound effects, panned by where on the tower
+// they happened relative to the camera. Game thread; a handful of ring
+// pushes per tick.
+void play_tick_sounds(Mixer& mixer, const TickEvents& events, const SimState& state);
+
+}  // namespace toppler
@@ -0,0 +1,196 @@
+#include "audio/mixer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "core/profiler.h"
+
+namespace toppler {
+
+namespace {
+
+// Music gain moves at most this much per sample: a full fade takes 250 ms.
+constexpr float kMusicRamp = 1.0f / (0.25f * kAudioSampleRate);
+
+float clamp_unit(float v, float lo) { return std::min(1.0f, std::max(lo, v)); }
+
+}  // namespace
+
+Mixer::Mixer(const SoundBank& bank) : bank_(bank) {}
+
+bool Mixer::send(const AudioCommand& cmd) {
+    if (commands_.push(cmd)) return true;
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+VoiceId Mixer::play(SoundId sound, float volume, float pan, bool loop) {
+    if (sound >= SoundId::kCount) return 0;
+    VoiceId id = next_id_++;
+    if (next_id_ == 0) next_id_ = 1;
+    AudioCommand cmd{AudioCommand::Op::Play, sound, static_cast<uint8_t>(loop), 0, volume, pan, id};
+    return send(cmd) ? id : 0;
+}
+
+void Mixer::stop(VoiceId voice) {
+    if (voice) send(AudioCommand{AudioCommand::Op::Stop, SoundId::kCount, 0, 0, 0.0f, 0.0f, voice});
+}
+
+void Mixer::stop_all() { send(AudioCommand{AudioCommand::Op::StopAll, SoundId::kCount, 0, 0, 0.0f, 0.0f, 0}); }
+
+void Mixer::set_music(SoundId sound, float volume) {
+    send(AudioCommand{AudioCommand::Op::Music, sound, 1, 0, volume, 0.0f, 0});
+}
+
+void Mixer::set_music_volume(float volume) {
+    send(AudioCommand{AudioCommand::Op::MusicVolume, SoundId::kCount, 0, 0, volume, 0.0f, 0});
+}
+
+// A free voice, or else the one-shot nearest its end: cutting the last few
+// ms of a sound is far less audible than refusing a new one. Loops are cut
+// only when every voice is looping.
+Mixer::Voice& Mixer::free_voice() {
+    Voice* best = nullptr;
+    uint32_t best_left = UINT32_MAX;
+    for (Voice& v : voices_) {
+        if (!v.id) return v;
+        uint32_t left = v.loop ? UINT32_MAX - 1 : v.length - v.cursor;
+        if (left < best_left) {
+            best_left = left;
+            best = &v;
+        }
+    }
+    stolen_.fetch_add(1, std::memory_order_relaxed);
+    active_.fetch_sub(1, std::memory_order_relaxed);
+    return *best;
+}
+
+void Mixer::apply(const AudioCommand& cmd) {
+    switch (cmd.op) {
+        case AudioCommand::Op::Play: {
+            const SoundClip& clip = bank_.clip(cmd.sound);
+            if (!clip.length) break;
+            float volume = clamp_unit(cmd.volume, 0.0f);
+            float pan = clamp_unit(cmd.pan, -1.0f);
+            Voice& v = free_voice();
+            v = Voice{clip.samples, clip.length, 0, cmd.voice, volume * std::min(1.0f, 1.0f - pan),
+                      volume * std::min(1.0f, 1.0f + pan), cmd.loop != 0};
+            active_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        case AudioCommand::Op::Stop:
+            for (Voice& v : voices_) {
+                if (v.id == cmd.voice) {
+                    v.id = 0;
+                    active_.fetch_sub(1, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            break;
+        case AudioCommand::Op::StopAll:
+            for (Voice& v : voices_) v.id = 0;
+            active_.store(0, std::memory_order_relaxed);
+            break;
+        case AudioCommand::Op::Music: {
+            const float* samples = nullptr;
+            uint32_t length = 0;
+            if (cmd.sound < SoundId::kCount) {
+                samples = bank_.clip(cmd.sound).samples;
+                length = bank_.clip(cmd.sound).length;
+            }
+            if (samples == music_.samples) {
+                music_.target = clamp_unit(cmd.volume, 0.0f);
+                break;
+            }
+            // The current clip becomes the fading one; a clip already fading
+            // out is dropped (two quick changes cut it, which is inaudible
+            // under the incoming fade).
+            music_.old_samples = music_.samples;
+            music_.old_length = music_.length;
+            music_.old_cursor = music_.cursor;
+            music_.old_gain = music_.gain;
+            music_.samples = samples;
+            music_.length = length;
+            music_.cursor = 0;
+            music_.gain = 0.0f;
+            music_.target = clamp_unit(cmd.volume, 0.0f);
+            break;
+        }
+        case AudioCommand::Op::MusicVolume:
+            music_volume_ = clamp_unit(cmd.volume, 0.0f);
+            break;
+    }
+}
+
+void Mixer::mix_chunk(float* acc, size_t frames) {
+    std::memset(acc, 0, frames * 2 * sizeof(float));
+    for (Voice& v : voices_) {
+        if (!v.id) continue;
+        size_t done = 0;
+        while (done < frames) {
+            size_t n = std::min<size_t>(frames - done, v.length - v.cursor);
+            const float* src = v.samples + v.cursor;
+            float* dst = acc + done * 2;
+            for (size_t i = 0; i < n; ++i) {
+                dst[2 * i] += src[i] * v.gain_l;
+                dst[2 * i + 1] += src[i] * v.gain_r;
+            }
+            done += n;
+            v.cursor += static_cast<uint32_t>(n);
+            if (v.cursor == v.length) {
+                if (!v.loop) {
+                    v.id = 0;
+                    active_.fetch_sub(1, std::memory_order_relaxed);
+                    break;
+                }
+                v.cursor = 0;
+            }
+        }
+    }
+
+    // Music loops; gains ramp per sample so volume changes never click.
+    if (music_.samples || music_.old_samples) {
+        for (size_t i = 0; i < frames; ++i) {
+            float s = 0.0f;
+            if (music_.samples) {
+                if (music_.gain < music_.target) music_.gain = std::min(music_.target, music_.gain + kMusicRamp);
+                else if (music_.gain > music_.target) music_.gain = std::max(music_.target, music_.gain - kMusicRamp);
+                s += music_.samples[music_.cursor] * music_.gain;
+                if (++music_.cursor == music_.length) music_.cursor = 0;
+            }
+            if (music_.old_samples) {
+                s += music_.old_samples[music_.old_cursor] * music_.old_gain;
+                if (++music_.old_cursor == music_.old_length) music_.old_cursor = 0;
+                music_.old_gain -= kMusicRamp;
+                if (music_.old_gain <= 0.0f) music_.old_samples = nullptr;
+            }
+            s *= music_volume_;
+            acc[2 * i] += s;
+            acc[2 * i + 1] += s;
+        }
+    }
+}
+
+void Mixer::mix(int16_t* out, size_t frames) {
+    TT_PROFILE_ZONE(AudioMix);
+    AudioCommand cmd;
+    while (commands_.pop(cmd)) apply(cmd);
+
+    while (frames) {
+        size_t n = std::min(frames, kMixChunk);
+        mix_chunk(scratch_, n);
+        for (size_t i = 0; i < n * 2; ++i) {
+            float s = std::min(1.0f, std::max(-1.0f, scratch_[i]));
+            out[i] = static_cast<int16_t>(s * 32767.0f);
+        }
+        out += n * 2;
+        frames -= n;
+    }
+}
+
+MixerStats Mixer::stats() const {
+    return MixerStats{dropped_.load(std::memory_order_relaxed), stolen_.load(std::memory_order_relaxed),
+                      active_.load(std::memory_order_relaxed)};
+}
+
+}  // namespace toppler
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "audio/sound_bank.h"
+#include "core/spsc_ring.h"
+
+namespace toppler {
+
+// Names one playing sound so the game can stop it later. Ids are handed out
+// by the game thread and never reused within a run; 0 means "none".
+using VoiceId = uint32_t;
+
+// One request from the game thread to the mixer. Plain data, copied
+// through the command ring.
+struct AudioCommand {
+    enum class Op : uint8_t { Play, Stop, StopAll, Music, MusicVolume };
+    Op op;
+    SoundId sound;
+    uint8_t loop;
+    uint8_t reserved;
+    float volume;  // 0..1
+    float pan;     // -1 (left) .. 1 (right)
+    VoiceId voice;
+};
+
+struct MixerStats {
+    uint64_t commands_dropped;  // ring full when the game sent them
+    uint64_t voices_stolen;     // pool full, the quietest-to-lose voice was cut
+    uint32_t voices_active;
+};
+
+// Sound effect and music mixer, split between two threads:
+//
+//   game thread:  play(), stop(), stop_all(), set_music(), set_music_volume()
+//   audio thread: mix()
+//
+// The two sides share nothing but a single-producer single-consumer ring of
+// AudioCommands and a few relaxed counters. Voices live in a fixed array
+// owned by the audio side and all scratch space is preallocated, so mix()
+// takes no locks, makes no allocations and never waits on the game thread:
+// a game thread that stalls only delays its next command, not a block.
+class Mixer {
+public:
+    static constexpr int kMaxVoices = 32;  // effects; music has its own voice
+    static constexpr size_t kCommandCapacity = 256;
+
+    explicit Mixer(const SoundBank& bank);
+
+    Mixer(const Mixer&) = delete;
+    Mixer& operator=(const Mixer&) = delete;
+
+    // --- game thread -------------------------------------------------------
+    // Starts `sound`. Returns its id, or 0 if the command ring was full (the
+    // sound is dropped; the audio thread has fallen far behind).
+    VoiceId play(SoundId sound, float volume = 1.0f, float pan = 0.0f, bool loop = false);
+    void stop(VoiceId voice);
+    void stop_all();
+    // Crossfades the music voice to `sound` (SoundId::kCount for silence).
+    void set_music(SoundId sound, float volume = 1.0f);
+    void set_music_volume(float volume);
+
+    // --- audio thread --------------------------------------------------------
+    // Applies pending commands, then writes `frames` interleaved stereo
+    // samples to `out`.
+    void mix(int16_t* out, size_t frames);
+
+    // Either thread; counters are approximate while both are running.
+    MixerStats stats() const;
+
+private:
+    struct Voice {
+        const float* samples;
+        uint32_t length;
+        uint32_t cursor;
+        VoiceId id;  // 0 when the voice is free
+        float gain_l;
+        float gain_r;
+        bool loop;
+    };
+
+    struct Music {
+        const float* samples = nullptr;
+        uint32_t length = 0;
+        uint32_t cursor = 0;
+        float gain = 0.0f;    // current, ramped towards target per sample
+        float target = 0.0f;
+        // The clip fading out while a new one fades in.
+        const float* old_samples = nullptr;
+        uint32_t old_length = 0;
+        uint32_t old_cursor = 0;
+        float old_gain = 0.0f;
+    };
+
+    static constexpr size_t kMixChunk = 256;  // frames mixed per pass over the voices
+
+    bool send(const AudioCommand& cmd);
+    void apply(const AudioCommand& cmd);
+    Voice& free_voice();
+    void mix_chunk(float* acc, size_t frames);
+
+    const SoundBank& bank_;
+    SpscRing<AudioCommand, kCommandCapacity> commands_;
+
+    // Game thread only.
+    VoiceId next_id_ = 1;
+
+    // Audio thread only.
+    Voice voices_[kMaxVoices] = {};
+    Music music_;
+    float music_volume_ = 1.0f;
+    alignas(64) float scratch_[kMixChunk * 2];
+
+    // Written by one side, read by either.
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> stolen_{0};
+    std::atomic<uint32_t> active_{0};
+};
+
+}  // namespace toppler
@@ -0,0 +1,108 @@
+#include "audio/sound_bank.h"
+
+#include <cmath>
+
+#include "core/rng.h"
+
+namespace toppler {
+
+namespace {
+
+constexpr double kTwoPi = 6.283185307179586;
+
+// Small synthesizer for chip-style effects: pitch sweeps over a square or
+// noise source under a linear attack / exponential decay envelope.
+struct Tone {
+    double seconds;
+    double start_hz;
+    double end_hz;
+    double noise;  // 0 = pure square, 1 = pure noise
+    double decay;  // envelope time constant, in seconds
+    double gain;
+};
+
+void render_tone(const Tone& t, std::vector<float>& out) {
+    size_t n = static_cast<size_t>(t.seconds * kAudioSampleRate);
+    uint32_t rng = rng_seed(static_cast<uint32_t>(t.start_hz * 977.0));
+    double phase = 0.0;
+    float held_noise = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        double time = static_cast<double>(i) / kAudioSampleRate;
+        double hz = t.start_hz + (t.end_hz - t.start_hz) * (time / t.seconds);
+        phase += hz / kAudioSampleRate;
+        if (phase >= 1.0) {
+            phase -= 1.0;
+            held_noise = static_cast<float>(rng_next(rng)) / 2147483648.0f - 1.0f;  // new noise each cycle
+        }
+        double square = phase < 0.5 ? 1.0 : -1.0;
+        double env = std::min(1.0, time * 400.0) * std::exp(-time / t.decay);
+        double v = (square * (1.0 - t.noise) + held_noise * t.noise) * env * t.gain;
+        out.push_back(static_cast<float>(v));
+    }
+}
+
+// Eight bars of a loop: a square-wave lead over a triangle bass.
+void render_theme(std::vector<float>& out) {
+    static const int kLead[] = {0, 4, 7, 12, 7, 4, 0, 4, 5, 9, 12, 17, 12, 9, 5, 9,
+                                7, 11, 14, 19, 14, 11, 7, 11, 0, 4, 7, 12, 16, 12, 7, 4};
+    static const int kBass[] = {0, 5, 7, 0};
+    constexpr double kNoteSeconds = 0.1875;  // eighth notes at 160 bpm
+    constexpr double kRoot = 261.63;         // C4
+    size_t note_len = static_cast<size_t>(kNoteSeconds * kAudioSampleRate);
+    size_t notes = sizeof kLead / sizeof kLead[0];
+    double bass_phase = 0.0, lead_phase = 0.0;
+    for (size_t n = 0; n < notes; ++n) {
+        double lead_hz = kRoot * std::pow(2.0, kLead[n] / 12.0);
+        double bass_hz = kRoot / 4.0 * std::pow(2.0, kBass[n / 8] / 12.0);
+        for (size_t i = 0; i < note_len; ++i) {
+            double time = static_cast<double>(i) / kAudioSampleRate;
+            lead_phase = std::fmod(lead_phase + lead_hz / kAudioSampleRate, 1.0);
+            bass_phase = std::fmod(bass_phase + bass_hz / kAudioSampleRate, 1.0);
+            double lead = (lead_phase < 0.25 ? 1.0 : -1.0) * std::exp(-time / 0.12) * std::min(1.0, time * 500.0);
+            double bass = 4.0 * std::fabs(bass_phase - 0.5) - 1.0;
+            out.push_back(static_cast<float>(0.18 * lead + 0.22 * bass));
+        }
+    }
+}
+
+}  // namespace
+
+SoundBank::SoundBank() {
+    size_t offsets[static_cast<size_t>(SoundId::kCount) + 1];
+    for (size_t id = 0; id < static_cast<size_t>(SoundId::kCount); ++id) {
+        offsets[id] = storage_.size();
+        switch (static_cast<SoundId>(id)) {
+            case SoundId::Shot:
+                render_tone(Tone{0.09, 1400.0, 700.0, 0.2, 0.04, 0.35}, storage_);
+                break;
+            case SoundId::ShotHit:
+                render_tone(Tone{0.18, 300.0, 90.0, 0.5, 0.06, 0.6}, storage_);
+                break;
+            case SoundId::ShotThud:
+                render_tone(Tone{0.08, 180.0, 120.0, 0.7, 0.02, 0.4}, storage_);
+                break;
+            case SoundId::Knocked:
+                render_tone(Tone{0.35, 520.0, 80.0, 0.1, 0.15, 0.6}, storage_);
+                break;
+            case SoundId::Crumble:
+                render_tone(Tone{0.25, 900.0, 200.0, 1.0, 0.08, 0.45}, storage_);
+                break;
+            case SoundId::Score:
+                render_tone(Tone{0.07, 1046.5, 1046.5, 0.0, 0.05, 0.3}, storage_);
+                render_tone(Tone{0.12, 1568.0, 1568.0, 0.0, 0.06, 0.3}, storage_);
+                break;
+            case SoundId::TowerTheme:
+                render_theme(storage_);
+                break;
+            default:
+                break;
+        }
+    }
+    offsets[static_cast<size_t>(SoundId::kCount)] = storage_.size();
+    // Pointers only once storage has stopped growing.
+    for (size_t id = 0; id < static_cast<size_t>(SoundId::kCount); ++id) {
+        clips_[id] = SoundClip{storage_.data() + offsets[id], static_cast<uint32_t>(offsets[id + 1] - offsets[id])};
+    }
+}
+
+}  // namespace toppler
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace toppler {
+
+constexpr int kAudioSampleRate = 44100;
+
+// Every sound the game plays, effects and music alike.
+enum class SoundId : uint8_t {
+    Shot = 0,   // snowball thrown
+    ShotHit,    // snowball hit an enemy
+    ShotThud,   // snowball hit a wall
+    Knocked,    // player hit
+    Crumble,    // brick broke away
+    Score,      // points awarded
+    TowerTheme, // looping music
+    kCount
+};
+
+// A mono clip at kAudioSampleRate, as floats in [-1, 1].
+struct SoundClip {
+    const float* samples = nullptr;
+    uint32_t length = 0;
+};
+
+// All clips, synthesized once at startup. Immutable afterwards, so the
+// mixer thread reads it without any synchronization.
+class SoundBank {
+public:
+    SoundBank();
+
+    const SoundClip& clip(SoundId id) const { return clips_[static_cast<size_t>(id)]; }
+    size_t size_bytes() const { return storage_.size() * sizeof(float); }
+
+private:
+    std::vector<float> storage_;
+    SoundClip clips_[static_cast<size_t>(SoundId::kCount)];
+};
+
+}  // namespace toppler
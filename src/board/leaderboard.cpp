@@ -0,0 +1,418 @@
+#include "board/leaderboard.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <map>
+
+namespace toppler {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kBoardMagic = 0x424c5454;  // "TTLB"
+constexpr uint16_t kBoardVersion = 1;
+constexpr uint16_t kLogFile = 0;
+constexpr uint16_t kSnapshotFile = 1;
+
+struct BoardFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;  // kLogFile or kSnapshotFile
+    uint32_t generation;
+    uint32_t reserved;
+};
+static_assert(sizeof(BoardFileHeader) == 16, "BoardFileHeader layout is part of the format");
+
+std::string file_path(const std::string& dir, const char* prefix, uint32_t generation) {
+    char name[32];
+    std::snprintf(name, sizeof name, "%s.%08u", prefix, generation);
+    return (fs::path(dir) / name).string();
+}
+
+// Generation of a "prefix.NNNNNNNN" file name, or 0 if it is not one.
+uint32_t parse_generation(const std::string& name, const char* prefix) {
+    size_t n = std::strlen(prefix);
+    if (name.size() != n + 9 || name.compare(0, n, prefix) != 0 || name[n] != '.') return 0;
+    uint32_t g = 0;
+    for (size_t i = n + 1; i < name.size(); ++i) {
+        if (name[i] < '0' || name[i] > '9') return 0;
+        g = g * 10 + static_cast<uint32_t>(name[i] - '0');
+    }
+    return g;
+}
+
+BoardRecord make_record(const ScoreSubmission& s) {
+    BoardRecord r{s.tower, s.player, s.score, s.ticks, 0, 0};
+    r.check = board_record_check(r);
+    return r;
+}
+
+// fflush gets the bytes to the kernel, fdatasync to the disk.
+void flush_file(std::FILE* f, bool durable, const std::string& what) {
+    if (std::fflush(f) != 0 || (durable && fdatasync(fileno(f)) != 0)) {
+        throw LeaderboardError(what + ": write failed: " + std::strerror(errno));
+    }
+}
+
+// Makes a rename or unlink in `dir` durable.
+void sync_dir(const std::string& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    fsync(fd);
+    close(fd);
+}
+
+// Reads the records of a log or snapshot. A log may end in a torn write:
+// the good prefix is kept, and with `repair` the file is cut back to it.
+// A snapshot is renamed into place only once complete, so any damage there
+// is an error.
+std::vector<BoardRecord> read_board_file(const std::string& path, uint16_t type, bool repair) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) throw LeaderboardError(path + ": cannot open");
+    BoardFileHeader h;
+    bool ok = std::fread(&h, sizeof h, 1, f) == 1 && h.magic == kBoardMagic && h.version == kBoardVersion &&
+              h.type == type;
+    std::vector<BoardRecord> records;
+    BoardRecord r;
+    while (ok && std::fread(&r, sizeof r, 1, f) == 1) {
+        if (r.check != board_record_check(r)) break;
+        records.push_back(r);
+    }
+    bool complete = ok && std::feof(f);
+    std::fclose(f);
+    if (!ok && type == kSnapshotFile) throw LeaderboardError(path + ": not a leaderboard snapshot");
+    if (!complete && type == kSnapshotFile) throw LeaderboardError(path + ": corrupt snapshot");
+    if (!ok) {
+        // A log torn inside its header holds nothing yet.
+        if (repair) fs::remove(path);
+        return records;
+    }
+    uint64_t good = sizeof(BoardFileHeader) + records.size() * sizeof(BoardRecord);
+    if (repair && fs::file_size(path) != good) fs::resize_file(path, good);
+    return records;
+}
+
+// Keeps the better of each field: the rule submit() applies, so folding a
+// record into a snapshot and replaying it give the same boards.
+void fold_record(std::map<std::pair<uint64_t, uint64_t>, BoardRecord>& into, const BoardRecord& r) {
+    auto [it, fresh] = into.try_emplace({r.tower, r.player}, r);
+    if (fresh) return;
+    BoardRecord& b = it->second;
+    b.score = std::max(b.score, r.score);
+    if (r.ticks && (!b.ticks || r.ticks < b.ticks)) b.ticks = r.ticks;
+}
+
+// Writes snapshot.<to> from snapshot.<from> (if any) and logs (from, to],
+// then deletes those. Only closed files are read, so this needs no lock.
+void fold_snapshot(const std::string& dir, uint32_t from, uint32_t to) {
+    std::map<std::pair<uint64_t, uint64_t>, BoardRecord> bests;
+    if (from) {
+        for (const BoardRecord& r : read_board_file(file_path(dir, "snapshot", from), kSnapshotFile, false)) {
+            fold_record(bests, r);
+        }
+    }
+    for (uint32_t g = from + 1; g <= to; ++g) {
+        std::string log = file_path(dir, "log", g);
+        if (!fs::exists(log)) continue;
+        for (const BoardRecord& r : read_board_file(log, kLogFile, false)) fold_record(bests, r);
+    }
+
+    std::string path = file_path(dir, "snapshot", to);
+    std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) throw LeaderboardError(tmp + ": cannot create");
+    BoardFileHeader h{kBoardMagic, kBoardVersion, kSnapshotFile, to, 0};
+    bool ok = std::fwrite(&h, sizeof h, 1, f) == 1;
+    for (const auto& [key, r] : bests) {
+        BoardRecord out = r;
+        out.check = board_record_check(out);
+        ok = ok && std::fwrite(&out, sizeof out, 1, f) == 1;
+    }
+    ok = ok && std::fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) {
+        fs::remove(tmp);
+        throw LeaderboardError(tmp + ": write failed");
+    }
+    fs::rename(tmp, path);
+    sync_dir(dir);
+    if (from) fs::remove(file_path(dir, "snapshot", from));
+    for (uint32_t g = from + 1; g <= to; ++g) fs::remove(file_path(dir, "log", g));
+}
+
+// Board order: better first. Times ascend; scores are stored negated.
+// Its own inverse, so it also decodes.
+uint64_t encode_value(BoardKind kind, uint64_t v) { return kind == BoardKind::TowerTime ? v : UINT64_MAX - v; }
+
+}  // namespace
+
+uint32_t board_record_check(const BoardRecord& r) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&r);
+    for (size_t i = 0; i < offsetof(BoardRecord, check); ++i) h = (h ^ p[i]) * 0x100000001b3ull;
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+Leaderboard::Leaderboard(const std::string& dir, const LeaderboardOptions& options) : dir_(dir), options_(options) {
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    if (!fs::is_directory(dir_)) throw LeaderboardError(dir_ + ": not a directory");
+
+    try {
+        std::vector<fs::path> files;
+        for (const auto& entry : fs::directory_iterator(dir_)) files.push_back(entry.path());
+        uint32_t newest_snapshot = 0;
+        for (const fs::path& f : files) {
+            newest_snapshot = std::max(newest_snapshot, parse_generation(f.filename().string(), "snapshot"));
+        }
+        // Anything older than the newest snapshot is already folded into it;
+        // leftovers mean a crash between the rename and the deletes.
+        std::vector<uint32_t> logs;
+        for (const fs::path& f : files) {
+            std::string name = f.filename().string();
+            uint32_t snap = parse_generation(name, "snapshot"), log = parse_generation(name, "log");
+            if ((snap && snap < newest_snapshot) || (log && log <= newest_snapshot) || f.extension() == ".tmp") {
+                fs::remove(f);
+            } else if (log) {
+                logs.push_back(log);
+            }
+        }
+        std::sort(logs.begin(), logs.end());
+        if (newest_snapshot) {
+            for (const BoardRecord& r : read_board_file(file_path(dir_, "snapshot", newest_snapshot), kSnapshotFile,
+                                                        false)) {
+                apply(ScoreSubmission{r.tower, r.player, r.score, r.ticks});
+            }
+        }
+        uint32_t newest = newest_snapshot;
+        size_t replayed = 0;
+        for (uint32_t g : logs) {
+            for (const BoardRecord& r : read_board_file(file_path(dir_, "log", g), kLogFile, true)) {
+                apply(ScoreSubmission{r.tower, r.player, r.score, r.ticks});
+                ++replayed;
+            }
+            newest = g;
+        }
+        generation_ = newest + 1;
+        snapshot_ = fold_to_ = newest_snapshot;
+        // Records left in logs from the last run are folded in the
+        // background; empty logs wait for the next rotation.
+        if (replayed) fold_to_ = newest;
+        open_log();
+    } catch (const fs::filesystem_error& e) {
+        throw LeaderboardError(e.what());
+    }
+    compactor_ = std::thread([this] { compactor_loop(); });
+}
+
+Leaderboard::~Leaderboard() {
+    {
+        std::lock_guard<std::mutex> lock(compact_mutex_);
+        stopping_ = true;
+    }
+    compact_cv_.notify_all();
+    compactor_.join();
+    if (log_) std::fclose(log_);
+}
+
+bool Leaderboard::submit(const ScoreSubmission& s) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    ++submissions_;
+    if (!improves(s)) return false;
+    // Logged before it is shown: a write that fails leaves no trace. Once
+    // the record is in the log stream it counts, even if the sync below
+    // fails, since a later flush still writes it.
+    append(s);
+    apply(s);
+    ++improvements_;
+    sync_log();
+    if (log_records_ >= options_.compact_after) rotate_log();
+    return true;
+}
+
+bool Leaderboard::improves(const ScoreSubmission& s) const {
+    auto it = bests_.find({s.tower, s.player});
+    if (it == bests_.end()) return s.ticks || s.score;
+    const Best& b = it->second;
+    return (s.ticks && (!b.ticks || s.ticks < b.ticks)) || s.score > b.score;
+}
+
+bool Leaderboard::apply(const ScoreSubmission& s) {
+    auto [it, fresh] = bests_.try_emplace({s.tower, s.player});
+    Best& b = it->second;
+    bool improved = false;
+    if (s.ticks && (!b.ticks || s.ticks < b.ticks)) {
+        reindex(tower_time_board(s.tower), s.player, b.ticks, s.ticks);
+        b.ticks = s.ticks;
+        improved = true;
+    }
+    if (s.score > b.score) {
+        reindex(tower_score_board(s.tower), s.player, b.score, s.score);
+        uint64_t& total = totals_[s.player];
+        reindex(total_score_board(), s.player, total, total + (s.score - b.score));
+        total += s.score - b.score;
+        b.score = s.score;
+        improved = true;
+    }
+    if (fresh && !improved) bests_.erase(it);
+    return improved;
+}
+
+void Leaderboard::reindex(BoardId board, uint64_t player, uint64_t old_value, uint64_t value) {
+    Index& index = boards_[{static_cast<uint64_t>(board.kind), board.tower}];
+    if (old_value) {
+        index.erase(Key{encode_value(board.kind, old_value), player});
+    } else {
+        ++entries_;
+    }
+    index.insert(Key{encode_value(board.kind, value), player});
+}
+
+const Leaderboard::Index* Leaderboard::board_index(BoardId board) const {
+    auto it = boards_.find({static_cast<uint64_t>(board.kind), board.tower});
+    return it == boards_.end() ? nullptr : &it->second;
+}
+
+void Leaderboard::append(const ScoreSubmission& s) {
+    BoardRecord r = make_record(s);
+    if (std::fwrite(&r, sizeof r, 1, log_) != 1) {
+        throw LeaderboardError(file_path(dir_, "log", generation_) + ": write failed");
+    }
+    ++log_records_;
+}
+
+void Leaderboard::sync_log() {
+    if (options_.sync_every && ++unsynced_ >= options_.sync_every) {
+        flush_file(log_, true, file_path(dir_, "log", generation_));
+        unsynced_ = 0;
+    }
+}
+
+void Leaderboard::open_log() {
+    std::string path = file_path(dir_, "log", generation_);
+    log_ = std::fopen(path.c_str(), "wb");
+    if (!log_) throw LeaderboardError(path + ": cannot create");
+    BoardFileHeader h{kBoardMagic, kBoardVersion, kLogFile, generation_, 0};
+    if (std::fwrite(&h, sizeof h, 1, log_) != 1) throw LeaderboardError(path + ": write failed");
+    log_records_ = 0;
+    unsynced_ = 0;
+}
+
+// Under the exclusive lock. The closed log is made durable before the
+// compactor may read it.
+void Leaderboard::rotate_log() {
+    flush_file(log_, true, file_path(dir_, "log", generation_));
+    std::fclose(log_);
+    log_ = nullptr;
+    uint32_t closed = generation_++;
+    open_log();
+    sync_dir(dir_);
+    {
+        std::lock_guard<std::mutex> lock(compact_mutex_);
+        fold_to_ = closed;
+    }
+    compact_cv_.notify_all();
+}
+
+void Leaderboard::compactor_loop() {
+    std::unique_lock<std::mutex> lock(compact_mutex_);
+    for (;;) {
+        compact_cv_.wait(lock, [&] { return stopping_ || fold_to_ > std::max(snapshot_, failed_); });
+        if (stopping_) return;
+        uint32_t from = snapshot_, to = fold_to_;
+        lock.unlock();
+        bool ok = true;
+        try {
+            fold_snapshot(dir_, from, to);
+        } catch (const std::exception&) {
+            // Nothing was deleted; the logs are folded again next time.
+            ok = false;
+        }
+        lock.lock();
+        if (ok) {
+            snapshot_ = to;
+            ++compactions_;
+        } else {
+            failed_ = to;
+            ++compaction_failures_;
+        }
+        compact_cv_.notify_all();
+    }
+}
+
+void Leaderboard::compact(bool wait) {
+    uint32_t target;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        target = generation_;
+        rotate_log();
+    }
+    if (!wait) return;
+    std::unique_lock<std::mutex> lock(compact_mutex_);
+    compact_cv_.wait(lock, [&] { return snapshot_ >= target || failed_ >= target; });
+}
+
+void Leaderboard::sync() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    flush_file(log_, true, file_path(dir_, "log", generation_));
+    unsynced_ = 0;
+}
+
+void Leaderboard::top(BoardId board, size_t k, std::vector<BoardEntry>& out) const {
+    out.clear();
+    if (k == 0) return;
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const Index* index = board_index(board);
+    if (!index) return;
+    uint32_t rank = 0;
+    index->scan_from(Key{0, 0}, [&](const Key& key) {
+        out.push_back(BoardEntry{key.player, encode_value(board.kind, key.value), ++rank});
+        return out.size() < k;
+    });
+}
+
+BoardEntry Leaderboard::find(BoardId board, uint64_t player) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    uint64_t value = 0;
+    if (board.kind == BoardKind::Total) {
+        auto it = totals_.find(player);
+        if (it != totals_.end()) value = it->second;
+    } else {
+        auto it = bests_.find({board.tower, player});
+        if (it != bests_.end()) value = board.kind == BoardKind::TowerTime ? it->second.ticks : it->second.score;
+    }
+    if (!value) return BoardEntry{player, 0, 0};
+    size_t before = board_index(board)->rank(Key{encode_value(board.kind, value), player});
+    return BoardEntry{player, value, static_cast<uint32_t>(before + 1)};
+}
+
+size_t Leaderboard::board_size(BoardId board) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const Index* index = board_index(board);
+    return index ? index->size() : 0;
+}
+
+LeaderboardStats Leaderboard::stats() const {
+    LeaderboardStats s;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        s.submissions = submissions_;
+        s.improvements = improvements_;
+        s.entries = entries_;
+        s.log_records = log_records_;
+        s.generation = generation_;
+    }
+    std::lock_guard<std::mutex> lock(compact_mutex_);
+    s.compactions = compactions_;
+    s.compaction_failures = compaction_failures_;
+    return s;
+}
+
+}  // namespace toppler
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "board/ranked_skip_list.h"
+
+namespace toppler {
+
+// Leaderboards for the campaign: per tower the best completion times and
+// best scores, and overall each player's total (their best score summed over
+// every tower).
+//
+// On disk (one directory):
+//
+//   log.<gen>        append-only, one BoardRecord per accepted submission
+//   snapshot.<gen>   one BoardRecord per (tower, player) with their bests,
+//                    folded from the previous snapshot and logs up to <gen>
+//
+// A submission is indexed in memory and appended to the current log, which
+// is a buffered write: durability comes from sync(), or from sync_every.
+// When the log has compact_after records it is closed and a new one started;
+// a background thread then folds the closed logs into a new snapshot and
+// deletes what it replaces. It works from the files alone, so submissions
+// and queries never wait for it. Opening the directory loads the newest
+// snapshot and replays the logs after it; a torn record at the end of a log
+// (a crash mid-write) is dropped and the log cut back to the last good one.
+//
+// Each board is a RankedSkipList keyed (value, player) with better values
+// first: top-K is a walk from the front, a player's rank one rank() lookup,
+// and a new personal best one erase and one insert.
+
+class LeaderboardError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+enum class BoardKind : uint8_t {
+    TowerTime = 0,  // fewest ticks to complete the tower
+    TowerScore,     // highest score on the tower
+    Total,          // highest sum of best tower scores
+};
+
+struct BoardId {
+    BoardKind kind = BoardKind::Total;
+    uint64_t tower = 0;  // level_fingerprint; 0 for Total
+};
+
+inline BoardId tower_time_board(uint64_t tower) { return BoardId{BoardKind::TowerTime, tower}; }
+inline BoardId tower_score_board(uint64_t tower) { return BoardId{BoardKind::TowerScore, tower}; }
+inline BoardId total_score_board() { return BoardId{BoardKind::Total, 0}; }
+
+struct ScoreSubmission {
+    uint64_t tower = 0;   // level_fingerprint of the tower played
+    uint64_t player = 0;
+    uint32_t score = 0;
+    uint32_t ticks = 0;   // completion time; 0 if the run did not complete the tower
+};
+
+// Log and snapshot record. Fixed-width: files store these verbatim.
+struct BoardRecord {
+    uint64_t tower;
+    uint64_t player;
+    uint32_t score;
+    uint32_t ticks;
+    uint32_t check;  // board_record_check of the fields above
+    uint32_t reserved;
+};
+static_assert(sizeof(BoardRecord) == 32, "BoardRecord is stored verbatim");
+
+struct BoardEntry {
+    uint64_t player = 0;
+    uint64_t value = 0;  // ticks, score or total, by board
+    uint32_t rank = 0;   // 1 = best; 0 if the player is not on the board
+};
+
+struct LeaderboardOptions {
+    uint32_t compact_after = 1 << 20;  // log records before a new snapshot is folded
+    uint32_t sync_every = 0;           // fdatasync the log every N records; 0 = only in sync()
+};
+
+struct LeaderboardStats {
+    uint64_t submissions = 0;
+    uint64_t improvements = 0;  // submissions that changed some board
+    uint64_t entries = 0;       // (board, player) pairs indexed
+    uint64_t log_records = 0;   // in the current log
+    uint64_t compactions = 0;   // snapshots written
+    uint64_t compaction_failures = 0;
+    uint32_t generation = 0;    // current log
+};
+
+class Leaderboard {
+public:
+    // Opens or creates the store in `dir`. Throws LeaderboardError.
+    explicit Leaderboard(const std::string& dir, const LeaderboardOptions& options = {});
+    ~Leaderboard();
+
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    // Records a run. True if it set a personal best on any board. Any
+    // thread. Throws LeaderboardError if the log cannot be written; the
+    // boards then stay as they were, matching what a restart would load.
+    bool submit(const ScoreSubmission& s);
+
+    // The best `k` entries of `board`, best first. Any thread.
+    void top(BoardId board, size_t k, std::vector<BoardEntry>& out) const;
+    // `player`'s entry on `board`, rank 0 if absent.
+    BoardEntry find(BoardId board, uint64_t player) const;
+    size_t board_size(BoardId board) const;
+
+    // Makes every accepted submission durable.
+    void sync();
+    // Starts a new log and folds the closed ones into a snapshot now; with
+    // `wait`, returns once the snapshot is written.
+    void compact(bool wait = false);
+
+    LeaderboardStats stats() const;
+
+private:
+    struct Key {
+        uint64_t value;  // encoded so that better sorts first; ties go to the lower player id
+        uint64_t player;
+        bool operator<(const Key& o) const { return value != o.value ? value < o.value : player < o.player; }
+    };
+    using Index = RankedSkipList<Key>;
+    struct Best {
+        uint32_t score = 0;
+        uint32_t ticks = 0;  // 0 = never completed
+    };
+    struct PairHash {
+        size_t operator()(const std::pair<uint64_t, uint64_t>& p) const {
+            return static_cast<size_t>(p.first * 0x9e3779b97f4a7c15ull ^ p.second);
+        }
+    };
+
+    const Index* board_index(BoardId board) const;
+    // Whether apply(s) would change anything.
+    bool improves(const ScoreSubmission& s) const;
+    bool apply(const ScoreSubmission& s);
+    // Moves `player` on `board` from `old_value` (0 = not on it) to `value`.
+    void reindex(BoardId board, uint64_t player, uint64_t old_value, uint64_t value);
+    void append(const ScoreSubmission& s);
+    void sync_log();  // every options_.sync_every records
+    void open_log();
+    void rotate_log();
+    void compactor_loop();
+
+    std::string dir_;
+    LeaderboardOptions options_;
+
+    mutable std::shared_mutex mutex_;  // boards, bests and the open log
+    std::unordered_map<std::pair<uint64_t, uint64_t>, Index, PairHash> boards_;  // (kind, tower)
+    uint64_t entries_ = 0;
+    std::unordered_map<std::pair<uint64_t, uint64_t>, Best, PairHash> bests_;  // (tower, player)
+    std::unordered_map<uint64_t, uint64_t> totals_;                            // player -> total score
+    std::FILE* log_ = nullptr;
+    uint32_t generation_ = 0;
+    uint64_t log_records_ = 0;
+    uint64_t unsynced_ = 0;
+    uint64_t submissions_ = 0;
+    uint64_t improvements_ = 0;
+
+    // Background compaction: fold every closed log up to `fold_to_`.
+    mutable std::mutex compact_mutex_;
+    std::condition_variable compact_cv_;
+    uint32_t fold_to_ = 0;    // newest closed log to fold
+    uint32_t snapshot_ = 0;   // newest snapshot written (0 = none)
+    uint32_t failed_ = 0;     // newest fold that failed; retried on the next rotation
+    uint64_t compactions_ = 0;
+    uint64_t compaction_failures_ = 0;
+    bool stopping_ = false;
+    std::thread compactor_;
+};
+
+// Integrity check stored in each record; catches torn and corrupt writes.
+uint32_t board_record_check(const BoardRecord& r);
+
+}  // namespace toppler
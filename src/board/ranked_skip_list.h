@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "core/rng.h"
+
+namespace toppler {
+
+// Ordered set of unique keys with rank queries: insert, erase, lower_bound
+// and "how many keys sort before this one" are all O(log n). Each forward
+// link stores its span, the number of level-0 steps it skips, so a search
+// that adds up the spans it follows knows the rank of where it stopped.
+//
+// Layout is for cache misses, which is what a search over a big board costs:
+// a node is `height` consecutive links in one flat vector (its id is the
+// offset of the first), and each link carries a copy of the key it points
+// at. A search compares against the link it is standing on and only touches
+// memory elsewhere when it actually moves, so it costs about one miss per
+// step forward. Erased nodes are recycled per height. Not thread-safe.
+template <class Key, class Less = std::less<Key>>
+class RankedSkipList {
+public:
+    static constexpr uint32_t kNil = UINT32_MAX;
+    static constexpr int kMaxHeight = 16;  // 4^16 keys before heights stop growing
+
+    RankedSkipList() { clear(); }
+
+    size_t size() const { return size_; }
+
+    void clear() {
+        links_.assign(kMaxHeight, Link{Key{}, kNil, 0});  // the head, node 0
+        heights_.assign(kMaxHeight, 0);
+        heights_[0] = kMaxHeight;
+        for (std::vector<uint32_t>& f : free_) f.clear();
+        height_ = 1;
+        size_ = 0;
+        rng_ = rng_seed(0);
+    }
+
+    // False if an equal key is already present.
+    bool insert(const Key& key) {
+        uint32_t update[kMaxHeight];
+        uint32_t rank[kMaxHeight];
+        uint32_t x = 0;
+        for (int l = height_ - 1; l >= 0; --l) {
+            rank[l] = l == height_ - 1 ? 0 : rank[l + 1];
+            for (const Link* k; (k = &links_[x + l])->next != kNil && less_(k->key, key);) {
+                rank[l] += k->span;
+                x = k->next;
+            }
+            update[l] = x;
+        }
+        const Link& after = links_[x];
+        if (after.next != kNil && !less_(key, after.key)) return false;
+
+        int h = random_height();
+        if (h > height_) {
+            for (int l = height_; l < h; ++l) {
+                rank[l] = 0;
+                update[l] = 0;
+                links_[l].span = static_cast<uint32_t>(size_);
+            }
+            height_ = h;
+        }
+        uint32_t node = allocate(h);  // may grow links_: index, don't hold references
+        for (int l = 0; l < h; ++l) {
+            Link& prev = links_[update[l] + l];
+            links_[node + l] = Link{prev.key, prev.next, prev.span - (rank[0] - rank[l])};
+            prev = Link{key, node, rank[0] - rank[l] + 1};
+        }
+        for (int l = h; l < height_; ++l) ++links_[update[l] + l].span;
+        ++size_;
+        return true;
+    }
+
+    // False if no equal key is present.
+    bool erase(const Key& key) {
+        uint32_t update[kMaxHeight];
+        uint32_t x = 0;
+        for (int l = height_ - 1; l >= 0; --l) {
+            for (const Link* k; (k = &links_[x + l])->next != kNil && less_(k->key, key);) x = k->next;
+            update[l] = x;
+        }
+        const Link& at = links_[x];
+        if (at.next == kNil || less_(key, at.key)) return false;
+        uint32_t node = at.next;
+        for (int l = 0; l < height_; ++l) {
+            Link& prev = links_[update[l] + l];
+            if (prev.next == node) {
+                const Link& skipped = links_[node + l];
+                prev = Link{skipped.key, skipped.next, prev.span + skipped.span - 1};
+            } else {
+                --prev.span;
+            }
+        }
+        while (height_ > 1 && links_[height_ - 1].next == kNil) --height_;
+        free_[heights_[node] - 1].push_back(node);
+        --size_;
+        return true;
+    }
+
+    // Number of keys that sort before `key` (present or not).
+    size_t rank(const Key& key) const {
+        size_t r = 0;
+        uint32_t x = 0;
+        for (int l = height_ - 1; l >= 0; --l) {
+            for (const Link* k; (k = &links_[x + l])->next != kNil && less_(k->key, key);) {
+                r += k->span;
+                x = k->next;
+            }
+        }
+        return r;
+    }
+
+    // Walks keys in order from the first one not before `key`, calling
+    // fn(const Key&) until it returns false or the keys run out.
+    template <class Fn>
+    void scan_from(const Key& key, Fn&& fn) const {
+        uint32_t x = 0;
+        for (int l = height_ - 1; l >= 0; --l) {
+            for (const Link* k; (k = &links_[x + l])->next != kNil && less_(k->key, key);) x = k->next;
+        }
+        for (const Link* k = &links_[x]; k->next != kNil && fn(k->key); k = &links_[k->next]) {
+        }
+    }
+
+private:
+    struct Link {
+        Key key;        // of the node `next` points at
+        uint32_t next;  // node id, or kNil
+        uint32_t span;
+    };
+
+    // P(height > h) = 4^-h: about 1.33 links per key.
+    int random_height() {
+        int h = 1;
+        while (h < kMaxHeight && (rng_next(rng_) & 3) == 0) ++h;
+        return h;
+    }
+
+    uint32_t allocate(int height) {
+        std::vector<uint32_t>& f = free_[height - 1];
+        if (!f.empty()) {
+            uint32_t node = f.back();
+            f.pop_back();
+            return node;
+        }
+        uint32_t node = static_cast<uint32_t>(links_.size());
+        links_.resize(links_.size() + height);
+        heights_.resize(links_.size(), 0);
+        heights_[node] = static_cast<uint8_t>(height);
+        return node;
+    }
+
+    std::vector<Link> links_;
+    std::vector<uint8_t> heights_;            // per node id, parallel to links_
+    std::vector<uint32_t> free_[kMaxHeight];  // erased nodes by height - 1
+    int height_ = 1;
+    size_t size_ = 0;
+    uint32_t rng_ = 0;
+    Less less_;
+};
+
+}  // namespace toppler
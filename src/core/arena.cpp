@@ -0,0 +1,41 @@
+#include "core/arena.h"
+
+#include <algorithm>
+
+namespace toppler {
+
+FrameArena::FrameArena(size_t capacity) : main_size_(std::max<size_t>(capacity, 256)) {
+    main_ = std::make_unique<unsigned char[]>(main_size_);
+    reset();
+}
+
+void* FrameArena::allocate_slow(size_t bytes, size_t align) {
+    // Account for what the current block holds, then chain a new one.
+    retired_ += cursor_ - block_begin_;
+    size_t size = std::max(main_size_, bytes + align);
+    overflow_.push_back(Block{std::make_unique<unsigned char[]>(size), size});
+    ++overflows_;
+    block_begin_ = reinterpret_cast<uintptr_t>(overflow_.back().data.get());
+    cursor_ = block_begin_;
+    limit_ = block_begin_ + size;
+    return allocate(bytes, align);
+}
+
+size_t FrameArena::used() const { return retired_ + (cursor_ - block_begin_); }
+
+void FrameArena::reset() {
+    size_t u = main_ ? used() : 0;
+    high_water_ = std::max(high_water_, u);
+    if (!overflow_.empty()) {
+        // This tick needed more than the main block: grow it to fit.
+        overflow_.clear();
+        main_size_ = std::max(main_size_ * 2, u + u / 2);
+        main_ = std::make_unique<unsigned char[]>(main_size_);
+    }
+    retired_ = 0;
+    block_begin_ = reinterpret_cast<uintptr_t>(main_.get());
+    cursor_ = block_begin_;
+    limit_ = block_begin_ + main_size_;
+}
+
+}  // namespace toppler
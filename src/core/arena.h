@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace toppler {
+
+// Bump allocator for objects that live for one tick (events, contact lists,
+// search candidates). Allocation is a pointer increment; reset() frees
+// everything at once. Memory is reused across ticks, so after the first few
+// ticks a steady workload never reaches malloc: if a tick outgrows the
+// current block an overflow block is chained on, and the next reset()
+// replaces them with one block big enough for the whole tick.
+//
+// Only trivially destructible types: nothing is ever destroyed.
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity = 64 * 1024);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        uintptr_t p = (cursor_ + (align - 1)) & ~static_cast<uintptr_t>(align - 1);
+        if (p + bytes > limit_) return allocate_slow(bytes, align);
+        cursor_ = p + bytes;
+        return reinterpret_cast<void*>(p);
+    }
+
+    // Uninitialized storage for n objects of T.
+    template <class T>
+    T* allocate_array(size_t n) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    template <class T, class... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+    }
+
+    // Frees everything allocated since the last reset.
+    void reset();
+
+    size_t used() const;  // bytes handed out since the last reset
+    size_t capacity() const { return main_size_; }
+    size_t high_water() const { return high_water_; }
+    // Times a tick overflowed into a chained block (each grows the arena once).
+    uint64_t overflows() const { return overflows_; }
+
+private:
+    void* allocate_slow(size_t bytes, size_t align);
+
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    std::unique_ptr<unsigned char[]> main_;
+    size_t main_size_ = 0;
+    std::vector<Block> overflow_;
+    size_t retired_ = 0;  // bytes used in blocks before the current one
+    uintptr_t cursor_ = 0;
+    uintptr_t limit_ = 0;
+    uintptr_t block_begin_ = 0;
+    size_t high_water_ = 0;
+    uint64_t overflows_ = 0;
+};
+
+// Growable array in a FrameArena for trivially copyable T. Growing copies
+// into a new arena region and abandons the old one until the next reset,
+// which is cheap next to the allocation it replaces. Invalid after the
+// arena is reset.
+template <class T>
+class ArenaVector {
+    static_assert(std::is_trivially_copyable_v<T>, "ArenaVector copies elements bytewise");
+
+public:
+    ArenaVector() = default;
+    explicit ArenaVector(FrameArena& arena, size_t reserve = 0) : arena_(&arena) {
+        if (reserve) grow(reserve);
+    }
+
+    void push_back(const T& value) {
+        if (size_ == capacity_) grow(capacity_ ? capacity_ * 2 : 8);
+        data_[size_++] = value;
+    }
+    void clear() { size_ = 0; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    T* begin() { return data_; }
+    T* end() { return data_ + size_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+
+private:
+    void grow(size_t capacity) {
+        T* next = arena_->allocate_array<T>(capacity);
+        if (size_) std::memcpy(next, data_, size_ * sizeof(T));
+        data_ = next;
+        capacity_ = capacity;
+    }
+
+    FrameArena* arena_ = nullptr;
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+}  // namespace toppler
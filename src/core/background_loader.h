@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace toppler {
+
+// One low-priority worker thread that runs loading jobs in submission order,
+// so decoding the next stage never competes with the frame loop for its
+// thread. Jobs must not throw; wrap their work and hand errors back through
+// whatever state they fill in.
+class BackgroundLoader {
+public:
+    BackgroundLoader();
+    // Finishes the running job, drops queued ones and joins.
+    ~BackgroundLoader();
+
+    BackgroundLoader(const BackgroundLoader&) = delete;
+    BackgroundLoader& operator=(const BackgroundLoader&) = delete;
+
+    void submit(std::function<void()> job);
+    // Blocks until the queue is empty and no job is running.
+    void wait_idle();
+
+private:
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::deque<std::function<void()>> jobs_;
+    bool busy_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+}  // namespace toppler
@@ -0,0 +1,87 @@
+#include "core/mapped_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace toppler {
+
+namespace {
+
+[[noreturn]] void fail(const std::string& path, const char* what) {
+    throw std::runtime_error(path + ": " + what + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) fail(path, "open");
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        fail(path, "stat");
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            int err = errno;
+            ::close(fd);
+            errno = err;
+            fail(path, "mmap");
+        }
+        data_ = static_cast<const uint8_t*>(p);
+    }
+    ::close(fd);  // the mapping keeps the file alive
+}
+
+void MappedFile::advise(size_t offset, size_t length, Advice advice) const {
+    if (!data_ || offset >= size_ || length == 0) return;
+    length = std::min(length, size_ - offset);
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t begin, end;
+    if (advice == Advice::WillNeed) {
+        begin = offset / page * page;
+        end = (offset + length + page - 1) / page * page;
+    } else {
+        // Only pages wholly inside the range: a partial page may hold
+        // bytes someone else still needs.
+        begin = (offset + page - 1) / page * page;
+        end = (offset + length) / page * page;
+        if (end <= begin) return;
+    }
+    ::madvise(const_cast<uint8_t*>(data_) + begin, end - begin,
+              advice == Advice::WillNeed ? MADV_WILLNEED : MADV_DONTNEED);
+}
+
+MappedFile::~MappedFile() { release(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+void MappedFile::release() {
+    if (data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+}  // namespace toppler
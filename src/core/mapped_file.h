@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace toppler {
+
+// Read-only memory map of a whole file. Pages are faulted in on first touch,
+// so opening a large pack costs a syscall, not a read of the file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    // Throws std::runtime_error if the file cannot be opened or mapped.
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    enum class Advice { WillNeed, DontNeed };
+    // Paging hint for bytes [offset, offset + length). WillNeed starts
+    // read-ahead on every page the range touches; DontNeed drops the pages
+    // wholly inside it (they are re-read from the file if touched again).
+    // Best effort, never throws.
+    void advise(size_t offset, size_t length, Advice advice) const;
+
+private:
+    void release();
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}  // namespace toppler
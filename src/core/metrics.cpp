@@ -0,0 +1,82 @@
+#include "core/metrics.h"
+
+#include <cstdio>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace toppler {
+
+namespace {
+
+void append_value(std::string& out, double value) {
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%.17g", value);
+    out += buf;
+}
+
+void append_series(std::string& out, const char* name, const char* suffix, const std::string& labels) {
+    out += name;
+    out += suffix;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+}
+
+}  // namespace
+
+void MetricsText::family(const char* name, const char* type, const char* help) {
+    text_ += "# HELP ";
+    text_ += name;
+    text_ += ' ';
+    text_ += help;
+    text_ += "\n# TYPE ";
+    text_ += name;
+    text_ += ' ';
+    text_ += type;
+    text_ += '\n';
+}
+
+void MetricsText::sample(const char* name, double value, const std::string& labels) {
+    append_series(text_, name, "", labels);
+    append_value(text_, value);
+    text_ += '\n';
+}
+
+void MetricsText::histogram(const char* name, const HistogramBuckets& layout, const HistogramTotals& totals,
+                            const std::string& labels) {
+    std::string prefix = labels.empty() ? std::string() : labels + ",";
+    uint64_t cumulative = 0;
+    char le[48];
+    for (size_t i = 0; i < layout.count; ++i) {
+        cumulative += totals.buckets[i];
+        std::snprintf(le, sizeof le, "le=\"%.9g\"", static_cast<double>(layout.bounds[i]) * layout.scale);
+        append_series(text_, name, "_bucket", prefix + le);
+        append_value(text_, static_cast<double>(cumulative));
+        text_ += '\n';
+    }
+    append_series(text_, name, "_bucket", prefix + "le=\"+Inf\"");
+    append_value(text_, static_cast<double>(totals.count));
+    text_ += '\n';
+    append_series(text_, name, "_sum", labels);
+    append_value(text_, static_cast<double>(totals.sum) * layout.scale);
+    text_ += '\n';
+    append_series(text_, name, "_count", labels);
+    append_value(text_, static_cast<double>(totals.count));
+    text_ += '\n';
+}
+
+uint64_t heap_bytes_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return static_cast<uint64_t>(info.uordblks + info.hblkhd);
+#else
+    return 0;
+#endif
+}
+
+}  // namespace toppler
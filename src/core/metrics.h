@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace toppler {
+
+// Runtime counters for servers and batch tools, exported in the Prometheus
+// text format (see MetricsServer in net/metrics_server.h).
+//
+// Every counter has exactly one writer: a shard or worker thread keeps its
+// own set, on cache lines of its own, and bumps it with a relaxed load and
+// store (no locked read-modify-write, no contention in the hot loop). A
+// scrape reads all the sets with relaxed loads and adds them up. Each value
+// is exact; the set as a whole is not a snapshot, which scrapes never need.
+
+// Single-writer increment.
+inline void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+constexpr size_t kMaxHistogramBuckets = 16;
+
+// Bucket layout of a histogram: inclusive upper bounds, ascending, in the
+// integer units observe() takes. `scale` converts those units to the
+// exported ones (1e-6 for microseconds exported as seconds).
+struct HistogramBuckets {
+    const uint64_t* bounds;
+    size_t count;  // at most kMaxHistogramBuckets
+    double scale = 1.0;
+};
+
+// Summed counts of one or more HistogramCells. buckets[i] counts values in
+// (bounds[i - 1], bounds[i]]; buckets[count] those above the last bound.
+struct HistogramTotals {
+    uint64_t buckets[kMaxHistogramBuckets + 1] = {};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+};
+
+// One writer's histogram.
+class HistogramCells {
+public:
+    void observe(const HistogramBuckets& layout, uint64_t value) {
+        size_t i = static_cast<size_t>(std::lower_bound(layout.bounds, layout.bounds + layout.count, value) -
+                                       layout.bounds);
+        bump(buckets_[i]);
+        bump(count_);
+        bump(sum_, value);
+    }
+
+    void add_to(HistogramTotals& totals) const {
+        for (size_t i = 0; i <= kMaxHistogramBuckets; ++i) {
+            totals.buckets[i] += buckets_[i].load(std::memory_order_relaxed);
+        }
+        totals.count += count_.load(std::memory_order_relaxed);
+        totals.sum += sum_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> buckets_[kMaxHistogramBuckets + 1] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+};
+
+// Builds one scrape's worth of Prometheus text (exposition format 0.0.4).
+// Call family() once per metric name, then add its samples.
+class MetricsText {
+public:
+    // type: "counter", "gauge" or "histogram".
+    void family(const char* name, const char* type, const char* help);
+    // `labels` is the inside of the braces, e.g. shard="3"; empty for none.
+    void sample(const char* name, double value, const std::string& labels = {});
+    // Writes the cumulative _bucket series, _sum and _count.
+    void histogram(const char* name, const HistogramBuckets& layout, const HistogramTotals& totals,
+                   const std::string& labels = {});
+
+    const std::string& text() const { return text_; }
+
+private:
+    std::string text_;
+};
+
+// Bytes the C heap has handed out and not had back (glibc's mallinfo2),
+// i.e. what the allocator holds in use for the whole process. Read at
+// scrape time only; 0 where unavailable.
+uint64_t heap_bytes_in_use();
+
+}  // namespace toppler
@@ -0,0 +1,271 @@
+#include "core/profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+namespace toppler {
+
+namespace {
+
+double calibrate_ticks_per_us() {
+#if TT_PROFILE_RDTSC
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    uint64_t c0 = profile_ticks();
+    while (clock::now() - t0 < std::chrono::milliseconds(5)) {
+    }
+    uint64_t c1 = profile_ticks();
+    double us = std::chrono::duration<double, std::micro>(clock::now() - t0).count();
+    return static_cast<double>(c1 - c0) / us;
+#else
+    return 1000.0;
+#endif
+}
+
+uint8_t thread_number() {
+    static std::atomic<uint8_t> next{0};
+    thread_local uint8_t number = next.fetch_add(1, std::memory_order_relaxed);
+    return number;
+}
+
+}  // namespace
+
+thread_local Profiler* Profiler::bound_ = nullptr;
+
+const char* profile_zone_name(ProfileZone zone) {
+    switch (zone) {
+        case ProfileZone::Input:
+            return "input";
+        case ProfileZone::Sim:
+            return "sim";
+        case ProfileZone::EnemyUpdate:
+            return "enemy_update";
+        case ProfileZone::Collision:
+            return "collision";
+        case ProfileZone::TowerDraw:
+            return "tower_draw";
+        case ProfileZone::SpriteDraw:
+            return "sprite_draw";
+        case ProfileZone::AudioMix:
+            return "audio_mix";
+        case ProfileZone::Present:
+            return "present";
+        default:
+            return "?";
+    }
+}
+
+double profile_ticks_per_us() {
+    static const double ticks_per_us = calibrate_ticks_per_us();
+    return ticks_per_us;
+}
+
+// A thread's own events. Written by that thread only; count is published
+// after each event, so readers copy an entry and then check it was not
+// overwritten meanwhile.
+struct Profiler::Ring {
+    Ring(size_t capacity, const void* owner) : events(new ProfileEvent[capacity]), owner(owner) {}
+
+    std::unique_ptr<ProfileEvent[]> events;
+    const void* owner;  // the writing thread's RingCache, while it runs
+    uint8_t thread = thread_number();
+    alignas(64) std::atomic<uint64_t> count{0};
+};
+
+namespace {
+
+// Which profiler's ring a thread last used; one entry is enough for the
+// usual one profiler per process.
+struct RingCache {
+    uint64_t profiler = 0;
+    void* ring = nullptr;
+};
+thread_local RingCache t_ring_cache;
+
+std::atomic<uint64_t> g_next_profiler_id{1};
+
+}  // namespace
+
+Profiler::Profiler(size_t events_per_thread, size_t frame_capacity)
+    : id_(g_next_profiler_id.fetch_add(1, std::memory_order_relaxed)),
+      ring_capacity_(std::max<size_t>(events_per_thread, 1)),
+      frames_(new FrameProfile[std::max<size_t>(frame_capacity, 1)]),
+      frame_capacity_(std::max<size_t>(frame_capacity, 1)),
+      epoch_(profile_ticks()) {
+    profile_ticks_per_us();  // calibrate now rather than in the first overlay frame
+}
+
+Profiler::~Profiler() = default;
+
+Profiler* Profiler::bind(Profiler* profiler) {
+    Profiler* previous = bound_;
+    bound_ = profiler;
+    if (profiler) profiler->thread_ring();  // allocate it now, not inside the first timed zone
+    return previous;
+}
+
+Profiler::Ring* Profiler::thread_ring() {
+    RingCache& cache = t_ring_cache;
+    if (cache.profiler == id_) return static_cast<Ring*>(cache.ring);
+    std::lock_guard<std::mutex> lock(claim_mutex_);
+    size_t n = ring_count_.load(std::memory_order_relaxed);
+    Ring* ring = nullptr;
+    // A thread that was bound before (or an exited one at the same
+    // thread-local address, which no longer writes) keeps its ring.
+    for (size_t i = 0; i < n && !ring; ++i) {
+        if (rings_[i]->owner == &cache) ring = rings_[i].get();
+    }
+    if (!ring && n < kMaxThreads) {
+        rings_[n] = std::make_unique<Ring>(ring_capacity_, &cache);
+        ring = rings_[n].get();
+        ring_count_.store(n + 1, std::memory_order_release);
+    }
+    cache = RingCache{id_, ring};
+    return ring;
+}
+
+void Profiler::begin_frame() {
+    open_start_ = profile_ticks();
+    open_frame_.store(static_cast<uint32_t>(frame_count_.load(std::memory_order_relaxed)),
+                      std::memory_order_relaxed);
+}
+
+void Profiler::end_frame() {
+    uint32_t frame = open_frame_.load(std::memory_order_relaxed);
+    if (frame == kNoProfileFrame) return;
+    open_frame_.store(kNoProfileFrame, std::memory_order_relaxed);
+    uint64_t count = frame_count_.load(std::memory_order_relaxed);
+    FrameProfile& f = frames_[count % frame_capacity_];
+    f = FrameProfile{};
+    f.frame = frame;
+    f.start = open_start_;
+    f.end = profile_ticks();
+    frame_count_.store(count + 1, std::memory_order_release);
+}
+
+void Profiler::record(ProfileZone zone, uint64_t start, uint64_t end) {
+    Ring* ring = thread_ring();
+    if (!ring) {
+        unringed_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t count = ring->count.load(std::memory_order_relaxed);
+    ring->events[count % ring_capacity_] =
+        ProfileEvent{start, end, open_frame_.load(std::memory_order_relaxed), zone, ring->thread, 0};
+    ring->count.store(count + 1, std::memory_order_release);
+}
+
+// Calls fn(event) for each thread's events, newest first, back to the first
+// that ended before `since`. Entries overwritten while being read are cut.
+template <class Fn>
+void Profiler::for_each_event_since(uint64_t since, Fn fn) const {
+    size_t rings = ring_count_.load(std::memory_order_acquire);
+    for (size_t r = 0; r < rings; ++r) {
+        const Ring& ring = *rings_[r];
+        uint64_t count = ring.count.load(std::memory_order_acquire);
+        uint64_t oldest = count > ring_capacity_ ? count - ring_capacity_ : 0;
+        for (uint64_t i = count; i-- > oldest;) {
+            ProfileEvent e = ring.events[i % ring_capacity_];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (i + ring_capacity_ <= ring.count.load(std::memory_order_relaxed)) break;  // overwritten
+            if (e.end < since) break;
+            fn(e);
+        }
+    }
+}
+
+size_t Profiler::copy_frames(FrameProfile* out, size_t max) const {
+    uint64_t count = frame_count_.load(std::memory_order_acquire);
+    size_t n = static_cast<size_t>(std::min<uint64_t>({count, frame_capacity_, max}));
+    for (size_t i = 0; i < n; ++i) out[i] = frames_[(count - n + i) % frame_capacity_];
+    // Readers on other threads than the main loop may race end_frame().
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t now = frame_count_.load(std::memory_order_relaxed);
+    size_t torn = 0;
+    while (torn < n && count - n + torn + frame_capacity_ <= now) ++torn;
+    if (torn) std::copy(out + torn, out + n, out);
+    return n - torn;
+}
+
+void Profiler::recent_frames(std::vector<FrameProfile>& out, size_t max) const {
+    out.resize(std::min(max, frame_capacity_));
+    out.resize(copy_frames(out.data(), out.size()));
+    if (out.empty()) return;
+    uint32_t first = out.front().frame;
+    size_t n = out.size();
+    for_each_event_since(out.front().start, [&](const ProfileEvent& e) {
+        if (e.frame == kNoProfileFrame || e.frame - first >= n || e.zone >= ProfileZone::kCount) return;
+        out[e.frame - first].zone_ticks[static_cast<int>(e.zone)] += e.end - e.start;
+    });
+}
+
+void Profiler::zone_averages_us(double out[kProfileZones], size_t frames) const {
+    uint64_t count = frame_count_.load(std::memory_order_acquire);
+    size_t n = static_cast<size_t>(std::min<uint64_t>({count, frame_capacity_, frames}));
+    uint64_t sums[kProfileZones] = {};
+    if (n) {
+        // Frames are numbered consecutively: the window is the n before
+        // `count`. The oldest one's start only bounds the scan; events are
+        // picked by frame number.
+        uint32_t first = static_cast<uint32_t>(count - n);
+        uint64_t since = frames_[(count - n) % frame_capacity_].start;
+        for_each_event_since(since, [&](const ProfileEvent& e) {
+            if (e.frame == kNoProfileFrame || e.frame - first >= n || e.zone >= ProfileZone::kCount) return;
+            sums[static_cast<int>(e.zone)] += e.end - e.start;
+        });
+    }
+    double scale = n ? 1.0 / (static_cast<double>(n) * profile_ticks_per_us()) : 0.0;
+    for (int z = 0; z < kProfileZones; ++z) out[z] = static_cast<double>(sums[z]) * scale;
+}
+
+void Profiler::events(std::vector<ProfileEvent>& out) const {
+    out.clear();
+    for_each_event_since(0, [&](const ProfileEvent& e) { out.push_back(e); });
+    std::sort(out.begin(), out.end(), [](const ProfileEvent& a, const ProfileEvent& b) { return a.start < b.start; });
+}
+
+uint64_t Profiler::dropped_events() const {
+    uint64_t dropped = unringed_.load(std::memory_order_relaxed);
+    size_t rings = ring_count_.load(std::memory_order_acquire);
+    for (size_t r = 0; r < rings; ++r) {
+        uint64_t count = rings_[r]->count.load(std::memory_order_relaxed);
+        if (count > ring_capacity_) dropped += count - ring_capacity_;
+    }
+    return dropped;
+}
+
+std::string chrome_trace_json(const Profiler& profiler) {
+    std::vector<ProfileEvent> events;
+    profiler.events(events);
+    double per_us = profile_ticks_per_us();
+    uint64_t epoch = profiler.epoch();
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char buf[192];
+    for (size_t i = 0; i < events.size(); ++i) {
+        const ProfileEvent& e = events[i];
+        double ts = static_cast<double>(e.start - epoch) / per_us;
+        double dur = static_cast<double>(e.end - e.start) / per_us;
+        std::snprintf(buf, sizeof buf,
+                      "%s{\"name\":\"%s\",\"cat\":\"toppler\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,"
+                      "\"tid\":%u,\"args\":{\"frame\":%lld}}",
+                      i ? ",\n" : "\n", profile_zone_name(e.zone), ts, dur, e.thread,
+                      e.frame == kNoProfileFrame ? -1LL : static_cast<long long>(e.frame));
+        out += buf;
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+void write_chrome_trace(const Profiler& profiler, const std::string& path) {
+    std::string json = chrome_trace_json(profiler);
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) throw std::runtime_error("cannot create " + path);
+    bool ok = std::fwrite(json.data(), 1, json.size(), f) == json.size();
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) throw std::runtime_error("cannot write " + path);
+}
+
+}  // namespace toppler
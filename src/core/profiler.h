@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TT_PROFILE_RDTSC 1
+#else
+#include <chrono>
+#define TT_PROFILE_RDTSC 0
+#endif
+
+// Compiled-in scoped timers unless the build turns them off (TT_PROFILER=0).
+#ifndef TT_PROFILER
+#define TT_PROFILER 1
+#endif
+
+namespace toppler {
+
+// Frame stages the profiler knows about. The overlay and trace export use
+// these names; the order is the overlay's stacking order.
+enum class ProfileZone : uint8_t {
+    Input = 0,
+    Sim,
+    EnemyUpdate,  // inside Sim
+    Collision,    // inside Sim
+    TowerDraw,
+    SpriteDraw,
+    AudioMix,
+    Present,
+    kCount
+};
+constexpr int kProfileZones = static_cast<int>(ProfileZone::kCount);
+
+const char* profile_zone_name(ProfileZone zone);
+
+// Raw timestamps: the TSC on x86 (a couple of ns to read; assumes the
+// invariant TSC every current x86 CPU has), steady_clock nanoseconds
+// elsewhere. Convert with profile_ticks_per_us().
+inline uint64_t profile_ticks() {
+#if TT_PROFILE_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#endif
+}
+
+// Calibrated against steady_clock on first use (a few ms, once per process).
+double profile_ticks_per_us();
+
+// One timed zone.
+struct ProfileEvent {
+    uint64_t start;
+    uint64_t end;
+    uint32_t frame;  // frame open when it was recorded, kNoProfileFrame if none
+    ProfileZone zone;
+    uint8_t thread;  // small per-process thread number, for the trace
+    uint16_t reserved;
+};
+constexpr uint32_t kNoProfileFrame = UINT32_MAX;
+
+// Per-zone totals for one frame, in ticks. Nested zones (EnemyUpdate inside
+// Sim) are counted in both.
+struct FrameProfile {
+    uint32_t frame;
+    uint64_t start;
+    uint64_t end;
+    uint64_t zone_ticks[kProfileZones];
+};
+
+// Collects zone timings into fixed rings, one per recording thread: the
+// last `events_per_thread` events of each, for trace export, and the last
+// `frame_capacity` frame boundaries for the overlay. Each ring has a single
+// writer, so record() takes no lock and touches no shared cache line; the
+// readers merge the rings and work out the per-frame totals themselves.
+// A thread's ring is allocated when it binds the profiler (or first records
+// without binding); at most kMaxThreads threads get one, later ones' events
+// are counted as dropped.
+//
+// Timers reach a profiler through the calling thread's binding (bind()),
+// so code deep inside the sim needs no profiler parameter and pays one
+// thread-local load when none is bound.
+class Profiler {
+public:
+    static constexpr size_t kMaxThreads = 32;
+
+    explicit Profiler(size_t events_per_thread = 1 << 14, size_t frame_capacity = 240);
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Frame boundaries, from the thread running the main loop.
+    void begin_frame();
+    void end_frame();
+
+    void record(ProfileZone zone, uint64_t start, uint64_t end);
+
+    // Completed frames, oldest first, at most `max` of the most recent.
+    void recent_frames(std::vector<FrameProfile>& out, size_t max) const;
+    // Mean of each zone over the last `frames` completed frames, in µs.
+    void zone_averages_us(double out[kProfileZones], size_t frames) const;
+    // Stored events of every thread, oldest first.
+    void events(std::vector<ProfileEvent>& out) const;
+
+    uint64_t epoch() const { return epoch_; }
+    uint64_t dropped_events() const;  // overwritten before being exported, or past kMaxThreads
+
+    // The profiler timers on this thread report to; nullptr for none.
+    static Profiler* current() { return bound_; }
+    // Binds `profiler` to the calling thread, returning the previous one.
+    static Profiler* bind(Profiler* profiler);
+
+private:
+    struct Ring;
+    Ring* thread_ring();
+    size_t copy_frames(FrameProfile* out, size_t max) const;
+    template <class Fn>
+    void for_each_event_since(uint64_t since, Fn fn) const;
+
+    const uint64_t id_;  // tells thread_ring()'s per-thread cache which profiler it holds
+    size_t ring_capacity_;
+    std::unique_ptr<Ring> rings_[kMaxThreads];
+    std::atomic<size_t> ring_count_{0};  // rings_[0, ring_count_) are published
+    std::mutex claim_mutex_;             // taken once per thread, to claim its ring
+    std::atomic<uint64_t> unringed_{0};  // events of threads past kMaxThreads
+
+    // Written by the main loop thread only.
+    std::unique_ptr<FrameProfile[]> frames_;
+    size_t frame_capacity_;
+    std::atomic<uint64_t> frame_count_{0};
+    std::atomic<uint32_t> open_frame_{kNoProfileFrame};
+    uint64_t open_start_ = 0;
+    uint64_t epoch_;
+
+    static thread_local Profiler* bound_;
+};
+
+// Binds a profiler to the current thread for a scope.
+class ProfilerBinding {
+public:
+    explicit ProfilerBinding(Profiler* profiler) : previous_(Profiler::bind(profiler)) {}
+    ~ProfilerBinding() { Profiler::bind(previous_); }
+    ProfilerBinding(const ProfilerBinding&) = delete;
+    ProfilerBinding& operator=(const ProfilerBinding&) = delete;
+
+private:
+    Profiler* previous_;
+};
+
+// Times its scope into the thread's bound profiler, if any.
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileZone zone) : profiler_(Profiler::current()), zone_(zone) {
+        if (profiler_) start_ = profile_ticks();
+    }
+    ~ProfileScope() {
+        if (profiler_) profiler_->record(zone_, start_, profile_ticks());
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler* profiler_;
+    ProfileZone zone_;
+    uint64_t start_ = 0;
+};
+
+// Chrome trace event format ("X" complete events), for chrome://tracing,
+// Perfetto or speedscope. Timestamps are µs since the profiler was created.
+std::string chrome_trace_json(const Profiler& profiler);
+// Throws std::runtime_error if the file cannot be written.
+void write_chrome_trace(const Profiler& profiler, const std::string& path);
+
+}  // namespace toppler
+
+#define TT_PROFILE_CAT2(a, b) a##b
+#define TT_PROFILE_CAT(a, b) TT_PROFILE_CAT2(a, b)
+#if TT_PROFILER
+#define TT_PROFILE_ZONE(zone) ::toppler::ProfileScope TT_PROFILE_CAT(tt_profile_, __LINE__)(::toppler::ProfileZone::zone)
+#else
+#define TT_PROFILE_ZONE(zone) ((void)0)
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+namespace toppler {
+
+// xorshift32. The state word lives inside whatever owns it (usually SimState)
+// so that copying the owner copies the random stream too.
+inline uint32_t rng_next(uint32_t& state) {
+    uint32_t x = state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state = x;
+    return x;
+}
+
+// Uniform-ish value in [0, bound). bound must be non-zero.
+inline uint32_t rng_below(uint32_t& state, uint32_t bound) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(rng_next(state)) * bound) >> 32);
+}
+
+// xorshift must never be seeded with zero.
+inline uint32_t rng_seed(uint32_t seed) { return seed ? seed : 0x6d2b79f5u; }
+
+}  // namespace toppler
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace toppler {
+
+// Bounded single-producer single-consumer queue with no locks and no
+// allocation after construction: push and pop are a few loads and one
+// release store each, so a real-time thread can drain it on a deadline.
+// Exactly one thread may push and exactly one (other) thread may pop.
+//
+// The head and tail indices live on their own cache lines, and each side
+// keeps a cached copy of the other's index, so in the common case neither
+// side touches the line the other is writing.
+template <class T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "elements are copied without running destructors");
+
+public:
+    static constexpr size_t kCapacity = N;
+
+    // Producer. False, leaving the ring unchanged, when full.
+    bool push(const T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == N) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == N) return false;
+        }
+        slots_[tail & (N - 1)] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer. False when empty.
+    bool pop(T& out) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) return false;
+        }
+        out = slots_[head & (N - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Either side; exact only when the other side is idle.
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head_{0};  // next slot to pop, written by the consumer
+    size_t tail_cache_ = 0;                    // consumer's view of tail_
+    alignas(64) std::atomic<size_t> tail_{0};  // next slot to push, written by the producer
+    size_t head_cache_ = 0;                    // producer's view of head_
+    alignas(64) T slots_[N];
+};
+
+}  // namespace toppler
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace toppler {
+
+// Fixed set of worker threads for data-parallel loops over independent items
+// (sessions, replays, candidate towers). The calling thread always takes part,
+// so a pool of size 1 runs everything inline with no threads at all.
+class ThreadPool {
+public:
+    // threads == 0 uses std::thread::hardware_concurrency().
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Participants in a parallel_for, including the caller.
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // Calls body(begin, end) on disjoint chunks covering [0, count), at most
+    // `grain` items each, and returns once every chunk has run. Chunks are
+    // handed out dynamically so uneven items still balance. Not reentrant.
+    template <class Body>
+    void parallel_for(size_t count, size_t grain, Body&& body) {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+        if (workers_.empty() || count <= grain) {
+            body(size_t{0}, count);
+            return;
+        }
+        auto trampoline = [](void* ctx, size_t begin, size_t end) {
+            (*static_cast<std::remove_reference_t<Body>*>(ctx))(begin, end);
+        };
+        run(count, grain, trampoline, &body);
+    }
+
+private:
+    using ChunkFn = void (*)(void*, size_t, size_t);
+
+    void run(size_t count, size_t grain, ChunkFn fn, void* ctx);
+    void worker_loop();
+    void drain();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    uint64_t generation_ = 0;
+    unsigned busy_ = 0;
+    bool stop_ = false;
+
+    // Current job; written under mutex_ before generation_ is bumped.
+    ChunkFn fn_ = nullptr;
+    void* ctx_ = nullptr;
+    size_t count_ = 0;
+    size_t grain_ = 1;
+    std::atomic<size_t> next_{0};
+};
+
+}  // namespace toppler
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace toppler {
+
+// Latest-value channel between one writer and one reader that never block
+// each other. Three slots: the writer fills its back slot and publishes it
+// by swapping it with the shared middle slot; the reader, when it wants
+// something newer, swaps its front slot with the middle. At any instant each
+// side owns one slot outright, so the reader's front() stays valid and
+// unchanged until its next update(), however many values the writer
+// publishes meanwhile (intermediate ones are simply skipped).
+template <class T>
+class TripleBuffer {
+public:
+    // Writer: the slot to fill next. Contents are whatever was there three
+    // publishes ago, so overwrite every field that matters.
+    T& back() { return slots_[back_]; }
+    void publish() {
+        uint8_t prev = middle_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel);
+        back_ = prev & kIndex;
+    }
+
+    // Reader: takes the most recent published value if there is one newer
+    // than front(). True if front() changed.
+    bool update() {
+        if (!(middle_.load(std::memory_order_relaxed) & kFresh)) return false;
+        uint8_t prev = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = prev & kIndex;
+        return true;
+    }
+    const T& front() const { return slots_[front_]; }
+
+private:
+    static constexpr uint8_t kIndex = 3;
+    static constexpr uint8_t kFresh = 4;  // middle holds a value the reader has not taken
+
+    T slots_[3] = {};
+    uint8_t back_ = 0;                  // writer only
+    alignas(64) std::atomic<uint8_t> middle_{1};
+    alignas(64) uint8_t front_ = 2;     // reader only
+};
+
+}  // namespace toppler
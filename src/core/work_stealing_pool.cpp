@@ -0,0 +1,110 @@
+#include "core/work_stealing_pool.h"
+
+#include "core/metrics.h"
+
+namespace toppler {
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    slices_ = std::make_unique<Slice[]>(threads);
+    workers_.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i) workers_.emplace_back([this, i] { worker_loop(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : workers_) t.join();
+}
+
+void WorkStealingPool::run(size_t count, JobFn fn, void* ctx) {
+    unsigned n = size();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fn_ = fn;
+        ctx_ = ctx;
+        for (unsigned i = 0; i < n; ++i) {
+            std::lock_guard<std::mutex> slice_lock(slices_[i].mutex);
+            slices_[i].begin = count * i / n;
+            slices_[i].end = count * (i + 1) / n;
+        }
+        busy_ = static_cast<unsigned>(workers_.size());
+        ++generation_;
+    }
+    wake_.notify_all();
+    drain(0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return busy_ == 0; });
+}
+
+uint64_t WorkStealingPool::steals() const {
+    uint64_t total = 0;
+    for (unsigned i = 0; i < size(); ++i) total += slices_[i].steals.load(std::memory_order_relaxed);
+    return total;
+}
+
+bool WorkStealingPool::take(unsigned id, size_t& index) {
+    Slice& s = slices_[id];
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.begin == s.end) return false;
+    index = s.begin++;
+    return true;
+}
+
+// Moves the back half of some other participant's slice into ours.
+bool WorkStealingPool::steal(unsigned id) {
+    unsigned n = size();
+    for (unsigned k = 1; k < n; ++k) {
+        Slice& victim = slices_[(id + k) % n];
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            size_t left = victim.end - victim.begin;
+            if (left == 0) continue;
+            end = victim.end;
+            begin = victim.end - (left + 1) / 2;
+            victim.end = begin;
+        }
+        Slice& own = slices_[id];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = begin;
+        own.end = end;
+        bump(own.steals);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::drain(unsigned id) {
+    for (;;) {
+        size_t index;
+        if (take(id, index)) {
+            fn_(ctx_, index, id);
+            continue;
+        }
+        // Jobs never add jobs, so once every slice is empty the rest is
+        // already running and this participant is done.
+        if (!steal(id)) return;
+    }
+}
+
+void WorkStealingPool::worker_loop(unsigned id) {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+        drain(id);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--busy_ == 0) done_.notify_one();
+    }
+}
+
+}  // namespace toppler
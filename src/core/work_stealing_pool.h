@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace toppler {
+
+// Worker threads for many independent jobs of very uneven cost (a replay can
+// be ten seconds or ten minutes of play). Each participant starts with an
+// equal contiguous slice of the job indices and takes from its front; one
+// that runs dry steals the back half of another's slice. Participants only
+// touch each other's slices when stealing, so the common path is an
+// uncontended lock on a cache line of their own. The caller takes part, as
+// with ThreadPool.
+class WorkStealingPool {
+public:
+    // threads == 0 uses std::thread::hardware_concurrency().
+    explicit WorkStealingPool(unsigned threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // Calls body(index, worker) once for each index in [0, count) and returns
+    // when all have run. `worker` in [0, size()) names the participant
+    // (0 is the caller) so bodies can keep per-thread state. Not reentrant.
+    template <class Body>
+    void for_each(size_t count, Body&& body) {
+        if (count == 0) return;
+        auto trampoline = [](void* ctx, size_t index, unsigned worker) {
+            (*static_cast<std::remove_reference_t<Body>*>(ctx))(index, worker);
+        };
+        run(count, trampoline, &body);
+    }
+
+    // Successful steals since construction. Each participant counts its own;
+    // this sums them, so it can be read while jobs run.
+    uint64_t steals() const;
+
+private:
+    using JobFn = void (*)(void*, size_t, unsigned);
+
+    // Remaining job indices [begin, end) of one participant.
+    struct alignas(64) Slice {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+        std::atomic<uint64_t> steals{0};  // by this participant; written by it only
+    };
+
+    void run(size_t count, JobFn fn, void* ctx);
+    void worker_loop(unsigned id);
+    void drain(unsigned id);
+    bool take(unsigned id, size_t& index);
+    bool steal(unsigned id);
+
+    std::vector<std::thread> workers_;
+    std::unique_ptr<Slice[]> slices_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    uint64_t generation_ = 0;
+    unsigned busy_ = 0;
+    bool stop_ = false;
+
+    JobFn fn_ = nullptr;
+    void* ctx_ = nullptr;
+};
+
+}  // namespace toppler
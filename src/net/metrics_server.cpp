@@ -0,0 +1,125 @@
+#include "net/metrics_server.h"
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "net/udp_socket.h"
+
+namespace toppler {
+
+namespace {
+
+constexpr size_t kMaxRequestBytes = 4096;
+constexpr int kClientTimeoutMs = 2000;  // a scraper that stalls cannot hold the endpoint longer
+
+void send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;  // the scraper went away
+        sent += static_cast<size_t>(n);
+    }
+}
+
+std::string response(const char* status, const char* type, const std::string& body) {
+    return std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + type +
+           "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+}
+
+}  // namespace
+
+MetricsServer::MetricsServer(uint16_t port, const char* bind_host, std::function<std::string()> render)
+    : render_(std::move(render)) {
+    fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) throw NetError(std::string("socket: ") + std::strerror(errno));
+    int one = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind_host && inet_pton(AF_INET, bind_host, &local.sin_addr) != 1) {
+        close(fd_);
+        throw NetError(std::string("bad bind address ") + bind_host);
+    }
+    if (bind(fd_, reinterpret_cast<const sockaddr*>(&local), sizeof local) != 0 || listen(fd_, 8) != 0) {
+        int err = errno;
+        close(fd_);
+        throw NetError("metrics port " + std::to_string(port) + ": " + std::strerror(err));
+    }
+    socklen_t len = sizeof local;
+    getsockname(fd_, reinterpret_cast<sockaddr*>(&local), &len);
+    port_ = ntohs(local.sin_port);
+    wake_ = eventfd(0, EFD_CLOEXEC);
+    if (wake_ < 0) {
+        close(fd_);
+        throw NetError(std::string("eventfd: ") + std::strerror(errno));
+    }
+    thread_ = std::thread([this] { run(); });
+}
+
+MetricsServer::~MetricsServer() {
+    uint64_t one = 1;
+    ssize_t ignored = write(wake_, &one, sizeof one);
+    (void)ignored;
+    thread_.join();
+    close(wake_);
+    close(fd_);
+}
+
+void MetricsServer::run() {
+    pollfd fds[2] = {{fd_, POLLIN, 0}, {wake_, POLLIN, 0}};
+    for (;;) {
+        int n = poll(fds, 2, -1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 || (fds[1].revents & POLLIN)) return;
+        if (!(fds[0].revents & POLLIN)) continue;
+        int client = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) continue;
+        serve(client);
+        close(client);
+    }
+}
+
+void MetricsServer::serve(int client) {
+    timeval timeout{kClientTimeoutMs / 1000, (kClientTimeoutMs % 1000) * 1000};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout);
+
+    // Only the request line matters; read until the end of the headers.
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequestBytes) {
+        ssize_t n = recv(client, buf, sizeof buf, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        request.append(buf, static_cast<size_t>(n));
+    }
+    size_t line_end = request.find("\r\n");
+    if (line_end == std::string::npos) return;
+    std::string line = request.substr(0, line_end);
+
+    static const char kPath[] = "GET /metrics";
+    size_t path_end = sizeof kPath - 1;
+    bool metrics = line.compare(0, path_end, kPath) == 0 && line.size() > path_end &&
+                   (line[path_end] == ' ' || line[path_end] == '?');
+    if (metrics) {
+        scrapes_.fetch_add(1, std::memory_order_relaxed);
+        send_all(client, response("200 OK", "text/plain; version=0.0.4; charset=utf-8", render_()));
+    } else if (line.rfind("GET ", 0) == 0) {
+        send_all(client, response("404 Not Found", "text/plain", "try /metrics\n"));
+    } else {
+        send_all(client, response("405 Method Not Allowed", "text/plain", "GET only\n"));
+    }
+}
+
+}  // namespace toppler
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace toppler {
+
+// Minimal HTTP endpoint for Prometheus scrapes: answers GET /metrics with
+// whatever `render` returns (see MetricsText in core/metrics.h) and 404 to
+// anything else, one connection at a time, on a thread of its own. render()
+// runs on that thread, so it must only read counters that their owners
+// publish with relaxed atomics; it never blocks the threads being measured.
+class MetricsServer {
+public:
+    // Listens on TCP `port` (0 picks a free one). Throws NetError.
+    MetricsServer(uint16_t port, const char* bind_host, std::function<std::string()> render);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    uint16_t port() const { return port_; }
+    uint64_t scrapes() const { return scrapes_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void serve(int client);
+
+    int fd_ = -1;
+    int wake_ = -1;  // eventfd, signalled to stop
+    uint16_t port_ = 0;
+    std::function<std::string()> render_;
+    std::atomic<uint64_t> scrapes_{0};
+    std::thread thread_;
+};
+
+}  // namespace toppler
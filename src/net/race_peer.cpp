@@ -0,0 +1,61 @@
+#include "net/race_peer.h"
+
+#include <algorithm>
+
+namespace toppler {
+
+RacePeer::RacePeer(RaceSession& session, uint16_t match, UdpSocket* socket, const NetAddress& remote)
+    : session_(session), match_(match), socket_(socket), remote_(remote) {}
+
+size_t RacePeer::build_packet(uint8_t* out) {
+    RacePacket& p = packet_;
+    p.match = match_;
+    p.ack = session_.confirmed_tick();
+    p.first = peer_ack_ + 1;
+    // Oldest first: if more are outstanding than fit, the remote needs the
+    // early ones before the later ones are any use.
+    uint32_t pending = session_.tick() - peer_ack_;
+    p.count = static_cast<uint8_t>(std::min<uint32_t>(pending, kMaxPacketInputs));
+    for (uint32_t i = 0; i < p.count; ++i) p.inputs[i] = session_.local_input(p.first + i);
+    p.hash_tick = session_.tick();
+    p.hash = session_.local_hash(session_.tick());
+    return encode_race_packet(p, out);
+}
+
+void RacePeer::handle_packet(const uint8_t* data, size_t size) {
+    RacePacket& p = packet_;
+    if (!decode_race_packet(data, size, p) || p.match != match_) {
+        ++stats_.packets_rejected;
+        return;
+    }
+    ++stats_.packets_received;
+    // Datagrams may arrive out of order: an older ack never moves back.
+    peer_ack_ = std::max(peer_ack_, std::min(p.ack, session_.tick()));
+    for (uint32_t i = 0; i < p.count; ++i) session_.add_remote_input(p.first + i, p.inputs[i]);
+    session_.add_remote_hash(p.hash_tick, p.hash);
+}
+
+void RacePeer::receive() {
+    if (!socket_) return;
+    uint8_t buf[kMaxRacePacketBytes];
+    NetAddress from;
+    long n;
+    while ((n = socket_->receive(buf, sizeof buf, &from)) >= 0) {
+        if (!(from == remote_) || static_cast<size_t>(n) > sizeof buf) {
+            ++stats_.packets_rejected;
+            continue;
+        }
+        handle_packet(buf, static_cast<size_t>(n));
+    }
+}
+
+void RacePeer::send() {
+    if (!socket_) return;
+    uint8_t buf[kMaxRacePacketBytes];
+    size_t n = build_packet(buf);
+    ++stats_.packets_sent;
+    stats_.bytes_sent += n;
+    socket_->send(remote_, buf, n);
+}
+
+}  // namespace toppler
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "net/race_protocol.h"
+#include "net/race_session.h"
+#include "net/udp_socket.h"
+
+namespace toppler {
+
+struct RacePeerStats {
+    uint64_t packets_sent = 0;
+    uint64_t packets_received = 0;
+    uint64_t packets_rejected = 0;  // malformed, or another match / sender
+    uint64_t bytes_sent = 0;
+};
+
+// Carries a RaceSession over the race protocol. Once per frame:
+//
+//   peer.receive();            // feed whatever has arrived
+//   session.advance(input);    // (may stall)
+//   peer.send();               // unacknowledged inputs + latest hash
+//
+// build_packet() / handle_packet() are the same without a socket, for
+// custom transports and tests.
+class RacePeer {
+public:
+    RacePeer(RaceSession& session, uint16_t match, UdpSocket* socket = nullptr, const NetAddress& remote = {});
+
+    void receive();
+    void send();
+
+    size_t build_packet(uint8_t* out);
+    void handle_packet(const uint8_t* data, size_t size);
+
+    // Newest local tick the remote has confirmed receiving.
+    uint32_t peer_ack() const { return peer_ack_; }
+    const RacePeerStats& stats() const { return stats_; }
+
+private:
+    RaceSession& session_;
+    uint16_t match_;
+    UdpSocket* socket_;
+    NetAddress remote_;
+    uint32_t peer_ack_ = 0;
+    RacePacket packet_;  // scratch for both directions
+    RacePeerStats stats_;
+};
+
+}  // namespace toppler
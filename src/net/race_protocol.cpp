@@ -0,0 +1,134 @@
+#include "net/race_protocol.h"
+
+#include <cstring>
+
+namespace toppler {
+
+namespace {
+
+class Writer {
+public:
+    explicit Writer(uint8_t* out) : begin_(out), p_(out) {}
+
+    void byte(uint8_t v) { *p_++ = v; }
+    void u16(uint16_t v) {
+        std::memcpy(p_, &v, 2);
+        p_ += 2;
+    }
+    void u32(uint32_t v) {
+        std::memcpy(p_, &v, 4);
+        p_ += 4;
+    }
+    void u64(uint64_t v) {
+        std::memcpy(p_, &v, 8);
+        p_ += 8;
+    }
+    void varint(uint32_t v) {
+        while (v >= 0x80) {
+            byte(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        byte(static_cast<uint8_t>(v));
+    }
+    size_t size() const { return static_cast<size_t>(p_ - begin_); }
+
+private:
+    uint8_t* begin_;
+    uint8_t* p_;
+};
+
+// Bounds-checked; ok() turns false on the first overrun and stays false.
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+
+    bool ok() const { return ok_; }
+    bool done() const { return p_ == end_; }
+
+    uint8_t byte() { return take(1) ? p_[-1] : 0; }
+    uint16_t u16() { return read<uint16_t>(); }
+    uint32_t u32() { return read<uint32_t>(); }
+    uint64_t u64() { return read<uint64_t>(); }
+    uint32_t varint() {
+        uint32_t v = 0;
+        for (int shift = 0; shift < 35 && ok_; shift += 7) {
+            uint8_t b = byte();
+            v |= static_cast<uint32_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok_ = false;
+        return 0;
+    }
+
+private:
+    template <class T>
+    T read() {
+        T v = 0;
+        if (take(sizeof v)) std::memcpy(&v, p_ - sizeof v, sizeof v);
+        return v;
+    }
+    bool take(size_t n) {
+        if (!ok_ || static_cast<size_t>(end_ - p_) < n) return ok_ = false;
+        p_ += n;
+        return true;
+    }
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+    bool ok_ = true;
+};
+
+}  // namespace
+
+size_t encode_race_packet(const RacePacket& packet, uint8_t* out) {
+    Writer w(out);
+    w.u32(kRaceMagic);
+    w.byte(kRaceProtocolVersion);
+    w.byte(0);
+    w.u16(packet.match);
+    w.u32(packet.ack);
+    w.u32(packet.first);
+    size_t count = packet.count < kMaxPacketInputs ? packet.count : kMaxPacketInputs;
+    w.byte(static_cast<uint8_t>(count));
+    for (size_t i = 0; i < count;) {
+        uint8_t mask = packet.inputs[i] & kInputAll;
+        size_t run = 1;
+        while (i + run < count && (packet.inputs[i + run] & kInputAll) == mask) ++run;
+        if (run <= 3) {
+            w.byte(static_cast<uint8_t>(mask | (run << 6)));
+        } else {
+            w.byte(mask);
+            w.varint(static_cast<uint32_t>(run - 4));
+        }
+        i += run;
+    }
+    w.u32(packet.hash_tick);
+    w.u64(packet.hash);
+    return w.size();
+}
+
+bool decode_race_packet(const uint8_t* data, size_t size, RacePacket& out) {
+    Reader r(data, size);
+    if (r.u32() != kRaceMagic || r.byte() != kRaceProtocolVersion) return false;
+    r.byte();
+    out.match = r.u16();
+    out.ack = r.u32();
+    out.first = r.u32();
+    size_t count = r.byte();
+    if (!r.ok() || count > kMaxPacketInputs) return false;
+    size_t filled = 0;
+    while (filled < count && r.ok()) {
+        uint8_t b = r.byte();
+        size_t run = b >> 6;
+        if (run == 0) run = size_t{r.varint()} + 4;
+        if (run > count - filled) return false;
+        std::memset(out.inputs + filled, b & kInputAll, run);
+        filled += run;
+    }
+    out.count = static_cast<uint8_t>(count);
+    out.hash_tick = r.u32();
+    out.hash = r.u64();
+    return r.ok() && r.done();
+}
+
+}  // namespace toppler
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sim/input.h"
+
+namespace toppler {
+
+// Wire format of the head-to-head race, one datagram per sender tick in
+// each direction (little-endian):
+//
+//   u32 magic "TTNR"   u8 version   u8 reserved   u16 match
+//   u32 ack            newest tick of the receiver's inputs the sender has
+//                      without gaps; the receiver drops them from its resends
+//   u32 first          tick driven by the first input below
+//   u8  tick count     inputs carried, at most kMaxPacketInputs
+//   input runs         the replay run coding: per run one byte, mask in
+//                      the low 6 bits, length 1..3 in the top 2, top bits 0
+//                      meaning a varint with length - 4 follows
+//   u32 hash tick      a tick of the sender's own session ...
+//   u64 hash           ... and its tick_hash, for desync checks
+//
+// Only inputs not yet acknowledged are sent, as runs of unchanged masks, so
+// a steady player costs a few bytes per packet, and every packet repeats
+// the unacknowledged ones; a lost datagram costs nothing once the next
+// arrives.
+
+constexpr uint32_t kRaceMagic = 0x524e5454;  // "TTNR"
+constexpr uint8_t kRaceProtocolVersion = 1;
+constexpr size_t kMaxPacketInputs = 128;
+constexpr size_t kMaxRacePacketBytes = 24 + kMaxPacketInputs * 2;
+
+struct RacePacket {
+    uint16_t match = 0;
+    uint32_t ack = 0;
+    uint32_t first = 0;
+    uint8_t count = 0;
+    InputMask inputs[kMaxPacketInputs] = {};
+    uint32_t hash_tick = 0;
+    uint64_t hash = 0;
+};
+
+// Writes `packet` to `out` (at least kMaxRacePacketBytes) and returns the
+// size.
+size_t encode_race_packet(const RacePacket& packet, uint8_t* out);
+
+// Datagrams come from the network, so malformed ones are not exceptional:
+// false for anything truncated, oversized or from another protocol version.
+bool decode_race_packet(const uint8_t* data, size_t size, RacePacket& out);
+
+}  // namespace toppler
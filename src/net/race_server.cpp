@@ -0,0 +1,493 @@
+#include "net/race_server.h"
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "net/race_protocol.h"
+#include "net/udp_socket.h"
+#include "sim/game_sim.h"
+#include "sim/state_hash.h"
+
+namespace toppler {
+
+namespace {
+
+constexpr unsigned kBatch = 64;          // datagrams per recvmmsg / sendmmsg
+constexpr uint32_t kHashHistory = 64;    // ticks a claimed hash can lag the inputs
+constexpr uint32_t kClaimLead = kMaxPacketInputs;  // ticks a claimed hash can lead them
+// A player whose run gets this far past its last verified hash is sending
+// claims that can never be checked, and is treated as desynced.
+constexpr uint32_t kUnverifiedLimit = kHashHistory + kClaimLead;
+constexpr uint32_t kMatchOffset = 6;     // byte offset of the match id in a datagram
+constexpr int kReceiveBuffer = 4 << 20;  // absorbs bursts while a shard is busy
+
+uint64_t now_ms() {
+    using namespace std::chrono;
+    return static_cast<uint64_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t thread_cpu_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+const uint64_t kCatchupBounds[] = {1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 128};
+const HistogramBuckets kCatchupBuckets{kCatchupBounds, sizeof kCatchupBounds / sizeof kCatchupBounds[0]};
+
+[[noreturn]] void fail(const std::string& what) { throw NetError(what + ": " + std::strerror(errno)); }
+
+int bind_shard_socket(uint16_t port, const char* bind_host) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) fail("socket");
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof one);
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &kReceiveBuffer, sizeof kReceiveBuffer);
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind_host && inet_pton(AF_INET, bind_host, &local.sin_addr) != 1) {
+        close(fd);
+        throw NetError(std::string("bad bind address ") + bind_host);
+    }
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&local), sizeof local) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        fail("bind port " + std::to_string(port));
+    }
+    return fd;
+}
+
+// Steers each datagram of the reuseport group to socket (match % shards),
+// i.e. shard_of(match): the kernel runs it with the UDP payload at offset 0
+// and indexes the group's sockets in bind order. A datagram too short to
+// hold a match id aborts the program, which selects shard 0; being short,
+// it is rejected there.
+void attach_shard_filter(int fd, unsigned shards) {
+    sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, kMatchOffset + 1),  // match, little-endian
+        BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 8),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, kMatchOffset),
+        BPF_STMT(BPF_ALU | BPF_OR | BPF_X, 0),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, shards),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    };
+    sock_fprog prog{static_cast<unsigned short>(sizeof code / sizeof code[0]), code};
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof prog) != 0) fail("reuseport filter");
+}
+
+// The server's run of one player's inputs.
+struct Runner {
+    NetAddress addr;
+    bool joined = false;
+    SimState state;
+    uint32_t confirmed = 0;  // inputs run so far, all of them without gaps
+    uint64_t hashes[kHashHistory];
+    uint32_t claim_tick = 0;  // a hash claimed for a tick past `confirmed`, 0 if none
+    uint64_t claim_hash = 0;
+    uint32_t verified = 0;    // newest tick whose claimed hash matched
+};
+
+struct Match {
+    Level level;
+    uint32_t seed = 0;
+    Runner players[2];
+    uint64_t last_seen_ms = 0;
+    bool over = false;
+
+    // Back to how open_match() left it: no players, nothing run.
+    void reset(uint64_t now) {
+        last_seen_ms = now;
+        over = false;
+        for (Runner& r : players) {
+            r.joined = false;
+            r.confirmed = 0;
+            r.claim_tick = 0;
+            r.verified = 0;
+            sim_init(level, seed, r.state);
+            r.hashes[0] = tick_hash(r.state);
+        }
+    }
+};
+
+struct PendingOpen {
+    uint16_t match;
+    Level level;
+    uint32_t seed;
+};
+
+}  // namespace
+
+struct RaceServer::Shard {
+    unsigned index = 0;
+    int fd = -1;
+    int epoll = -1;
+    int wake = -1;  // eventfd: stop, or open_match() queued something
+    uint32_t idle_timeout_ms = 0;
+    std::function<void(const RaceDesync&)> on_desync;
+    std::atomic<bool> running{true};
+    std::thread thread;
+
+    std::mutex mutex;
+    std::vector<PendingOpen> opens;  // guarded by mutex
+
+    // Shard thread only from here on.
+    std::unordered_map<uint16_t, Match> matches;
+    RacePacket packet;
+    uint64_t now = 0;
+
+    mmsghdr in[kBatch];
+    iovec in_iov[kBatch];
+    sockaddr_in in_addr[kBatch];
+    uint8_t in_buf[kBatch][kMaxRacePacketBytes];
+    // Relayed datagrams point straight into in_buf: the batch goes out
+    // before the next one is read.
+    mmsghdr out[kBatch];
+    sockaddr_in out_addr[kBatch];
+    unsigned out_count = 0;
+
+    // Written by the shard thread only (bump() in core/metrics.h); stats()
+    // reads them from anywhere.
+    struct alignas(64) Counters {
+        std::atomic<uint64_t> packets_in{0}, packets_relayed{0}, packets_rejected{0}, receive_batches{0},
+            sim_ticks{0}, desyncs{0}, matches{0}, active_matches{0}, busy_ns{0};
+        HistogramCells catchup;
+    } counters;
+
+    ~Shard() {
+        if (thread.joinable()) {
+            running.store(false);
+            signal();
+            thread.join();
+        }
+        if (wake >= 0) close(wake);
+        if (epoll >= 0) close(epoll);
+        if (fd >= 0) close(fd);
+    }
+
+    void signal() {
+        uint64_t one = 1;
+        ssize_t ignored = write(wake, &one, sizeof one);
+        (void)ignored;
+    }
+
+    void run();
+    void apply_opens();
+    void receive();
+    void handle(unsigned i);
+    void absorb(Match& m, Runner& r, uint8_t player);
+    void check(Match& m, Runner& r, uint8_t player, uint32_t tick, uint64_t hash);
+    void desync(Match& m, uint8_t player, uint32_t tick);
+    void flush();
+    void sweep();
+    void count_active();
+};
+
+void RaceServer::Shard::run() {
+    epoll_event events[2];
+    uint64_t last_sweep = now_ms();
+    while (running.load(std::memory_order_relaxed)) {
+        int n = epoll_wait(epoll, events, 2, 1000);
+        uint64_t start = thread_cpu_ns();
+        now = now_ms();
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.fd == wake) {
+                uint64_t count;
+                ssize_t ignored = read(wake, &count, sizeof count);
+                (void)ignored;
+                apply_opens();
+            } else {
+                receive();
+            }
+        }
+        if (now - last_sweep >= 1000) {
+            sweep();
+            last_sweep = now;
+        }
+        bump(counters.busy_ns, thread_cpu_ns() - start);
+    }
+}
+
+void RaceServer::Shard::apply_opens() {
+    std::vector<PendingOpen> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.swap(opens);
+    }
+    for (const PendingOpen& o : pending) {
+        Match& m = matches[o.match];
+        m.level = o.level;
+        m.seed = o.seed;
+        m.reset(now);
+    }
+    counters.matches.store(matches.size(), std::memory_order_relaxed);
+    count_active();
+}
+
+void RaceServer::Shard::receive() {
+    for (;;) {
+        for (unsigned i = 0; i < kBatch; ++i) in[i].msg_hdr.msg_namelen = sizeof in_addr[i];
+        int k = recvmmsg(fd, in, kBatch, MSG_DONTWAIT, nullptr);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return;
+        bump(counters.receive_batches);
+        bump(counters.packets_in, static_cast<uint64_t>(k));
+        for (int i = 0; i < k; ++i) handle(static_cast<unsigned>(i));
+        flush();
+        if (static_cast<unsigned>(k) < kBatch) return;
+    }
+}
+
+void RaceServer::Shard::handle(unsigned i) {
+    if ((in[i].msg_hdr.msg_flags & MSG_TRUNC) || !decode_race_packet(in_buf[i], in[i].msg_len, packet)) {
+        bump(counters.packets_rejected);
+        return;
+    }
+    auto it = matches.find(packet.match);
+    if (it == matches.end() || it->second.over) {
+        bump(counters.packets_rejected);
+        return;
+    }
+    Match& m = it->second;
+    NetAddress from;
+    from.addr = in_addr[i];
+    int player = -1;
+    for (int p = 0; p < 2 && player < 0; ++p) {
+        if (m.players[p].joined && m.players[p].addr == from) player = p;
+    }
+    for (int p = 0; p < 2 && player < 0; ++p) {
+        if (!m.players[p].joined) {
+            if (p == 0 || !m.players[0].joined) bump(counters.active_matches);
+            m.players[p].joined = true;
+            m.players[p].addr = from;
+            player = p;
+        }
+    }
+    if (player < 0) {
+        bump(counters.packets_rejected);
+        return;
+    }
+    m.last_seen_ms = now;
+    absorb(m, m.players[player], static_cast<uint8_t>(player));
+    if (m.over) return;
+
+    const Runner& other = m.players[1 - player];
+    if (!other.joined) return;
+    out_addr[out_count] = other.addr.addr;
+    mmsghdr& msg = out[out_count++];
+    msg.msg_hdr = msghdr{};
+    msg.msg_hdr.msg_name = &out_addr[out_count - 1];
+    msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    msg.msg_hdr.msg_iov = &in_iov[i];
+    msg.msg_hdr.msg_iovlen = 1;
+    in_iov[i].iov_len = in[i].msg_len;  // restored before the next receive
+}
+
+// Runs the inputs that extend the player's confirmed run and checks the
+// hash the packet claims. Packets repeat every unacked input, so anything
+// before `confirmed` is a duplicate and a gap means a datagram was lost;
+// either way the next packet carries what is missing. The claimed hash must
+// be one the server can check: at most kHashHistory ticks old and kClaimLead
+// ahead. Anything else is rejected, and a player who never lets the server
+// check a hash is flagged once kUnverifiedLimit ticks go unverified.
+void RaceServer::Shard::absorb(Match& m, Runner& r, uint8_t player) {
+    const RacePacket& p = packet;
+    uint32_t end = p.first + p.count;  // one past the last tick carried
+    if (p.first <= r.confirmed + 1 && end > r.confirmed + 1) {
+        for (uint32_t t = r.confirmed + 1; t < end; ++t) {
+            sim_step(m.level, r.state, p.inputs[t - p.first] & kInputAll);
+            r.hashes[t % kHashHistory] = tick_hash(r.state);
+        }
+        bump(counters.sim_ticks, end - 1 - r.confirmed);
+        counters.catchup.observe(kCatchupBuckets, end - 1 - r.confirmed);
+        r.confirmed = end - 1;
+    }
+    if (r.claim_tick && r.claim_tick <= r.confirmed) {
+        check(m, r, player, r.claim_tick, r.claim_hash);
+        r.claim_tick = 0;
+    }
+    if (p.hash_tick + kHashHistory <= r.confirmed || p.hash_tick > r.confirmed + kClaimLead) {
+        bump(counters.packets_rejected);
+    } else if (p.hash_tick <= r.confirmed) {
+        check(m, r, player, p.hash_tick, p.hash);
+    } else if (!r.claim_tick) {
+        // Kept until the run reaches it; the window keeps that near.
+        r.claim_tick = p.hash_tick;
+        r.claim_hash = p.hash;
+    }
+    if (r.confirmed - r.verified > kUnverifiedLimit) desync(m, player, r.verified + 1);
+}
+
+void RaceServer::Shard::check(Match& m, Runner& r, uint8_t player, uint32_t tick, uint64_t hash) {
+    if (m.over || tick + kHashHistory <= r.confirmed) return;  // already verified, or too old to check
+    if (r.hashes[tick % kHashHistory] != hash) {
+        desync(m, player, tick);
+        return;
+    }
+    r.verified = std::max(r.verified, tick);
+}
+
+void RaceServer::Shard::desync(Match& m, uint8_t player, uint32_t tick) {
+    if (m.over) return;
+    m.over = true;
+    bump(counters.desyncs);
+    if (on_desync) on_desync(RaceDesync{packet.match, player, tick});
+}
+
+void RaceServer::Shard::flush() {
+    unsigned sent = 0;
+    while (sent < out_count) {
+        int n = sendmmsg(fd, out + sent, out_count - sent, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;  // socket buffer full: the rest is lost like any datagram
+        sent += static_cast<unsigned>(n);
+    }
+    bump(counters.packets_relayed, sent);
+    out_count = 0;
+    for (unsigned i = 0; i < kBatch; ++i) in_iov[i].iov_len = kMaxRacePacketBytes;
+}
+
+void RaceServer::Shard::sweep() {
+    for (auto& [id, m] : matches) {
+        bool joined = m.players[0].joined || m.players[1].joined;
+        if (joined && now - m.last_seen_ms > idle_timeout_ms) m.reset(now);
+    }
+    count_active();
+}
+
+void RaceServer::Shard::count_active() {
+    uint64_t active = 0;
+    for (const auto& [id, m] : matches) active += m.players[0].joined || m.players[1].joined;
+    counters.active_matches.store(active, std::memory_order_relaxed);
+}
+
+RaceServer::RaceServer(const RaceServerConfig& config) {
+    unsigned count = config.shards ? config.shards : std::thread::hardware_concurrency();
+    if (count == 0) count = 1;
+    shards_.reserve(count);
+    uint16_t port = config.port;
+    for (unsigned i = 0; i < count; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->index = i;
+        shard->idle_timeout_ms = config.idle_timeout_ms;
+        shard->on_desync = config.on_desync;
+        shard->fd = bind_shard_socket(port, config.bind_host);
+        if (i == 0) {
+            // Port 0 picks a free port; the rest of the group joins it.
+            sockaddr_in local{};
+            socklen_t len = sizeof local;
+            getsockname(shard->fd, reinterpret_cast<sockaddr*>(&local), &len);
+            port = ntohs(local.sin_port);
+        }
+        shard->epoll = epoll_create1(EPOLL_CLOEXEC);
+        shard->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (shard->epoll < 0 || shard->wake < 0) fail("epoll");
+        for (int fd : {shard->fd, shard->wake}) {
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            if (epoll_ctl(shard->epoll, EPOLL_CTL_ADD, fd, &ev) != 0) fail("epoll_ctl");
+        }
+        for (unsigned b = 0; b < kBatch; ++b) {
+            shard->in_iov[b] = iovec{shard->in_buf[b], kMaxRacePacketBytes};
+            shard->in[b].msg_hdr = msghdr{};
+            shard->in[b].msg_hdr.msg_name = &shard->in_addr[b];
+            shard->in[b].msg_hdr.msg_iov = &shard->in_iov[b];
+            shard->in[b].msg_hdr.msg_iovlen = 1;
+        }
+        shards_.push_back(std::move(shard));
+    }
+    port_ = port;
+    if (count > 1) attach_shard_filter(shards_[0]->fd, count);
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (auto& shard : shards_) {
+        Shard* s = shard.get();
+        s->thread = std::thread([s] { s->run(); });
+        // One shard per core keeps each shard's matches in one core's cache.
+        // Best effort: a cgroup may not allow it.
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(s->index % cores, &cpus);
+        pthread_setaffinity_np(s->thread.native_handle(), sizeof cpus, &cpus);
+    }
+}
+
+RaceServer::~RaceServer() { stop(); }
+
+void RaceServer::open_match(uint16_t match, const Level& level, uint32_t seed) {
+    Shard& s = *shards_[shard_of(match)];
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.opens.push_back(PendingOpen{match, level, seed});
+    }
+    s.signal();
+}
+
+void RaceServer::stop() {
+    for (auto& s : shards_) s->running.store(false);
+    for (auto& s : shards_) {
+        if (!s->thread.joinable()) continue;
+        s->signal();
+        s->thread.join();
+    }
+}
+
+const HistogramBuckets& race_catchup_buckets() { return kCatchupBuckets; }
+
+RaceServerStats RaceServer::shard_stats(unsigned shard) const {
+    const Shard::Counters& c = shards_[shard]->counters;
+    RaceServerStats out;
+    out.packets_in = c.packets_in.load(std::memory_order_relaxed);
+    out.packets_relayed = c.packets_relayed.load(std::memory_order_relaxed);
+    out.packets_rejected = c.packets_rejected.load(std::memory_order_relaxed);
+    out.receive_batches = c.receive_batches.load(std::memory_order_relaxed);
+    out.sim_ticks = c.sim_ticks.load(std::memory_order_relaxed);
+    out.desyncs = c.desyncs.load(std::memory_order_relaxed);
+    out.matches = c.matches.load(std::memory_order_relaxed);
+    out.active_matches = c.active_matches.load(std::memory_order_relaxed);
+    out.busy_ns = c.busy_ns.load(std::memory_order_relaxed);
+    c.catchup.add_to(out.catchup);
+    return out;
+}
+
+RaceServerStats RaceServer::stats() const {
+    RaceServerStats total;
+    for (unsigned i = 0; i < shards(); ++i) {
+        RaceServerStats s = shard_stats(i);
+        total.packets_in += s.packets_in;
+        total.packets_relayed += s.packets_relayed;
+        total.packets_rejected += s.packets_rejected;
+        total.receive_batches += s.receive_batches;
+        total.sim_ticks += s.sim_ticks;
+        total.desyncs += s.desyncs;
+        total.matches += s.matches;
+        total.active_matches += s.active_matches;
+        total.busy_ns += s.busy_ns;
+        for (size_t b = 0; b <= kMaxHistogramBuckets; ++b) total.catchup.buckets[b] += s.catchup.buckets[b];
+        total.catchup.count += s.catchup.count;
+        total.catchup.sum += s.catchup.sum;
+    }
+    return total;
+}
+
+}  // namespace toppler
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "core/metrics.h"
+#include "tower/level.h"
+
+namespace toppler {
+
+// A player whose hashes stopped matching the server's own run of their
+// inputs. `player` is 0 for whoever sent first in the match.
+struct RaceDesync {
+    uint16_t match;
+    uint8_t player;
+    uint32_t tick;
+};
+
+struct RaceServerConfig {
+    uint16_t port = 7272;
+    const char* bind_host = nullptr;   // all interfaces
+    unsigned shards = 0;               // 0 = one per hardware thread
+    uint32_t idle_timeout_ms = 30000;  // a match nobody has sent to for this long is reset
+    // Called on the shard thread that found the desync; keep it short.
+    std::function<void(const RaceDesync&)> on_desync;
+};
+
+struct RaceServerStats {
+    uint64_t packets_in = 0;
+    uint64_t packets_relayed = 0;
+    uint64_t packets_rejected = 0;  // malformed, unknown match, third sender
+    uint64_t receive_batches = 0;   // recvmmsg calls that returned datagrams
+    uint64_t sim_ticks = 0;         // ticks re-run to check hashes
+    uint64_t desyncs = 0;
+    uint64_t matches = 0;           // open right now
+    uint64_t active_matches = 0;    // of those, with a player joined (as of the last second)
+    uint64_t busy_ns = 0;           // thread CPU time spent handling events
+    // Ticks of new input each packet made the server run: how far its check
+    // of a player trails their play, the server's side of rollback depth.
+    HistogramTotals catchup;
+};
+
+// Bucket layout of RaceServerStats::catchup, in ticks.
+const HistogramBuckets& race_catchup_buckets();
+
+// Dedicated relay for head-to-head races (see race_protocol.h), hosting
+// thousands of matches in one process.
+//
+// Matches are split over shards, one thread each, and nothing is shared
+// between shards: each owns a UDP socket, an epoll set and its matches. All
+// shard sockets bind the same port with SO_REUSEPORT, and a small classic
+// BPF program attached to the group picks the socket from the match id in
+// the datagram, so both players of a match always land on the same shard
+// and no lock or hand-off is needed on the packet path. Datagrams are read
+// and relayed in batches with recvmmsg / sendmmsg.
+//
+// The server needs no game logic beyond the sim: it forwards each player's
+// datagrams to the other untouched, and re-runs each player's confirmed
+// inputs to check the hash they claim. The first mismatch ends the match
+// and is reported through RaceServerConfig::on_desync, as is a player whose
+// claims never fall where the server can check them. Players join a match
+// by sending to it; the first two source addresses are the players. A
+// match goes back to waiting for players once it has been idle for
+// idle_timeout_ms, so a fixed set of matches can be reused indefinitely.
+//
+// Linux only (epoll, recvmmsg, reuseport BPF), like the rest of the tree.
+class RaceServer {
+public:
+    // Binds the sockets and starts the shard threads. Throws NetError.
+    explicit RaceServer(const RaceServerConfig& config = {});
+    ~RaceServer();
+
+    RaceServer(const RaceServer&) = delete;
+    RaceServer& operator=(const RaceServer&) = delete;
+
+    // Opens (or restarts) `match` on `level`, which must outlive it, from
+    // `seed`. Any thread; takes effect on the shard's next wakeup.
+    void open_match(uint16_t match, const Level& level, uint32_t seed);
+
+    void stop();
+
+    unsigned shards() const { return static_cast<unsigned>(shards_.size()); }
+    uint16_t port() const { return port_; }
+    unsigned shard_of(uint16_t match) const { return match % shards(); }
+    // Totals over all shards, or one shard's own; each counter is exact, the
+    // set is not a snapshot. Cheap enough to call on every metrics scrape.
+    RaceServerStats stats() const;
+    RaceServerStats shard_stats(unsigned shard) const;
+
+private:
+    struct Shard;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    uint16_t port_ = 0;
+};
+
+}  // namespace toppler
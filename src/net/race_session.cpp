@@ -0,0 +1,145 @@
+#include "net/race_session.h"
+
+#include <algorithm>
+
+#include "net/race_protocol.h"
+#include "sim/game_sim.h"
+#include "sim/state_hash.h"
+
+namespace toppler {
+
+namespace {
+
+constexpr size_t kReservedTicks = 10 * 60 * kTicksPerSecond;  // a long race never reallocates
+
+}  // namespace
+
+RaceSession::RaceSession(const Level& level, uint32_t seed, uint32_t max_rollback)
+    : level_(level), max_rollback_(std::max<uint32_t>(max_rollback, 1)), remote_history_(max_rollback_ + 1) {
+    sim_init(level_, seed, local_);
+    sim_init(level_, seed, remote_);
+    remote_history_.push(remote_);
+    local_inputs_.reserve(kReservedTicks);
+    remote_inputs_.reserve(kReservedTicks);
+    remote_used_.reserve(kReservedTicks);
+    remote_known_.reserve(kReservedTicks);
+    local_hashes_[0] = remote_hashes_[0] = tick_hash(local_);
+}
+
+InputMask RaceSession::remote_input(uint32_t tick) const {
+    if (tick <= remote_known_.size() && remote_known_[tick - 1]) return remote_inputs_[tick - 1];
+    // Players hold inputs for many ticks at a time, so the last confirmed
+    // one is by far the best guess.
+    return confirmed_ ? remote_inputs_[confirmed_ - 1] : 0;
+}
+
+void RaceSession::step_remote(uint32_t tick) {
+    InputMask input = remote_input(tick);
+    if (tick > remote_used_.size()) remote_used_.resize(tick, 0);
+    remote_used_[tick - 1] = input;
+    sim_step(level_, remote_, input);
+    remote_history_.push(remote_);
+    remote_hashes_[tick % kHashHistory] = tick_hash(remote_);
+}
+
+bool RaceSession::advance(InputMask local) {
+    resolve();
+    if (!can_advance()) {
+        ++stats_.stalls;
+        return false;
+    }
+    ++tick_;
+    local_inputs_.push_back(local);
+    sim_step(level_, local_, local);
+    local_hashes_[tick_ % kHashHistory] = tick_hash(local_);
+    step_remote(tick_);
+    check_hashes();
+    return true;
+}
+
+uint32_t RaceSession::lead_limit() const {
+    return tick_ + max_rollback_ + static_cast<uint32_t>(kMaxPacketInputs);
+}
+
+void RaceSession::add_remote_input(uint32_t tick, InputMask input) {
+    if (tick == 0 || tick <= confirmed_) return;
+    if (tick > lead_limit()) {
+        ++stats_.out_of_window;
+        return;
+    }
+    if (tick > remote_known_.size()) {
+        remote_inputs_.resize(tick, 0);
+        remote_known_.resize(tick, 0);
+    }
+    if (remote_known_[tick - 1]) return;
+    input &= kInputAll;
+    if (tick <= tick_ && remote_used_[tick - 1] != input) ++stats_.mispredictions;
+    remote_inputs_[tick - 1] = input;
+    remote_known_[tick - 1] = 1;
+    uint32_t old_confirmed = confirmed_;
+    while (confirmed_ < remote_known_.size() && remote_known_[confirmed_]) ++confirmed_;
+
+    // The new input, and a new confirmed input changing the guess for the
+    // ticks after it, can both invalidate ticks already run. Only
+    // unconfirmed ticks can be affected: at most max_rollback of them.
+    for (uint32_t t = old_confirmed + 1; t <= tick_; ++t) {
+        if (remote_input(t) != remote_used_[t - 1]) {
+            if (!rewind_from_ || t < rewind_from_) rewind_from_ = t;
+            break;
+        }
+    }
+}
+
+void RaceSession::add_remote_hash(uint32_t tick, uint64_t hash) {
+    if (tick == 0 || desync_tick_ != kNoDesync) return;
+    if (tick > lead_limit()) {
+        ++stats_.out_of_window;
+        return;
+    }
+    // Every packet repeats the sender's newest hash; keep one per tick, and
+    // never more than the history could check.
+    if (peer_hashes_.size() >= kHashHistory) return;
+    for (const PeerHash& p : peer_hashes_) {
+        if (p.tick == tick) return;
+    }
+    peer_hashes_.push_back(PeerHash{tick, hash});
+    check_hashes();
+}
+
+void RaceSession::resolve() {
+    if (!rewind_from_) return;
+    uint32_t from = rewind_from_;
+    rewind_from_ = 0;
+    uint32_t depth = tick_ - from + 1;
+    // can_advance() keeps every unconfirmed tick inside the history, so
+    // this only fails if that invariant is broken; re-running from a wrong
+    // state would hide it.
+    if (!remote_history_.rewind(depth, remote_)) {
+        desync_tick_ = std::min(desync_tick_, from);
+        return;
+    }
+    for (uint32_t t = from; t <= tick_; ++t) step_remote(t);
+    ++stats_.rollbacks;
+    stats_.resimulated_ticks += depth;
+    stats_.max_rollback = std::max(stats_.max_rollback, depth);
+    check_hashes();
+}
+
+// A peer hash can be checked once the tick is confirmed and re-run with
+// real inputs here, and while its hash is still in the history.
+void RaceSession::check_hashes() {
+    uint32_t exact = rewind_from_ ? std::min(confirmed_, rewind_from_ - 1) : confirmed_;
+    exact = std::min(exact, tick_);
+    size_t kept = 0;
+    for (const PeerHash& p : peer_hashes_) {
+        if (p.tick > exact) {
+            peer_hashes_[kept++] = p;
+            continue;
+        }
+        if (p.tick + kHashHistory <= tick_) continue;  // too old to check
+        if (remote_hashes_[p.tick % kHashHistory] != p.hash) desync_tick_ = std::min(desync_tick_, p.tick);
+    }
+    peer_hashes_.resize(kept);
+}
+
+}  // namespace toppler
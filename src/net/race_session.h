@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "sim/input.h"
+#include "sim/rewind.h"
+#include "sim/sim_state.h"
+#include "tower/level.h"
+
+namespace toppler {
+
+struct RaceStats {
+    uint64_t rollbacks = 0;          // corrections that rewound the remote run
+    uint64_t resimulated_ticks = 0;  // ticks re-run by those rollbacks
+    uint32_t max_rollback = 0;       // deepest single rollback, in ticks
+    uint64_t stalls = 0;             // ticks held back waiting for the remote
+    uint64_t mispredictions = 0;     // remote inputs that differed from the guess
+    uint64_t out_of_window = 0;      // remote inputs and hashes too far ahead to be real, dropped
+};
+
+// One side of a head-to-head race: both players climb their own copy of the
+// same tower from the same seed, each seeing the other as a ghost. Both
+// sessions run here. The local one only ever sees real inputs. The remote
+// player's inputs arrive late, so its session runs ahead on predicted inputs
+// (their last confirmed input, held). When the real input arrives and
+// differs, the remote session is restored from the RewindBuffer snapshot
+// taken before that tick, and re-simulated up to the present.
+//
+// The local side may run at most max_rollback ticks past the newest remote
+// input it has, so no correction ever needs more than that many re-run
+// ticks; beyond it, advance() stalls until the remote catches up.
+//
+// Both peers hash their own session every tick (tick_hash). Hashes the
+// remote sends are checked against this side's copy of the remote session
+// once that tick is confirmed, so a desync is reported for the exact tick
+// it happened on.
+class RaceSession {
+public:
+    static constexpr uint32_t kDefaultMaxRollback = 10;
+    static constexpr uint32_t kNoDesync = UINT32_MAX;
+
+    RaceSession(const Level& level, uint32_t seed, uint32_t max_rollback = kDefaultMaxRollback);
+
+    // Runs one tick with the local player's input. False, doing nothing,
+    // when the remote is too far behind (see class comment).
+    bool advance(InputMask local);
+    // The remote may be ahead of us, so confirmed_ can pass tick_.
+    bool can_advance() const { return confirmed_ >= tick_ || tick_ - confirmed_ < max_rollback_; }
+
+    // From the network. `tick` is the tick the input drives (1 = first).
+    // Duplicates and inputs already known are ignored; corrections are
+    // applied lazily, at the next advance() or resolve(). Ticks past
+    // lead_limit() cannot come from an honest peer and are dropped.
+    void add_remote_input(uint32_t tick, InputMask input);
+    // The remote's tick_hash of its own session after `tick`; same window.
+    void add_remote_hash(uint32_t tick, uint64_t hash);
+    // Applies pending corrections now (rollback and re-simulation). A
+    // correction the history can no longer reach is reported as a desync.
+    void resolve();
+    // The newest tick the remote can have reached: it stalls max_rollback
+    // ticks past our inputs, and one packet carries kMaxPacketInputs.
+    uint32_t lead_limit() const;
+
+    uint32_t tick() const { return tick_; }
+    // Every remote input up to here is known; the remote session is exact
+    // up to this tick.
+    uint32_t confirmed_tick() const { return confirmed_; }
+    // The first tick whose hashes disagreed, or kNoDesync.
+    uint32_t desync_tick() const { return desync_tick_; }
+
+    const SimState& local() const { return local_; }
+    const SimState& remote() const { return remote_; }
+    // Local input of `tick` (1..tick()), for the transport to send.
+    InputMask local_input(uint32_t tick) const { return local_inputs_[tick - 1]; }
+    // tick_hash of the local session after one of the last kHashHistory ticks.
+    uint64_t local_hash(uint32_t tick) const { return local_hashes_[tick % kHashHistory]; }
+
+    const RaceStats& stats() const { return stats_; }
+
+    static constexpr uint32_t kHashHistory = 64;
+
+private:
+    InputMask remote_input(uint32_t tick) const;
+    void step_remote(uint32_t tick);
+    void check_hashes();
+
+    Level level_;
+    uint32_t max_rollback_;
+    SimState local_;
+    SimState remote_;
+    RewindBuffer remote_history_;  // remote_ after each of the last max_rollback + 1 ticks
+
+    uint32_t tick_ = 0;
+    uint32_t confirmed_ = 0;
+    uint32_t rewind_from_ = 0;  // earliest mispredicted tick not yet re-run, 0 if none
+    std::vector<InputMask> local_inputs_;
+    std::vector<InputMask> remote_inputs_;  // as received, where remote_known_
+    std::vector<uint8_t> remote_known_;
+    std::vector<InputMask> remote_used_;    // what remote_ was last run with
+
+    uint64_t local_hashes_[kHashHistory] = {};
+    uint64_t remote_hashes_[kHashHistory] = {};  // our tick_hash of remote_ per tick
+    struct PeerHash {
+        uint32_t tick;
+        uint64_t hash;
+    };
+    std::vector<PeerHash> peer_hashes_;  // received, not yet checkable
+    uint32_t desync_tick_ = kNoDesync;
+    RaceStats stats_;
+};
+
+}  // namespace toppler
@@ -0,0 +1,81 @@
+#include "net/udp_socket.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace toppler {
+
+std::string NetAddress::str() const {
+    char host[INET_ADDRSTRLEN] = "?";
+    inet_ntop(AF_INET, &addr.sin_addr, host, sizeof host);
+    return std::string(host) + ":" + std::to_string(ntohs(addr.sin_port));
+}
+
+NetAddress parse_address(const std::string& text) {
+    size_t colon = text.rfind(':');
+    if (colon == std::string::npos || colon + 1 == text.size()) throw NetError("address needs host:port: " + text);
+    std::string host = text.substr(0, colon);
+    std::string port = text.substr(colon + 1);
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* found = nullptr;
+    int rc = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &found);
+    if (rc != 0 || !found) throw NetError("cannot resolve " + text + ": " + gai_strerror(rc));
+    NetAddress out;
+    std::memcpy(&out.addr, found->ai_addr, sizeof out.addr);
+    freeaddrinfo(found);
+    return out;
+}
+
+UdpSocket::UdpSocket(uint16_t port, const char* bind_host) {
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) throw NetError(std::string("socket: ") + std::strerror(errno));
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind_host && inet_pton(AF_INET, bind_host, &local.sin_addr) != 1) {
+        close(fd_);
+        throw NetError(std::string("bad bind address ") + bind_host);
+    }
+    if (bind(fd_, reinterpret_cast<const sockaddr*>(&local), sizeof local) != 0) {
+        int err = errno;
+        close(fd_);
+        throw NetError("bind port " + std::to_string(port) + ": " + std::strerror(err));
+    }
+    socklen_t len = sizeof local;
+    getsockname(fd_, reinterpret_cast<sockaddr*>(&local), &len);
+    port_ = ntohs(local.sin_port);
+}
+
+UdpSocket::~UdpSocket() {
+    if (fd_ >= 0) close(fd_);
+}
+
+bool UdpSocket::send(const NetAddress& to, const void* data, size_t size) {
+    ssize_t n = sendto(fd_, data, size, 0, reinterpret_cast<const sockaddr*>(&to.addr), sizeof to.addr);
+    return n == static_cast<ssize_t>(size);
+}
+
+long UdpSocket::receive(void* buf, size_t capacity, NetAddress* from) {
+    sockaddr_in src{};
+    socklen_t len = sizeof src;
+    for (;;) {
+        ssize_t n = recvfrom(fd_, buf, capacity, MSG_TRUNC, reinterpret_cast<sockaddr*>(&src), &len);
+        if (n >= 0) {
+            if (from) from->addr = src;
+            return static_cast<long>(n);
+        }
+        if (errno == EINTR) continue;
+        return -1;  // EAGAIN, or an ICMP error from an earlier send
+    }
+}
+
+}  // namespace toppler
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <netinet/in.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace toppler {
+
+// Raised when a socket cannot be created, bound or addressed.
+class NetError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// IPv4 endpoint.
+struct NetAddress {
+    sockaddr_in addr{};
+
+    bool operator==(const NetAddress& o) const {
+        return addr.sin_addr.s_addr == o.addr.sin_addr.s_addr && addr.sin_port == o.addr.sin_port;
+    }
+    std::string str() const;
+};
+
+// "host:port", with host a name or dotted quad. Throws NetError.
+NetAddress parse_address(const std::string& text);
+
+// Non-blocking UDP socket bound to a local port (0 picks a free one). The
+// game polls it once per frame, so nothing here ever waits.
+class UdpSocket {
+public:
+    explicit UdpSocket(uint16_t port = 0, const char* bind_host = nullptr);
+    ~UdpSocket();
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    uint16_t port() const { return port_; }
+    int fd() const { return fd_; }
+
+    // False if the datagram could not be queued (buffer full, unreachable);
+    // UDP may drop it anyway, so callers treat this as loss.
+    bool send(const NetAddress& to, const void* data, size_t size);
+    // Size of the next waiting datagram, copied into `buf` (truncated to
+    // `capacity`), or -1 if none is waiting.
+    long receive(void* buf, size_t capacity, NetAddress* from = nullptr);
+
+private:
+    int fd_ = -1;
+    uint16_t port_ = 0;
+};
+
+}  // namespace toppler
@@ -0,0 +1,54 @@
+#include "render/atlas.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "render/sprite_art.h"
+
+namespace toppler {
+
+namespace {
+
+constexpr int kAtlasWidth = 128;
+constexpr int kPadding = 1;  // transparent gutter so filtering never bleeds between sprites
+
+}  // namespace
+
+SpriteAtlas::SpriteAtlas() {
+    constexpr size_t kCount = static_cast<size_t>(SpriteId::kCount);
+    std::vector<Image> art;
+    art.reserve(kCount);
+    std::vector<size_t> order(kCount);
+    for (size_t i = 0; i < kCount; ++i) {
+        art.push_back(make_sprite_image(static_cast<SpriteId>(i)));
+        order[i] = i;
+    }
+    // Shelf packing, tallest first.
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return art[a].height > art[b].height; });
+    int x = 0, y = 0, shelf = 0;
+    for (size_t id : order) {
+        const Image& img = art[id];
+        if (x + img.width > kAtlasWidth) {
+            x = 0;
+            y += shelf + kPadding;
+            shelf = 0;
+        }
+        rects_[id] = AtlasRect{static_cast<uint16_t>(x), static_cast<uint16_t>(y),
+                               static_cast<uint16_t>(img.width), static_cast<uint16_t>(img.height)};
+        x += img.width + kPadding;
+        shelf = std::max(shelf, img.height);
+    }
+    int height = 1;
+    while (height < y + shelf) height *= 2;
+
+    image_ = Image(kAtlasWidth, height, 0);
+    for (size_t id = 0; id < kCount; ++id) {
+        const AtlasRect& r = rects_[id];
+        for (int row = 0; row < r.h; ++row) {
+            std::copy_n(&art[id].pixels[static_cast<size_t>(row) * r.w], r.w, &image_.at(r.x, r.y + row));
+        }
+    }
+}
+
+}  // namespace toppler
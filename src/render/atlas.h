@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "render/draw_list.h"
+#include "render/image.h"
+
+namespace toppler {
+
+// Region of the atlas texture, in pixels.
+struct AtlasRect {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+// Every sprite packed into one texture so a frame can be drawn with one
+// texture binding. Built once at startup.
+class SpriteAtlas {
+public:
+    // Packs the built-in art for all SpriteIds.
+    SpriteAtlas();
+
+    const Image& image() const { return image_; }
+    const AtlasRect& rect(SpriteId id) const { return rects_[static_cast<size_t>(id)]; }
+
+    // Texture id the backend knows the atlas by.
+    static constexpr uint16_t kTexture = 0;
+
+private:
+    Image image_;
+    std::array<AtlasRect, static_cast<size_t>(SpriteId::kCount)> rects_{};
+};
+
+}  // namespace toppler
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace toppler {
+
+// Draw order, back to front.
+enum class Layer : uint8_t {
+    Backdrop = 0,  // sky, stars, water
+    Tower,         // cylinder face and tiles
+    Entities,      // player, enemies, lifts, shots
+    Hud,
+    Overlay,  // debug / profiling
+    kCount
+};
+
+// Every sprite the game draws. Stable numbering is not required; these are
+// resolved to atlas regions at load time.
+enum class SpriteId : uint16_t {
+    // Tower tiles, stretched over a projected column span.
+    TowerFace = 0,
+    Ledge,
+    Crumble,
+    Slippery,
+    Wall,
+    Door,
+    Shaft,
+    Spike,
+    Exit,
+    // Entities.
+    PlayerStand,
+    PlayerJump,
+    PlayerHurt,
+    Ball,
+    Eye,
+    Bouncer,
+    Shot,
+    ElevatorCar,
+    // Backdrop.
+    Water,
+    Star,
+    // Submarine bonus stage.
+    Submarine,
+    Fish,
+    Torpedo,
+    // HUD and score popups; Digit0 + n draws digit n.
+    Digit0,
+    Digit1,
+    Digit2,
+    Digit3,
+    Digit4,
+    Digit5,
+    Digit6,
+    Digit7,
+    Digit8,
+    Digit9,
+    // Profiler overlay: ZoneBar0 + n is the colour of ProfileZone n.
+    ZoneBar0,
+    ZoneBar1,
+    ZoneBar2,
+    ZoneBar3,
+    ZoneBar4,
+    ZoneBar5,
+    ZoneBar6,
+    ZoneBar7,
+    OverlayPanel,
+    kCount
+};
+
+// One textured, tinted screen rectangle. shade scales the sprite's colour
+// (255 = full brightness); the tower uses it for cylinder lighting.
+struct Quad {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+    SpriteId sprite;
+    Layer layer;
+    uint8_t shade;
+};
+
+// Quads produced for one frame. Storage is kept between frames so a steady
+// state frame never allocates.
+class DrawList {
+public:
+    void clear() { quads_.clear(); }
+    void reserve(size_t n) { quads_.reserve(n); }
+    void push(const Quad& q) { quads_.push_back(q); }
+
+    const std::vector<Quad>& quads() const { return quads_; }
+    size_t size() const { return quads_.size(); }
+
+private:
+    std::vector<Quad> quads_;
+};
+
+}  // namespace toppler
@@ -0,0 +1,49 @@
+#include "render/effects.h"
+
+namespace toppler {
+
+namespace {
+
+constexpr float kPopupRise = 1.0f / 32.0f;
+constexpr float kDebrisGravity = 1.0f / 128.0f;
+
+// Outward kicks for the fragments of one brick.
+constexpr float kDebrisKick[Effects::kDebrisPerBrick][2] = {
+    {-0.04f, 0.10f}, {-0.015f, 0.14f}, {0.015f, 0.12f}, {0.04f, 0.08f},
+};
+
+}  // namespace
+
+void Effects::tick(const TickEvents& events) {
+    for (Popup& p : popups_) {
+        if (p.age == 0) continue;
+        p.height += kPopupRise;
+        if (++p.age > kPopupTicks) p.age = 0;
+    }
+    for (Debris& d : debris_) {
+        if (d.age == 0) continue;
+        d.angle += d.vangle;
+        d.vheight -= kDebrisGravity;
+        d.height += d.vheight;
+        if (++d.age > kDebrisTicks) d.age = 0;
+    }
+
+    for (const ScoreEvent& s : events.scores) {
+        popups_[next_popup_] = Popup{s.angle, s.height + 1.0f, s.points, 1};
+        next_popup_ = (next_popup_ + 1) % kMaxPopups;
+    }
+    for (const BrickEvent& b : events.bricks) {
+        for (const auto& kick : kDebrisKick) {
+            debris_[next_debris_] = Debris{static_cast<float>(b.column) + 0.5f, static_cast<float>(b.row) + 0.5f,
+                                           kick[0], kick[1], 1};
+            next_debris_ = (next_debris_ + 1) % kMaxDebris;
+        }
+    }
+}
+
+void Effects::clear() {
+    for (Popup& p : popups_) p.age = 0;
+    for (Debris& d : debris_) d.age = 0;
+}
+
+}  // namespace toppler
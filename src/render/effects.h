@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+#include "sim/tick_events.h"
+
+namespace toppler {
+
+// Short-lived presentation effects spawned from TickEvents: rising score
+// popups and falling brick debris. Fixed rings, so a busy tick overwrites
+// the oldest effect rather than allocating; feed it once per sim tick.
+class Effects {
+public:
+    static constexpr int kMaxPopups = 16;
+    static constexpr int kMaxDebris = 64;
+    static constexpr int kDebrisPerBrick = 4;
+
+    struct Popup {
+        float angle;
+        float height;
+        uint32_t points;
+        uint16_t age;  // ticks; 0 = free slot
+    };
+    struct Debris {
+        float angle;
+        float height;
+        float vangle;
+        float vheight;
+        uint16_t age;
+    };
+
+    // Ages existing effects by one tick, then spawns the tick's new ones.
+    void tick(const TickEvents& events);
+    void clear();
+
+    const Popup* popups() const { return popups_; }
+    const Debris* debris() const { return debris_; }
+
+    static constexpr uint16_t kPopupTicks = 45;
+    static constexpr uint16_t kDebrisTicks = 40;
+
+private:
+    Popup popups_[kMaxPopups] = {};
+    Debris debris_[kMaxDebris] = {};
+    int next_popup_ = 0;
+    int next_debris_ = 0;
+};
+
+}  // namespace toppler
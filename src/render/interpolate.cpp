@@ -0,0 +1,65 @@
+#include "render/interpolate.h"
+
+#include <cmath>
+
+namespace toppler {
+
+namespace {
+
+constexpr float kColumns = static_cast<float>(kTowerColumns);
+// Further than any object moves in one tick: a teleport, drawn where it landed.
+constexpr float kSnapDistance = 1.5f;
+
+float lerp(float a, float b, float t) { return a + (b - a) * t; }
+
+// Angles blend the short way round the tower.
+float lerp_angle(float a, float b, float t) {
+    float d = b - a;
+    if (d > kColumns * 0.5f) d -= kColumns;
+    if (d < -kColumns * 0.5f) d += kColumns;
+    if (std::fabs(d) > kSnapDistance) return b;
+    float v = b - d * (1.0f - t);
+    if (v < 0.0f) v += kColumns;
+    if (v >= kColumns) v -= kColumns;
+    return v >= kColumns ? 0.0f : v;
+}
+
+float lerp_height(float a, float b, float t) { return std::fabs(b - a) > kSnapDistance ? b : lerp(a, b, t); }
+
+}  // namespace
+
+void interpolate_state(const SimState& from, const SimState& to, float alpha, SimState& out) {
+    out = to;
+    if (alpha >= 1.0f || from.session.tick + 1 != to.session.tick) return;
+
+    const PlayerState& p0 = from.player;
+    PlayerState& p = out.player;
+    if (p0.mode != PlayerMode::Tunnel || p.mode == PlayerMode::Tunnel) {
+        p.angle = lerp_angle(p0.angle, p.angle, alpha);
+        p.height = lerp_height(p0.height, p.height, alpha);
+    }
+    out.session.tower_angle = lerp_angle(from.session.tower_angle, to.session.tower_angle, alpha);
+    for (int i = 0; i < kMaxElevators; ++i) {
+        out.elevators.pos[i] = lerp_height(from.elevators.pos[i], to.elevators.pos[i], alpha);
+    }
+
+    const EnemyLanes& e0 = from.enemies;
+    EnemyLanes& e = out.enemies;
+    for (int lane = 0; lane < e.pool.count; ++lane) {
+        int old = e0.pool.lane(e.pool.handle(lane));
+        if (old < 0) continue;
+        e.angle[lane] = lerp_angle(e0.angle[old], e.angle[lane], alpha);
+        e.height[lane] = lerp_height(e0.height[old], e.height[lane], alpha);
+    }
+
+    const ShotLanes& s0 = from.shots;
+    ShotLanes& s = out.shots;
+    for (int lane = 0; lane < s.pool.count; ++lane) {
+        int old = s0.pool.lane(s.pool.handle(lane));
+        if (old < 0) continue;
+        s.angle[lane] = lerp_angle(s0.angle[old], s.angle[lane], alpha);
+        s.height[lane] = lerp_height(s0.height[old], s.height[lane], alpha);
+    }
+}
+
+}  // namespace toppler
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "sim/sim_state.h"
+
+namespace toppler {
+
+// Presentation state `alpha` of the way from tick `from` to tick `to`:
+// `to` with the player, camera, elevators, enemies and shots moved back
+// along their path. Everything discrete (tiles, score, modes, which objects
+// are alive) is `to`'s. Objects are matched by lane handle, so an enemy that
+// moved lanes still blends and one that just spawned does not slide in from
+// another's position; anything that jumped further than motion can explain
+// (respawn, tunnel exit) snaps.
+void interpolate_state(const SimState& from, const SimState& to, float alpha, SimState& out);
+
+}  // namespace toppler
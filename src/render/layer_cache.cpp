@@ -0,0 +1,90 @@
+#include "render/layer_cache.h"
+
+#include <algorithm>
+
+namespace toppler {
+
+namespace {
+
+uint32_t shade_pixel(uint32_t p, uint32_t shade) {
+    if (shade == 255) return p;
+    uint32_t r = ((p >> 16) & 0xff) * shade / 255;
+    uint32_t g = ((p >> 8) & 0xff) * shade / 255;
+    uint32_t b = (p & 0xff) * shade / 255;
+    return (p & 0xff000000u) | (r << 16) | (g << 8) | b;
+}
+
+// Straight-alpha "over".
+uint32_t blend_over(uint32_t src, uint32_t dst) {
+    uint32_t sa = src >> 24;
+    uint32_t da = dst >> 24;
+    uint32_t oa = sa + da * (255 - sa) / 255;
+    if (oa == 0) return 0;
+    auto channel = [&](int shift) {
+        uint32_t s = (src >> shift) & 0xff;
+        uint32_t d = (dst >> shift) & 0xff;
+        return (s * sa + d * da * (255 - sa) / 255) / oa;
+    };
+    return (oa << 24) | (channel(16) << 16) | (channel(8) << 8) | channel(0);
+}
+
+}  // namespace
+
+void rasterize_quads(const std::vector<Quad>& quads, const SpriteAtlas& atlas, Image& target, PixelRect clip) {
+    const Image& src = atlas.image();
+    int cx0 = std::max(clip.x, 0), cx1 = std::min(clip.x + clip.w, target.width);
+    int cy0 = std::max(clip.y, 0), cy1 = std::min(clip.y + clip.h, target.height);
+    for (const Quad& q : quads) {
+        if (q.w <= 0 || q.h <= 0) continue;
+        const AtlasRect& r = atlas.rect(q.sprite);
+        int x0 = std::max<int>(q.x, cx0), x1 = std::min<int>(q.x + q.w, cx1);
+        int y0 = std::max<int>(q.y, cy0), y1 = std::min<int>(q.y + q.h, cy1);
+        for (int y = y0; y < y1; ++y) {
+            int sy = r.y + (y - q.y) * r.h / q.h;
+            for (int x = x0; x < x1; ++x) {
+                int sx = r.x + (x - q.x) * r.w / q.w;
+                uint32_t p = src.at(sx, sy);
+                uint32_t a = p >> 24;
+                if (a == 0) continue;
+                p = shade_pixel(p, q.shade);
+                uint32_t& d = target.at(x, y);
+                d = a == 255 ? p : blend_over(p, d);
+            }
+        }
+    }
+}
+
+int CachedLayer::add_region(PixelRect rect) {
+    regions_.emplace_back();
+    regions_.back().rect = rect;
+    return static_cast<int>(regions_.size() - 1);
+}
+
+DrawList& CachedLayer::rebuild(int region, uint64_t key) {
+    Region& r = regions_[static_cast<size_t>(region)];
+    r.key = key;
+    r.valid = true;
+    r.dirty = true;
+    r.quads.clear();
+    return r.quads;
+}
+
+bool CachedLayer::flush(const SpriteAtlas& atlas, RenderBackend& backend) {
+    bool any = false;
+    for (Region& r : regions_) {
+        if (!r.dirty) continue;
+        int x0 = std::max(r.rect.x, 0), x1 = std::min(r.rect.x + r.rect.w, image_.width);
+        for (int y = std::max(r.rect.y, 0); y < std::min(r.rect.y + r.rect.h, image_.height); ++y) {
+            if (x1 > x0) std::fill_n(&image_.at(x0, y), x1 - x0, 0u);
+        }
+        rasterize_quads(r.quads.quads(), atlas, image_, r.rect);
+        r.dirty = false;
+        any = true;
+    }
+    if (!any) return false;
+    backend.upload_texture(texture_, image_);
+    ++uploads_;
+    return true;
+}
+
+}  // namespace toppler
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "render/atlas.h"
+#include "render/draw_list.h"
+#include "render/image.h"
+#include "render/render_backend.h"
+
+namespace toppler {
+
+// Texture ids of the cached layers; the atlas is SpriteAtlas::kTexture.
+constexpr uint16_t kBackdropTexture = 1;
+constexpr uint16_t kHudTexture = 2;
+
+struct PixelRect {
+    int x;
+    int y;
+    int w;
+    int h;
+};
+
+// Draws `quads` into the `clip` part of `target` in list order, sampling the
+// atlas with nearest-neighbour scaling, tinting by shade and blending by
+// alpha.
+void rasterize_quads(const std::vector<Quad>& quads, const SpriteAtlas& atlas, Image& target, PixelRect clip);
+
+// Part of the frame that changes rarely, kept in a texture of its own and
+// split into regions (the score, the clock, ...). The owner describes what
+// each region shows with a key; only regions whose key changed are cleared
+// and rasterized again, and the texture is uploaded only on frames where
+// one did. Every other frame the layer costs one textured quad.
+class CachedLayer {
+public:
+    CachedLayer(uint16_t texture, int width, int height) : texture_(texture), image_(width, height) {}
+
+    // Returns the region's index. Regions should not overlap.
+    int add_region(PixelRect rect);
+
+    // True when `region` must be rebuilt to show `key`.
+    bool stale(int region, uint64_t key) const {
+        const Region& r = regions_[static_cast<size_t>(region)];
+        return !r.valid || r.key != key;
+    }
+    // Starts rebuilding `region` to show `key`: returns its (cleared) quad
+    // list, in layer image coordinates, for the caller to fill.
+    DrawList& rebuild(int region, uint64_t key);
+    // Rasterizes the regions rebuilt since the last flush and re-uploads
+    // the texture. False if there was nothing to do.
+    bool flush(const SpriteAtlas& atlas, RenderBackend& backend);
+
+    uint16_t texture() const { return texture_; }
+    const Image& image() const { return image_; }
+    uint64_t uploads() const { return uploads_; }
+
+private:
+    struct Region {
+        PixelRect rect;
+        uint64_t key = 0;
+        bool valid = false;
+        bool dirty = false;
+        DrawList quads;
+    };
+
+    uint16_t texture_;
+    Image image_;
+    std::vector<Region> regions_;
+    uint64_t uploads_ = 0;
+};
+
+}  // namespace toppler
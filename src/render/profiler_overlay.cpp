@@ -0,0 +1,81 @@
+#include "render/profiler_overlay.h"
+
+#include <algorithm>
+
+namespace toppler {
+
+namespace {
+
+constexpr int kMargin = 4;
+constexpr int kRowHeight = 12;    // legend rows: swatch and digits
+constexpr int kDigitStep = 6;     // as for score popups
+constexpr int kGraphHeight = 48;  // pixels for one 60 Hz frame budget
+constexpr double kBudgetUs = 1e6 / 60.0;
+
+Quad quad(int x, int y, int w, int h, SpriteId sprite, uint8_t shade = 255) {
+    return Quad{static_cast<int16_t>(x), static_cast<int16_t>(y), static_cast<int16_t>(w), static_cast<int16_t>(h),
+                sprite, Layer::Overlay, shade};
+}
+
+SpriteId zone_bar(int zone) { return static_cast<SpriteId>(static_cast<int>(SpriteId::ZoneBar0) + zone); }
+
+// Time spent in a zone and not in a zone nested inside it.
+uint64_t self_ticks(const FrameProfile& f, int zone) {
+    uint64_t t = f.zone_ticks[zone];
+    if (zone == static_cast<int>(ProfileZone::Sim)) {
+        uint64_t nested = f.zone_ticks[static_cast<int>(ProfileZone::EnemyUpdate)] +
+                          f.zone_ticks[static_cast<int>(ProfileZone::Collision)];
+        t = t > nested ? t - nested : 0;
+    }
+    return t;
+}
+
+}  // namespace
+
+void ProfilerOverlay::draw(const Profiler& profiler, const SpriteAtlas& atlas, DrawList& out) {
+    const AtlasRect& glyph = atlas.rect(SpriteId::Digit0);
+    int legend_h = kProfileZones * kRowHeight;
+    int panel_w = kGraphFrames + 2 * kMargin;
+    int panel_h = legend_h + kGraphHeight + 3 * kMargin;
+    out.push(quad(0, 0, panel_w, panel_h, SpriteId::OverlayPanel));
+
+    // Legend: swatch, then the zone's mean in whole microseconds.
+    double mean_us[kProfileZones];
+    profiler.zone_averages_us(mean_us, 60);
+    for (int z = 0; z < kProfileZones; ++z) {
+        int y = kMargin + z * kRowHeight;
+        out.push(quad(kMargin, y + 2, 6, 6, zone_bar(z)));
+        char digits[8];
+        int n = 0;
+        uint32_t v = static_cast<uint32_t>(std::min(mean_us[z] + 0.5, 9999999.0));
+        do {
+            digits[n++] = static_cast<char>(v % 10);
+            v /= 10;
+        } while (v && n < 7);
+        int x = kMargin + 10;
+        for (int k = n - 1; k >= 0; --k, x += kDigitStep) {
+            SpriteId d = static_cast<SpriteId>(static_cast<int>(SpriteId::Digit0) + digits[k]);
+            out.push(quad(x, y, glyph.w, glyph.h, d));
+        }
+    }
+
+    // Graph: one column per frame, newest on the right, zones stacked bottom up.
+    int base = legend_h + 2 * kMargin + kGraphHeight;
+    double px_per_tick = kGraphHeight / (kBudgetUs * profile_ticks_per_us());
+    profiler.recent_frames(frames_, kGraphFrames);
+    int x = kMargin + kGraphFrames - static_cast<int>(frames_.size());
+    for (const FrameProfile& f : frames_) {
+        int y = base;
+        for (int z = 0; z < kProfileZones; ++z) {
+            int h = static_cast<int>(static_cast<double>(self_ticks(f, z)) * px_per_tick + 0.5);
+            h = std::min(h, y - (legend_h + kMargin));  // clip at the top of the graph area
+            if (h <= 0) continue;
+            y -= h;
+            out.push(quad(x, y, 1, h, zone_bar(z)));
+        }
+        ++x;
+    }
+    out.push(quad(kMargin, base - kGraphHeight, kGraphFrames, 1, SpriteId::Star, 160));  // 16.7 ms
+}
+
+}  // namespace toppler
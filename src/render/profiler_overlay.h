@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+#include "core/profiler.h"
+#include "render/atlas.h"
+#include "render/draw_list.h"
+
+namespace toppler {
+
+// In-game view of a Profiler: a legend with each zone's mean time over the
+// last second, and a stacked bar per frame for the last kGraphFrames frames
+// against a 60 Hz budget line. Drawn on Layer::Overlay from the atlas's
+// solid colour sprites, so it batches with the rest of the frame.
+class ProfilerOverlay {
+public:
+    static constexpr int kGraphFrames = 120;
+
+    void draw(const Profiler& profiler, const SpriteAtlas& atlas, DrawList& out);
+
+private:
+    std::vector<FrameProfile> frames_;  // reused between frames
+};
+
+}  // namespace toppler
@@ -0,0 +1,53 @@
+#include "render/projection.h"
+
+#include <algorithm>
+
+namespace toppler {
+
+namespace {
+
+// Wraps a step difference into [-kAngleSteps/2, kAngleSteps/2).
+int relative_step(int step) { return ((step + kAngleSteps / 2) & kAngleStepMask) - kAngleSteps / 2; }
+
+uint8_t shade_for(int rel) {
+    int c = cos_q14(std::clamp(rel, -kQuarterTurn, kQuarterTurn));
+    return static_cast<uint8_t>(64 + (191 * c) / kTrigOne);
+}
+
+}  // namespace
+
+TowerProjection::TowerProjection(TowerLayout layout) : layout_(layout), rings_(kAngleSteps) {
+    auto screen_x = [&](int rel) {
+        return layout_.center_x + (layout_.radius * sin_q14(rel)) / kTrigOne;
+    };
+    for (int view = 0; view < kAngleSteps; ++view) {
+        ProjectedRing& ring = rings_[view];
+        ring.count = 0;
+        for (int col = 0; col < kTowerColumns; ++col) {
+            int r0 = relative_step(col * kAngleStepsPerColumn - view);
+            int r1 = r0 + kAngleStepsPerColumn;
+            if (r0 >= kQuarterTurn || r1 <= -kQuarterTurn) continue;  // on the far side
+            int x0 = screen_x(std::max(r0, -kQuarterTurn));
+            int x1 = screen_x(std::min(r1, kQuarterTurn));
+            if (x1 <= x0) continue;
+            ColumnSpan& span = ring.spans[ring.count++];
+            span.x = static_cast<int16_t>(x0);
+            span.width = static_cast<int16_t>(x1 - x0);
+            span.column = static_cast<uint8_t>(col);
+            span.shade = shade_for(r0 + kAngleStepsPerColumn / 2);
+        }
+        std::sort(ring.spans, ring.spans + ring.count,
+                  [](const ColumnSpan& a, const ColumnSpan& b) { return a.x < b.x; });
+    }
+}
+
+ProjectedPoint TowerProjection::point(float angle, float view_angle) const {
+    int rel = relative_step(angle_step(angle) - angle_step(view_angle));
+    ProjectedPoint p;
+    p.visible = rel > -kQuarterTurn && rel < kQuarterTurn;
+    p.x = static_cast<int16_t>(layout_.center_x + (layout_.radius * sin_q14(rel)) / kTrigOne);
+    p.shade = shade_for(rel);
+    return p;
+}
+
+}  // namespace toppler
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "tower/tower_grid.h"
+
+namespace toppler {
+
+// Cylinder projection without trigonometry at draw time.
+//
+// Rotation is quantized to kAngleStepsPerColumn steps per brick column. The
+// sine table is generated at compile time; TowerProjection turns it into
+// per-rotation column spans once per screen layout, so drawing the tower is
+// a table lookup per visible column.
+
+constexpr int kAngleStepsPerColumn = 64;
+constexpr int kAngleSteps = kTowerColumns * kAngleStepsPerColumn;
+constexpr int kAngleStepMask = kAngleSteps - 1;
+constexpr int kQuarterTurn = kAngleSteps / 4;
+static_assert((kAngleSteps & kAngleStepMask) == 0, "angle steps must be a power of two");
+
+constexpr int kTrigOne = 1 << 14;  // Q14 fixed point
+
+namespace detail {
+
+// sin(x) for x in [-pi/2, pi/2]; the Taylor series is accurate to well under
+// one Q14 unit there.
+constexpr double taylor_sin(double x) {
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 10; ++n) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr std::array<int16_t, kAngleSteps> make_sine_table() {
+    constexpr double kPi = 3.14159265358979323846;
+    std::array<int16_t, kAngleSteps> table{};
+    for (int i = 0; i < kAngleSteps; ++i) {
+        // Fold into [-quarter, quarter] turn using sin(pi - x) = sin(x).
+        int s = i < kAngleSteps / 2 ? i : i - kAngleSteps;
+        if (s > kQuarterTurn) s = kAngleSteps / 2 - s;
+        if (s < -kQuarterTurn) s = -kAngleSteps / 2 - s;
+        double v = taylor_sin(2.0 * kPi * s / kAngleSteps) * kTrigOne;
+        table[i] = static_cast<int16_t>(v < 0 ? v - 0.5 : v + 0.5);
+    }
+    return table;
+}
+
+inline constexpr std::array<int16_t, kAngleSteps> kSineTable = make_sine_table();
+
+}  // namespace detail
+
+constexpr int sin_q14(int step) { return detail::kSineTable[step & kAngleStepMask]; }
+constexpr int cos_q14(int step) { return detail::kSineTable[(step + kQuarterTurn) & kAngleStepMask]; }
+
+// Quantizes an angle in columns to a table step.
+inline int angle_step(float angle) {
+    return static_cast<int>(angle * static_cast<float>(kAngleStepsPerColumn)) & kAngleStepMask;
+}
+
+// Screen placement of the tower cylinder.
+struct TowerLayout {
+    int center_x = 160;
+    int radius = 96;  // pixels from axis to surface
+};
+
+// One visible column at a given rotation.
+struct ColumnSpan {
+    int16_t x;       // left edge on screen
+    int16_t width;   // > 0
+    uint8_t column;  // tower column drawn here
+    uint8_t shade;   // brightness from how squarely the column faces the viewer
+};
+
+// Visible columns for one rotation step, left to right. At most half the
+// tower plus the partly visible column at each rim.
+struct ProjectedRing {
+    uint8_t count;
+    ColumnSpan spans[kTowerColumns / 2 + 2];
+};
+
+// A point on the cylinder surface as seen from the front.
+struct ProjectedPoint {
+    int16_t x;
+    uint8_t shade;
+    bool visible;  // on the front half
+};
+
+class TowerProjection {
+public:
+    explicit TowerProjection(TowerLayout layout = {});
+
+    const TowerLayout& layout() const { return layout_; }
+
+    // Columns to draw when the tower is rotated to view_angle (in columns).
+    const ProjectedRing& ring(float view_angle) const { return rings_[angle_step(view_angle)]; }
+    const ProjectedRing& ring_at_step(int step) const { return rings_[step & kAngleStepMask]; }
+
+    // Projects an entity at `angle` for a tower rotated to `view_angle`.
+    ProjectedPoint point(float angle, float view_angle) const;
+
+private:
+    TowerLayout layout_;
+    std::vector<ProjectedRing> rings_;  // kAngleSteps entries
+};
+
+}  // namespace toppler
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include "render/atlas.h"
+#include "render/draw_list.h"
+#include "render/image.h"
+
+namespace toppler {
+
+// A quad resolved against the atlas: where to draw and what to sample.
+struct BatchQuad {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+    AtlasRect src;
+    uint8_t shade;
+};
+
+// One draw call: consecutive quads sharing a layer and a texture.
+struct DrawBatch {
+    Layer layer;
+    uint16_t texture;
+    const BatchQuad* quads;
+    uint32_t count;
+};
+
+// Counters for the frame just submitted.
+struct FrameStats {
+    uint32_t draw_calls = 0;
+    uint32_t quads = 0;
+    uint32_t layer_uploads = 0;  // cached layers redrawn and re-uploaded
+};
+
+// What a graphics API (or the software rasterizer) implements. The batcher
+// calls draw() once per batch, never per sprite.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual void upload_texture(uint16_t texture, const Image& image) = 0;
+    virtual void begin_frame() = 0;
+    virtual void draw(const DrawBatch& batch) = 0;
+    virtual void end_frame() = 0;
+};
+
+// Backend that draws nothing; for headless runs and draw-call accounting.
+class NullBackend final : public RenderBackend {
+public:
+    void upload_texture(uint16_t, const Image&) override {}
+    void begin_frame() override {}
+    void draw(const DrawBatch&) override {}
+    void end_frame() override {}
+};
+
+}  // namespace toppler
@@ -0,0 +1,250 @@
+#include "render/renderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/rng.h"
+
+namespace toppler {
+
+namespace {
+
+constexpr int kStarCount = 48;
+constexpr int kHudScoreDigits = 6;
+// Digits step 6 px: the 7 px glyphs overlap by their drop shadow.
+constexpr int kDigitStep = 6;
+
+constexpr int kHudMaxLives = 5;  // icons shown; more lives still count
+
+int hud_height(const SpriteAtlas& atlas) {
+    return std::max(atlas.rect(SpriteId::Digit0).h, atlas.rect(SpriteId::PlayerStand).h) + 2;
+}
+
+uint32_t hud_seconds(const SimState& state) {
+    return (state.session.time_left + kTicksPerSecond - 1) / kTicksPerSecond;
+}
+
+}  // namespace
+
+Renderer::Renderer(RenderBackend& backend, const ScreenLayout& screen)
+    : backend_(backend),
+      tower_(screen),
+      backdrop_(kBackdropTexture, screen.width, screen.height * 2 + atlas_.rect(SpriteId::Water).h),
+      hud_(kHudTexture, screen.width, hud_height(atlas_)) {
+    backend_.upload_texture(SpriteAtlas::kTexture, atlas_.image());
+    list_.reserve(1024);
+    layer_quads_.reserve(4);
+    build_backdrop();
+
+    // HUD fields, each redrawn on its own: score on the left, tower number
+    // in the middle, lives and seconds left on the right.
+    int w = screen.width, h = hud_.image().height;
+    int life_w = atlas_.rect(SpriteId::PlayerStand).w + 2;
+    hud_score_ = hud_.add_region(PixelRect{0, 0, w / 2 - 20, h});
+    hud_tower_ = hud_.add_region(PixelRect{w / 2 - 20, 0, 40, h});
+    hud_time_ = hud_.add_region(PixelRect{w - 40, 0, 40, h});
+    hud_lives_ = hud_.add_region(PixelRect{w - 44 - kHudMaxLives * life_w, 0, kHudMaxLives * life_w, h});
+}
+
+const FrameStats& Renderer::render(const Level& level, const SimState& state) {
+    list_.clear();
+    layer_quads_.clear();
+    {
+        TT_PROFILE_ZONE(TowerDraw);
+        draw_backdrop(state);
+        tower_.draw(level, state, list_);
+    }
+    backend_.begin_frame();
+    {
+        TT_PROFILE_ZONE(SpriteDraw);
+        draw_entities(level, state);
+        draw_effects(state);
+        bool hud_uploaded = draw_hud(state);
+        if (show_profiler_ && profiler_) overlay_.draw(*profiler_, atlas_, list_);
+        stats_ = batcher_.submit(list_, atlas_, backend_, layer_batches_, 2);
+        stats_.layer_uploads = hud_uploaded;
+    }
+    {
+        TT_PROFILE_ZONE(Present);
+        backend_.end_frame();
+    }
+    return stats_;
+}
+
+void Renderer::push_sprite(SpriteId sprite, int x_center, int y_bottom, Layer layer, uint8_t shade) {
+    const AtlasRect& r = atlas_.rect(sprite);
+    list_.push(Quad{static_cast<int16_t>(x_center - r.w / 2), static_cast<int16_t>(y_bottom - r.h),
+                    static_cast<int16_t>(r.w), static_cast<int16_t>(r.h), sprite, layer, shade});
+}
+
+// The backdrop never changes, only scrolls: stars are drawn once into a
+// band that wraps horizontally, water tiles into the band below it.
+void Renderer::build_backdrop() {
+    const ScreenLayout& screen = tower_.screen();
+    DrawList& quads =
+        backdrop_.rebuild(backdrop_.add_region(PixelRect{0, 0, backdrop_.image().width, backdrop_.image().height}), 0);
+    uint32_t rng = rng_seed(0x57a25);
+    const AtlasRect& star = atlas_.rect(SpriteId::Star);
+    for (int i = 0; i < kStarCount; ++i) {
+        int16_t x = static_cast<int16_t>(rng_below(rng, static_cast<uint32_t>(screen.width)));
+        int16_t y = static_cast<int16_t>(rng_below(rng, static_cast<uint32_t>(screen.height)));
+        uint8_t shade = static_cast<uint8_t>(96 + rng_below(rng, 160));
+        Quad q{x, y, static_cast<int16_t>(star.w), static_cast<int16_t>(star.h), SpriteId::Star, Layer::Backdrop,
+               shade};
+        quads.push(q);
+        q.x = static_cast<int16_t>(q.x - screen.width);  // the part hanging off the right edge, wrapped
+        quads.push(q);
+    }
+    const AtlasRect& w = atlas_.rect(SpriteId::Water);
+    for (int y = screen.height; y < backdrop_.image().height; y += w.h) {
+        for (int x = 0; x < screen.width; x += w.w) {
+            quads.push(Quad{static_cast<int16_t>(x), static_cast<int16_t>(y), static_cast<int16_t>(w.w),
+                            static_cast<int16_t>(w.h), SpriteId::Water, Layer::Backdrop, 255});
+        }
+    }
+    backdrop_.flush(atlas_, backend_);
+}
+
+void Renderer::draw_backdrop(const SimState& state) {
+    const ScreenLayout& screen = tower_.screen();
+    auto region = [](int x, int y, int w, int h) {
+        return AtlasRect{static_cast<uint16_t>(x), static_cast<uint16_t>(y), static_cast<uint16_t>(w),
+                         static_cast<uint16_t>(h)};
+    };
+    auto add = [&](int x, int y, int w, int h, AtlasRect src) {
+        layer_quads_.push_back(BatchQuad{static_cast<int16_t>(x), static_cast<int16_t>(y), static_cast<int16_t>(w),
+                                         static_cast<int16_t>(h), src, 255});
+    };
+    // Stars drift slowly against the tower's rotation: screen x shows band
+    // column (x + shift) mod width.
+    int shift = static_cast<int>(state.session.tower_angle * static_cast<float>(screen.width) /
+                                 static_cast<float>(kTowerColumns * 4)) % screen.width;
+    add(0, 0, screen.width - shift, screen.height, region(shift, 0, screen.width - shift, screen.height));
+    if (shift) add(screen.width - shift, 0, shift, screen.height, region(0, 0, shift, screen.height));
+
+    int water_top = tower_.height_to_y(-1.0f, tower_.camera_height(state));
+    if (water_top < screen.height) {
+        const AtlasRect& w = atlas_.rect(SpriteId::Water);
+        int start = std::max(water_top, -static_cast<int>(w.h));  // tile phase, as if tiled down from here
+        int y = std::max(start, 0);
+        add(0, y, screen.width, screen.height - y, region(0, screen.height + y - start, screen.width, screen.height - y));
+    }
+    layer_batches_[0] = DrawBatch{Layer::Backdrop, kBackdropTexture, layer_quads_.data(),
+                                  static_cast<uint32_t>(layer_quads_.size())};
+}
+
+bool Renderer::draw_hud(const SimState& state) {
+    const ScreenLayout& screen = tower_.screen();
+    int bottom = hud_.image().height - 1;
+    auto sprite = [&](DrawList& quads, SpriteId id, int x) {
+        const AtlasRect& r = atlas_.rect(id);
+        quads.push(Quad{static_cast<int16_t>(x), static_cast<int16_t>(bottom - r.h), static_cast<int16_t>(r.w),
+                        static_cast<int16_t>(r.h), id, Layer::Hud, 255});
+    };
+    // Right-aligned at `right`, at least `min_digits` wide.
+    auto number = [&](int region, uint32_t value, int right, int min_digits) {
+        if (!hud_.stale(region, value)) return;
+        DrawList& quads = hud_.rebuild(region, value);
+        int x = right - kDigitStep;
+        for (int n = 0; n < min_digits || value; ++n, value /= 10, x -= kDigitStep) {
+            sprite(quads, static_cast<SpriteId>(static_cast<int>(SpriteId::Digit0) + static_cast<int>(value % 10)), x);
+        }
+    };
+    number(hud_score_, state.session.score, 4 + kHudScoreDigits * kDigitStep, kHudScoreDigits);
+    number(hud_tower_, static_cast<uint32_t>(tower_number_), screen.width / 2 + kDigitStep, 2);
+    number(hud_time_, hud_seconds(state), screen.width - 4, 3);
+    int lives = std::min<int>(state.session.lives, kHudMaxLives);
+    if (hud_.stale(hud_lives_, static_cast<uint64_t>(lives))) {
+        DrawList& quads = hud_.rebuild(hud_lives_, static_cast<uint64_t>(lives));
+        int step = atlas_.rect(SpriteId::PlayerStand).w + 2;
+        for (int i = 0; i < lives; ++i) sprite(quads, SpriteId::PlayerStand, screen.width - 44 - (i + 1) * step);
+    }
+    bool uploaded = hud_.flush(atlas_, backend_);
+
+    const Image& img = hud_.image();
+    hud_quad_ = BatchQuad{0, 0, static_cast<int16_t>(img.width), static_cast<int16_t>(img.height),
+                          AtlasRect{0, 0, static_cast<uint16_t>(img.width), static_cast<uint16_t>(img.height)}, 255};
+    layer_batches_[1] = DrawBatch{Layer::Hud, kHudTexture, &hud_quad_, 1};
+    return uploaded;
+}
+
+void Renderer::draw_entities(const Level& level, const SimState& state) {
+    const TowerProjection& proj = tower_.projection();
+    float view = state.session.tower_angle;
+    float camera = tower_.camera_height(state);
+    auto feet_y = [&](float h) { return tower_.height_to_y(h - 1.0f, camera); };
+
+    for (uint32_t i = 0; i < level.elevator_count && i < static_cast<uint32_t>(kMaxElevators); ++i) {
+        ProjectedPoint p = proj.point(static_cast<float>(level.elevators[i].column) + 0.5f, view);
+        if (p.visible) {
+            const AtlasRect& r = atlas_.rect(SpriteId::ElevatorCar);
+            push_sprite(SpriteId::ElevatorCar, p.x, feet_y(state.elevators.pos[i]) + r.h, Layer::Entities,
+                        p.shade);
+        }
+    }
+
+    const EnemyLanes& e = state.enemies;
+    for (int i = 0; i < e.pool.count; ++i) {
+        ProjectedPoint p = proj.point(e.angle[i], view);
+        if (!p.visible) continue;
+        SpriteId sprite = e.kind[i] == EnemyKind::Ball  ? SpriteId::Ball
+                          : e.kind[i] == EnemyKind::Eye ? SpriteId::Eye
+                                                        : SpriteId::Bouncer;
+        push_sprite(sprite, p.x, feet_y(e.height[i]), Layer::Entities, p.shade);
+    }
+
+    const ShotLanes& shots = state.shots;
+    for (int i = 0; i < shots.pool.count; ++i) {
+        ProjectedPoint p = proj.point(shots.angle[i], view);
+        if (p.visible) push_sprite(SpriteId::Shot, p.x, feet_y(shots.height[i]), Layer::Entities);
+    }
+
+    const PlayerState& pl = state.player;
+    if (pl.mode == PlayerMode::Tunnel || pl.mode == PlayerMode::Drowning) return;
+    if (pl.invulnerable > 0 && (state.session.tick / 4) % 2) return;  // flicker
+    SpriteId sprite = pl.mode == PlayerMode::Knocked ? SpriteId::PlayerHurt
+                      : (pl.mode == PlayerMode::Jumping || pl.mode == PlayerMode::Falling)
+                          ? SpriteId::PlayerJump
+                          : SpriteId::PlayerStand;
+    ProjectedPoint p = proj.point(pl.angle, view);
+    push_sprite(sprite, p.x, feet_y(pl.height), Layer::Entities);
+}
+
+void Renderer::draw_effects(const SimState& state) {
+    const TowerProjection& proj = tower_.projection();
+    float view = state.session.tower_angle;
+    float camera = tower_.camera_height(state);
+
+    for (int i = 0; i < Effects::kMaxDebris; ++i) {
+        const Effects::Debris& d = effects_.debris()[i];
+        if (d.age == 0) continue;
+        // Fragments are a 4x4 shrink of the crumble sprite.
+        ProjectedPoint p = proj.point(d.angle, view);
+        if (!p.visible) continue;
+        int y = tower_.height_to_y(d.height - 1.0f, camera);
+        list_.push(Quad{static_cast<int16_t>(p.x - 2), static_cast<int16_t>(y - 4), 4, 4, SpriteId::Crumble,
+                        Layer::Entities, p.shade});
+    }
+
+    for (int i = 0; i < Effects::kMaxPopups; ++i) {
+        const Effects::Popup& pop = effects_.popups()[i];
+        if (pop.age == 0) continue;
+        ProjectedPoint p = proj.point(pop.angle, view);
+        if (!p.visible) continue;
+        char digits[10];
+        int n = 0;
+        uint32_t v = pop.points;
+        do {
+            digits[n++] = static_cast<char>(v % 10);
+            v /= 10;
+        } while (v && n < 10);
+        int x = p.x - n * kDigitStep / 2 + kDigitStep / 2;
+        int y = tower_.height_to_y(pop.height - 1.0f, camera);
+        for (int k = n - 1; k >= 0; --k, x += kDigitStep) {
+            SpriteId glyph = static_cast<SpriteId>(static_cast<int>(SpriteId::Digit0) + digits[k]);
+            push_sprite(glyph, x, y, Layer::Entities);
+        }
+    }
+}
+
+}  // namespace toppler
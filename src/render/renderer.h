@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+
+#include "render/atlas.h"
+#include "render/draw_list.h"
+#include "render/effects.h"
+#include "render/layer_cache.h"
+#include "render/profiler_overlay.h"
+#include "render/render_backend.h"
+#include "render/sprite_batch.h"
+#include "render/tower_renderer.h"
+#include "sim/sim_state.h"
+#include "tower/level.h"
+
+namespace toppler {
+
+// Draws complete frames of a tower session: backdrop, tower, entities, HUD.
+// Reads only a const SimState; all sprites come from one atlas and reach
+// the backend as a handful of batched draw calls.
+//
+// The backdrop and HUD are cached layers (layer_cache.h) composited under
+// and over the tower: the starfield and water are drawn once and scrolled
+// by texture offset, and each HUD field (score, lives, seconds left, tower
+// number) is redrawn only when its value changes.
+class Renderer {
+public:
+    explicit Renderer(RenderBackend& backend, const ScreenLayout& screen = {});
+
+    // Builds, submits and presents one frame.
+    const FrameStats& render(const Level& level, const SimState& state);
+
+    // Feeds one sim tick's events to the popup / debris effects. Call once
+    // per sim_step, independently of how often frames are rendered.
+    void add_events(const TickEvents& events) { effects_.tick(events); }
+    void clear_effects() { effects_.clear(); }
+    // For a renderer fed from another thread's sim: draws `effects` as that
+    // thread's Effects stood at the state about to be rendered.
+    void set_effects(const Effects& effects) { effects_ = effects; }
+
+    // Tower number the HUD shows (1-based position in the campaign).
+    void set_tower_number(int number) { tower_number_ = number; }
+
+    // Profiler whose numbers the overlay shows (nullptr for none). Timing
+    // itself goes to whichever profiler is bound to the rendering thread.
+    void set_profiler(const Profiler* profiler) { profiler_ = profiler; }
+    // Shows or hides the overlay; the game binds this to a debug key.
+    void toggle_profiler_overlay() { show_profiler_ = !show_profiler_; }
+    bool profiler_overlay_visible() const { return show_profiler_; }
+
+    // Counters for the last frame (draw calls, quads).
+    const FrameStats& stats() const { return stats_; }
+
+    const TowerRenderer& tower() const { return tower_; }
+    const SpriteAtlas& atlas() const { return atlas_; }
+    const DrawList& draw_list() const { return list_; }
+    const CachedLayer& hud_layer() const { return hud_; }
+
+private:
+    void build_backdrop();
+    void draw_backdrop(const SimState& state);
+    bool draw_hud(const SimState& state);
+    void draw_entities(const Level& level, const SimState& state);
+    void draw_effects(const SimState& state);
+    void push_sprite(SpriteId sprite, int x_center, int y_bottom, Layer layer, uint8_t shade = 255);
+
+    RenderBackend& backend_;
+    TowerRenderer tower_;
+    SpriteAtlas atlas_;
+    SpriteBatcher batcher_;
+    DrawList list_;
+    FrameStats stats_;
+    Effects effects_;
+    CachedLayer backdrop_;  // starfield in rows [0, h), water tiles below
+    CachedLayer hud_;
+    std::vector<BatchQuad> layer_quads_;  // backdrop quads, rebuilt each frame
+    BatchQuad hud_quad_{};
+    DrawBatch layer_batches_[2] = {};
+    int tower_number_ = 1;
+    int hud_score_ = 0, hud_tower_ = 0, hud_time_ = 0, hud_lives_ = 0;  // hud_ regions
+    const Profiler* profiler_ = nullptr;
+    bool show_profiler_ = false;
+    ProfilerOverlay overlay_;
+};
+
+}  // namespace toppler
@@ -0,0 +1,241 @@
+#include "render/replay_video.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "render/effects.h"
+#include "render/renderer.h"
+#include "render/software_backend.h"
+#include "sim/game_sim.h"
+
+namespace toppler {
+
+namespace {
+
+// Buffers between the stages: enough to ride out a slow frame without
+// letting the sim run far ahead of the encoder.
+constexpr int kSimSlots = 4;
+constexpr int kFrameSlots = 3;
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point t0) { return std::chrono::duration<double>(Clock::now() - t0).count(); }
+
+// Indices of buffers passed from one stage to the next, in order. pop()
+// blocks until one arrives; after close() it drains what is left, after
+// abort() it returns false at once.
+class SlotQueue {
+public:
+    void push(int slot) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slots_.push_back(slot);
+        }
+        ready_.notify_one();
+    }
+
+    // Adds the time spent blocked to `waited`.
+    bool pop(int& slot, double& waited) {
+        auto t0 = Clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return aborted_ || closed_ || !slots_.empty(); });
+        waited += seconds_since(t0);
+        if (aborted_ || slots_.empty()) return false;
+        slot = slots_.front();
+        slots_.pop_front();
+        return true;
+    }
+
+    void close() { finish(false); }
+    void abort() { finish(true); }
+
+private:
+    void finish(bool abort) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            aborted_ = aborted_ || abort;
+        }
+        ready_.notify_all();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<int> slots_;
+    bool closed_ = false;
+    bool aborted_ = false;
+};
+
+// What the raster stage needs to draw one frame.
+struct SimFrame {
+    SimState state;
+    Effects effects;
+};
+
+// BT.601, limited range, chroma averaged over each 2x2 block.
+void to_i420(const Image& img, uint8_t* y_plane, uint8_t* u_plane, uint8_t* v_plane) {
+    int w = img.width, h = img.height;
+    for (int y = 0; y < h; ++y) {
+        const uint32_t* row = &img.pixels[static_cast<size_t>(y) * w];
+        uint8_t* out = y_plane + static_cast<size_t>(y) * w;
+        for (int x = 0; x < w; ++x) {
+            int r = (row[x] >> 16) & 0xff, g = (row[x] >> 8) & 0xff, b = row[x] & 0xff;
+            out[x] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+    for (int y = 0; y < h; y += 2) {
+        const uint32_t* top = &img.pixels[static_cast<size_t>(y) * w];
+        const uint32_t* bottom = top + w;
+        uint8_t* u = u_plane + static_cast<size_t>(y / 2) * (w / 2);
+        uint8_t* v = v_plane + static_cast<size_t>(y / 2) * (w / 2);
+        for (int x = 0; x < w; x += 2) {
+            auto mean = [&](int shift) {
+                return static_cast<int>(((top[x] >> shift) & 0xff) + ((top[x + 1] >> shift) & 0xff) +
+                                        ((bottom[x] >> shift) & 0xff) + ((bottom[x + 1] >> shift) & 0xff) + 2) >>
+                       2;
+            };
+            int r = mean(16), g = mean(8), b = mean(0);
+            u[x / 2] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            v[x / 2] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+void write_all(std::FILE* out, const void* data, size_t size) {
+    if (std::fwrite(data, 1, size, out) != size) throw ReplayError("replay video: write failed");
+}
+
+}  // namespace
+
+ReplayVideoStats render_replay_video(const Level& level, const Replay& replay, std::FILE* out,
+                                     const ReplayVideoOptions& options) {
+    if (replay.tower_id != level_fingerprint(level)) throw ReplayError("replay: recorded on a different tower");
+    if (replay.sim_version != kSimVersion) throw ReplayError("replay: recorded with another sim version");
+    const ScreenLayout& screen = options.screen;
+    if (screen.width <= 0 || screen.height <= 0 || screen.width % 2 || screen.height % 2) {
+        throw ReplayError("replay video: frame size must be even");
+    }
+    uint32_t step = std::max<uint32_t>(options.frame_step, 1);
+
+    SoftwareBackendOptions raster;
+    raster.threads = options.raster_threads;
+    SoftwareBackend backend(screen.width, screen.height, raster);
+    Renderer renderer(backend, screen);
+    renderer.set_tower_number(options.tower_number);
+
+    std::vector<SimFrame> sim_frames(kSimSlots);
+    std::vector<Image> images(kFrameSlots, Image(screen.width, screen.height));
+    SlotQueue sim_free, sim_ready, frame_free, frame_ready;
+    for (int i = 0; i < kSimSlots; ++i) sim_free.push(i);
+    for (int i = 0; i < kFrameSlots; ++i) frame_free.push(i);
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto fail = [&](std::exception_ptr e) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = e;
+        }
+        for (SlotQueue* q : {&sim_free, &sim_ready, &frame_free, &frame_ready}) q->abort();
+    };
+
+    ReplayVideoStats stats;
+    auto start = Clock::now();
+    double sim_wait = 0.0, raster_wait = 0.0, encode_wait = 0.0;
+
+    // Stage 1: the sim, with the effects the renderer would have built.
+    std::thread sim_thread([&] {
+        try {
+            SimState state;
+            sim_init(level, replay.seed, state);
+            Effects effects;
+            FrameArena arena;
+            TickEvents events;
+            uint32_t tick = 0;
+            auto emit = [&] {
+                int slot;
+                if (!sim_free.pop(slot, sim_wait)) return false;
+                sim_frames[static_cast<size_t>(slot)].state = state;
+                sim_frames[static_cast<size_t>(slot)].effects = effects;
+                sim_ready.push(slot);
+                return true;
+            };
+            bool running = emit();
+            // Nothing happens after the session ends; input past it (which
+            // only a bad file has) is not worth simulating.
+            auto live = [&] { return running && state.session.status == SimStatus::Playing; };
+            for (size_t r = 0; live() && r < replay.inputs.size(); ++r) {
+                for (uint32_t i = 0; live() && i < replay.inputs[r].ticks; ++i) {
+                    arena.reset();
+                    events.reset(arena);
+                    sim_step(level, state, replay.inputs[r].mask, &events);
+                    effects.tick(events);
+                    if (++tick % step == 0) running = emit();
+                }
+            }
+            stats.ticks = tick;
+            stats.sim_seconds = seconds_since(start) - sim_wait;
+            sim_ready.close();
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    });
+
+    // Stage 2: rasterize, then hand the framebuffer itself downstream.
+    std::thread raster_thread([&] {
+        try {
+            int slot, frame;
+            while (sim_ready.pop(slot, raster_wait)) {
+                const SimFrame& f = sim_frames[static_cast<size_t>(slot)];
+                renderer.set_effects(f.effects);
+                renderer.render(level, f.state);
+                sim_free.push(slot);
+                if (!frame_free.pop(frame, raster_wait)) break;
+                backend.swap_frame(images[static_cast<size_t>(frame)]);
+                frame_ready.push(frame);
+            }
+            stats.raster_seconds = seconds_since(start) - raster_wait;
+            frame_ready.close();
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    });
+
+    // Stage 3, on the calling thread: convert and write.
+    try {
+        char header[96];
+        int n = std::snprintf(header, sizeof header, "YUV4MPEG2 W%d H%d F%u:%u Ip A1:1 C420jpeg\n", screen.width,
+                              screen.height, static_cast<unsigned>(kTicksPerSecond), step);
+        write_all(out, header, static_cast<size_t>(n));
+        stats.bytes += static_cast<size_t>(n);
+        size_t luma = static_cast<size_t>(screen.width) * screen.height;
+        std::vector<uint8_t> yuv(luma + luma / 2);
+        static const char kFrame[] = "FRAME\n";
+        int frame;
+        while (frame_ready.pop(frame, encode_wait)) {
+            to_i420(images[static_cast<size_t>(frame)], yuv.data(), yuv.data() + luma, yuv.data() + luma + luma / 4);
+            frame_free.push(frame);
+            write_all(out, kFrame, sizeof kFrame - 1);
+            write_all(out, yuv.data(), yuv.size());
+            stats.bytes += sizeof kFrame - 1 + yuv.size();
+            ++stats.frames;
+        }
+        if (std::fflush(out) != 0) throw ReplayError("replay video: write failed");
+        stats.encode_seconds = seconds_since(start) - encode_wait;
+    } catch (...) {
+        fail(std::current_exception());
+    }
+    sim_thread.join();
+    raster_thread.join();
+    if (error) std::rethrow_exception(error);
+    stats.seconds = seconds_since(start);
+    return stats;
+}
+
+}  // namespace toppler
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include "render/tower_renderer.h"
+#include "replay/replay.h"
+#include "tower/level.h"
+
+namespace toppler {
+
+// Renders a replay to video without a window: the sim, the software
+// rasterizer and the encoder each run on their own thread, handing frames
+// down through small fixed pools of buffers, so all three overlap and a
+// clip takes as long as its slowest stage rather than the sum. Nothing
+// waits on a clock; frames come out as fast as the machine makes them.
+//
+// Output is YUV4MPEG2 (I420, BT.601 limited range): raw frames any encoder
+// reads from a pipe, e.g.
+//
+//   replay_render --pack campaign.ttpk run.ttr | ffmpeg -i - -c:v libx264 run.mp4
+
+struct ReplayVideoOptions {
+    ScreenLayout screen;          // frame size; width and height must be even
+    uint32_t frame_step = 1;      // render every Nth tick: 60 / N frames per second
+    unsigned raster_threads = 1;  // threads of the software rasterizer
+    int tower_number = 1;         // shown in the HUD
+};
+
+struct ReplayVideoStats {
+    uint32_t ticks = 0;
+    uint32_t frames = 0;
+    uint64_t bytes = 0;
+    double seconds = 0.0;  // wall clock
+    // Time each stage spent working rather than waiting on its neighbours.
+    double sim_seconds = 0.0;
+    double raster_seconds = 0.0;
+    double encode_seconds = 0.0;
+};
+
+// Writes the whole replay to `out` as a y4m stream. `level` must be the
+// replay's tower and the sim versions must agree; throws ReplayError for
+// that, for an odd frame size and when writing fails.
+ReplayVideoStats render_replay_video(const Level& level, const Replay& replay, std::FILE* out,
+                                     const ReplayVideoOptions& options = {});
+
+}  // namespace toppler
@@ -0,0 +1,283 @@
+#include "render/software_backend.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#define TT_RASTER_SSE2 1
+#endif
+
+namespace toppler {
+
+namespace {
+
+constexpr int kMinSolidRun = 4;  // shorter single-colour stretches stay in the surrounding Opaque run
+constexpr int kLineChunk = 256;  // pixels gathered per step when a quad is scaled
+
+// round(x / 255) for x <= 255 * 255; the SIMD paths use the same identity on
+// 16-bit lanes, which is what keeps them bit-identical to the scalar path.
+inline uint32_t div255(uint32_t x) {
+    uint32_t t = x + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+inline uint32_t shade_rgb(uint32_t p, uint32_t shade) {
+    return (p & 0xff000000u) | (div255(((p >> 16) & 0xff) * shade) << 16) | (div255(((p >> 8) & 0xff) * shade) << 8) |
+           div255((p & 0xff) * shade);
+}
+
+// `p` (straight alpha, already shaded) over an opaque pixel.
+inline uint32_t over_opaque(uint32_t p, uint32_t d) {
+    uint32_t a = p >> 24, na = 255 - a;
+    auto channel = [&](int shift) { return div255(((p >> shift) & 0xff) * a + ((d >> shift) & 0xff) * na); };
+    return 0xff000000u | (channel(16) << 16) | (channel(8) << 8) | channel(0);
+}
+
+// One texel drawn over the framebuffer: the per-pixel definition.
+inline uint32_t composite(uint32_t p, uint32_t shade, uint32_t d) {
+    uint32_t a = p >> 24;
+    if (a == 0) return d;
+    if (shade != 255) p = shade_rgb(p, shade);
+    return a == 255 ? p : over_opaque(p, d);
+}
+
+void fill_span(uint32_t* dst, int n, uint32_t colour) {
+    int i = 0;
+#if TT_RASTER_SSE2
+    __m128i c = _mm_set1_epi32(static_cast<int>(colour));
+    for (; i + 4 <= n; i += 4) _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), c);
+#endif
+    for (; i < n; ++i) dst[i] = colour;
+}
+
+#if TT_RASTER_SSE2
+inline __m128i div255_epu16(__m128i x) {
+    __m128i t = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+#endif
+
+// Opaque texels scaled by shade.
+void shade_span(const uint32_t* src, uint32_t* dst, int n, uint32_t shade) {
+    int i = 0;
+#if TT_RASTER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i s = _mm_set1_epi16(static_cast<int16_t>(shade));
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    for (; i + 4 <= n; i += 4) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i lo = div255_epu16(_mm_mullo_epi16(_mm_unpacklo_epi8(p, zero), s));
+        __m128i hi = div255_epu16(_mm_mullo_epi16(_mm_unpackhi_epi8(p, zero), s));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), alpha));
+    }
+#endif
+    for (; i < n; ++i) dst[i] = shade_rgb(src[i], shade);
+}
+
+// Any texels, shaded and blended over the framebuffer.
+void blend_span(const uint32_t* src, uint32_t* dst, int n, uint32_t shade) {
+    int i = 0;
+#if TT_RASTER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i s = _mm_set1_epi16(static_cast<int16_t>(shade));
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    auto half = [&](__m128i p, __m128i d) {
+        __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(p, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i c = div255_epu16(_mm_mullo_epi16(p, s));
+        return div255_epu16(_mm_add_epi16(_mm_mullo_epi16(c, a), _mm_mullo_epi16(d, _mm_sub_epi16(full, a))));
+    };
+    for (; i + 4 <= n; i += 4) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i lo = half(_mm_unpacklo_epi8(p, zero), _mm_unpacklo_epi8(d, zero));
+        __m128i hi = half(_mm_unpackhi_epi8(p, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), alpha));
+    }
+#endif
+    for (; i < n; ++i) dst[i] = composite(src[i], shade, dst[i]);
+}
+
+}  // namespace
+
+SoftwareBackend::SoftwareBackend(int width, int height, const SoftwareBackendOptions& options)
+    : options_(options), pool_(options.threads), frame_(width, height, options.clear) {
+    items_.reserve(1024);
+}
+
+void SoftwareBackend::upload_texture(uint16_t texture, const Image& image) {
+    if (texture >= textures_.size()) textures_.resize(texture + 1u);
+    Texture& t = textures_[texture];
+    t.image = image;
+    t.runs.clear();
+    t.row_runs.assign(static_cast<size_t>(image.height) + 1, 0);
+
+    auto push = [&](RunKind kind, int x0, int x1, uint32_t colour) {
+        if (kind != RunKind::Solid && !t.runs.empty() && t.runs.back().kind == kind && t.runs.back().x1 == x0) {
+            t.runs.back().x1 = static_cast<uint16_t>(x1);
+            return;
+        }
+        t.runs.push_back(Run{static_cast<uint16_t>(x0), static_cast<uint16_t>(x1), kind, colour});
+    };
+    for (int y = 0; y < image.height; ++y) {
+        t.row_runs[static_cast<size_t>(y)] = static_cast<uint32_t>(t.runs.size());
+        const uint32_t* row = &image.pixels[static_cast<size_t>(y) * image.width];
+        for (int x = 0; x < image.width;) {
+            uint32_t p = row[x];
+            uint32_t a = p >> 24;
+            if (a != 255) {
+                push(a == 0 ? RunKind::Clear : RunKind::Blend, x, x + 1, 0);
+                ++x;
+                continue;
+            }
+            int end = x + 1;
+            while (end < image.width && row[end] == p) ++end;
+            if (end - x >= kMinSolidRun) {
+                push(RunKind::Solid, x, end, p);
+            } else {
+                push(RunKind::Opaque, x, end, 0);
+            }
+            x = end;
+        }
+    }
+    t.row_runs.back() = static_cast<uint32_t>(t.runs.size());
+}
+
+void SoftwareBackend::begin_frame() { items_.clear(); }
+
+void SoftwareBackend::draw(const DrawBatch& batch) {
+    for (uint32_t i = 0; i < batch.count; ++i) items_.push_back(Item{batch.texture, batch.quads[i]});
+}
+
+void SoftwareBackend::end_frame() {
+    // A few bands per thread so a band crowded with sprites does not hold
+    // the others up.
+    int bands = pool_.size() == 1 ? 1 : static_cast<int>(pool_.size()) * 4;
+    int rows = (frame_.height + bands - 1) / bands;
+    scratch_.resize(static_cast<size_t>(bands));
+    pool_.parallel_for(static_cast<size_t>(bands), 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            int y0 = static_cast<int>(b) * rows;
+            draw_band(scratch_[b], y0, std::min(y0 + rows, frame_.height));
+        }
+    });
+    ++frames_;
+}
+
+void SoftwareBackend::draw_band(Scratch& scratch, int y0, int y1) {
+    if (y0 >= y1) return;
+    fill_span(&frame_.at(0, y0), (y1 - y0) * frame_.width, options_.clear);
+    for (const Item& item : items_) {
+        if (item.texture >= textures_.size()) continue;
+        const Texture& tex = textures_[item.texture];
+        const BatchQuad& q = item.quad;
+        if (q.w <= 0 || q.h <= 0 || q.src.w == 0 || q.src.h == 0) continue;
+        int qy0 = std::max<int>(q.y, y0), qy1 = std::min<int>(q.y + q.h, y1);
+        if (qy0 >= qy1) continue;
+        if (options_.per_pixel) {
+            draw_quad_pixels(tex, q, qy0, qy1);
+        } else {
+            draw_quad_spans(scratch, tex, q, qy0, qy1);
+        }
+    }
+}
+
+void SoftwareBackend::draw_quad_pixels(const Texture& tex, const BatchQuad& q, int y0, int y1) {
+    const AtlasRect& r = q.src;
+    int x0 = std::max<int>(q.x, 0), x1 = std::min<int>(q.x + q.w, frame_.width);
+    for (int y = y0; y < y1; ++y) {
+        int sy = r.y + (y - q.y) * r.h / q.h;
+        for (int x = x0; x < x1; ++x) {
+            int sx = r.x + (x - q.x) * r.w / q.w;
+            uint32_t& d = frame_.at(x, y);
+            d = composite(tex.image.at(sx, sy), q.shade, d);
+        }
+    }
+}
+
+void SoftwareBackend::draw_quad_spans(Scratch& scratch, const Texture& tex, const BatchQuad& q, int y0, int y1) {
+    const AtlasRect& r = q.src;
+    int x0 = std::max<int>(q.x, 0), x1 = std::min<int>(q.x + q.w, frame_.width);
+    if (x0 >= x1) return;
+    // Screen x samples texel r.x + (x - q.x) * r.w / q.w. The mapping is the
+    // same for every row, so a scaled quad works it out once, by stepping
+    // rather than dividing: which texel each screen x samples, and the first
+    // screen x of each texel.
+    int s0 = r.x + (x0 - q.x) * r.w / q.w;
+    int s1 = r.x + (x1 - 1 - q.x) * r.w / q.w + 1;
+    bool scaled = q.w != r.w;
+    if (scaled) {
+        scratch.texel_x.resize(static_cast<size_t>(x1 - x0));
+        scratch.dest_x.assign(static_cast<size_t>(s1 - s0) + 1, x1);
+        int sx = s0, rem = (x0 - q.x) * r.w % q.w;
+        scratch.dest_x[0] = x0;
+        for (int x = x0; x < x1; ++x) {
+            scratch.texel_x[static_cast<size_t>(x - x0)] = static_cast<uint32_t>(sx);
+            for (rem += r.w; rem >= q.w; rem -= q.w) {
+                ++sx;
+                if (sx < s1) scratch.dest_x[static_cast<size_t>(sx - s0)] = x + 1;
+            }
+        }
+    }
+    auto dest_x = [&](int s) { return scaled ? scratch.dest_x[static_cast<size_t>(s - s0)] : q.x + (s - r.x); };
+    uint32_t line[kLineChunk];
+
+    // Texture rows often repeat (brick courses, a quad scaled up). When the
+    // texels under this row match the previous row's and that row covered
+    // the framebuffer completely, its pixels are copied instead of redrawn.
+    const uint32_t* prev_src = nullptr;
+    bool prev_covered = false;
+    int sy = r.y + (y0 - q.y) * r.h / q.h, rem_y = (y0 - q.y) * r.h % q.h;
+    for (int y = y0; y < y1; ++y) {
+        int ty = sy;
+        for (rem_y += r.h; rem_y >= q.h; rem_y -= q.h) ++sy;
+        const uint32_t* src = &tex.image.pixels[static_cast<size_t>(ty) * tex.image.width];
+        uint32_t* row = &frame_.at(0, y);
+        if (prev_covered &&
+            (src == prev_src || std::memcmp(src + s0, prev_src + s0, static_cast<size_t>(s1 - s0) * 4) == 0)) {
+            std::memcpy(row + x0, row - frame_.width + x0, static_cast<size_t>(x1 - x0) * sizeof(uint32_t));
+            prev_src = src;
+            continue;
+        }
+        prev_src = src;
+        prev_covered = true;
+        const Run* first = tex.runs.data() + tex.row_runs[static_cast<size_t>(ty)];
+        const Run* last = tex.runs.data() + tex.row_runs[static_cast<size_t>(ty) + 1];
+        const Run* run = std::upper_bound(first, last, s0, [](int x, const Run& k) { return x < k.x1; });
+        for (; run != last && run->x0 < s1; ++run) {
+            if (run->kind == RunKind::Clear || run->kind == RunKind::Blend) prev_covered = false;
+            if (run->kind == RunKind::Clear) continue;
+            int da = dest_x(std::max<int>(run->x0, s0));
+            int db = dest_x(std::min<int>(run->x1, s1));
+            if (da >= db) continue;
+            if (run->kind == RunKind::Solid) {
+                fill_span(row + da, db - da, q.shade == 255 ? run->colour : shade_rgb(run->colour, q.shade));
+                continue;
+            }
+            bool opaque = run->kind == RunKind::Opaque;
+            auto emit = [&](const uint32_t* texels, int x, int n) {
+                if (!opaque) {
+                    blend_span(texels, row + x, n, q.shade);
+                } else if (q.shade != 255) {
+                    shade_span(texels, row + x, n, q.shade);
+                } else {
+                    std::memcpy(row + x, texels, static_cast<size_t>(n) * sizeof(uint32_t));
+                }
+            };
+            if (!scaled) {
+                emit(src + r.x + (da - q.x), da, db - da);
+                continue;
+            }
+            const uint32_t* texel_x = scratch.texel_x.data() - x0;
+            for (int x = da; x < db;) {
+                int n = std::min(db - x, kLineChunk);
+                for (int i = 0; i < n; ++i) line[i] = src[texel_x[x + i]];
+                emit(line, x, n);
+                x += n;
+            }
+        }
+    }
+}
+
+}  // namespace toppler
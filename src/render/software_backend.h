@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "core/thread_pool.h"
+#include "render/image.h"
+#include "render/render_backend.h"
+
+namespace toppler {
+
+struct SoftwareBackendOptions {
+    unsigned threads = 1;  // rasterizing threads including the caller; 0 = hardware_concurrency
+    bool per_pixel = false;  // sample, shade and blend pixel by pixel: the reference the span path must match
+    uint32_t clear = argb(255, 0, 0, 0);
+};
+
+// Rendering backend for machines without a GPU: draws every batch into an
+// opaque framebuffer in memory, for headless servers, CI and video export.
+//
+// Batches are only recorded as they arrive; end_frame() rasterizes them in
+// order. The frame is cut into horizontal bands that the thread pool draws
+// independently (each band walks the whole quad list clipped to its rows),
+// so painter's order holds without any locking.
+//
+// Uploaded textures are split per row into runs: fully transparent,
+// a single opaque colour, opaque, or partly transparent. A quad row then
+// costs one step per run instead of one per pixel: transparent runs are
+// skipped, single-colour runs become SIMD fills of the shaded colour (most
+// of the tower: brick faces and mortar lines stretched over a column), and
+// only the rest is sampled, with SIMD shading and blending. A row whose
+// texels repeat the one above (brick courses) is copied from it. Scaling is
+// nearest-neighbour like rasterize_quads(); both paths share one rounding
+// rule, so the span path is bit-identical to per_pixel.
+class SoftwareBackend final : public RenderBackend {
+public:
+    SoftwareBackend(int width, int height, const SoftwareBackendOptions& options = {});
+
+    void upload_texture(uint16_t texture, const Image& image) override;
+    void begin_frame() override;
+    void draw(const DrawBatch& batch) override;
+    void end_frame() override;
+
+    // The last completed frame; alpha is always 255.
+    const Image& frame() const { return frame_; }
+    // Hands the last frame over without copying it: swaps it with `other`,
+    // which must be the same size and becomes the buffer the next frame is
+    // drawn into.
+    void swap_frame(Image& other) { std::swap(frame_.pixels, other.pixels); }
+    unsigned threads() const { return pool_.size(); }
+    uint64_t frames() const { return frames_; }
+
+private:
+    enum class RunKind : uint8_t { Clear, Solid, Opaque, Blend };
+    struct Run {
+        uint16_t x0;
+        uint16_t x1;
+        RunKind kind;
+        uint32_t colour;  // Solid only
+    };
+    struct Texture {
+        Image image;
+        std::vector<uint32_t> row_runs;  // row y's runs are runs[row_runs[y] .. row_runs[y + 1])
+        std::vector<Run> runs;
+    };
+    struct Item {
+        uint16_t texture;
+        BatchQuad quad;
+    };
+    // Per band, reused between quads: where a scaled quad's texels land.
+    struct Scratch {
+        std::vector<int> dest_x;        // texel offset k is first drawn at screen x dest_x[k]
+        std::vector<uint32_t> texel_x;  // texel column sampled at each screen x of the quad
+    };
+
+    void draw_band(Scratch& scratch, int y0, int y1);
+    void draw_quad_spans(Scratch& scratch, const Texture& tex, const BatchQuad& q, int y0, int y1);
+    void draw_quad_pixels(const Texture& tex, const BatchQuad& q, int y0, int y1);
+
+    SoftwareBackendOptions options_;
+    ThreadPool pool_;
+    Image frame_;
+    std::vector<Texture> textures_;  // by texture id
+    std::vector<Item> items_;        // this frame's quads, in draw order
+    std::vector<Scratch> scratch_;   // by band
+    uint64_t frames_ = 0;
+};
+
+}  // namespace toppler
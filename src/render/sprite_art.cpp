@@ -0,0 +1,215 @@
+#include "render/sprite_art.h"
+
+#include <cstdlib>
+
+namespace toppler {
+
+namespace {
+
+constexpr uint32_t kClear = 0;
+
+void fill_rect(Image& img, int x0, int y0, int w, int h, uint32_t c) {
+    for (int y = y0; y < y0 + h && y < img.height; ++y) {
+        for (int x = x0; x < x0 + w && x < img.width; ++x) {
+            if (x >= 0 && y >= 0) img.at(x, y) = c;
+        }
+    }
+}
+
+// Filled ellipse inscribed in the rectangle.
+void fill_ellipse(Image& img, int x0, int y0, int w, int h, uint32_t c) {
+    int rx2 = w * w, ry2 = h * h;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            int dx = 2 * x + 1 - w, dy = 2 * y + 1 - h;
+            if (dx * dx * ry2 + dy * dy * rx2 <= rx2 * ry2) img.at(x0 + x, y0 + y) = c;
+        }
+    }
+}
+
+Image bricks(uint32_t brick, uint32_t mortar) {
+    Image img(16, 16, brick);
+    for (int y = 0; y < 16; y += 4) fill_rect(img, 0, y, 16, 1, mortar);
+    for (int y = 0; y < 16; y += 4) {
+        int offset = (y / 4) % 2 ? 4 : 12;
+        fill_rect(img, offset, y, 1, 4, mortar);
+    }
+    return img;
+}
+
+// 3x5 digit glyphs, one row per nibble (bit 2 = leftmost pixel).
+constexpr uint8_t kDigitGlyphs[10][5] = {
+    {7, 5, 5, 5, 7}, {2, 6, 2, 2, 7}, {7, 1, 7, 4, 7}, {7, 1, 3, 1, 7}, {5, 5, 7, 1, 1},
+    {7, 4, 7, 1, 7}, {7, 4, 7, 5, 7}, {7, 1, 1, 2, 2}, {7, 5, 7, 5, 7}, {7, 5, 7, 1, 7},
+};
+
+// Glyph at 2x with a one pixel drop shadow: 7x11.
+Image digit(int n) {
+    Image img(7, 11, kClear);
+    for (int pass = 0; pass < 2; ++pass) {
+        uint32_t c = pass == 0 ? argb(255, 20, 20, 30) : argb(255, 255, 240, 120);
+        int off = pass == 0 ? 1 : 0;
+        for (int y = 0; y < 5; ++y) {
+            for (int x = 0; x < 3; ++x) {
+                if (kDigitGlyphs[n][y] & (4 >> x)) fill_rect(img, x * 2 + off, y * 2 + off, 2, 2, c);
+            }
+        }
+    }
+    return img;
+}
+
+// One colour per ProfileZone, in zone order.
+constexpr uint32_t kZoneColours[] = {
+    argb(255, 140, 150, 170),  // input
+    argb(255, 60, 200, 80),    // sim
+    argb(255, 190, 230, 60),   // enemy update
+    argb(255, 250, 150, 40),   // collision
+    argb(255, 70, 120, 240),   // tower draw
+    argb(255, 60, 210, 230),   // sprite draw
+    argb(255, 190, 90, 230),   // audio mix
+    argb(255, 240, 70, 70),    // present
+};
+
+Image ledge(uint32_t top, uint32_t face) {
+    Image img(16, 16, kClear);
+    fill_rect(img, 0, 10, 16, 2, top);
+    fill_rect(img, 0, 12, 16, 4, face);
+    return img;
+}
+
+}  // namespace
+
+Image make_sprite_image(SpriteId id) {
+    switch (id) {
+        case SpriteId::TowerFace:
+            return bricks(argb(255, 150, 60, 40), argb(255, 90, 40, 30));
+        case SpriteId::Ledge:
+            return ledge(argb(255, 200, 200, 200), argb(255, 130, 130, 140));
+        case SpriteId::Crumble: {
+            Image img = ledge(argb(255, 190, 160, 110), argb(255, 130, 100, 70));
+            for (int x = 2; x < 16; x += 5) fill_rect(img, x, 12, 1, 4, argb(255, 60, 40, 20));
+            return img;
+        }
+        case SpriteId::Slippery:
+            return ledge(argb(255, 220, 240, 255), argb(255, 120, 180, 230));
+        case SpriteId::Wall:
+            return bricks(argb(255, 90, 90, 110), argb(255, 50, 50, 60));
+        case SpriteId::Door: {
+            Image img = bricks(argb(255, 150, 60, 40), argb(255, 90, 40, 30));
+            fill_rect(img, 3, 4, 10, 12, argb(255, 10, 10, 20));
+            fill_ellipse(img, 3, 1, 10, 7, argb(255, 10, 10, 20));
+            return img;
+        }
+        case SpriteId::Shaft: {
+            Image img(16, 16, argb(255, 40, 30, 30));
+            fill_rect(img, 2, 0, 2, 16, argb(255, 100, 100, 100));
+            fill_rect(img, 12, 0, 2, 16, argb(255, 100, 100, 100));
+            return img;
+        }
+        case SpriteId::Spike: {
+            Image img = ledge(argb(255, 200, 200, 200), argb(255, 130, 130, 140));
+            for (int x = 0; x < 16; x += 4) {
+                for (int h = 0; h < 4; ++h) fill_rect(img, x + h / 2, 9 - h * 2, 4 - h, 2, argb(255, 230, 230, 240));
+            }
+            return img;
+        }
+        case SpriteId::Exit: {
+            Image img = bricks(argb(255, 150, 60, 40), argb(255, 90, 40, 30));
+            fill_rect(img, 3, 3, 10, 13, argb(255, 255, 220, 60));
+            return img;
+        }
+        case SpriteId::PlayerStand:
+        case SpriteId::PlayerJump:
+        case SpriteId::PlayerHurt: {
+            uint32_t body = id == SpriteId::PlayerHurt ? argb(255, 240, 80, 80) : argb(255, 60, 200, 60);
+            Image img(16, 24, kClear);
+            fill_ellipse(img, 1, 2, 14, 16, body);
+            fill_ellipse(img, 4, 6, 3, 4, argb(255, 255, 255, 255));
+            fill_ellipse(img, 9, 6, 3, 4, argb(255, 255, 255, 255));
+            int foot = id == SpriteId::PlayerJump ? 17 : 18;
+            fill_rect(img, 2, foot, 5, 6, body);
+            fill_rect(img, 9, foot, 5, 6, body);
+            return img;
+        }
+        case SpriteId::Ball: {
+            Image img(12, 12, kClear);
+            fill_ellipse(img, 0, 0, 12, 12, argb(255, 230, 60, 200));
+            fill_ellipse(img, 3, 2, 3, 3, argb(255, 255, 200, 255));
+            return img;
+        }
+        case SpriteId::Eye: {
+            Image img(14, 10, kClear);
+            fill_ellipse(img, 0, 0, 14, 10, argb(255, 250, 250, 250));
+            fill_ellipse(img, 5, 3, 4, 4, argb(255, 30, 60, 200));
+            return img;
+        }
+        case SpriteId::Bouncer: {
+            Image img(12, 16, kClear);
+            fill_rect(img, 1, 2, 10, 12, argb(255, 240, 160, 30));
+            fill_rect(img, 3, 5, 2, 2, argb(255, 0, 0, 0));
+            fill_rect(img, 7, 5, 2, 2, argb(255, 0, 0, 0));
+            return img;
+        }
+        case SpriteId::Shot: {
+            Image img(6, 6, kClear);
+            fill_ellipse(img, 0, 0, 6, 6, argb(255, 255, 255, 255));
+            return img;
+        }
+        case SpriteId::ElevatorCar: {
+            Image img(24, 6, argb(255, 170, 170, 180));
+            fill_rect(img, 0, 0, 24, 1, argb(255, 230, 230, 240));
+            return img;
+        }
+        case SpriteId::Water: {
+            Image img(32, 8, argb(255, 20, 40, 140));
+            for (int x = 0; x < 32; ++x) img.at(x, (x / 4) % 2) = argb(255, 90, 130, 230);
+            return img;
+        }
+        case SpriteId::Star:
+            return Image(2, 2, argb(255, 255, 255, 220));
+        case SpriteId::Submarine: {
+            Image img(32, 16, kClear);
+            fill_ellipse(img, 0, 4, 32, 12, argb(255, 240, 220, 40));
+            fill_rect(img, 12, 0, 6, 6, argb(255, 240, 220, 40));
+            fill_ellipse(img, 22, 7, 4, 4, argb(255, 60, 160, 230));
+            return img;
+        }
+        case SpriteId::Fish: {
+            Image img(16, 8, kClear);
+            fill_ellipse(img, 0, 0, 12, 8, argb(255, 250, 130, 40));
+            for (int y = 0; y < 8; ++y) fill_rect(img, 11, y, 1 + std::abs(y - 4) / 1, 1, argb(255, 250, 130, 40));
+            return img;
+        }
+        case SpriteId::Torpedo: {
+            Image img(8, 3, argb(255, 220, 220, 220));
+            img.at(7, 0) = img.at(7, 2) = kClear;
+            return img;
+        }
+        case SpriteId::Digit0:
+        case SpriteId::Digit1:
+        case SpriteId::Digit2:
+        case SpriteId::Digit3:
+        case SpriteId::Digit4:
+        case SpriteId::Digit5:
+        case SpriteId::Digit6:
+        case SpriteId::Digit7:
+        case SpriteId::Digit8:
+        case SpriteId::Digit9:
+            return digit(static_cast<int>(id) - static_cast<int>(SpriteId::Digit0));
+        case SpriteId::ZoneBar0:
+        case SpriteId::ZoneBar1:
+        case SpriteId::ZoneBar2:
+        case SpriteId::ZoneBar3:
+        case SpriteId::ZoneBar4:
+        case SpriteId::ZoneBar5:
+        case SpriteId::ZoneBar6:
+        case SpriteId::ZoneBar7:
+            return Image(4, 4, kZoneColours[static_cast<int>(id) - static_cast<int>(SpriteId::ZoneBar0)]);
+        case SpriteId::OverlayPanel:
+            return Image(4, 4, argb(255, 14, 14, 22));
+        default:
+            return Image(1, 1, argb(255, 255, 0, 255));
+    }
+}
+
+}  // namespace toppler
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "render/draw_list.h"
+#include "render/image.h"
+
+namespace toppler {
+
+// Built-in pixel art for every sprite, generated in code so headless builds
+// need no asset files.
+Image make_sprite_image(SpriteId id);
+
+}  // namespace toppler
@@ -0,0 +1,43 @@
+#include "render/sprite_batch.h"
+
+#include <algorithm>
+#include <array>
+
+namespace toppler {
+
+FrameStats SpriteBatcher::submit(const DrawList& list, const SpriteAtlas& atlas, RenderBackend& backend,
+                                 const DrawBatch* prebuilt, size_t prebuilt_count) {
+    constexpr size_t kLayers = static_cast<size_t>(Layer::kCount);
+    const std::vector<Quad>& quads = list.quads();
+
+    std::array<uint32_t, kLayers + 1> start{};
+    for (const Quad& q : quads) ++start[static_cast<size_t>(q.layer) + 1];
+    for (size_t l = 1; l <= kLayers; ++l) start[l] += start[l - 1];
+
+    sorted_.resize(quads.size());
+    std::array<uint32_t, kLayers> cursor{};
+    std::copy_n(start.begin(), kLayers, cursor.begin());
+    for (const Quad& q : quads) {
+        sorted_[cursor[static_cast<size_t>(q.layer)]++] =
+            BatchQuad{q.x, q.y, q.w, q.h, atlas.rect(q.sprite), q.shade};
+    }
+
+    FrameStats stats;
+    stats.quads = static_cast<uint32_t>(quads.size());
+    for (size_t l = 0; l < kLayers; ++l) {
+        for (size_t i = 0; i < prebuilt_count; ++i) {
+            if (prebuilt[i].layer != static_cast<Layer>(l) || prebuilt[i].count == 0) continue;
+            backend.draw(prebuilt[i]);
+            ++stats.draw_calls;
+            stats.quads += prebuilt[i].count;
+        }
+        for (uint32_t begin = start[l]; begin < start[l + 1]; begin += kMaxQuadsPerBatch) {
+            uint32_t count = std::min(kMaxQuadsPerBatch, start[l + 1] - begin);
+            backend.draw(DrawBatch{static_cast<Layer>(l), SpriteAtlas::kTexture, sorted_.data() + begin, count});
+            ++stats.draw_calls;
+        }
+    }
+    return stats;
+}
+
+}  // namespace toppler
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "render/atlas.h"
+#include "render/draw_list.h"
+#include "render/render_backend.h"
+
+namespace toppler {
+
+// Turns a frame's DrawList into as few draw calls as possible: quads are
+// bucketed by layer (stable, so painter's order within a layer is kept),
+// resolved against the single atlas texture and handed to the backend one
+// layer at a time.
+class SpriteBatcher {
+public:
+    // Cap on quads per draw call, e.g. the size of a backend vertex buffer.
+    static constexpr uint32_t kMaxQuadsPerBatch = 8192;
+
+    // `prebuilt` batches (cached layers with their own textures) are drawn
+    // first within their layer, under that layer's sprites.
+    FrameStats submit(const DrawList& list, const SpriteAtlas& atlas, RenderBackend& backend,
+                      const DrawBatch* prebuilt = nullptr, size_t prebuilt_count = 0);
+
+private:
+    std::vector<BatchQuad> sorted_;  // reused between frames
+};
+
+}  // namespace toppler
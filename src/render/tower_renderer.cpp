@@ -0,0 +1,52 @@
+#include "render/tower_renderer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "tower/tile_behavior.h"
+
+namespace toppler {
+
+namespace {
+
+constexpr std::array<SpriteId, static_cast<size_t>(Tile::kCount)> kTileSprites = {
+    SpriteId::TowerFace, SpriteId::Ledge, SpriteId::Crumble, SpriteId::Slippery, SpriteId::Wall,
+    SpriteId::Door,      SpriteId::Shaft, SpriteId::Spike,   SpriteId::Exit,
+};
+
+}  // namespace
+
+SpriteId tile_sprite(Tile tile) { return kTileSprites[static_cast<size_t>(tile)]; }
+
+TowerRenderer::TowerRenderer(const ScreenLayout& screen) : screen_(screen), projection_(screen.tower) {}
+
+float TowerRenderer::camera_height(const SimState& state) const { return state.player.height + 1.0f; }
+
+int TowerRenderer::height_to_y(float h, float camera) const {
+    float y = static_cast<float>(screen_.height / 2) - (h + 1.0f - camera) * static_cast<float>(screen_.row_height);
+    return static_cast<int>(std::floor(y));
+}
+
+void TowerRenderer::draw(const Level& level, const SimState& state, DrawList& out) const {
+    const ProjectedRing& ring = projection_.ring(state.session.tower_angle);
+    float camera = camera_height(state);
+    int half_rows = screen_.height / (2 * screen_.row_height) + 1;
+    int first = std::max(0, static_cast<int>(std::floor(camera)) - half_rows);
+    int last = std::min(level.grid.rows - 1, static_cast<int>(std::ceil(camera)) + half_rows);
+    int16_t row_h = static_cast<int16_t>(screen_.row_height);
+
+    for (int row = first; row <= last; ++row) {
+        const Tile* tiles = level.grid.row_data(row);
+        uint16_t broken = state.broken.rows[row];
+        int16_t y = static_cast<int16_t>(height_to_y(static_cast<float>(row), camera));
+        for (int i = 0; i < ring.count; ++i) {
+            const ColumnSpan& span = ring.spans[i];
+            Tile tile = tiles[span.column];
+            if ((tile_flags(tile) & kTileCrumbles) && ((broken >> span.column) & 1u)) tile = Tile::Empty;
+            out.push(Quad{span.x, y, span.width, row_h, tile_sprite(tile), Layer::Tower, span.shade});
+        }
+    }
+}
+
+}  // namespace toppler
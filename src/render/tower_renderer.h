@@ -0,0 +1,42 @@
+#pragma once
+
+#include "render/draw_list.h"
+#include "render/projection.h"
+#include "sim/sim_state.h"
+#include "tower/level.h"
+
+namespace toppler {
+
+struct ScreenLayout {
+    int width = 320;
+    int height = 200;
+    int row_height = 16;  // pixels per tower row
+    TowerLayout tower;
+};
+
+// Turns the tower around the player into quads: only the front half of the
+// cylinder and only the rows on screen, with column placement read from the
+// precomputed projection.
+class TowerRenderer {
+public:
+    explicit TowerRenderer(const ScreenLayout& screen = {});
+
+    const ScreenLayout& screen() const { return screen_; }
+    const TowerProjection& projection() const { return projection_; }
+
+    // Vertical camera position (in rows) for a frame of `state`.
+    float camera_height(const SimState& state) const;
+
+    // Screen y of the top of the band between heights h and h + 1.
+    int height_to_y(float h, float camera) const;
+
+    void draw(const Level& level, const SimState& state, DrawList& out) const;
+
+private:
+    ScreenLayout screen_;
+    TowerProjection projection_;
+};
+
+SpriteId tile_sprite(Tile tile);
+
+}  // namespace toppler
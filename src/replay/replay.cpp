@@ -0,0 +1,401 @@
+#include "replay/replay.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "sim/game_sim.h"
+#include "sim/state_hash.h"
+
+namespace toppler {
+
+namespace {
+
+constexpr size_t kStateSize = sizeof(SimState);
+
+void put_varint(std::vector<uint8_t>& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+    uint8_t b[4];
+    std::memcpy(b, &v, 4);
+    out.insert(out.end(), b, b + 4);
+}
+
+// Bounds-checked reader over the encoded bytes.
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+
+    size_t left() const { return static_cast<size_t>(end_ - p_); }
+    const uint8_t* pos() const { return p_; }
+
+    uint8_t byte() {
+        need(1);
+        return *p_++;
+    }
+    uint32_t u32() {
+        need(4);
+        uint32_t v;
+        std::memcpy(&v, p_, 4);
+        p_ += 4;
+        return v;
+    }
+    uint32_t varint() {
+        uint32_t v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t b = byte();
+            v |= static_cast<uint32_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        throw ReplayError("replay: bad varint");
+    }
+    void skip(size_t n) {
+        need(n);
+        p_ += n;
+    }
+
+private:
+    void need(size_t n) const {
+        if (left() < n) throw ReplayError("replay: truncated");
+    }
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+};
+
+void encode_inputs(std::vector<uint8_t>& out, const std::vector<InputRun>& runs) {
+    for (const InputRun& r : runs) {
+        uint8_t mask = r.mask & kInputAll;
+        if (r.ticks == 0) continue;  // nothing to play, and a bare mask byte means a long run
+        if (r.ticks <= 3) {
+            out.push_back(static_cast<uint8_t>(mask | (r.ticks << 6)));
+        } else {
+            out.push_back(mask);
+            put_varint(out, r.ticks - 4);
+        }
+    }
+}
+
+// Zero-run coding of a state XORed with its predecessor. Keyframes of one
+// run differ in a few hundred bytes at most, so this shrinks them ~20x.
+void encode_state(std::vector<uint8_t>& out, const SimState& state, const SimState* prev) {
+    uint8_t delta[kStateSize];
+    std::memcpy(delta, &state, kStateSize);
+    if (prev) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(prev);
+        for (size_t i = 0; i < kStateSize; ++i) delta[i] ^= p[i];
+    }
+    size_t i = 0;
+    while (i < kStateSize) {
+        size_t zeros = 0;
+        while (i + zeros < kStateSize && delta[i + zeros] == 0) ++zeros;
+        size_t lit = 0;
+        // A literal run ends at the next stretch of 3+ zeros.
+        size_t j = i + zeros;
+        while (j + lit < kStateSize) {
+            if (delta[j + lit] == 0 && j + lit + 2 < kStateSize && delta[j + lit + 1] == 0 &&
+                delta[j + lit + 2] == 0) {
+                break;
+            }
+            ++lit;
+        }
+        put_varint(out, static_cast<uint32_t>(zeros));
+        put_varint(out, static_cast<uint32_t>(lit));
+        out.insert(out.end(), delta + j, delta + j + lit);
+        i = j + lit;
+    }
+}
+
+void decode_state(Reader& in, SimState& state, const SimState* prev) {
+    uint8_t* out = reinterpret_cast<uint8_t*>(&state);
+    size_t i = 0;
+    while (i < kStateSize) {
+        uint32_t zeros = in.varint();
+        uint32_t lit = in.varint();
+        if (zeros > kStateSize - i || lit > kStateSize - i - zeros) throw ReplayError("replay: bad keyframe");
+        std::memset(out + i, 0, zeros);
+        i += zeros;
+        const uint8_t* src = in.pos();
+        in.skip(lit);
+        std::memcpy(out + i, src, lit);
+        i += lit;
+    }
+    if (prev) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(prev);
+        for (size_t k = 0; k < kStateSize; ++k) out[k] ^= p[k];
+    }
+}
+
+}  // namespace
+
+uint32_t Replay::input_ticks() const {
+    uint32_t n = 0;
+    for (const InputRun& r : inputs) n += r.ticks;
+    return n;
+}
+
+uint32_t checkpoint_hash(const SimState& state) { return static_cast<uint32_t>(state_hash(state)); }
+uint32_t checkpoint_hash(const SubState& state) { return static_cast<uint32_t>(sub_state_hash(state)); }
+
+ReplayRecorder::ReplayRecorder(const Level& level, uint32_t seed, uint32_t keyframe_interval,
+                               uint32_t checkpoint_interval) {
+    replay_.tower_id = level_fingerprint(level);
+    replay_.seed = seed;
+    replay_.keyframe_interval = keyframe_interval;
+    replay_.checkpoint_interval = checkpoint_interval;
+}
+
+ReplayRecorder::ReplayRecorder(const SubStage& stage, uint32_t seed, uint32_t checkpoint_interval) {
+    replay_.tower_id = sub_stage_fingerprint(stage);
+    replay_.seed = seed;
+    replay_.checkpoint_interval = checkpoint_interval;
+}
+
+bool ReplayRecorder::add_input(InputMask input, uint32_t tick) {
+    input &= kInputAll;
+    if (!replay_.inputs.empty() && replay_.inputs.back().mask == input &&
+        replay_.inputs.back().ticks < UINT32_MAX) {
+        ++replay_.inputs.back().ticks;
+    } else {
+        replay_.inputs.push_back(InputRun{input, 1});
+    }
+    return replay_.checkpoint_interval && tick % replay_.checkpoint_interval == 0;
+}
+
+void ReplayRecorder::record(InputMask input, const SimState& after) {
+    uint32_t tick = after.session.tick;
+    if (add_input(input, tick)) replay_.checkpoints.push_back(checkpoint_hash(after));
+    if (replay_.keyframe_interval && tick % replay_.keyframe_interval == 0) {
+        replay_.keyframes.push_back(Keyframe{tick, after});
+    }
+}
+
+void ReplayRecorder::record(InputMask input, const SubState& after) {
+    if (add_input(input, after.session.tick)) replay_.checkpoints.push_back(checkpoint_hash(after));
+}
+
+Replay ReplayRecorder::finish(const SimState& final_state) {
+    replay_.result.ticks = final_state.session.tick;
+    replay_.result.score = final_state.session.score;
+    replay_.result.status = final_state.session.status;
+    return std::move(replay_);
+}
+
+Replay ReplayRecorder::finish(const SubState& final_state) {
+    replay_.result.ticks = final_state.session.tick;
+    replay_.result.score = final_state.session.score;
+    replay_.result.status = final_state.session.status;
+    return std::move(replay_);
+}
+
+std::vector<uint8_t> encode_replay(const Replay& replay) {
+    ReplayFileHeader h;
+    std::memset(&h, 0, sizeof h);
+    h.magic = kReplayMagic;
+    h.version = kReplayVersion;
+    h.header_size = sizeof h;
+    h.sim_version = replay.sim_version;
+    h.state_size = kStateSize;
+    h.tower_id = replay.tower_id;
+    h.seed = replay.seed;
+    h.result_ticks = replay.result.ticks;
+    h.result_score = replay.result.score;
+    h.result_status = static_cast<uint8_t>(replay.result.status);
+    h.keyframe_interval = replay.keyframe_interval;
+    h.run_count = static_cast<uint32_t>(replay.inputs.size());
+    h.keyframe_count = static_cast<uint32_t>(replay.keyframes.size());
+    h.checkpoint_interval = replay.checkpoint_interval;
+    h.checkpoint_count = static_cast<uint32_t>(replay.checkpoints.size());
+
+    std::vector<uint8_t> out(sizeof h);
+    encode_inputs(out, replay.inputs);
+    h.input_bytes = static_cast<uint32_t>(out.size() - sizeof h);
+    std::memcpy(out.data(), &h, sizeof h);
+    for (uint32_t c : replay.checkpoints) put_u32(out, c);
+    std::vector<uint8_t> frame;
+    const SimState* prev = nullptr;
+    for (const Keyframe& k : replay.keyframes) {
+        frame.clear();
+        encode_state(frame, k.state, prev);
+        put_u32(out, k.tick);
+        put_u32(out, static_cast<uint32_t>(frame.size()));
+        out.insert(out.end(), frame.begin(), frame.end());
+        prev = &k.state;
+    }
+    return out;
+}
+
+Replay decode_replay(const uint8_t* data, size_t size) {
+    // v1 headers are a prefix of the current one; the missing fields read as 0.
+    ReplayFileHeader h;
+    std::memset(&h, 0, sizeof h);
+    if (size < kReplayHeaderV1Size) throw ReplayError("replay: too short");
+    std::memcpy(&h, data, kReplayHeaderV1Size);
+    if (h.magic != kReplayMagic) throw ReplayError("replay: bad magic");
+    size_t header_size = h.version == 1 ? kReplayHeaderV1Size : sizeof h;
+    if (h.version < 1 || h.version > kReplayVersion || h.header_size != header_size) {
+        throw ReplayError("replay: unsupported version");
+    }
+    if (size < header_size) throw ReplayError("replay: too short");
+    std::memcpy(&h, data, header_size);
+    if (h.result_status > static_cast<uint8_t>(SimStatus::GameOver)) throw ReplayError("replay: bad status");
+
+    Replay r;
+    r.tower_id = h.tower_id;
+    r.seed = h.seed;
+    r.sim_version = h.sim_version;
+    r.result.ticks = h.result_ticks;
+    r.result.score = h.result_score;
+    r.result.status = static_cast<SimStatus>(h.result_status);
+    r.keyframe_interval = h.keyframe_interval;
+    r.checkpoint_interval = h.checkpoint_interval;
+
+    Reader in(data + header_size, size - header_size);
+    if (h.input_bytes > in.left() || h.run_count > h.input_bytes) throw ReplayError("replay: truncated");
+    Reader runs(in.pos(), h.input_bytes);
+    in.skip(h.input_bytes);
+    r.inputs.reserve(h.run_count);
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < h.run_count; ++i) {
+        uint8_t b = runs.byte();
+        uint32_t ticks = b >> 6;
+        if (ticks == 0) {
+            uint32_t extra = runs.varint();
+            if (extra > UINT32_MAX - 4) throw ReplayError("replay: run too long");
+            ticks = extra + 4;
+        }
+        total += ticks;
+        r.inputs.push_back(InputRun{static_cast<InputMask>(b & kInputAll), ticks});
+    }
+    if (runs.left() != 0) throw ReplayError("replay: trailing input bytes");
+    if (total > UINT32_MAX) throw ReplayError("replay: too many ticks");
+
+    if (h.checkpoint_count > in.left() / 4) throw ReplayError("replay: truncated");
+    r.checkpoints.resize(h.checkpoint_count);
+    for (uint32_t& c : r.checkpoints) c = in.u32();
+
+    if (h.state_size != kStateSize) {
+        r.keyframe_interval = 0;  // from a build with another SimState layout
+        return r;
+    }
+    // Each keyframe is at least its tick and byte count on disk.
+    if (h.keyframe_count > in.left() / 8) throw ReplayError("replay: truncated");
+    r.keyframes.resize(h.keyframe_count);
+    for (uint32_t i = 0; i < h.keyframe_count; ++i) {
+        Keyframe& k = r.keyframes[i];
+        k.tick = in.u32();
+        if (i > 0 && k.tick <= r.keyframes[i - 1].tick) throw ReplayError("replay: keyframes out of order");
+        uint32_t bytes = in.u32();
+        if (bytes > in.left()) throw ReplayError("replay: truncated");
+        Reader frame(in.pos(), bytes);
+        in.skip(bytes);
+        decode_state(frame, k.state, i > 0 ? &r.keyframes[i - 1].state : nullptr);
+        if (frame.left() != 0 || !sim_state_in_bounds(k.state, nullptr)) {
+            throw ReplayError("replay: bad keyframe");
+        }
+    }
+    if (in.left() != 0) throw ReplayError("replay: trailing bytes");
+    return r;
+}
+
+void write_replay(const std::string& path, const Replay& replay) {
+    std::vector<uint8_t> bytes = encode_replay(replay);
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) throw std::runtime_error(path + ": cannot create");
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) throw std::runtime_error(path + ": write failed");
+}
+
+Replay read_replay(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw ReplayError(path + ": cannot open");
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    try {
+        return decode_replay(bytes.data(), bytes.size());
+    } catch (const ReplayError& e) {
+        throw ReplayError(path + ": " + e.what());
+    }
+}
+
+void add_keyframes(const Level& level, Replay& replay, uint32_t interval) {
+    replay.keyframes.clear();
+    replay.keyframe_interval = interval;
+    if (interval == 0) return;
+    SimState state;
+    sim_init(level, replay.seed, state);
+    uint32_t tick = 0;
+    for (const InputRun& run : replay.inputs) {
+        for (uint32_t i = 0; i < run.ticks; ++i) {
+            sim_step(level, state, run.mask);
+            if (++tick % interval == 0) replay.keyframes.push_back(Keyframe{tick, state});
+        }
+    }
+}
+
+ReplayPlayer::ReplayPlayer(const Level& level, const Replay& replay)
+    : level_(level), replay_(replay), end_(replay.input_ticks()) {
+    if (replay.tower_id != level_fingerprint(level)) throw ReplayError("replay: recorded on a different tower");
+    if (replay.sim_version != kSimVersion) throw ReplayError("replay: recorded with another sim version");
+    // seek() restores keyframes as they are; decode_replay() only knew the
+    // capacities, this tower's own counts are tighter.
+    for (const Keyframe& k : replay.keyframes) {
+        if (!sim_state_in_bounds(k.state, &level)) {
+            throw ReplayError("replay: bad keyframe");
+        }
+    }
+    restart(0, nullptr);
+}
+
+void ReplayPlayer::restart(uint32_t tick, const SimState* from) {
+    if (from) {
+        state_ = *from;
+    } else {
+        sim_init(level_, replay_.seed, state_);
+    }
+    tick_ = tick;
+    // Walk the run cursor to `tick`.
+    run_ = 0;
+    run_used_ = 0;
+    uint32_t left = tick;
+    while (run_ < replay_.inputs.size() && left >= replay_.inputs[run_].ticks) {
+        left -= replay_.inputs[run_].ticks;
+        ++run_;
+    }
+    run_used_ = left;
+}
+
+void ReplayPlayer::seek(uint32_t tick) {
+    tick = std::min(tick, end_);
+    if (tick < tick_) restart(0, nullptr);
+    // Latest keyframe at or before the target, if it beats where we are.
+    auto it = std::upper_bound(replay_.keyframes.begin(), replay_.keyframes.end(), tick,
+                               [](uint32_t t, const Keyframe& k) { return t < k.tick; });
+    if (it != replay_.keyframes.begin()) {
+        const Keyframe& k = *std::prev(it);
+        if (k.tick > tick_ && k.tick <= end_) restart(k.tick, &k.state);
+    }
+    while (tick_ < tick) step();
+}
+
+bool ReplayPlayer::step() {
+    if (at_end()) return false;
+    const InputRun& run = replay_.inputs[run_];
+    sim_step(level_, state_, run.mask);
+    ++tick_;
+    if (++run_used_ == run.ticks) {
+        ++run_;
+        run_used_ = 0;
+    }
+    return true;
+}
+
+}  // namespace toppler
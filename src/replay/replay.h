@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sim/input.h"
+#include "sim/sim_state.h"
+#include "sim/sub_stage.h"
+#include "tower/level.h"
+
+namespace toppler {
+
+// Input-only replays. A run is fully determined by (tower, seed, inputs), so
+// that is all a replay stores: a small header, then the per-tick input masks
+// run-length encoded. Checkpoints (a 32-bit state hash every N ticks) let a
+// verifier pin down the tick a re-simulation diverged at; optional keyframes
+// (full SimState snapshots every K ticks) let playback seek without
+// simulating from tick 0.
+//
+// Submarine stage runs use the same format: tower_id is then the
+// sub_stage_fingerprint of the stage, checkpoints hash the SubState, and
+// there are no keyframes.
+//
+// File layout (.ttr, little-endian):
+//   ReplayFileHeader
+//   input stream: per run one byte, mask in the low 6 bits and the run
+//                 length 1..3 in the top 2; top bits 0 means a varint with
+//                 length - 4 follows
+//   checkpoints:  u32 per checkpoint (v2)
+//   keyframes:    u32 tick, u32 byte count, then the state XORed with the
+//                 previous keyframe (the first with zeros) and coded as
+//                 repeated (varint zero count, varint literal count, literals)
+
+constexpr uint32_t kReplayMagic = 0x50525454;  // "TTRP"
+constexpr uint16_t kReplayVersion = 2;  // v2 added checkpoints; v1 still reads
+constexpr uint32_t kDefaultCheckpointInterval = kTicksPerSecond;
+
+class ReplayError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+struct ReplayFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t sim_version;
+    uint32_t state_size;  // sizeof(SimState) of the build that wrote keyframes
+    uint64_t tower_id;
+    uint32_t seed;
+    uint32_t result_ticks;
+    uint32_t result_score;
+    uint8_t result_status;
+    uint8_t reserved[3];
+    uint32_t keyframe_interval;
+    uint32_t run_count;
+    uint32_t keyframe_count;
+    uint32_t input_bytes;
+    uint32_t checkpoint_interval;  // v2 and later
+    uint32_t checkpoint_count;
+};
+constexpr size_t kReplayHeaderV1Size = 56;
+static_assert(sizeof(ReplayFileHeader) == 64, "ReplayFileHeader layout is part of the format");
+
+// `ticks` consecutive ticks with the same input.
+struct InputRun {
+    InputMask mask = 0;
+    uint32_t ticks = 0;
+};
+
+// Sim state after `tick` steps from sim_init.
+struct Keyframe {
+    uint32_t tick = 0;
+    SimState state;
+};
+
+// The outcome the recording client claims.
+struct ReplayResult {
+    uint32_t ticks = 0;
+    uint32_t score = 0;
+    SimStatus status = SimStatus::Playing;
+};
+
+struct Replay {
+    uint64_t tower_id = 0;  // level_fingerprint of the tower played
+    uint32_t seed = 0;
+    uint32_t sim_version = kSimVersion;
+    ReplayResult result;
+    uint32_t keyframe_interval = 0;  // 0 = no keyframes
+    uint32_t checkpoint_interval = 0;  // 0 = no checkpoints
+    std::vector<InputRun> inputs;
+    // checkpoints[i] = checkpoint_hash of the state after
+    // (i + 1) * checkpoint_interval ticks.
+    std::vector<uint32_t> checkpoints;
+    std::vector<Keyframe> keyframes;  // ascending tick
+
+    uint32_t input_ticks() const;
+};
+
+// Builds a replay alongside a live session:
+//
+//   ReplayRecorder rec(level, seed, 600);
+//   sim_init(level, seed, state);
+//   for each tick: sim_step(level, state, input); rec.record(input, state);
+//   Replay r = rec.finish(state);
+//
+// and likewise with a SubStage, sub_init / sub_step and SubState.
+class ReplayRecorder {
+public:
+    ReplayRecorder(const Level& level, uint32_t seed, uint32_t keyframe_interval = 0,
+                   uint32_t checkpoint_interval = kDefaultCheckpointInterval);
+    ReplayRecorder(const SubStage& stage, uint32_t seed, uint32_t checkpoint_interval = kDefaultCheckpointInterval);
+
+    // Once per sim_step, with the input used and the state after the step.
+    void record(InputMask input, const SimState& after);
+    void record(InputMask input, const SubState& after);
+    Replay finish(const SimState& final_state);
+    Replay finish(const SubState& final_state);
+
+private:
+    // Returns whether `tick` is due a checkpoint, adding `input` to the runs.
+    bool add_input(InputMask input, uint32_t tick);
+
+    Replay replay_;
+};
+
+// What a checkpoint stores for a state.
+uint32_t checkpoint_hash(const SimState& state);
+uint32_t checkpoint_hash(const SubState& state);
+
+std::vector<uint8_t> encode_replay(const Replay& replay);
+// Throws ReplayError on malformed data. Keyframes written by a build with a
+// different SimState layout are dropped; the inputs still decode.
+Replay decode_replay(const uint8_t* data, size_t size);
+
+void write_replay(const std::string& path, const Replay& replay);
+Replay read_replay(const std::string& path);
+
+// Re-simulates the inputs and stores a keyframe every `interval` ticks, e.g.
+// to make a storage-only replay seekable. interval == 0 removes them.
+void add_keyframes(const Level& level, Replay& replay, uint32_t interval);
+
+// Plays a replay back against its tower.
+class ReplayPlayer {
+public:
+    // Throws ReplayError if `level` is not the tower it was recorded on, the
+    // replay was made by a different sim version, or a keyframe is not a
+    // state this tower can be in.
+    ReplayPlayer(const Level& level, const Replay& replay);
+
+    // Puts the sim at `tick` (clamped to the end of the inputs), restoring
+    // the nearest keyframe at or before it and simulating the rest.
+    void seek(uint32_t tick);
+
+    // Steps one recorded tick; false once the inputs are exhausted.
+    bool step();
+
+    uint32_t tick() const { return tick_; }
+    uint32_t end_tick() const { return end_; }
+    bool at_end() const { return tick_ >= end_; }
+    const SimState& state() const { return state_; }
+
+private:
+    void restart(uint32_t tick, const SimState* from);
+
+    Level level_;
+    const Replay& replay_;  // must outlive the player
+    SimState state_;
+    uint32_t tick_ = 0;
+    uint32_t end_ = 0;
+    size_t run_ = 0;         // cursor into replay_.inputs
+    uint32_t run_used_ = 0;  // ticks of that run already played
+};
+
+}  // namespace toppler
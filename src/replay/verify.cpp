@@ -0,0 +1,94 @@
+#include "replay/verify.h"
+
+#include <cstring>
+
+#include "sim/game_sim.h"
+
+namespace toppler {
+
+const char* verdict_status_name(VerdictStatus status) {
+    switch (status) {
+        case VerdictStatus::Ok:
+            return "ok";
+        case VerdictStatus::Desync:
+            return "desync";
+        case VerdictStatus::ResultMismatch:
+            return "result_mismatch";
+    }
+    return "?";
+}
+
+namespace {
+
+// Plays the inputs through `step`, checking checkpoints (and, via
+// `keyframe_ok`, keyframes) as it goes. Stepping stops when the session
+// ends: the time limit bounds the work however many ticks the file claims,
+// and input recorded past the end cannot belong to an honest run.
+template <class State, class Step, class KeyframeOk>
+Verdict verify_inputs(const Replay& replay, State& state, Step step, KeyframeOk keyframe_ok) {
+    Verdict v;
+    size_t checkpoint = 0, keyframe = 0;
+    uint32_t tick = 0;
+    auto diverged = [&] {
+        v.status = VerdictStatus::Desync;
+        v.desync_tick = tick;
+    };
+    bool overrun = false;
+    for (const InputRun& run : replay.inputs) {
+        for (uint32_t i = 0; i < run.ticks; ++i) {
+            if (state.session.status != SimStatus::Playing) {
+                overrun = true;
+                break;
+            }
+            step(state, run.mask);
+            ++tick;
+            if (v.completion_tick < 0 && state.session.status == SimStatus::Complete) v.completion_tick = tick;
+
+            if (replay.checkpoint_interval && tick % replay.checkpoint_interval == 0 &&
+                checkpoint < replay.checkpoints.size()) {
+                if (replay.checkpoints[checkpoint++] != checkpoint_hash(state)) diverged();
+            }
+            if (keyframe < replay.keyframes.size() && replay.keyframes[keyframe].tick == tick) {
+                if (!keyframe_ok(replay.keyframes[keyframe++], state)) diverged();
+            }
+            if (v.status == VerdictStatus::Desync) break;
+        }
+        if (v.status == VerdictStatus::Desync || overrun) break;
+    }
+    v.ticks = tick;
+    v.score = state.session.score;
+    v.outcome = state.session.status;
+    if (v.status == VerdictStatus::Ok &&
+        (overrun || replay.result.ticks != tick || replay.result.score != v.score || replay.result.status != v.outcome)) {
+        v.status = VerdictStatus::ResultMismatch;
+        v.desync_tick = tick;
+    }
+    return v;
+}
+
+}  // namespace
+
+Verdict verify_replay(const Level& level, const Replay& replay) {
+    if (replay.tower_id != level_fingerprint(level)) throw ReplayError("replay: recorded on a different tower");
+    if (replay.sim_version != kSimVersion) throw ReplayError("replay: recorded with another sim version");
+
+    SimState state;
+    sim_init(level, replay.seed, state);
+    return verify_inputs(
+        replay, state, [&level](SimState& s, InputMask input) { sim_step(level, s, input); },
+        [](const Keyframe& k, const SimState& s) { return std::memcmp(&k.state, &s, sizeof s) == 0; });
+}
+
+Verdict verify_replay(const SubStage& stage, const Replay& replay) {
+    if (replay.tower_id != sub_stage_fingerprint(stage)) throw ReplayError("replay: recorded on a different stage");
+    if (replay.sim_version != kSimVersion) throw ReplayError("replay: recorded with another sim version");
+    if (!replay.keyframes.empty()) throw ReplayError("replay: submarine stage replays carry no keyframes");
+
+    SubState state;
+    sub_init(stage, replay.seed, state);
+    return verify_inputs(
+        replay, state, [&stage](SubState& s, InputMask input) { sub_step(stage, s, input); },
+        [](const Keyframe&, const SubState&) { return true; });
+}
+
+}  // namespace toppler
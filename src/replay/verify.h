@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "replay/replay.h"
+
+namespace toppler {
+
+// Server-side check of a submitted replay: re-simulate its inputs with the
+// headless core and compare against what the client recorded.
+
+enum class VerdictStatus : uint8_t {
+    Ok = 0,
+    Desync,          // a checkpoint or keyframe did not match
+    ResultMismatch,  // every checkpoint matched but the claimed result did not, or input ran past the end
+};
+
+struct Verdict {
+    VerdictStatus status = VerdictStatus::Ok;
+    SimStatus outcome = SimStatus::Playing;  // as re-simulated
+    uint32_t score = 0;                      // as re-simulated
+    uint32_t ticks = 0;                      // inputs played
+    int64_t completion_tick = -1;            // tick the exit was reached, if it was
+    int64_t desync_tick = -1;                // first tick found to differ
+};
+
+const char* verdict_status_name(VerdictStatus status);
+
+// `level` must be the replay's tower (level_fingerprint(level) ==
+// replay.tower_id) and the sim versions must agree; otherwise throws
+// ReplayError. Stops at the first desync.
+Verdict verify_replay(const Level& level, const Replay& replay);
+// Same for a submarine stage run; `stage` must be the one it names.
+Verdict verify_replay(const SubStage& stage, const Replay& replay);
+
+}  // namespace toppler
@@ -0,0 +1,282 @@
+#include "sim/enemy_kernel.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define TT_KERNEL_X86 1
+#endif
+
+namespace toppler {
+
+namespace {
+
+constexpr float kColumns = static_cast<float>(kTowerColumns);
+
+// ---------------------------------------------------------------- scalar ---
+// The reference definition; the vector paths mirror it operation for
+// operation, including the select-based wrap (an add of 0.0f would turn -0
+// into +0 and break bitwise equality).
+
+inline void update_lane(const EnemyArrays& e, size_t i) {
+    if (!e.alive[i]) return;
+    float a = e.angle[i] + e.vangle[i];
+    a = a < 0.0f ? a + kColumns : (a >= kColumns ? a - kColumns : a);
+    a = a >= kColumns ? 0.0f : a;
+    e.angle[i] = a;
+
+    float h = e.height[i] + e.vheight[i];
+    bool below = h < e.lo[i];
+    bool above = h > e.hi[i];
+    float reflected = below ? e.lo[i] + (e.lo[i] - h) : e.hi[i] - (h - e.hi[i]);
+    e.height[i] = (below || above) ? reflected : h;
+    if (below || above) e.vheight[i] = -e.vheight[i];
+}
+
+inline bool lane_overlaps(const EnemyArrays& e, size_t i, const OverlapBox& box) {
+    if (!e.alive[i]) return false;
+    float d = box.angle - e.angle[i];
+    d = d < 0.0f ? -d : d;
+    float wrapped = kColumns - d;
+    d = wrapped < d ? wrapped : d;
+    float reach = box.half_width + kEnemyHalfWidth;
+    float top = e.height[i] + kEnemyHeight;
+    return d < reach && e.height[i] < box.y1 && top > box.y0;
+}
+
+void update_scalar(const EnemyArrays& e, size_t begin) {
+    for (size_t i = begin; i < e.count; ++i) update_lane(e, i);
+}
+
+uint64_t overlap_scalar(const EnemyArrays& e, const OverlapBox& box, size_t begin) {
+    uint64_t mask = 0;
+    for (size_t i = begin; i < e.count; ++i) {
+        if (lane_overlaps(e, i, box)) mask |= uint64_t{1} << i;
+    }
+    return mask;
+}
+
+#if TT_KERNEL_X86
+
+// ------------------------------------------------------------------ SSE2 ---
+
+inline __m128 select_ps(__m128 mask, __m128 a, __m128 b) {  // mask ? a : b
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Four alive bytes, read as one word so wholly dead groups can be skipped.
+inline int32_t alive_bytes4(const uint8_t* alive) {
+    int32_t bytes;
+    std::memcpy(&bytes, alive, 4);
+    return bytes;
+}
+
+inline __m128 alive_mask4(int32_t bytes) {
+    __m128i v = _mm_cvtsi32_si128(bytes);
+    __m128i zero = _mm_setzero_si128();
+    v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(v, zero), zero);
+    return _mm_castsi128_ps(_mm_xor_si128(_mm_cmpeq_epi32(v, zero), _mm_set1_epi32(-1)));
+}
+
+void update_sse2(const EnemyArrays& e) {
+    const __m128 cols = _mm_set1_ps(kColumns);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 4 <= e.count; i += 4) {
+        int32_t bytes = alive_bytes4(e.alive + i);
+        if (bytes == 0) continue;
+        __m128 live = alive_mask4(bytes);
+        __m128 a0 = _mm_loadu_ps(e.angle + i);
+        __m128 a = _mm_add_ps(a0, _mm_loadu_ps(e.vangle + i));
+        __m128 over = _mm_cmpge_ps(a, cols);
+        a = select_ps(_mm_cmplt_ps(a, zero), _mm_add_ps(a, cols),
+                      select_ps(over, _mm_sub_ps(a, cols), a));
+        a = select_ps(_mm_cmpge_ps(a, cols), zero, a);
+        _mm_storeu_ps(e.angle + i, select_ps(live, a, a0));
+
+        __m128 h0 = _mm_loadu_ps(e.height + i);
+        __m128 vh = _mm_loadu_ps(e.vheight + i);
+        __m128 lo = _mm_loadu_ps(e.lo + i);
+        __m128 hi = _mm_loadu_ps(e.hi + i);
+        __m128 h = _mm_add_ps(h0, vh);
+        __m128 below = _mm_cmplt_ps(h, lo);
+        __m128 above = _mm_cmpgt_ps(h, hi);
+        __m128 reflected = select_ps(below, _mm_add_ps(lo, _mm_sub_ps(lo, h)),
+                                     _mm_sub_ps(hi, _mm_sub_ps(h, hi)));
+        __m128 bounce = _mm_and_ps(_mm_or_ps(below, above), live);
+        h = select_ps(_mm_or_ps(below, above), reflected, h);
+        _mm_storeu_ps(e.height + i, select_ps(live, h, h0));
+        _mm_storeu_ps(e.vheight + i, _mm_xor_ps(vh, _mm_and_ps(bounce, sign)));
+    }
+    update_scalar(e, i);
+}
+
+uint64_t overlap_sse2(const EnemyArrays& e, const OverlapBox& box) {
+    const __m128 cols = _mm_set1_ps(kColumns);
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 pa = _mm_set1_ps(box.angle);
+    const __m128 reach = _mm_set1_ps(box.half_width + kEnemyHalfWidth);
+    const __m128 y0 = _mm_set1_ps(box.y0);
+    const __m128 y1 = _mm_set1_ps(box.y1);
+    const __m128 eh = _mm_set1_ps(kEnemyHeight);
+    uint64_t mask = 0;
+    size_t i = 0;
+    for (; i + 4 <= e.count; i += 4) {
+        int32_t bytes = alive_bytes4(e.alive + i);
+        if (bytes == 0) continue;
+        __m128 d = _mm_and_ps(_mm_sub_ps(pa, _mm_loadu_ps(e.angle + i)), abs_mask);
+        __m128 wrapped = _mm_sub_ps(cols, d);
+        d = select_ps(_mm_cmplt_ps(wrapped, d), wrapped, d);
+        __m128 h = _mm_loadu_ps(e.height + i);
+        __m128 hit = _mm_and_ps(_mm_cmplt_ps(d, reach), _mm_cmplt_ps(h, y1));
+        hit = _mm_and_ps(hit, _mm_cmpgt_ps(_mm_add_ps(h, eh), y0));
+        hit = _mm_and_ps(hit, alive_mask4(bytes));
+        mask |= static_cast<uint64_t>(_mm_movemask_ps(hit)) << i;
+    }
+    return mask | overlap_scalar(e, box, i);
+}
+
+// ------------------------------------------------------------------ AVX2 ---
+
+inline int64_t alive_bytes8(const uint8_t* alive) {
+    int64_t bytes;
+    std::memcpy(&bytes, alive, 8);
+    return bytes;
+}
+
+__attribute__((target("avx2"))) inline __m256 alive_mask8(int64_t bytes) {
+    __m256i v = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(bytes));
+    __m256i zero = _mm256_setzero_si256();
+    return _mm256_castsi256_ps(_mm256_xor_si256(_mm256_cmpeq_epi32(v, zero), _mm256_set1_epi32(-1)));
+}
+
+__attribute__((target("avx2"))) void update_avx2(const EnemyArrays& e) {
+    const __m256 cols = _mm256_set1_ps(kColumns);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 8 <= e.count; i += 8) {
+        int64_t bytes = alive_bytes8(e.alive + i);
+        if (bytes == 0) continue;
+        __m256 live = alive_mask8(bytes);
+        __m256 a0 = _mm256_loadu_ps(e.angle + i);
+        __m256 a = _mm256_add_ps(a0, _mm256_loadu_ps(e.vangle + i));
+        __m256 over = _mm256_cmp_ps(a, cols, _CMP_GE_OQ);
+        a = _mm256_blendv_ps(_mm256_blendv_ps(a, _mm256_sub_ps(a, cols), over),
+                             _mm256_add_ps(a, cols), _mm256_cmp_ps(a, zero, _CMP_LT_OQ));
+        a = _mm256_blendv_ps(a, zero, _mm256_cmp_ps(a, cols, _CMP_GE_OQ));
+        _mm256_storeu_ps(e.angle + i, _mm256_blendv_ps(a0, a, live));
+
+        __m256 h0 = _mm256_loadu_ps(e.height + i);
+        __m256 vh = _mm256_loadu_ps(e.vheight + i);
+        __m256 lo = _mm256_loadu_ps(e.lo + i);
+        __m256 hi = _mm256_loadu_ps(e.hi + i);
+        __m256 h = _mm256_add_ps(h0, vh);
+        __m256 below = _mm256_cmp_ps(h, lo, _CMP_LT_OQ);
+        __m256 above = _mm256_cmp_ps(h, hi, _CMP_GT_OQ);
+        __m256 reflected = _mm256_blendv_ps(_mm256_sub_ps(hi, _mm256_sub_ps(h, hi)),
+                                            _mm256_add_ps(lo, _mm256_sub_ps(lo, h)), below);
+        __m256 out = _mm256_or_ps(below, above);
+        h = _mm256_blendv_ps(h, reflected, out);
+        _mm256_storeu_ps(e.height + i, _mm256_blendv_ps(h0, h, live));
+        _mm256_storeu_ps(e.vheight + i, _mm256_xor_ps(vh, _mm256_and_ps(_mm256_and_ps(out, live), sign)));
+    }
+    // The scalar tail is legacy-SSE code; clear the upper halves first or
+    // every instruction in it pays the AVX-SSE transition penalty.
+    _mm256_zeroupper();
+    update_scalar(e, i);
+}
+
+__attribute__((target("avx2"))) uint64_t overlap_avx2(const EnemyArrays& e, const OverlapBox& box) {
+    const __m256 cols = _mm256_set1_ps(kColumns);
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 pa = _mm256_set1_ps(box.angle);
+    const __m256 reach = _mm256_set1_ps(box.half_width + kEnemyHalfWidth);
+    const __m256 y0 = _mm256_set1_ps(box.y0);
+    const __m256 y1 = _mm256_set1_ps(box.y1);
+    const __m256 eh = _mm256_set1_ps(kEnemyHeight);
+    uint64_t mask = 0;
+    size_t i = 0;
+    for (; i + 8 <= e.count; i += 8) {
+        int64_t bytes = alive_bytes8(e.alive + i);
+        if (bytes == 0) continue;
+        __m256 d = _mm256_and_ps(_mm256_sub_ps(pa, _mm256_loadu_ps(e.angle + i)), abs_mask);
+        __m256 wrapped = _mm256_sub_ps(cols, d);
+        d = _mm256_blendv_ps(d, wrapped, _mm256_cmp_ps(wrapped, d, _CMP_LT_OQ));
+        __m256 h = _mm256_loadu_ps(e.height + i);
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(d, reach, _CMP_LT_OQ), _mm256_cmp_ps(h, y1, _CMP_LT_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_add_ps(h, eh), y0, _CMP_GT_OQ));
+        hit = _mm256_and_ps(hit, alive_mask8(bytes));
+        mask |= static_cast<uint64_t>(_mm256_movemask_ps(hit)) << i;
+    }
+    _mm256_zeroupper();
+    return mask | overlap_scalar(e, box, i);
+}
+
+#endif  // TT_KERNEL_X86
+
+KernelIsa detect_isa() {
+#if TT_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return KernelIsa::Avx2;
+    if (__builtin_cpu_supports("sse2")) return KernelIsa::Sse2;
+#endif
+    return KernelIsa::Scalar;
+}
+
+KernelIsa g_isa = detect_isa();
+
+}  // namespace
+
+void enemy_update(const EnemyArrays& e) {
+    switch (g_isa) {
+#if TT_KERNEL_X86
+        case KernelIsa::Avx2:
+            update_avx2(e);
+            return;
+        case KernelIsa::Sse2:
+            update_sse2(e);
+            return;
+#endif
+        default:
+            update_scalar(e, 0);
+            return;
+    }
+}
+
+uint64_t enemy_overlap_mask(const EnemyArrays& e, const OverlapBox& box) {
+    switch (g_isa) {
+#if TT_KERNEL_X86
+        case KernelIsa::Avx2:
+            return overlap_avx2(e, box);
+        case KernelIsa::Sse2:
+            return overlap_sse2(e, box);
+#endif
+        default:
+            return overlap_scalar(e, box, 0);
+    }
+}
+
+KernelIsa best_kernel_isa() { return detect_isa(); }
+
+KernelIsa kernel_isa() { return g_isa; }
+
+KernelIsa set_kernel_isa(KernelIsa isa) {
+    KernelIsa best = detect_isa();
+    g_isa = static_cast<uint8_t>(isa) <= static_cast<uint8_t>(best) ? isa : best;
+    return g_isa;
+}
+
+const char* kernel_isa_name(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Avx2:
+            return "avx2";
+        case KernelIsa::Sse2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+}  // namespace toppler
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sim/sim_state.h"
+
+namespace toppler {
+
+// Vectorized enemy motion and overlap tests over packed float lanes.
+//
+// Every implementation performs the same IEEE operations in the same order
+// (adds, compares and selects only, no FMA or reciprocal estimates), so the
+// scalar, SSE2 and AVX2 paths produce bit-identical results and replays stay
+// valid whichever one a machine picks.
+
+enum class KernelIsa : uint8_t { Scalar = 0, Sse2, Avx2 };
+
+// Packed lanes the kernels work over. Lanes with alive == 0 are left untouched
+// and never overlap.
+struct EnemyArrays {
+    float* angle;
+    float* height;
+    float* vangle;
+    float* vheight;
+    const float* lo;
+    const float* hi;
+    const uint8_t* alive;
+    size_t count;  // at most 64 for enemy_overlap_mask
+};
+
+inline EnemyArrays enemy_arrays(EnemyLanes& e) {
+    // Live enemies are packed at the front, so only those lanes are passed.
+    return EnemyArrays{e.angle, e.height, e.vangle, e.vheight, e.lo, e.hi, e.alive, e.pool.count};
+}
+
+// Axis-aligned box on the tower surface: centre angle with a half width,
+// and the height range [y0, y1). Enemy boxes are kEnemyHalfWidth x kEnemyHeight.
+struct OverlapBox {
+    float angle;
+    float half_width;
+    float y0;
+    float y1;
+};
+
+// position += velocity for every live lane; angles wrap around the tower and
+// heights bounce between lo and hi.
+void enemy_update(const EnemyArrays& e);
+
+// Bit i set if live lane i overlaps `box`.
+uint64_t enemy_overlap_mask(const EnemyArrays& e, const OverlapBox& box);
+
+inline void enemy_update(EnemyLanes& e) { enemy_update(enemy_arrays(e)); }
+inline uint64_t enemy_overlap_mask(const EnemyLanes& e, const OverlapBox& box) {
+    // The overlap test only reads; the mutable view is just the shared type.
+    return enemy_overlap_mask(enemy_arrays(const_cast<EnemyLanes&>(e)), box);
+}
+
+// Best implementation this CPU supports; chosen once at startup.
+KernelIsa best_kernel_isa();
+KernelIsa kernel_isa();
+// Forces an implementation (clamped to what the CPU supports), e.g. to
+// benchmark or cross-check paths. Returns the one actually selected.
+KernelIsa set_kernel_isa(KernelIsa isa);
+const char* kernel_isa_name(KernelIsa isa);
+
+}  // namespace toppler
@@ -0,0 +1,671 @@
+#include "sim/game_sim.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "core/profiler.h"
+#include "core/rng.h"
+#include "sim/enemy_kernel.h"
+#include "sim/sim_phases.h"
+#include "sim/state_hash.h"
+#include "tower/tile_behavior.h"
+
+namespace toppler {
+
+using detail::SimRefs;
+
+namespace {
+
+// Tuning. Speeds are exact binary fractions so positions stay exact and
+// elevator cars line up with ledges without rounding drift.
+constexpr float kColumns = static_cast<float>(kTowerColumns);
+constexpr float kWalkSpeed = 1.0f / 16.0f;
+constexpr float kSlideSpeed = 1.0f / 32.0f;
+constexpr float kJumpVx = 3.0f / 32.0f;
+constexpr float kJumpVy = 7.0f / 32.0f;
+constexpr float kGravity = 1.0f / 64.0f;
+constexpr float kMaxFall = 0.4375f;  // < 1 so a fall crosses at most one row per tick
+constexpr float kKnockVx = 1.0f / 16.0f;
+constexpr float kKnockVy = 1.0f / 8.0f;
+constexpr float kLiftSpeed = 1.0f / 16.0f;
+constexpr float kCameraSpeed = 1.0f / 4.0f;
+constexpr float kShotSpeed = 3.0f / 16.0f;
+constexpr float kShotReach = 0.15f;
+constexpr float kCarTolerance = 1.0f / 128.0f;
+
+constexpr uint16_t kTunnelTicks = 40;
+constexpr uint16_t kDrownTicks = 90;
+constexpr uint16_t kKnockInvulnerable = 90;
+constexpr uint16_t kRespawnInvulnerable = 120;
+constexpr uint16_t kCrumbleTicks = 30;
+constexpr uint16_t kShotTicks = 40;
+constexpr uint16_t kShotCooldown = 18;
+constexpr uint16_t kDefaultTimeLimit = 120;
+constexpr uint8_t kStartLives = 3;
+
+constexpr int kSpawnRadius = 10;    // rows; enemies appear when the player is this close
+constexpr float kDespawnRadius = 14.0f;
+
+constexpr uint32_t kHeightScore = 10;
+constexpr uint32_t kExitScore = 1000;
+constexpr uint32_t kTimeBonusPerSecond = 10;
+
+float wrap_angle(float a) {
+    if (a < 0.0f) {
+        a += kColumns;
+    } else if (a >= kColumns) {
+        a -= kColumns;
+    }
+    if (a >= kColumns) a = 0.0f;  // -epsilon + 16 rounds up to 16
+    return a;
+}
+
+// Shortest signed angular step from a to b, in [-kColumns/2, kColumns/2).
+float angle_delta(float a, float b) {
+    float d = b - a;
+    if (d >= kColumns * 0.5f) {
+        d -= kColumns;
+    } else if (d < -kColumns * 0.5f) {
+        d += kColumns;
+    }
+    return d;
+}
+
+int column_of(float angle) { return static_cast<int>(angle) & kTowerColumnMask; }
+
+int row_of(float height) { return static_cast<int>(std::floor(height)); }
+
+// Tile as this session sees it: crumbled bricks read as Empty.
+Tile tile_at(const Level& level, const BrokenMask& broken, int row, int col) {
+    Tile t = level.grid.at(row, col);
+    if ((tile_flags(t) & kTileCrumbles) && broken.test(row, col)) return Tile::Empty;
+    return t;
+}
+
+// Behaviour of the tile as this session sees it.
+TileFlags flags_at(const Level& level, const BrokenMask& broken, int row, int col) {
+    return tile_flags(tile_at(level, broken, row, col));
+}
+
+uint32_t elevator_count(const Level& level) {
+    return std::min<uint32_t>(level.elevator_count, kMaxElevators);
+}
+
+uint32_t spawn_count(const Level& level) { return std::min<uint32_t>(level.spawn_count, kMaxSpawns); }
+
+// What the player is standing on at a whole-number height.
+struct Footing {
+    TileFlags flags = 0;
+    int elevator = -1;
+    bool solid() const { return elevator >= 0 || (flags & kTileSupports); }
+};
+
+Footing footing_at(const Level& level, const SimRefs& s, float angle, float height) {
+    Footing f;
+    int col = column_of(angle);
+    int h = static_cast<int>(std::lround(height));
+    f.flags = flags_at(level, s.broken, h - 1, col);
+    if (f.flags & kTileSupports) return f;
+    for (uint32_t i = 0; i < elevator_count(level); ++i) {
+        if (level.elevators[i].column == col &&
+            std::fabs(s.elevators.pos[i] - height) <= kCarTolerance) {
+            f.elevator = static_cast<int>(i);
+            break;
+        }
+    }
+    return f;
+}
+
+bool wall_in_rows(const Level& level, const SimRefs& s, int col, int r0, int r1) {
+    for (int r = r0; r <= r1; ++r) {
+        if (flags_at(level, s.broken, r, col) & kTileBlocks) return true;
+    }
+    return false;
+}
+
+// Moves sideways unless the leading edge would enter a wall. Only the leading
+// edge is tested so a body already touching a wall can always back away.
+bool try_move(const Level& level, const SimRefs& s, PlayerState& p, float dx) {
+    float next = wrap_angle(p.angle + dx);
+    float edge = wrap_angle(next + (dx > 0.0f ? kPlayerHalfWidth : -kPlayerHalfWidth));
+    if (wall_in_rows(level, s, column_of(edge), row_of(p.height), row_of(p.height + kPlayerHeight))) {
+        return false;
+    }
+    p.angle = next;
+    return true;
+}
+
+// True if rising from old_h to new_h puts the head into a wall row.
+bool head_blocked(const Level& level, const SimRefs& s, float angle, float old_h, float new_h) {
+    int row = row_of(new_h + kPlayerHeight);
+    if (row == row_of(old_h + kPlayerHeight)) return false;
+    return wall_in_rows(level, s, column_of(wrap_angle(angle - kPlayerHalfWidth)), row, row) ||
+           wall_in_rows(level, s, column_of(wrap_angle(angle + kPlayerHalfWidth)), row, row);
+}
+
+void knock(PlayerState& p) {
+    p.mode = PlayerMode::Knocked;
+    p.vx = -static_cast<float>(p.facing) * kKnockVx;
+    p.vy = kKnockVy;
+    p.invulnerable = kKnockInvulnerable;
+    p.crumble_ticks = 0;
+}
+
+void start_fall(PlayerState& p) {
+    p.mode = PlayerMode::Falling;
+    p.vx = 0.0f;
+    p.vy = 0.0f;
+    p.crumble_ticks = 0;
+}
+
+void drown(const SimRefs& s) {
+    PlayerState& p = s.player;
+    if (s.session.lives > 0) --s.session.lives;
+    p.mode = PlayerMode::Drowning;
+    p.timer = kDrownTicks;
+    p.vx = 0.0f;
+    p.vy = 0.0f;
+}
+
+void award_height(const SimRefs& s, int height) {
+    PlayerState& p = s.player;
+    if (height > p.best_row) {
+        s.session.score += kHeightScore * static_cast<uint32_t>(height - p.best_row);
+        p.best_row = static_cast<int16_t>(height);
+    }
+}
+
+void add_score(const SimRefs& s, uint32_t points, float angle, float height) {
+    s.session.score += points;
+    if (s.events) s.events->scores.push_back(ScoreEvent{angle, height, points});
+}
+
+void add_contact(const SimRefs& s, ContactKind kind, LaneHandle enemy, float angle, float height) {
+    if (s.events) s.events->contacts.push_back(Contact{kind, enemy, angle, height});
+}
+
+void complete(const SimRefs& s) {
+    s.session.status = SimStatus::Complete;
+    add_score(s, kExitScore + (s.session.time_left / kTicksPerSecond) * kTimeBonusPerSecond, s.player.angle,
+              s.player.height);
+}
+
+void break_brick(const SimRefs& s, int row, int col) {
+    if (static_cast<unsigned>(row) < static_cast<unsigned>(kMaxTowerRows)) {
+        uint16_t bit = static_cast<uint16_t>(1u << (col & kTowerColumnMask));
+        if (!(s.broken.rows[row] & bit)) s.session.world_hash ^= zobrist_brick(row, col & kTowerColumnMask);
+        s.broken.rows[row] = static_cast<uint16_t>(s.broken.rows[row] | bit);
+        if (s.events) {
+            s.events->bricks.push_back(BrickEvent{static_cast<int16_t>(row),
+                                                  static_cast<uint8_t>(col & kTowerColumnMask), Tile::Crumble});
+        }
+    }
+}
+
+void try_fire(const SimRefs& s, InputMask input) {
+    PlayerState& p = s.player;
+    if (!(input & kInputFire) || p.shot_cooldown > 0) return;
+    ShotLanes& shots = s.shots;
+    if (shots.pool.full()) return;
+    int i = shots.pool.acquire();
+    float dir = static_cast<float>(p.facing);
+    shots.angle[i] = wrap_angle(p.angle + dir * 0.4f);
+    shots.height[i] = p.height + 0.4f;
+    shots.vangle[i] = dir * kShotSpeed;
+    shots.ttl[i] = kShotTicks;
+    p.shot_cooldown = kShotCooldown;
+}
+
+// Settles a player that is standing at a whole-number height: handles what
+// the footing does to them this tick.
+void resolve_footing(const Level& level, const SimRefs& s) {
+    PlayerState& p = s.player;
+    Footing f = footing_at(level, s, p.angle, p.height);
+    if (!f.solid()) {
+        start_fall(p);
+        return;
+    }
+    if (f.elevator >= 0) {
+        p.mode = PlayerMode::Riding;
+        p.elevator = static_cast<uint8_t>(f.elevator);
+        p.crumble_ticks = 0;
+        return;
+    }
+    int h = static_cast<int>(std::lround(p.height));
+    if (f.flags & kTileCrumbles) {
+        if (++p.crumble_ticks >= kCrumbleTicks) {
+            break_brick(s, h - 1, column_of(p.angle));
+            start_fall(p);
+        }
+        return;
+    }
+    if (f.flags & kTileHurts) {
+        if (p.invulnerable == 0) knock(p);
+        return;
+    }
+    p.crumble_ticks = 0;
+    p.checkpoint_angle = p.angle;
+    p.checkpoint_height = p.height;
+    award_height(s, h);
+}
+
+void step_walking(const Level& level, const SimRefs& s, InputMask input) {
+    PlayerState& p = s.player;
+    int dir = ((input & kInputRight) ? 1 : 0) - ((input & kInputLeft) ? 1 : 0);
+    if (dir != 0) p.facing = static_cast<int8_t>(dir);
+
+    int row = static_cast<int>(std::lround(p.height));
+    TileFlags body = flags_at(level, s.broken, row, column_of(p.angle));
+    if (body & kTileExit) {
+        complete(s);
+        return;
+    }
+    if (input & kInputJump) {
+        p.mode = PlayerMode::Jumping;
+        p.vx = static_cast<float>(dir) * kJumpVx;
+        p.vy = kJumpVy;
+        p.crumble_ticks = 0;
+        return;
+    }
+    if ((input & kInputUp) && (body & kTileTunnel)) {
+        p.mode = PlayerMode::Tunnel;
+        p.timer = kTunnelTicks;
+        p.crumble_ticks = 0;
+        return;
+    }
+
+    float dx = static_cast<float>(dir) * kWalkSpeed;
+    if (flags_at(level, s.broken, row - 1, column_of(p.angle)) & kTileSlides) {
+        dx += static_cast<float>(p.facing) * kSlideSpeed;
+    }
+    if (dx != 0.0f) try_move(level, s, p, dx);
+    try_fire(s, input);
+    resolve_footing(level, s);
+}
+
+void step_riding(const Level& level, const SimRefs& s, InputMask input) {
+    PlayerState& p = s.player;
+    const ElevatorDef& car = level.elevators[p.elevator];
+    float& pos = s.elevators.pos[p.elevator];
+    if (input & kInputUp) {
+        pos = std::min(pos + kLiftSpeed, static_cast<float>(car.top));
+    } else if (input & kInputDown) {
+        pos = std::max(pos - kLiftSpeed, static_cast<float>(car.bottom));
+    }
+    p.height = pos;
+
+    int dir = ((input & kInputRight) ? 1 : 0) - ((input & kInputLeft) ? 1 : 0);
+    if (dir != 0) p.facing = static_cast<int8_t>(dir);
+    if (input & kInputJump) {
+        p.mode = PlayerMode::Jumping;
+        p.vx = static_cast<float>(dir) * kJumpVx;
+        p.vy = kJumpVy;
+        return;
+    }
+    if (dir != 0) try_move(level, s, p, static_cast<float>(dir) * kWalkSpeed);
+    try_fire(s, input);
+    if (column_of(p.angle) == car.column) return;
+
+    // Stepped off the car: onto a ledge if it is level with one, else down.
+    float whole = std::round(p.height);
+    if (std::fabs(whole - p.height) <= kCarTolerance) {
+        p.height = whole;
+        p.mode = PlayerMode::Walking;
+        resolve_footing(level, s);
+    } else {
+        start_fall(p);
+    }
+}
+
+void step_airborne(const Level& level, const SimRefs& s) {
+    PlayerState& p = s.player;
+    if (p.vx != 0.0f && !try_move(level, s, p, p.vx)) p.vx = 0.0f;
+
+    float old_h = p.height;
+    p.vy = std::max(p.vy - kGravity, -kMaxFall);
+    float new_h = old_h + p.vy;
+
+    if (p.vy > 0.0f) {
+        if (head_blocked(level, s, p.angle, old_h, new_h)) {
+            p.vy = 0.0f;
+            new_h = old_h;
+        }
+        p.height = new_h;
+        return;
+    }
+
+    int col = column_of(p.angle);
+    for (uint32_t i = 0; i < elevator_count(level); ++i) {
+        float car = s.elevators.pos[i];
+        if (level.elevators[i].column == col && old_h >= car - kCarTolerance && new_h <= car) {
+            p.height = car;
+            p.mode = PlayerMode::Riding;
+            p.elevator = static_cast<uint8_t>(i);
+            p.vx = p.vy = 0.0f;
+            return;
+        }
+    }
+    int landing = static_cast<int>(std::floor(old_h));
+    if (landing >= 1 && new_h <= static_cast<float>(landing) &&
+        (flags_at(level, s.broken, landing - 1, col) & kTileSupports)) {
+        p.height = static_cast<float>(landing);
+        p.mode = PlayerMode::Walking;
+        p.vx = p.vy = 0.0f;
+        return;
+    }
+    p.height = new_h;
+    if (p.height < 0.0f) drown(s);
+}
+
+// Drops lane `i`, moving the last live enemy into it to keep lanes packed.
+void remove_enemy(EnemyLanes& e, int i) {
+    int last = e.pool.release(i);
+    if (last >= 0) {
+        e.angle[i] = e.angle[last];
+        e.height[i] = e.height[last];
+        e.vangle[i] = e.vangle[last];
+        e.vheight[i] = e.vheight[last];
+        e.lo[i] = e.lo[last];
+        e.hi[i] = e.hi[last];
+        e.kind[i] = e.kind[last];
+        e.spawn[i] = e.spawn[last];
+    }
+    e.alive[e.pool.count] = 0;
+}
+
+void remove_shot(ShotLanes& shots, int i) {
+    int last = shots.pool.release(i);
+    if (last < 0) return;
+    shots.angle[i] = shots.angle[last];
+    shots.height[i] = shots.height[last];
+    shots.vangle[i] = shots.vangle[last];
+    shots.ttl[i] = shots.ttl[last];
+}
+
+// Every spawn record write goes through here to keep world_hash current.
+void set_spawn(const SimRefs& s, int sp, LaneHandle enemy, uint32_t ready_tick) {
+    s.session.world_hash ^= zobrist_spawn(sp, s.spawns.enemy[sp], s.spawns.ready_tick[sp]) ^
+                            zobrist_spawn(sp, enemy, ready_tick);
+    s.spawns.enemy[sp] = enemy;
+    s.spawns.ready_tick[sp] = ready_tick;
+}
+
+void kill_enemy(const Level& level, const SimRefs& s, int lane) {
+    EnemyLanes& e = s.enemies;
+    int sp = e.spawn[lane];
+    if (sp >= 0) set_spawn(s, sp, kNoLane, s.session.tick + level.spawns[sp].period + 1);
+    remove_enemy(e, lane);
+}
+
+void spawn_enemy(const Level& level, const SimRefs& s, int sp) {
+    const EnemySpawn& def = level.spawns[sp];
+    EnemyLanes& e = s.enemies;
+    int lane = e.pool.acquire();
+    float dir = rng_below(s.session.rng, 2) ? 1.0f : -1.0f;
+    float row = static_cast<float>(def.row);
+    float range = static_cast<float>(std::max<uint16_t>(def.range, 1));
+    e.alive[lane] = 1;
+    e.kind[lane] = def.kind;
+    e.spawn[lane] = static_cast<int16_t>(sp);
+    e.angle[lane] = static_cast<float>(def.column & kTowerColumnMask) + 0.5f;
+    e.height[lane] = row;
+    e.lo[lane] = row;
+    switch (def.kind) {
+        case EnemyKind::Ball:
+            e.hi[lane] = row + 0.5f;
+            e.vangle[lane] = dir * (3.0f / 64.0f);
+            e.vheight[lane] = 1.0f / 32.0f;
+            break;
+        case EnemyKind::Eye:
+            e.hi[lane] = row + range;
+            e.vangle[lane] = dir * (1.0f / 32.0f);
+            e.vheight[lane] = 1.0f / 64.0f;
+            break;
+        default:
+            e.hi[lane] = row + range;
+            e.vangle[lane] = 0.0f;
+            e.vheight[lane] = 1.0f / 16.0f;
+            break;
+    }
+    set_spawn(s, sp, e.pool.handle(lane), s.spawns.ready_tick[sp]);
+}
+
+}  // namespace
+
+namespace detail {
+
+void step_player(const Level& level, const SimRefs& s, InputMask input) {
+    PlayerState& p = s.player;
+    if (p.invulnerable > 0) --p.invulnerable;
+    if (p.shot_cooldown > 0) --p.shot_cooldown;
+
+    switch (p.mode) {
+        case PlayerMode::Walking:
+            step_walking(level, s, input);
+            break;
+        case PlayerMode::Riding:
+            step_riding(level, s, input);
+            break;
+        case PlayerMode::Jumping:
+        case PlayerMode::Falling:
+        case PlayerMode::Knocked:
+            step_airborne(level, s);
+            break;
+        case PlayerMode::Tunnel:
+            if (--p.timer == 0) {
+                p.angle = wrap_angle(p.angle + kColumns * 0.5f);
+                p.mode = PlayerMode::Walking;
+            }
+            break;
+        case PlayerMode::Drowning:
+            if (--p.timer == 0) {
+                if (s.session.lives == 0) {
+                    s.session.status = SimStatus::GameOver;
+                    break;
+                }
+                p.angle = p.checkpoint_angle;
+                p.height = p.checkpoint_height;
+                p.mode = PlayerMode::Walking;
+                p.invulnerable = kRespawnInvulnerable;
+            }
+            break;
+    }
+}
+
+// Enemies exist only near the player; far ones are dropped and respawn
+// from their spawn point when the player comes back.
+void manage_spawns(const Level& level, const SimRefs& s) {
+    EnemyLanes& e = s.enemies;
+    float ph = s.player.height;
+    // Backwards, so the lane moved into a hole has already been looked at.
+    for (int i = e.pool.count - 1; i >= 0; --i) {
+        if (std::fabs(e.height[i] - ph) > kDespawnRadius) {
+            if (e.spawn[i] >= 0) set_spawn(s, e.spawn[i], kNoLane, s.spawns.ready_tick[e.spawn[i]]);
+            remove_enemy(e, i);
+        }
+    }
+    // Only the band of spawns around the player is visited; respawn timers
+    // are deadlines, so spawns elsewhere on the tower cost nothing.
+    int prow = row_of(ph);
+    SpawnRange near = spawns_in_rows(level, prow - kSpawnRadius, prow + kSpawnRadius);
+    uint32_t end = std::min(near.end, spawn_count(level));
+    for (uint32_t sp = near.begin; sp < end; ++sp) {
+        if (s.spawns.enemy[sp] != kNoLane || s.session.tick < s.spawns.ready_tick[sp]) continue;
+        if (e.pool.full()) return;
+        spawn_enemy(level, s, static_cast<int>(sp));
+    }
+}
+
+void update_enemies(EnemyLanes& e) { enemy_update(e); }
+
+void step_shots(const Level& level, const SimRefs& s) {
+    ShotLanes& shots = s.shots;
+    EnemyLanes& e = s.enemies;
+    for (int i = shots.pool.count - 1; i >= 0; --i) {
+        shots.angle[i] = wrap_angle(shots.angle[i] + shots.vangle[i]);
+        if (--shots.ttl[i] == 0) {
+            remove_shot(shots, i);
+            continue;
+        }
+        if (flags_at(level, s.broken, row_of(shots.height[i]), column_of(shots.angle[i])) & kTileBlocks) {
+            add_contact(s, ContactKind::ShotWall, kNoLane, shots.angle[i], shots.height[i]);
+            remove_shot(shots, i);
+            continue;
+        }
+        OverlapBox box{shots.angle[i], kShotReach, shots.height[i] - kShotReach,
+                       shots.height[i] + kShotReach};
+        uint64_t hits = enemy_overlap_mask(e, box);
+        if (hits == 0) continue;
+        int j = __builtin_ctzll(hits);  // lowest lane wins, as in a linear scan
+        remove_shot(shots, i);
+        add_contact(s, ContactKind::ShotEnemy, e.pool.handle(j), e.angle[j], e.height[j]);
+        if (e.kind[j] == EnemyKind::Ball) {
+            add_score(s, 100, e.angle[j], e.height[j]);
+            kill_enemy(level, s, j);
+        } else if (e.kind[j] == EnemyKind::Eye) {
+            add_score(s, 200, e.angle[j], e.height[j]);
+            kill_enemy(level, s, j);
+        }  // bouncers soak up shots
+    }
+}
+
+void collide_player(const SimRefs& s) {
+    PlayerState& p = s.player;
+    if (p.invulnerable > 0 || p.mode == PlayerMode::Tunnel || p.mode == PlayerMode::Drowning) return;
+    OverlapBox box{p.angle, kPlayerHalfWidth, p.height, p.height + kPlayerHeight};
+    uint64_t hits = enemy_overlap_mask(s.enemies, box);
+    if (hits == 0) return;
+    add_contact(s, ContactKind::PlayerEnemy, s.enemies.pool.handle(__builtin_ctzll(hits)), p.angle,
+                p.height);
+    knock(p);
+}
+
+void init_session(const Level& level, uint32_t seed, const SimRefs& s) {
+    // memset also zeroes padding, so states compare and hash bytewise.
+    std::memset(&s.session, 0, sizeof s.session);
+    std::memset(&s.player, 0, sizeof s.player);
+    std::memset(&s.elevators, 0, sizeof s.elevators);
+    std::memset(&s.enemies, 0, sizeof s.enemies);
+    std::memset(&s.shots, 0, sizeof s.shots);
+    std::memset(&s.spawns, 0, sizeof s.spawns);
+    std::memset(&s.broken, 0, sizeof s.broken);
+
+    s.session.rng = rng_seed(seed);
+    s.session.lives = kStartLives;
+    s.session.status = SimStatus::Playing;
+    uint16_t limit = level.time_limit ? level.time_limit : kDefaultTimeLimit;
+    s.session.time_left = static_cast<uint32_t>(limit) * kTicksPerSecond;
+
+    PlayerState& p = s.player;
+    p.angle = static_cast<float>(level.start_column & kTowerColumnMask) + 0.5f;
+    p.height = static_cast<float>(level.start_row);
+    p.checkpoint_angle = p.angle;
+    p.checkpoint_height = p.height;
+    p.mode = PlayerMode::Walking;
+    p.facing = 1;
+    p.best_row = static_cast<int16_t>(level.start_row);
+    s.session.tower_angle = p.angle;
+
+    for (uint32_t i = 0; i < elevator_count(level); ++i) {
+        s.elevators.pos[i] = static_cast<float>(level.elevators[i].bottom);
+    }
+    for (int i = 0; i < kMaxEnemies; ++i) s.enemies.spawn[i] = -1;
+    for (int i = 0; i < kMaxSpawns; ++i) s.spawns.enemy[i] = kNoLane;  // zobrist_spawn 0: world_hash stays 0
+    s.enemies.pool.init();
+    s.shots.pool.init();
+}
+
+bool begin_tick(const SimRefs& s) {
+    ++s.session.tick;
+    return playing(s);
+}
+
+void end_tick(const SimRefs& s) {
+    SessionState& session = s.session;
+    float d = angle_delta(session.tower_angle, s.player.angle);
+    d = std::clamp(d, -kCameraSpeed, kCameraSpeed);
+    session.tower_angle = wrap_angle(session.tower_angle + d);
+
+    if (session.time_left > 0 && --session.time_left == 0) session.status = SimStatus::GameOver;
+}
+
+}  // namespace detail
+
+Tile sim_tile(const Level& level, const SimState& state, int row, int col) {
+    return tile_at(level, state.broken, row, col);
+}
+
+void sim_init(const Level& level, uint32_t seed, SimState& state) {
+    detail::init_session(level, seed, detail::refs_of(state));
+}
+
+namespace {
+
+// Coordinates sim_step() turns into ints (rows, columns, spawn bands) stay
+// far inside int range within these; NaN fails every test.
+bool height_ok(float h) { return h >= -kMaxTowerRows && h <= 2 * kMaxTowerRows; }
+bool angle_ok(float a) { return a >= -kTowerColumns && a <= 2 * kTowerColumns; }
+bool speed_ok(float v) { return v >= -kTowerColumns && v <= kTowerColumns; }
+
+}  // namespace
+
+bool sim_state_in_bounds(const SimState& state, const Level* level) {
+    uint32_t elevators = level ? elevator_count(*level) : kMaxElevators;
+    uint32_t spawns = level ? spawn_count(*level) : kMaxSpawns;
+    const SessionState& session = state.session;
+    const PlayerState& p = state.player;
+    if (session.status > SimStatus::GameOver || p.mode > PlayerMode::Drowning) return false;
+    if (!angle_ok(session.tower_angle)) return false;
+    if (!angle_ok(p.angle) || !height_ok(p.height) || !speed_ok(p.vx) || !speed_ok(p.vy) ||
+        !angle_ok(p.checkpoint_angle) || !height_ok(p.checkpoint_height)) {
+        return false;
+    }
+    if (p.mode == PlayerMode::Riding && p.elevator >= elevators) return false;
+    for (uint32_t i = 0; i < elevators; ++i) {
+        float pos = state.elevators.pos[i];
+        if (!height_ok(pos)) return false;
+        if (level && (pos < level->elevators[i].bottom || pos > level->elevators[i].top)) return false;
+    }
+
+    const EnemyLanes& e = state.enemies;
+    if (!e.pool.valid()) return false;
+    for (int i = 0; i < e.pool.count; ++i) {
+        if (e.kind[i] >= EnemyKind::kCount || e.spawn[i] < -1 || e.spawn[i] >= static_cast<int>(spawns)) return false;
+        if (!angle_ok(e.angle[i]) || !height_ok(e.height[i]) || !speed_ok(e.vangle[i]) || !speed_ok(e.vheight[i]) ||
+            !height_ok(e.lo[i]) || !height_ok(e.hi[i])) {
+            return false;
+        }
+    }
+    const ShotLanes& shots = state.shots;
+    if (!shots.pool.valid()) return false;
+    for (int i = 0; i < shots.pool.count; ++i) {
+        if (!angle_ok(shots.angle[i]) || !height_ok(shots.height[i]) || !speed_ok(shots.vangle[i])) return false;
+    }
+    return true;
+}
+
+void sim_step(const Level& level, SimState& state, InputMask input) { sim_step(level, state, input, nullptr); }
+
+void sim_step(const Level& level, SimState& state, InputMask input, TickEvents* events) {
+    using namespace detail;
+    TT_PROFILE_ZONE(Sim);
+    SimRefs s = refs_of(state);
+    s.events = events;
+    if (!begin_tick(s)) return;
+    step_player(level, s, input);
+    if (!playing(s)) return;
+    manage_spawns(level, s);
+    {
+        TT_PROFILE_ZONE(EnemyUpdate);
+        update_enemies(s.enemies);
+    }
+    {
+        TT_PROFILE_ZONE(Collision);
+        step_shots(level, s);
+        collide_player(s);
+    }
+    end_tick(s);
+}
+
+}  // namespace toppler
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include "sim/input.h"
+#include "sim/sim_state.h"
+#include "sim/tick_events.h"
+#include "tower/level.h"
+
+namespace toppler {
+
+// Headless, fixed-timestep tower simulation. No rendering, audio or platform
+// code lives here: a tick is a pure function of (level, state, input), so the
+// same inputs always reproduce the same run.
+
+// Puts `state` at the start of `level`.
+void sim_init(const Level& level, uint32_t seed, SimState& state);
+
+// Advances `state` by exactly one tick (1 / kTicksPerSecond seconds).
+void sim_step(const Level& level, SimState& state, InputMask input);
+// Same, also recording what happened into `events` (see tick_events.h).
+void sim_step(const Level& level, SimState& state, InputMask input, TickEvents* events);
+
+// Whether every count, index and enum in `state` is in range and every
+// position, speed and lift height is finite and within a few tower heights
+// of the tower, so no conversion to a row or column can overflow. With
+// `level`, indices are checked against its lifts and spawns and each car
+// against its travel; without, against the capacities. sim_step() assumes
+// this, and its own states always satisfy it; check states from outside
+// (replay keyframes) before use.
+bool sim_state_in_bounds(const SimState& state, const Level* level);
+
+// Tile at (row, col) as the session currently sees it, i.e. with crumbled
+// bricks removed.
+Tile sim_tile(const Level& level, const SimState& state, int row, int col);
+
+// Convenience owner of one session. The renderer only ever gets state(),
+// a const snapshot that is stable between steps.
+class GameSim {
+public:
+    GameSim(const Level& level, uint32_t seed) : level_(level) { sim_init(level_, seed, state_); }
+
+    void reset(uint32_t seed) { sim_init(level_, seed, state_); }
+    void step(InputMask input) { sim_step(level_, state_, input); }
+
+    const Level& level() const { return level_; }
+    const SimState& state() const { return state_; }
+    // Snapshot with state(), roll back with restore(): both one flat copy.
+    void restore(const SimState& snapshot) { state_ = snapshot; }
+    bool finished() const { return state_.session.status != SimStatus::Playing; }
+
+private:
+    Level level_;
+    SimState state_;
+};
+
+}  // namespace toppler
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+namespace toppler {
+
+// One tick of player input. Replays and the network protocol store these
+// bits directly, so never renumber them.
+using InputMask = uint8_t;
+
+enum InputBit : InputMask {
+    kInputLeft = 1 << 0,
+    kInputRight = 1 << 1,
+    kInputUp = 1 << 2,    // ride an elevator up, enter a door
+    kInputDown = 1 << 3,  // ride an elevator down
+    kInputJump = 1 << 4,
+    kInputFire = 1 << 5,  // throw a snowball
+};
+
+constexpr InputMask kInputAll = 0x3f;
+
+}  // namespace toppler
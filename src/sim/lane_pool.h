@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+
+namespace toppler {
+
+// Stable name for a pooled object: handle slot in the low byte, that slot's
+// generation in the high byte. Stale once the object is removed.
+using LaneHandle = uint16_t;
+constexpr LaneHandle kNoLane = 0xffff;  // slot 0xff never exists
+
+// Bookkeeping for a fixed-capacity set of SoA lanes. Live objects always
+// occupy lanes [0, count), so loops and SIMD kernels touch live data only;
+// removing an object moves the last live lane into the hole (the owner
+// copies the lane data using the index release() returns). Handles follow an
+// object whichever lane it is in and go stale when it dies, so references
+// held elsewhere (spawn points, events, AI targets) can never alias a reused
+// lane. Handle slots come off a free list.
+//
+// Plain data: lives inside SimState and is copied and hashed with it.
+template <int N>
+struct LanePool {
+    static_assert(N > 0 && N < 0xff, "lane indices and handle slots are bytes");
+
+    uint8_t count;         // live lanes
+    uint8_t free_count;    // entries in free_slots
+    uint8_t free_slots[N]; // unused handle slots, next one on top
+    uint8_t lane_of[N];    // handle slot -> lane, while live
+    uint8_t slot_of[N];    // lane -> handle slot, for lanes < count
+    uint8_t generation[N]; // bumped each time a slot is released
+
+    void init() {
+        count = 0;
+        free_count = N;
+        for (int i = 0; i < N; ++i) {
+            free_slots[i] = static_cast<uint8_t>(N - 1 - i);  // slot 0 handed out first
+            lane_of[i] = slot_of[i] = generation[i] = 0;
+        }
+    }
+
+    bool full() const { return count == N; }
+
+    // Whether the bookkeeping is consistent: every slot either free or
+    // mapped to exactly one live lane and back. For pools read from outside
+    // (replay keyframes) before acquire() / release() trust them.
+    bool valid() const {
+        if (count > N || free_count != N - count) return false;
+        bool seen[N] = {};
+        for (int i = 0; i < free_count; ++i) {
+            if (free_slots[i] >= N || seen[free_slots[i]]) return false;
+            seen[free_slots[i]] = true;
+        }
+        for (int l = 0; l < count; ++l) {
+            uint8_t slot = slot_of[l];
+            if (slot >= N || seen[slot] || lane_of[slot] != l) return false;
+            seen[slot] = true;
+        }
+        return true;
+    }
+
+    // Claims lane `count` and returns it; its handle is handle(lane).
+    int acquire() {
+        uint8_t slot = free_slots[--free_count];
+        int lane = count++;
+        lane_of[slot] = static_cast<uint8_t>(lane);
+        slot_of[lane] = slot;
+        return lane;
+    }
+
+    // Frees `lane`. Returns the lane whose data must now be moved into
+    // `lane` (the old last lane), or -1 if `lane` was the last one.
+    int release(int lane) {
+        uint8_t slot = slot_of[lane];
+        generation[slot] = static_cast<uint8_t>(generation[slot] + 1);
+        free_slots[free_count++] = slot;
+        int last = --count;
+        if (lane == last) return -1;
+        uint8_t moved = slot_of[last];
+        slot_of[lane] = moved;
+        lane_of[moved] = static_cast<uint8_t>(lane);
+        return last;
+    }
+
+    LaneHandle handle(int lane) const {
+        uint8_t slot = slot_of[lane];
+        return static_cast<LaneHandle>(generation[slot] << 8 | slot);
+    }
+
+    // Current lane of the object `h` names, or -1 if it has died.
+    int lane(LaneHandle h) const {
+        unsigned slot = h & 0xffu;
+        if (slot >= static_cast<unsigned>(N) || generation[slot] != (h >> 8)) return -1;
+        int l = lane_of[slot];
+        return l < count && slot_of[l] == slot ? l : -1;
+    }
+};
+
+}  // namespace toppler
@@ -0,0 +1,25 @@
+#include "sim/rewind.h"
+
+#include <algorithm>
+
+namespace toppler {
+
+RewindBuffer::RewindBuffer(size_t capacity)
+    : ring_(new SimState[std::max<size_t>(capacity, 1)]), capacity_(std::max<size_t>(capacity, 1)) {}
+
+void RewindBuffer::push(const SimState& state) {
+    ring_[head_] = state;
+    head_ = head_ + 1 == capacity_ ? 0 : head_ + 1;
+    if (size_ < capacity_) ++size_;
+}
+
+bool RewindBuffer::rewind(size_t ticks, SimState& out) {
+    if (ticks >= size_) return false;
+    size_t slot = (head_ + capacity_ - 1 - ticks) % capacity_;
+    out = ring_[slot];
+    size_ -= ticks;
+    head_ = slot + 1 == capacity_ ? 0 : slot + 1;
+    return true;
+}
+
+}  // namespace toppler
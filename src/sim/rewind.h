@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "sim/sim_state.h"
+
+namespace toppler {
+
+// The last few seconds of a session, for rewind. Storage is allocated once;
+// push and rewind are each a single flat copy of SimState, so keeping a
+// snapshot every tick costs a fraction of the tick itself.
+class RewindBuffer {
+public:
+    explicit RewindBuffer(size_t capacity = 5 * kTicksPerSecond);
+
+    size_t capacity() const { return capacity_; }
+    size_t size() const { return size_; }
+    void clear() { head_ = size_ = 0; }
+
+    // Stores `state` as the newest snapshot, dropping the oldest when full.
+    void push(const SimState& state);
+
+    // Copies the snapshot pushed `ticks` pushes ago into `out` (0 is the
+    // newest) and forgets everything newer, so rewinding again continues
+    // from there. False, with `out` untouched, if it is no longer held.
+    bool rewind(size_t ticks, SimState& out);
+
+private:
+    std::unique_ptr<SimState[]> ring_;
+    size_t capacity_;
+    size_t head_ = 0;  // slot the next push writes
+    size_t size_ = 0;
+};
+
+}  // namespace toppler
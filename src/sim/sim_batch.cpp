@@ -0,0 +1,103 @@
+#include "sim/sim_batch.h"
+
+#include <algorithm>
+
+#include "core/thread_pool.h"
+#include "sim/sim_phases.h"
+
+namespace toppler {
+
+namespace {
+
+// Sessions per work item: enough to amortize hand-out, small enough to
+// balance when some sessions have finished and cost nothing.
+constexpr size_t kSessionsPerChunk = 64;
+// Sessions each phase is swept over in turn: their components (about 2 KB
+// of enemy lanes each) stay in L1 across all the phases of a tick.
+constexpr size_t kSessionsPerBlock = 8;
+
+}  // namespace
+
+SimBatch::SimBatch(size_t sessions)
+    : levels_(sessions),
+      session_(sessions),
+      player_(sessions),
+      elevators_(sessions),
+      enemies_(sessions),
+      shots_(sessions),
+      spawns_(sessions),
+      broken_(sessions),
+      active_(sessions, 0) {
+    for (size_t i = 0; i < sessions; ++i) session_[i].status = SimStatus::GameOver;
+}
+
+void SimBatch::reset(size_t i, const Level& level, uint32_t seed) {
+    levels_[i] = level;
+    detail::SimRefs refs{session_[i], player_[i], elevators_[i], enemies_[i],
+                         shots_[i],   spawns_[i], broken_[i]};
+    detail::init_session(level, seed, refs);
+}
+
+void SimBatch::gather(size_t i, SimState& out) const {
+    out.session = session_[i];
+    out.player = player_[i];
+    out.elevators = elevators_[i];
+    out.enemies = enemies_[i];
+    out.shots = shots_[i];
+    out.spawns = spawns_[i];
+    out.broken = broken_[i];
+}
+
+void SimBatch::step(const InputMask* inputs, ThreadPool* pool) {
+    if (pool) {
+        pool->parallel_for(size(), kSessionsPerChunk,
+                           [&](size_t begin, size_t end) { step_range(begin, end, inputs); });
+    } else {
+        step_range(0, size(), inputs);
+    }
+}
+
+void SimBatch::step_range(size_t begin, size_t end, const InputMask* inputs) {
+    // A sweep over thousands of sessions evicts each one's components
+    // between phases; small blocks keep them cache-hot.
+    for (size_t b = begin; b < end; b += kSessionsPerBlock) {
+        step_block(b, std::min(end, b + kSessionsPerBlock), inputs);
+    }
+}
+
+void SimBatch::step_block(size_t begin, size_t end, const InputMask* inputs) {
+    using namespace detail;
+    auto refs = [this](size_t i) {
+        return SimRefs{session_[i], player_[i], elevators_[i], enemies_[i],
+                       shots_[i],   spawns_[i], broken_[i]};
+    };
+
+    // Same phase order as sim_step, each phase swept across the chunk.
+    for (size_t i = begin; i < end; ++i) {
+        SimRefs s = refs(i);
+        bool live = begin_tick(s);
+        if (live) {
+            step_player(levels_[i], s, inputs[i]);
+            live = playing(s);
+        }
+        active_[i] = live;
+    }
+    for (size_t i = begin; i < end; ++i) {
+        if (active_[i]) manage_spawns(levels_[i], refs(i));
+    }
+    for (size_t i = begin; i < end; ++i) {
+        if (active_[i]) update_enemies(enemies_[i]);
+    }
+    for (size_t i = begin; i < end; ++i) {
+        if (active_[i]) step_shots(levels_[i], refs(i));
+    }
+    for (size_t i = begin; i < end; ++i) {
+        if (active_[i]) {
+            SimRefs s = refs(i);
+            collide_player(s);
+            end_tick(s);
+        }
+    }
+}
+
+}  // namespace toppler
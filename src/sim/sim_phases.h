@@ -0,0 +1,44 @@
+#pragma once
+
+// Internal: sim_step broken into its phases so SimBatch can run each phase
+// across many sessions in turn. Not part of the public sim API.
+
+#include "sim/input.h"
+#include "sim/sim_state.h"
+#include "sim/tick_events.h"
+#include "tower/level.h"
+
+namespace toppler::detail {
+
+// The components of one session, wherever they are stored.
+struct SimRefs {
+    SessionState& session;
+    PlayerState& player;
+    ElevatorState& elevators;
+    EnemyLanes& enemies;
+    ShotLanes& shots;
+    SpawnState& spawns;
+    BrokenMask& broken;
+    TickEvents* events = nullptr;  // optional sink
+};
+
+inline SimRefs refs_of(SimState& s) {
+    return SimRefs{s.session, s.player, s.elevators, s.enemies, s.shots, s.spawns, s.broken};
+}
+
+void init_session(const Level& level, uint32_t seed, const SimRefs& s);
+
+// A tick runs: begin_tick, then (while still playing) step_player,
+// manage_spawns, update_enemies, step_shots, collide_player, end_tick.
+// begin_tick returns false if the session has already finished.
+bool begin_tick(const SimRefs& s);
+void step_player(const Level& level, const SimRefs& s, InputMask input);
+void manage_spawns(const Level& level, const SimRefs& s);
+void update_enemies(EnemyLanes& e);
+void step_shots(const Level& level, const SimRefs& s);
+void collide_player(const SimRefs& s);
+void end_tick(const SimRefs& s);
+
+inline bool playing(const SimRefs& s) { return s.session.status == SimStatus::Playing; }
+
+}  // namespace toppler::detail
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "sim/lane_pool.h"
+#include "tower/level.h"
+#include "tower/tower_grid.h"
+
+namespace toppler {
+
+constexpr int kTicksPerSecond = 60;
+
+// Bump whenever a tick can turn out differently for the same inputs, or the
+// SimState layout changes: replays and their keyframes record it.
+constexpr uint32_t kSimVersion = 4;
+
+// Entity capacities. Everything in SimState is a fixed-size array so the
+// whole state is one flat block.
+constexpr int kMaxEnemies = 64;
+constexpr int kMaxShots = 4;
+
+// Collision extents. Angles are in columns ([0, kTowerColumns)), heights in rows.
+constexpr float kPlayerHalfWidth = 0.3f;
+constexpr float kPlayerHeight = 0.9f;
+constexpr float kEnemyHalfWidth = 0.35f;
+constexpr float kEnemyHeight = 0.7f;
+
+enum class PlayerMode : uint8_t {
+    Walking = 0,  // standing on a ledge; height is a whole number
+    Jumping,      // airborne with the take-off momentum
+    Falling,      // walked off an edge, drops straight down
+    Knocked,      // hit by an enemy or spike, thrown back without control
+    Riding,       // standing on an elevator car
+    Tunnel,       // walking through the tower to the far side
+    Drowning,     // fell into the water; waiting to respawn
+};
+
+enum class SimStatus : uint8_t {
+    Playing = 0,
+    Complete,  // reached the exit
+    GameOver,  // out of lives or out of time
+};
+
+struct PlayerState {
+    float angle;   // centre of the player, in columns
+    float height;  // feet
+    float vx;      // columns per tick while airborne
+    float vy;      // rows per tick
+    float checkpoint_angle;
+    float checkpoint_height;
+    PlayerMode mode;
+    int8_t facing;     // -1 left, +1 right
+    uint8_t elevator;  // car being ridden, valid in Riding mode
+    uint8_t reserved;
+    uint16_t timer;    // ticks left in Tunnel / Drowning
+    uint16_t invulnerable;
+    uint16_t crumble_ticks;  // time spent standing on the current crumbling brick
+    uint16_t shot_cooldown;
+    int16_t best_row;  // highest standing height reached, for height score
+    uint16_t reserved2;
+};
+
+// Enemies in structure-of-arrays form, motion is position += velocity with a
+// reflective bounce between lo and hi. Live enemies are packed into lanes
+// [0, pool.count); alive[] mirrors that for the kernels' lane masks.
+struct EnemyLanes {
+    float angle[kMaxEnemies];
+    float height[kMaxEnemies];
+    float vangle[kMaxEnemies];
+    float vheight[kMaxEnemies];
+    float lo[kMaxEnemies];
+    float hi[kMaxEnemies];
+    EnemyKind kind[kMaxEnemies];
+    uint8_t alive[kMaxEnemies];
+    int16_t spawn[kMaxEnemies];  // index of the EnemySpawn that created the lane
+    LanePool<kMaxEnemies> pool;
+};
+
+// The player's shots, packed into lanes [0, pool.count) like enemies.
+struct ShotLanes {
+    float angle[kMaxShots];
+    float height[kMaxShots];
+    float vangle[kMaxShots];
+    uint16_t ttl[kMaxShots];
+    LanePool<kMaxShots> pool;
+};
+
+// Per-session bookkeeping: clock, RNG stream, score and camera.
+struct SessionState {
+    uint32_t tick;
+    uint32_t rng;
+    uint32_t score;
+    uint32_t time_left;  // ticks
+    uint8_t lives;
+    SimStatus status;
+    uint16_t reserved;
+    float tower_angle;  // camera rotation; eases after the player's angle
+    // Zobrist accumulator over the slow-changing parts of the state (broken
+    // bricks, spawn records), kept up to date by the sim; see state_hash.h.
+    uint64_t world_hash;
+};
+
+struct ElevatorState {
+    float pos[kMaxElevators];  // standing height on each car
+};
+
+struct SpawnState {
+    LaneHandle enemy[kMaxSpawns];  // live enemy per spawn point, kNoLane if none
+    uint32_t ready_tick[kMaxSpawns];  // first tick a killed enemy may respawn
+};
+
+// One bit per column per row: bricks that have crumbled away this session.
+struct BrokenMask {
+    uint16_t rows[kMaxTowerRows];
+
+    bool test(int row, int col) const { return (rows[row] >> (col & kTowerColumnMask)) & 1u; }
+};
+
+// Complete simulation state of one tower session. Plain data only: no
+// pointers, no heap, so it can be copied, hashed and stored byte-for-byte.
+// SimBatch keeps the same components in separate per-session arrays.
+struct SimState {
+    SessionState session;
+    PlayerState player;
+    ElevatorState elevators;
+    EnemyLanes enemies;
+    ShotLanes shots;
+    SpawnState spawns;
+    BrokenMask broken;
+};
+static_assert(std::is_trivially_copyable_v<SimState>, "SimState is saved and restored bytewise");
+static_assert(std::is_standard_layout_v<SimState>, "SimState is saved and restored bytewise");
+// SimBatch and the replay keyframes copy components on their own.
+static_assert(std::is_trivially_copyable_v<EnemyLanes> && std::is_trivially_copyable_v<ShotLanes> &&
+                  std::is_trivially_copyable_v<SpawnState> && std::is_trivially_copyable_v<BrokenMask>,
+              "SimState components are copied bytewise");
+
+}  // namespace toppler
@@ -0,0 +1,98 @@
+#include "sim/sim_thread.h"
+
+#include <algorithm>
+
+#include "sim/game_sim.h"
+
+namespace toppler {
+
+SimThread::SimThread(const Level& level, uint32_t seed, TickHook hook)
+    : level_(level), hook_(std::move(hook)) {
+    sim_init(level_, seed, state_);
+    thread_ = std::thread([this] { run(); });
+}
+
+SimThread::~SimThread() {
+    stop_.store(true, std::memory_order_relaxed);
+    thread_.join();
+}
+
+void SimThread::set_input(InputMask held) {
+    held_.store(held, std::memory_order_relaxed);
+    latched_.fetch_or(held, std::memory_order_relaxed);
+}
+
+const SimSnapshot* SimThread::snapshot() {
+    if (snapshots_.update()) have_snapshot_ = true;
+    return have_snapshot_ ? &snapshots_.front() : nullptr;
+}
+
+float SimThread::alpha(const SimSnapshot& snapshot, std::chrono::steady_clock::time_point now) {
+    float a = std::chrono::duration<float>(now - snapshot.time) / std::chrono::duration<float>(kTickPeriod);
+    return std::clamp(a, 0.0f, 1.0f);
+}
+
+bool SimThread::pop_tick_events(FrameArena& arena, TickEvents& out) {
+    TickEventBlock& block = popped_;
+    if (!events_.pop(block)) return false;
+    arena.reset();
+    out.reset(arena);
+    for (int i = 0; i < block.contact_count; ++i) out.contacts.push_back(block.contacts[i]);
+    for (int i = 0; i < block.score_count; ++i) out.scores.push_back(block.scores[i]);
+    for (int i = 0; i < block.brick_count; ++i) out.bricks.push_back(block.bricks[i]);
+    return true;
+}
+
+void SimThread::publish_events(const TickEvents& events, uint32_t tick) {
+    TickEventBlock& block = staged_;
+    block.tick = tick;
+    block.contact_count = static_cast<uint8_t>(std::min<size_t>(events.contacts.size(), TickEventBlock::kMaxContacts));
+    block.score_count = static_cast<uint8_t>(std::min<size_t>(events.scores.size(), TickEventBlock::kMaxScores));
+    block.brick_count = static_cast<uint8_t>(std::min<size_t>(events.bricks.size(), TickEventBlock::kMaxBricks));
+    std::copy_n(events.contacts.begin(), block.contact_count, block.contacts);
+    std::copy_n(events.scores.begin(), block.score_count, block.scores);
+    std::copy_n(events.bricks.begin(), block.brick_count, block.bricks);
+    if (!events_.push(block)) dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SimThread::run() {
+    using clock = std::chrono::steady_clock;
+    FrameArena arena;
+    TickEvents events;
+
+    auto next = clock::now();
+    SimSnapshot& first = snapshots_.back();
+    first.previous = first.current = state_;
+    first.time = next;
+    snapshots_.publish();
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+        next += kTickPeriod;
+        std::this_thread::sleep_until(next);
+        auto now = clock::now();
+        if (now - next > kTickPeriod * kMaxCatchUpTicks) {
+            skipped_.fetch_add(static_cast<uint64_t>((now - next) / kTickPeriod), std::memory_order_relaxed);
+            next = now;
+        }
+
+        InputMask input = held_.load(std::memory_order_relaxed) | latched_.exchange(0, std::memory_order_relaxed);
+        SimSnapshot& snap = snapshots_.back();
+        snap.previous = state_;
+        arena.reset();
+        events.reset(arena);
+        sim_step(level_, state_, input, &events);
+        snap.current = state_;
+        snap.time = next;
+        snapshots_.publish();
+        publish_events(events, state_.session.tick);
+        if (hook_) hook_(events, state_);
+        ticks_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SimThreadStats SimThread::stats() const {
+    return SimThreadStats{ticks_.load(std::memory_order_relaxed), skipped_.load(std::memory_order_relaxed),
+                          dropped_.load(std::memory_order_relaxed)};
+}
+
+}  // namespace toppler
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "core/arena.h"
+#include "core/spsc_ring.h"
+#include "core/triple_buffer.h"
+#include "sim/input.h"
+#include "sim/sim_state.h"
+#include "sim/tick_events.h"
+#include "tower/level.h"
+
+namespace toppler {
+
+// The last two ticks, as one immutable unit: presentation draws
+// interpolate_state(previous, current, alpha) with alpha from
+// SimThread::alpha(), i.e. one tick behind the sim, so any display rate
+// gets smooth motion without the sim rate changing.
+struct SimSnapshot {
+    SimState previous;
+    SimState current;
+    std::chrono::steady_clock::time_point time;  // when `current` was due
+};
+
+// One tick's events as a single ring entry, so the reader never sees half a
+// tick. Capped: effects are cosmetic and a tick that overflows these just
+// loses the extra popups.
+struct TickEventBlock {
+    static constexpr int kMaxContacts = 16;
+    static constexpr int kMaxScores = 8;
+    static constexpr int kMaxBricks = 16;
+
+    uint32_t tick;
+    uint8_t contact_count;
+    uint8_t score_count;
+    uint8_t brick_count;
+    Contact contacts[kMaxContacts];
+    ScoreEvent scores[kMaxScores];
+    BrickEvent bricks[kMaxBricks];
+};
+
+struct SimThreadStats {
+    uint64_t ticks;
+    uint64_t skipped_ticks;   // dropped after a stall rather than replayed in a burst
+    uint64_t dropped_events;  // event blocks the reader had not drained in time
+};
+
+// Runs a GameSim at exactly kTicksPerSecond on its own thread, decoupled
+// from the display. The display thread:
+//
+//   sim.set_input(poll_input());
+//   while (sim.pop_tick_events(arena, events)) renderer.add_events(events);
+//   if (const SimSnapshot* s = sim.snapshot()) {
+//       interpolate_state(s->previous, s->current, sim.alpha(*s, now), frame);
+//       renderer.render(level, frame);
+//   }
+//
+// Snapshots travel through a TripleBuffer and tick events through an
+// SpscRing, so neither thread ever waits on the other: a slow frame skips
+// snapshots, a slow tick repeats the last one.
+class SimThread {
+public:
+    // Called on the sim thread after every tick (sounds, net). Must not block.
+    using TickHook = std::function<void(const TickEvents&, const SimState&)>;
+
+    SimThread(const Level& level, uint32_t seed, TickHook hook = {});
+    // Stops after the tick in progress and joins.
+    ~SimThread();
+
+    SimThread(const SimThread&) = delete;
+    SimThread& operator=(const SimThread&) = delete;
+
+    // Input for the coming ticks. Presses are latched until a tick has seen
+    // them, so a tap shorter than a tick is never lost.
+    void set_input(InputMask held);
+
+    // --- display thread -----------------------------------------------------
+    // Newest snapshot, stable until the next call; nullptr before the first
+    // tick.
+    const SimSnapshot* snapshot();
+    // Fraction of the way from snapshot.previous to snapshot.current to draw
+    // at `now`, in [0, 1].
+    static float alpha(const SimSnapshot& snapshot, std::chrono::steady_clock::time_point now);
+    // Next undrained tick's events, rebuilt in `arena` (which this resets).
+    // False when the reader has caught up.
+    bool pop_tick_events(FrameArena& arena, TickEvents& out);
+
+    SimThreadStats stats() const;
+
+    static constexpr std::chrono::nanoseconds kTickPeriod{1000000000 / kTicksPerSecond};
+    // After a stall longer than this the clock jumps forward instead of
+    // running the missed ticks back to back.
+    static constexpr int kMaxCatchUpTicks = 5;
+
+private:
+    void run();
+    void publish_events(const TickEvents& events, uint32_t tick);
+
+    Level level_;
+    SimState state_;
+    TickHook hook_;
+    TripleBuffer<SimSnapshot> snapshots_;
+    SpscRing<TickEventBlock, 128> events_;
+    TickEventBlock staged_;  // sim thread
+    TickEventBlock popped_;  // display thread
+    bool have_snapshot_ = false;  // display thread
+    std::atomic<InputMask> held_{0};
+    std::atomic<InputMask> latched_{0};
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> ticks_{0};
+    std::atomic<uint64_t> skipped_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::thread thread_;
+};
+
+}  // namespace toppler
@@ -0,0 +1,345 @@
+#include "sim/sub_stage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "core/rng.h"
+#include "sim/state_hash.h"
+
+namespace toppler {
+
+namespace {
+
+// Tuning. Binary fractions, as in the tower sim, so positions stay exact.
+constexpr float kBaseScroll = 1.0f / 16.0f;  // rows per tick, stage 1
+constexpr float kScrollPerStage = 1.0f / 256.0f;
+constexpr float kMaxScroll = 1.0f / 8.0f;
+constexpr float kSubMove = 3.0f / 32.0f;
+constexpr float kSubDrift = 1.0f / 32.0f;  // pushed back while stunned
+constexpr float kSubMinX = 1.0f;
+constexpr float kSubMaxX = 12.0f;
+constexpr float kSubHalfWidth = 1.0f;
+constexpr float kSubHalfHeight = 0.5f;
+constexpr float kFishHalfWidth = 0.4f;
+constexpr float kFishHalfHeight = 0.25f;
+constexpr float kTorpedoSpeed = 1.0f / 4.0f;
+constexpr float kTorpedoHalfHeight = 0.1f;
+constexpr float kBobSpeed = 1.0f / 64.0f;
+constexpr float kBobRange = 1.0f;
+
+constexpr uint16_t kStunTicks = 45;
+constexpr uint16_t kTorpedoCooldown = 15;
+constexpr uint16_t kDefaultTimeLimit = 40;
+
+constexpr int kWallStep = 4;  // slices between the random points cave walls are drawn through
+constexpr int kWallVariation = 3 * kSubSubrow;
+constexpr int kFishMargin = kSubSubrow;  // fish spawn this far inside the walls
+
+constexpr uint32_t kStageTag = 0x42535454;  // "TTSB"
+
+uint32_t hash2(uint32_t a, uint32_t b) {
+    uint32_t h = a * 0x9e3779b1u ^ (b + 0x7f4a7c15u);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    return h ^ (h >> 16);
+}
+
+float scroll_speed(const SubStage& stage) {
+    return std::min(kMaxScroll, kBaseScroll + static_cast<float>(stage.number - 1) * kScrollPerStage);
+}
+
+// Wall height in eighths at global slice `s`: a line through a random point
+// every kWallStep slices, so the cave is continuous across segments without
+// a segment needing its neighbour.
+int wall_at(uint32_t seed, uint32_t salt, uint32_t s) {
+    uint32_t g = s / kWallStep, t = s % kWallStep;
+    int a = static_cast<int>(hash2(seed ^ salt, g) % (kWallVariation + 1));
+    int b = static_cast<int>(hash2(seed ^ salt, g + 1) % (kWallVariation + 1));
+    return (a * static_cast<int>(kWallStep - t) + b * static_cast<int>(t)) / kWallStep;
+}
+
+void generate_segment(const SubStage& stage, uint32_t world_seed, uint32_t index, SubSegment& seg) {
+    std::memset(&seg, 0, sizeof seg);
+    seg.index = index;
+    for (int k = 0; k < kSubSegmentSlices; ++k) {
+        uint32_t s = index * kSubSegmentSlices + static_cast<uint32_t>(k);
+        seg.floor[k] = static_cast<uint8_t>(wall_at(world_seed, 0x1u, s));
+        seg.ceiling[k] = static_cast<uint8_t>(kSubDepth * kSubSubrow - wall_at(world_seed, 0x2u, s));
+    }
+    if (index == 0) return;  // open water to start in
+
+    uint32_t rng = rng_seed(hash2(world_seed, index | 0x80000000u));
+    uint32_t extra = std::min<uint32_t>(stage.number / 3u, 2u);
+    seg.fish_count = static_cast<uint8_t>(std::min<uint32_t>(kSubSegmentFish, 2 + extra + rng_below(rng, 3)));
+    for (int i = 0; i < seg.fish_count; ++i) {
+        FishSpawn& f = seg.fish[i];
+        f.slice = static_cast<uint8_t>(rng_below(rng, kSubSegmentSlices));
+        int lo = seg.floor[f.slice] + kFishMargin, hi = seg.ceiling[f.slice] - kFishMargin;
+        f.y = static_cast<uint8_t>(lo + static_cast<int>(rng_below(rng, static_cast<uint32_t>(hi - lo + 1))));
+        uint32_t roll = rng_below(rng, 10) + std::min<uint32_t>(stage.number / 4u, 2u);
+        f.kind = roll < 5 ? FishKind::Minnow : roll < 8 ? FishKind::Bobber : FishKind::Darter;
+    }
+    std::sort(seg.fish, seg.fish + seg.fish_count,
+              [](const FishSpawn& a, const FishSpawn& b) { return a.slice < b.slice; });
+}
+
+const SubSegment& segment_at(const SubState& s, float x) {
+    uint32_t slice = static_cast<uint32_t>(std::max(x, 0.0f));
+    return s.ring[(slice / kSubSegmentSlices) % kSubRingSegments];
+}
+
+int slice_of(float x) { return static_cast<int>(std::max(x, 0.0f)) % kSubSegmentSlices; }
+
+// Drops segments that have scrolled off the left for the ones coming up.
+void advance_ring(const SubStage& stage, SubState& s) {
+    while (static_cast<float>((s.first_segment + 1u) * kSubSegmentSlices) < s.scroll - 1.0f) {
+        uint32_t next = s.first_segment + kSubRingSegments;
+        generate_segment(stage, s.session.world_seed, next, s.ring[next % kSubRingSegments]);
+        ++s.first_segment;
+    }
+}
+
+void spawn_fish(SubState& s) {
+    float edge = s.scroll + static_cast<float>(kSubViewWidth) + 1.0f;
+    FishLanes& fish = s.fish;
+    for (SubSegment& seg : s.ring) {
+        float x0 = static_cast<float>(seg.index * kSubSegmentSlices);
+        for (; seg.next_fish < seg.fish_count; ++seg.next_fish) {
+            const FishSpawn& f = seg.fish[seg.next_fish];
+            float x = x0 + static_cast<float>(f.slice) + 0.5f;
+            if (x > edge) break;
+            if (fish.pool.full()) continue;  // the pool is the cap: this one never appears
+            int i = fish.pool.acquire();
+            fish.x[i] = x;
+            fish.y[i] = static_cast<float>(f.y) / kSubSubrow;
+            fish.kind[i] = f.kind;
+            fish.vy[i] = 0.0f;
+            fish.lo[i] = fish.hi[i] = fish.y[i];
+            switch (f.kind) {
+                case FishKind::Minnow:
+                    fish.vx[i] = -1.0f / 32.0f;
+                    break;
+                case FishKind::Bobber:
+                    fish.vx[i] = -1.0f / 64.0f;
+                    fish.vy[i] = kBobSpeed;
+                    fish.lo[i] = fish.y[i] - kBobRange;
+                    fish.hi[i] = fish.y[i] + kBobRange;
+                    break;
+                case FishKind::Darter:
+                case FishKind::kCount:
+                    fish.vx[i] = -1.0f / 8.0f;
+                    break;
+            }
+        }
+    }
+}
+
+void remove_fish(FishLanes& fish, int lane) {
+    int moved = fish.pool.release(lane);
+    if (moved < 0) return;
+    fish.x[lane] = fish.x[moved];
+    fish.y[lane] = fish.y[moved];
+    fish.vx[lane] = fish.vx[moved];
+    fish.vy[lane] = fish.vy[moved];
+    fish.lo[lane] = fish.lo[moved];
+    fish.hi[lane] = fish.hi[moved];
+    fish.kind[lane] = fish.kind[moved];
+}
+
+void remove_torpedo(TorpedoLanes& t, int lane) {
+    int moved = t.pool.release(lane);
+    if (moved < 0) return;
+    t.x[lane] = t.x[moved];
+    t.y[lane] = t.y[moved];
+}
+
+bool in_cave(const SubState& s, float x, float y, float half_height) {
+    return y - half_height >= sub_floor(s, x) && y + half_height <= sub_ceiling(s, x);
+}
+
+void step_sub(SubState& s, InputMask input) {
+    SubPlayer& p = s.sub;
+    if (p.cooldown) --p.cooldown;
+    if (p.stunned) {
+        --p.stunned;
+        p.x = std::max(kSubMinX, p.x - kSubDrift);
+    } else {
+        int dx = ((input & kInputRight) ? 1 : 0) - ((input & kInputLeft) ? 1 : 0);
+        int dy = ((input & kInputUp) ? 1 : 0) - ((input & kInputDown) ? 1 : 0);
+        p.x = std::clamp(p.x + static_cast<float>(dx) * kSubMove, kSubMinX, kSubMaxX);
+        p.y += static_cast<float>(dy) * kSubMove;
+    }
+
+    // Keep the hull inside the cave under its whole length.
+    float x = s.scroll + p.x;
+    float lo = 0.0f, hi = static_cast<float>(kSubDepth);
+    for (float at : {x - kSubHalfWidth, x, x + kSubHalfWidth}) {
+        lo = std::max(lo, sub_floor(s, at));
+        hi = std::min(hi, sub_ceiling(s, at));
+    }
+    lo += kSubHalfHeight;
+    hi -= kSubHalfHeight;
+    p.y = lo <= hi ? std::clamp(p.y, lo, hi) : (lo + hi) * 0.5f;
+
+    TorpedoLanes& t = s.torpedoes;
+    if ((input & kInputFire) && !p.stunned && p.cooldown == 0 && !t.pool.full()) {
+        int i = t.pool.acquire();
+        t.x[i] = x + kSubHalfWidth;
+        t.y[i] = p.y;
+        p.cooldown = kTorpedoCooldown;
+    }
+}
+
+void step_torpedoes(SubState& s) {
+    TorpedoLanes& t = s.torpedoes;
+    float edge = s.scroll + static_cast<float>(kSubViewWidth) + 1.0f;
+    for (int i = 0; i < t.pool.count;) {
+        t.x[i] += kTorpedoSpeed;
+        if (t.x[i] > edge || !in_cave(s, t.x[i], t.y[i], kTorpedoHalfHeight)) {
+            remove_torpedo(t, i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void step_fish(SubState& s) {
+    FishLanes& f = s.fish;
+    int n = f.pool.count;
+    for (int i = 0; i < n; ++i) {
+        f.x[i] += f.vx[i];
+        float y = f.y[i] + f.vy[i];
+        if (y > f.hi[i] || y < f.lo[i]) {
+            f.vy[i] = -f.vy[i];
+            y = f.y[i] + f.vy[i];
+        }
+        f.y[i] = y;
+    }
+    float gone = s.scroll - 1.0f;
+    for (int i = 0; i < f.pool.count;) {
+        if (f.x[i] < gone) {
+            remove_fish(f, i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void collide(SubState& s) {
+    FishLanes& f = s.fish;
+    TorpedoLanes& t = s.torpedoes;
+    for (int j = 0; j < t.pool.count;) {
+        bool hit = false;
+        for (int i = 0; i < f.pool.count; ++i) {
+            if (std::abs(f.x[i] - t.x[j]) <= kFishHalfWidth &&
+                std::abs(f.y[i] - t.y[j]) <= kFishHalfHeight + kTorpedoHalfHeight) {
+                s.session.score += fish_value(f.kind[i]);
+                ++s.session.fish_shot;
+                remove_fish(f, i);
+                hit = true;
+                break;
+            }
+        }
+        if (hit) {
+            remove_torpedo(t, j);
+        } else {
+            ++j;
+        }
+    }
+
+    if (s.sub.stunned) return;
+    float x = s.scroll + s.sub.x;
+    for (int i = 0; i < f.pool.count; ++i) {
+        if (std::abs(f.x[i] - x) <= kSubHalfWidth + kFishHalfWidth &&
+            std::abs(f.y[i] - s.sub.y) <= kSubHalfHeight + kFishHalfHeight) {
+            s.sub.stunned = kStunTicks;
+            ++s.session.hits;
+            remove_fish(f, i);
+            return;
+        }
+    }
+}
+
+}  // namespace
+
+SubStage sub_stage_after(int tower_number) {
+    SubStage stage;
+    stage.number = static_cast<uint16_t>(std::clamp(tower_number, 1, 0xffff));
+    return stage;
+}
+
+uint64_t sub_stage_fingerprint(const SubStage& stage) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    uint32_t words[] = {kStageTag, stage.number, stage.time_limit};
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(words);
+    for (size_t i = 0; i < sizeof words; ++i) h = (h ^ p[i]) * 0x100000001b3ull;
+    return h;
+}
+
+uint32_t fish_value(FishKind kind) {
+    switch (kind) {
+        case FishKind::Minnow:
+            return 50;
+        case FishKind::Bobber:
+            return 100;
+        case FishKind::Darter:
+        case FishKind::kCount:
+            return 200;
+    }
+    return 0;
+}
+
+float sub_floor(const SubState& state, float x) {
+    return static_cast<float>(segment_at(state, x).floor[slice_of(x)]) / kSubSubrow;
+}
+
+float sub_ceiling(const SubState& state, float x) {
+    return static_cast<float>(segment_at(state, x).ceiling[slice_of(x)]) / kSubSubrow;
+}
+
+void sub_init(const SubStage& stage, uint32_t seed, SubState& state) {
+    std::memset(&state, 0, sizeof state);  // padding too, so equal states hash equal
+    SubSession& session = state.session;
+    session.world_seed = hash2(rng_seed(seed), stage.number);
+    session.time_left = static_cast<uint32_t>(stage.time_limit ? stage.time_limit : kDefaultTimeLimit) *
+                        kTicksPerSecond;
+    session.status = SimStatus::Playing;
+    state.sub.x = 3.0f;
+    state.sub.y = kSubDepth * 0.5f;
+    for (uint32_t i = 0; i < kSubRingSegments; ++i) generate_segment(stage, session.world_seed, i, state.ring[i]);
+    state.fish.pool.init();
+    state.torpedoes.pool.init();
+}
+
+void sub_step(const SubStage& stage, SubState& state, InputMask input) {
+    if (state.session.status != SimStatus::Playing) return;
+    ++state.session.tick;
+    state.scroll += scroll_speed(stage);
+    advance_ring(stage, state);
+    spawn_fish(state);
+    step_sub(state, input);
+    step_torpedoes(state);
+    step_fish(state);
+    collide(state);
+    if (--state.session.time_left == 0) state.session.status = SimStatus::Complete;
+}
+
+uint64_t sub_state_hash(const SubState& state) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(&state);
+    uint64_t h = 0x9e3779b97f4a7c15ull;
+    size_t i = 0;
+    for (; i + 8 <= sizeof(SubState); i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = detail::absorb(h, w);
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p + i, sizeof(SubState) - i);
+    h = detail::absorb(h, tail);
+    return h ^ (h >> 32);
+}
+
+}  // namespace toppler
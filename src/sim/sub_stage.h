@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "sim/input.h"
+#include "sim/lane_pool.h"
+#include "sim/sim_state.h"
+
+namespace toppler {
+
+// The submarine bonus stage played between towers: the sub cruises right
+// through an undersea cave and torpedoes fish for points until the clock
+// runs out. Headless and fixed-timestep like the tower sim, and shares its
+// kSimVersion: a tick is a pure function of (stage, state, input).
+//
+// The stage has no level data. The world is generated segment by segment
+// from the session seed as the view scrolls, into a small ring of segments
+// that always covers the view: a segment that has scrolled off the left is
+// regenerated in place as the next one ahead. Fish come from a fixed lane
+// pool like the tower's enemies. So SubState is one flat block whatever the
+// stage length, and a tick neither allocates nor touches more than the
+// live fish and torpedoes.
+//
+// Units: x and y in rows; y = 0 is the seabed, kSubDepth the surface.
+
+constexpr int kSubDepth = 12;
+constexpr int kSubViewWidth = 20;       // rows of world across the screen
+constexpr int kSubSegmentSlices = 16;   // one slice per row of x
+constexpr int kSubRingSegments = 4;     // enough to cover the view plus the next segment
+constexpr int kSubSegmentFish = 6;
+constexpr int kMaxFish = 32;
+constexpr int kMaxTorpedoes = 4;
+constexpr int kSubSubrow = 8;           // cave walls are stored in eighths of a row
+
+static_assert(kSubRingSegments * kSubSegmentSlices >= kSubViewWidth + 2 * kSubSegmentSlices,
+              "the ring must keep the view covered while a segment is regenerated");
+
+// Which stage this is. Later stages scroll faster and hold more fish.
+struct SubStage {
+    uint16_t number = 1;       // the stage after tower `number`
+    uint16_t time_limit = 40;  // seconds; the stage ends when the clock runs out
+};
+
+// The stage played after tower `tower_number` of a campaign.
+SubStage sub_stage_after(int tower_number);
+
+// Names the stage in replays (Replay::tower_id), the way level_fingerprint
+// names a tower.
+uint64_t sub_stage_fingerprint(const SubStage& stage);
+
+enum class FishKind : uint8_t {
+    Minnow = 0,  // swims straight at the sub
+    Bobber,      // slow, bobbing up and down
+    Darter,      // fast and worth the most
+    kCount
+};
+
+struct FishSpawn {
+    uint8_t slice;  // within the segment
+    uint8_t y;      // centre, in eighths of a row
+    FishKind kind;
+    uint8_t reserved;
+};
+
+// One generated stretch of cave: x in [index, index + 1) * kSubSegmentSlices.
+struct SubSegment {
+    uint32_t index;
+    uint8_t floor[kSubSegmentSlices];    // per slice, in eighths of a row
+    uint8_t ceiling[kSubSegmentSlices];
+    uint8_t fish_count;
+    uint8_t next_fish;  // fish[0, next_fish) have been spawned
+    uint16_t reserved;
+    FishSpawn fish[kSubSegmentFish];  // ascending slice
+};
+
+// Fish in structure-of-arrays lanes [0, pool.count), like EnemyLanes.
+// Bobbers bounce between lo and hi; the rest keep vy == 0.
+struct FishLanes {
+    float x[kMaxFish];
+    float y[kMaxFish];
+    float vx[kMaxFish];
+    float vy[kMaxFish];
+    float lo[kMaxFish];
+    float hi[kMaxFish];
+    FishKind kind[kMaxFish];
+    LanePool<kMaxFish> pool;
+};
+
+struct TorpedoLanes {
+    float x[kMaxTorpedoes];
+    float y[kMaxTorpedoes];
+    LanePool<kMaxTorpedoes> pool;
+};
+
+struct SubSession {
+    uint32_t tick;
+    uint32_t world_seed;  // segments are a function of this and their index
+    uint32_t score;
+    uint32_t time_left;   // ticks
+    uint32_t fish_shot;
+    uint16_t hits;        // fish that rammed the sub
+    SimStatus status;     // Playing, then Complete when time runs out
+    uint8_t reserved;
+};
+
+struct SubPlayer {
+    float x;  // from the left edge of the view
+    float y;
+    uint16_t stunned;  // ticks left without control after being rammed
+    uint16_t cooldown;
+};
+
+// Complete state of one submarine stage session. Plain data like SimState.
+struct SubState {
+    SubSession session;
+    SubPlayer sub;
+    float scroll;            // world x at the left edge of the view
+    uint32_t first_segment;  // index of the oldest segment in the ring
+    SubSegment ring[kSubRingSegments];  // segment i lives in ring[i % kSubRingSegments]
+    FishLanes fish;
+    TorpedoLanes torpedoes;
+};
+static_assert(std::is_trivially_copyable_v<SubState>, "SubState is saved and restored bytewise");
+static_assert(std::is_standard_layout_v<SubState>, "SubState is saved and restored bytewise");
+
+// Puts `state` at the start of `stage`.
+void sub_init(const SubStage& stage, uint32_t seed, SubState& state);
+
+// Advances `state` by exactly one tick. Up / Down / Left / Right steer,
+// Fire launches a torpedo.
+void sub_step(const SubStage& stage, SubState& state, InputMask input);
+
+// Cave walls at world x as the session currently has them generated; x must
+// lie within the ring (roughly the view). In rows.
+float sub_floor(const SubState& state, float x);
+float sub_ceiling(const SubState& state, float x);
+
+// Points for torpedoing one fish of `kind`.
+uint32_t fish_value(FishKind kind);
+
+// 64-bit hash of the whole state, for desync checks (see state_hash()).
+uint64_t sub_state_hash(const SubState& state);
+
+}  // namespace toppler
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+#include "core/arena.h"
+#include "sim/lane_pool.h"
+#include "tower/tower_grid.h"
+
+namespace toppler {
+
+// What happened during one tick, for presentation (score popups, brick
+// debris, hit effects) and tools. The sim writes these only when the caller
+// passes a sink; nothing in SimState depends on them. Lists live in a
+// FrameArena, so a frame loop looks like:
+//
+//   arena.reset();
+//   events.reset(arena);
+//   sim_step(level, state, input, &events);
+
+enum class ContactKind : uint8_t {
+    PlayerEnemy = 0,  // player knocked by an enemy
+    ShotEnemy,        // shot hit an enemy (killed unless it is a bouncer)
+    ShotWall,         // shot stopped by a wall
+};
+
+struct Contact {
+    ContactKind kind;
+    LaneHandle enemy;  // the enemy hit (stale if it died), kNoLane for walls
+    float angle;
+    float height;
+};
+
+struct ScoreEvent {
+    float angle;
+    float height;
+    uint32_t points;
+};
+
+struct BrickEvent {
+    int16_t row;
+    uint8_t column;
+    Tile tile;  // what was there before it broke
+};
+
+struct TickEvents {
+    ArenaVector<Contact> contacts;
+    ArenaVector<ScoreEvent> scores;
+    ArenaVector<BrickEvent> bricks;
+
+    // Empties the lists and points them at `arena`; call after arena.reset().
+    void reset(FrameArena& arena) {
+        contacts = ArenaVector<Contact>(arena);
+        scores = ArenaVector<ScoreEvent>(arena);
+        bricks = ArenaVector<BrickEvent>(arena);
+    }
+};
+
+}  // namespace toppler
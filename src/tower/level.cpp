@@ -0,0 +1,68 @@
+#include "tower/level.h"
+
+#include <algorithm>
+
+namespace toppler {
+
+namespace {
+
+[[noreturn]] void fail(const std::string& what) { throw LevelError("invalid level: " + what); }
+
+}  // namespace
+
+void validate_level(const Level& level) {
+    const TowerGridView& grid = level.grid;
+    if (grid.rows < 2 || grid.rows > kMaxTowerRows) fail("row count out of range");
+    if (!grid.tiles) fail("missing tiles");
+    for (size_t i = 0; i < grid.size_bytes(); ++i) {
+        if (!is_valid_tile(static_cast<uint8_t>(grid.tiles[i]))) fail("unknown tile code");
+    }
+    if (level.elevator_count > static_cast<uint32_t>(kMaxElevators)) fail("too many elevators");
+    for (uint32_t i = 0; i < level.elevator_count; ++i) {
+        const ElevatorDef& e = level.elevators[i];
+        if (e.column >= kTowerColumns) fail("elevator column out of range");
+        if (e.bottom > e.top || e.top >= grid.rows) fail("elevator travel out of range");
+    }
+    if (level.spawn_count > static_cast<uint32_t>(kMaxSpawns)) fail("too many spawns");
+    for (uint32_t i = 0; i < level.spawn_count; ++i) {
+        const EnemySpawn& s = level.spawns[i];
+        if (s.column >= kTowerColumns || s.row >= grid.rows) fail("spawn position out of range");
+        if (static_cast<uint8_t>(s.kind) >= static_cast<uint8_t>(EnemyKind::kCount)) fail("unknown enemy kind");
+        if (i > 0 && s.row < level.spawns[i - 1].row) fail("spawns not sorted by row");
+    }
+    if (level.start_row < 1 || level.start_row >= grid.rows || level.start_column >= kTowerColumns) {
+        fail("start position out of range");
+    }
+}
+
+SpawnRange spawns_in_rows(const Level& level, int lo_row, int hi_row) {
+    const EnemySpawn* begin = level.spawns;
+    const EnemySpawn* end = level.spawns + level.spawn_count;
+    const EnemySpawn* lo = std::lower_bound(begin, end, lo_row,
+                                            [](const EnemySpawn& s, int row) { return s.row < row; });
+    const EnemySpawn* hi = std::upper_bound(lo, end, hi_row,
+                                            [](int row, const EnemySpawn& s) { return row < s.row; });
+    return SpawnRange{static_cast<uint32_t>(lo - begin), static_cast<uint32_t>(hi - begin)};
+}
+
+void sort_spawns(std::vector<EnemySpawn>& spawns) {
+    std::stable_sort(spawns.begin(), spawns.end(),
+                     [](const EnemySpawn& a, const EnemySpawn& b) { return a.row < b.row; });
+}
+
+uint64_t level_fingerprint(const Level& level) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    auto mix = [&h](const void* data, size_t bytes) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < bytes; ++i) h = (h ^ p[i]) * 0x100000001b3ull;
+    };
+    uint32_t header[] = {static_cast<uint32_t>(level.grid.rows), level.elevator_count, level.spawn_count,
+                         level.time_limit, level.start_row, level.start_column};
+    mix(header, sizeof header);
+    mix(level.grid.tiles, level.grid.size_bytes());
+    mix(level.elevators, level.elevator_count * sizeof(ElevatorDef));
+    mix(level.spawns, level.spawn_count * sizeof(EnemySpawn));
+    return h;
+}
+
+}  // namespace toppler
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tower/tower_grid.h"
+
+namespace toppler {
+
+// Upper bounds per tower; the sim keeps state for each in fixed arrays.
+constexpr int kMaxElevators = 16;
+constexpr int kMaxSpawns = 256;
+
+enum class EnemyKind : uint8_t {
+    Ball = 0,  // rolls around the tower, hopping on its ledge
+    Eye,       // drifts around the tower bobbing up and down
+    Bouncer,   // bounces straight up and down one column
+    kCount
+};
+
+// A lift car that travels one column between two standing heights.
+// Fixed-width fields: level packs store these verbatim.
+struct ElevatorDef {
+    uint8_t column = 0;
+    uint8_t reserved = 0;
+    uint16_t bottom = 0;  // lowest standing height (row above the car's floor)
+    uint16_t top = 0;     // highest standing height
+    uint16_t reserved2 = 0;
+};
+static_assert(sizeof(ElevatorDef) == 8, "ElevatorDef is stored verbatim in packs");
+
+// Where and how often an enemy appears once the player gets near.
+struct EnemySpawn {
+    uint16_t row = 0;      // lowest body row of the enemy
+    uint8_t column = 0;
+    EnemyKind kind = EnemyKind::Ball;
+    uint16_t range = 0;    // vertical travel in rows for Eye / Bouncer
+    uint16_t period = 0;   // ticks before a killed enemy respawns
+};
+static_assert(sizeof(EnemySpawn) == 8, "EnemySpawn is stored verbatim in packs");
+
+// Everything the simulation needs to know about one tower. Non-owning: the
+// arrays point into a LevelData or straight into a mapped level pack.
+//
+// Spawns are sorted by row, which makes them their own spatial index: the
+// spawns within a band of rows are one contiguous range (spawns_in_rows), so
+// per-tick spawn work depends on how crowded the player's surroundings are,
+// not on how tall the tower is.
+struct Level {
+    TowerGridView grid;
+    const ElevatorDef* elevators = nullptr;
+    uint32_t elevator_count = 0;
+    const EnemySpawn* spawns = nullptr;
+    uint32_t spawn_count = 0;
+    uint16_t time_limit = 0;  // seconds
+    uint16_t start_row = 0;   // standing height the player starts at
+    uint8_t start_column = 0;
+};
+
+// Raised for malformed level sources or packs.
+class LevelError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Checks everything the sim and renderer rely on: tile codes, capacities,
+// spawn row order, and that columns / rows referenced by lifts, spawns and
+// the start exist.
+// Throws LevelError naming the first problem.
+void validate_level(const Level& level);
+
+// Index range [begin, end) of the spawns whose row is in [lo_row, hi_row].
+struct SpawnRange {
+    uint32_t begin;
+    uint32_t end;
+};
+SpawnRange spawns_in_rows(const Level& level, int lo_row, int hi_row);
+
+// Puts spawns into the row order validate_level requires, keeping the
+// written order among spawns on the same row.
+void sort_spawns(std::vector<EnemySpawn>& spawns);
+
+// 64-bit FNV-1a over everything that affects play (tiles, lifts, spawns,
+// time limit, start). Replays use it to name the tower they were recorded
+// on, so a replay never runs against an edited tower of the same name.
+uint64_t level_fingerprint(const Level& level);
+
+// Owning storage for a level, e.g. one parsed from text or built in code.
+struct LevelData {
+    std::string name;
+    TowerGrid grid;
+    std::vector<ElevatorDef> elevators;
+    std::vector<EnemySpawn> spawns;
+    uint16_t time_limit = 120;
+    uint16_t start_row = 1;
+    uint8_t start_column = 0;
+
+    Level view() const {
+        Level level;
+        level.grid = grid.view();
+        level.elevators = elevators.data();
+        level.elevator_count = static_cast<uint32_t>(elevators.size());
+        level.spawns = spawns.data();
+        level.spawn_count = static_cast<uint32_t>(spawns.size());
+        level.time_limit = time_limit;
+        level.start_row = start_row;
+        level.start_column = start_column;
+        return level;
+    }
+};
+
+}  // namespace toppler
@@ -0,0 +1,201 @@
+#include "tower/level_pack.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace toppler {
+
+namespace {
+
+size_t align_up(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+template <class T>
+void put(std::vector<uint8_t>& out, size_t at, const T& value) {
+    std::memcpy(out.data() + at, &value, sizeof value);
+}
+
+// Checks that [offset, offset + bytes) lies inside a file of `size` bytes.
+bool in_bounds(uint64_t offset, uint64_t bytes, size_t size) {
+    return offset <= size && bytes <= size - offset;
+}
+
+}  // namespace
+
+std::vector<uint8_t> build_level_pack(const std::vector<LevelData>& towers) {
+    if (towers.size() > UINT16_MAX) throw LevelError("level pack: too many towers");
+    for (const LevelData& t : towers) {
+        try {
+            validate_level(t.view());
+        } catch (const LevelError& e) {
+            throw LevelError(t.name + ": " + e.what());
+        }
+        if (t.name.size() > UINT16_MAX) throw LevelError(t.name.substr(0, 32) + "...: name too long");
+    }
+
+    // Lay out the sections first, then fill them in.
+    std::vector<PackEntry> entries(towers.size());
+    size_t at = sizeof(PackHeader) + entries.size() * sizeof(PackEntry);
+    for (size_t i = 0; i < towers.size(); ++i) {
+        const LevelData& t = towers[i];
+        PackEntry& e = entries[i];
+        std::memset(&e, 0, sizeof e);
+        e.name_offset = static_cast<uint32_t>(at);
+        e.name_length = static_cast<uint16_t>(t.name.size());
+        at = align_up(at + t.name.size() + 1, kPackGridAlign);
+        e.grid_offset = static_cast<uint32_t>(at);
+        e.rows = static_cast<uint16_t>(t.grid.rows());
+        at = align_up(at + t.grid.size_bytes(), 8);
+        e.elevators_offset = static_cast<uint32_t>(at);
+        e.elevator_count = static_cast<uint16_t>(t.elevators.size());
+        at += t.elevators.size() * sizeof(ElevatorDef);
+        e.spawns_offset = static_cast<uint32_t>(at);
+        e.spawn_count = static_cast<uint16_t>(t.spawns.size());
+        at = align_up(at + t.spawns.size() * sizeof(EnemySpawn), 8);
+        e.time_limit = t.time_limit;
+        e.start_row = t.start_row;
+        e.start_column = t.start_column;
+        if (at > UINT32_MAX) throw LevelError("level pack: larger than 4 GiB");
+    }
+
+    std::vector<uint8_t> out(at, 0);
+    PackHeader h;
+    std::memset(&h, 0, sizeof h);
+    h.magic = kPackMagic;
+    h.version = kPackVersion;
+    h.entry_size = sizeof(PackEntry);
+    h.tower_count = static_cast<uint32_t>(towers.size());
+    h.entries_offset = sizeof(PackHeader);
+    h.file_size = out.size();
+    put(out, 0, h);
+    for (size_t i = 0; i < towers.size(); ++i) {
+        const LevelData& t = towers[i];
+        const PackEntry& e = entries[i];
+        put(out, sizeof(PackHeader) + i * sizeof(PackEntry), e);
+        std::memcpy(out.data() + e.name_offset, t.name.data(), t.name.size());
+        std::memcpy(out.data() + e.grid_offset, t.grid.row_data(0), t.grid.size_bytes());
+        if (!t.elevators.empty()) {
+            std::memcpy(out.data() + e.elevators_offset, t.elevators.data(),
+                        t.elevators.size() * sizeof(ElevatorDef));
+        }
+        if (!t.spawns.empty()) {
+            std::memcpy(out.data() + e.spawns_offset, t.spawns.data(), t.spawns.size() * sizeof(EnemySpawn));
+        }
+    }
+    return out;
+}
+
+void write_level_pack(const std::string& path, const std::vector<LevelData>& towers) {
+    std::vector<uint8_t> bytes = build_level_pack(towers);
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) throw std::runtime_error(path + ": cannot create");
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) throw std::runtime_error(path + ": write failed");
+}
+
+LevelPack LevelPack::open(const std::string& path) {
+    LevelPack pack;
+    pack.file_ = MappedFile(path);
+    pack.attach(pack.file_.data(), pack.file_.size(), path);
+    return pack;
+}
+
+LevelPack LevelPack::from_bytes(std::vector<uint8_t> bytes) {
+    LevelPack pack;
+    pack.bytes_ = std::move(bytes);
+    pack.attach(pack.bytes_.data(), pack.bytes_.size(), "<memory>");
+    return pack;
+}
+
+void LevelPack::attach(const uint8_t* data, size_t size, const std::string& source) {
+    auto fail = [&](const char* what) { throw LevelError(source + ": " + what); };
+    PackHeader h;
+    if (size < sizeof h) fail("not a level pack (too short)");
+    std::memcpy(&h, data, sizeof h);
+    if (h.magic != kPackMagic) fail("not a level pack (bad magic)");
+    if (h.version != kPackVersion) fail("unsupported level pack version");
+    if (h.entry_size != sizeof(PackEntry)) fail("unexpected directory entry size");
+    if (h.file_size != size) fail("truncated level pack");
+    if (h.entries_offset % alignof(PackEntry) != 0 ||
+        !in_bounds(h.entries_offset, uint64_t{h.tower_count} * sizeof(PackEntry), size)) {
+        fail("directory out of bounds");
+    }
+    data_ = data;
+    size_ = size;
+    count_ = h.tower_count;
+    source_ = source;
+
+    for (size_t i = 0; i < count_; ++i) {
+        const PackEntry& e = entry(i);
+        if (!in_bounds(e.name_offset, uint64_t{e.name_length} + 1, size) ||
+            data[e.name_offset + e.name_length] != 0) {
+            fail("tower name out of bounds");
+        }
+        if (e.rows < 2 || e.rows > kMaxTowerRows ||
+            !in_bounds(e.grid_offset, uint64_t{e.rows} * kTowerColumns, size)) {
+            fail("tower grid out of bounds");
+        }
+        if (e.elevator_count > kMaxElevators || e.elevators_offset % alignof(ElevatorDef) != 0 ||
+            !in_bounds(e.elevators_offset, uint64_t{e.elevator_count} * sizeof(ElevatorDef), size)) {
+            fail("elevator table out of bounds");
+        }
+        if (e.spawn_count > kMaxSpawns || e.spawns_offset % alignof(EnemySpawn) != 0 ||
+            !in_bounds(e.spawns_offset, uint64_t{e.spawn_count} * sizeof(EnemySpawn), size)) {
+            fail("spawn table out of bounds");
+        }
+        if (e.name_offset > e.grid_offset || e.grid_offset > e.elevators_offset ||
+            e.elevators_offset > e.spawns_offset) {
+            fail("tower sections out of order");
+        }
+    }
+}
+
+const PackEntry& LevelPack::entry(size_t i) const {
+    if (i >= count_) throw std::out_of_range("LevelPack: tower index out of range");
+    // entries_offset is aligned (checked at attach) and the mapping is page aligned.
+    uint32_t entries_offset;
+    std::memcpy(&entries_offset, data_ + offsetof(PackHeader, entries_offset), sizeof entries_offset);
+    return reinterpret_cast<const PackEntry*>(data_ + entries_offset)[i];
+}
+
+void LevelPack::advise(size_t i, MappedFile::Advice advice) const {
+    if (!file_.data()) return;
+    // Sections of one tower are contiguous: name, grid, elevators, spawns.
+    const PackEntry& e = entry(i);
+    size_t end = e.spawns_offset + size_t{e.spawn_count} * sizeof(EnemySpawn);
+    file_.advise(e.name_offset, end - e.name_offset, advice);
+}
+
+std::string_view LevelPack::name(size_t i) const {
+    const PackEntry& e = entry(i);
+    return std::string_view(reinterpret_cast<const char*>(data_ + e.name_offset), e.name_length);
+}
+
+int LevelPack::find(std::string_view tower_name) const {
+    for (size_t i = 0; i < count_; ++i) {
+        if (name(i) == tower_name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+Level LevelPack::tower(size_t i) const {
+    const PackEntry& e = entry(i);
+    Level level;
+    level.grid = TowerGridView{reinterpret_cast<const Tile*>(data_ + e.grid_offset), e.rows};
+    level.elevators = reinterpret_cast<const ElevatorDef*>(data_ + e.elevators_offset);
+    level.elevator_count = e.elevator_count;
+    level.spawns = reinterpret_cast<const EnemySpawn*>(data_ + e.spawns_offset);
+    level.spawn_count = e.spawn_count;
+    level.time_limit = e.time_limit;
+    level.start_row = e.start_row;
+    level.start_column = e.start_column;
+    try {
+        validate_level(level);
+    } catch (const LevelError& err) {
+        throw LevelError(source_ + ": tower " + std::to_string(i) + ": " + err.what());
+    }
+    return level;
+}
+
+}  // namespace toppler
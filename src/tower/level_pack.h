@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/mapped_file.h"
+#include "tower/level.h"
+
+namespace toppler {
+
+// Binary level pack (.ttpk): every tower of a campaign or community pack in
+// one file, laid out so the game can mmap it and hand out Level views that
+// point straight into the mapping. Nothing is parsed or copied at load.
+//
+//   PackHeader
+//   PackEntry[tower_count]
+//   per tower: name (NUL-terminated), tile grid (rows * kTowerColumns bytes,
+//              row 0 first), ElevatorDef[], EnemySpawn[]
+//
+// All integers are little-endian. Grids start on a 64-byte boundary so their
+// rows share cache lines the way TowerGrid's do; other sections on 8 bytes.
+// Packs are built from .tower text by the toppler_pack tool.
+
+constexpr uint32_t kPackMagic = 0x4b505454;  // "TTPK"
+constexpr uint16_t kPackVersion = 1;
+constexpr size_t kPackGridAlign = 64;
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "level packs are read in place as little-endian");
+
+struct PackHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;  // sizeof(PackEntry) when written
+    uint32_t tower_count;
+    uint32_t entries_offset;
+    uint64_t file_size;
+    uint64_t reserved;
+};
+static_assert(sizeof(PackHeader) == 32, "PackHeader layout is part of the format");
+
+struct PackEntry {
+    uint32_t name_offset;
+    uint32_t grid_offset;
+    uint32_t elevators_offset;
+    uint32_t spawns_offset;
+    uint16_t name_length;  // excluding the NUL
+    uint16_t rows;
+    uint16_t elevator_count;
+    uint16_t spawn_count;
+    uint16_t time_limit;
+    uint16_t start_row;
+    uint8_t start_column;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(PackEntry) == 32, "PackEntry layout is part of the format");
+
+// Serializes towers into pack bytes. Validates each tower first and throws
+// LevelError on the first bad one.
+std::vector<uint8_t> build_level_pack(const std::vector<LevelData>& towers);
+void write_level_pack(const std::string& path, const std::vector<LevelData>& towers);
+
+// An opened pack. Levels returned by tower() stay valid as long as the pack.
+class LevelPack {
+public:
+    LevelPack() = default;
+
+    // Maps a pack file. Checks the header and directory (every section lies
+    // inside the file, counts within limits); throws LevelError if not.
+    static LevelPack open(const std::string& path);
+    // Same, over bytes already in memory (e.g. just built); takes ownership.
+    static LevelPack from_bytes(std::vector<uint8_t> bytes);
+
+    size_t size() const { return count_; }
+    std::string_view name(size_t i) const;
+    // Index of the tower called `name`, or -1.
+    int find(std::string_view name) const;
+
+    // View of tower i, in place. Its tiles are checked on each call (one pass
+    // over rows * kTowerColumns bytes, which also faults the pages in), so a
+    // corrupt pack cannot hand the sim an unknown tile code.
+    Level tower(size_t i) const;
+
+    // Paging hints for tower i's bytes in a mapped pack (no-op for packs in
+    // memory): start reading it in, or let the OS drop it once a copy is
+    // resident elsewhere.
+    void will_need(size_t i) const { advise(i, MappedFile::Advice::WillNeed); }
+    void dont_need(size_t i) const { advise(i, MappedFile::Advice::DontNeed); }
+
+    const uint8_t* data() const { return data_; }
+    size_t size_bytes() const { return size_; }
+
+private:
+    void attach(const uint8_t* data, size_t size, const std::string& source);
+    const PackEntry& entry(size_t i) const;
+    void advise(size_t i, MappedFile::Advice advice) const;
+
+    MappedFile file_;
+    std::vector<uint8_t> bytes_;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t count_ = 0;
+    std::string source_;
+};
+
+}  // namespace toppler
@@ -0,0 +1,232 @@
+#include "tower/level_text.h"
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace toppler {
+
+namespace {
+
+constexpr std::array<char, static_cast<size_t>(Tile::kCount)> kTileChars = {
+    '.', '=', '~', '-', 'W', 'D', '|', '^', 'E',
+};
+
+constexpr const char* kKindNames[] = {"ball", "eye", "bouncer"};
+static_assert(std::size(kKindNames) == static_cast<size_t>(EnemyKind::kCount), "one name per kind");
+
+int tile_from_char(char c) {
+    for (size_t i = 0; i < kTileChars.size(); ++i) {
+        if (kTileChars[i] == c) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+std::string_view trim(std::string_view s) {
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string_view::npos) return {};
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+std::string_view strip_comment(std::string_view s) {
+    size_t hash = s.find('#');
+    return hash == std::string_view::npos ? s : s.substr(0, hash);
+}
+
+class Parser {
+public:
+    Parser(std::string_view text, const std::string& source) : text_(text), source_(source) {}
+
+    LevelData run() {
+        LevelData level;
+        bool have_name = false;
+        std::string_view line;
+        while (next_line(line)) {
+            std::string_view body = trim(strip_comment(line));
+            if (body.empty()) continue;
+            words_.clear();
+            split(body);
+            const std::string& key = words_[0];
+            if (key == "grid") {
+                expect_args(0);
+                parse_grid(level);
+                if (!have_name) fail("missing 'name'");
+                sort_spawns(level.spawns);
+                Level view = level.view();
+                try {
+                    validate_level(view);
+                } catch (const LevelError& e) {
+                    throw LevelError(source_ + ": " + e.what());
+                }
+                return level;
+            } else if (key == "name") {
+                if (words_.size() < 2) fail("'name' needs a value");
+                level.name = std::string(trim(body.substr(4)));
+                have_name = true;
+            } else if (key == "time") {
+                expect_args(1);
+                level.time_limit = static_cast<uint16_t>(number(1, 1, 65535));
+            } else if (key == "start") {
+                expect_args(2);
+                level.start_row = static_cast<uint16_t>(number(1, 1, kMaxTowerRows - 1));
+                level.start_column = static_cast<uint8_t>(number(2, 0, kTowerColumns - 1));
+            } else if (key == "elevator") {
+                expect_args(3);
+                ElevatorDef e;
+                e.column = static_cast<uint8_t>(number(1, 0, kTowerColumns - 1));
+                e.bottom = static_cast<uint16_t>(number(2, 1, kMaxTowerRows - 1));
+                e.top = static_cast<uint16_t>(number(3, e.bottom, kMaxTowerRows - 1));
+                level.elevators.push_back(e);
+            } else if (key == "spawn") {
+                if (words_.size() < 4 || words_.size() > 6) fail("'spawn' takes kind row column [range [period]]");
+                EnemySpawn s;
+                s.kind = kind(1);
+                s.row = static_cast<uint16_t>(number(2, 0, kMaxTowerRows - 1));
+                s.column = static_cast<uint8_t>(number(3, 0, kTowerColumns - 1));
+                s.range = static_cast<uint16_t>(words_.size() > 4 ? number(4, 0, 65535) : 0);
+                s.period = static_cast<uint16_t>(words_.size() > 5 ? number(5, 0, 65535) : 0);
+                level.spawns.push_back(s);
+            } else {
+                fail("unknown keyword '" + key + "'");
+            }
+        }
+        fail("missing 'grid'");
+    }
+
+private:
+    bool next_line(std::string_view& line) {
+        if (pos_ >= text_.size()) return false;
+        size_t end = text_.find('\n', pos_);
+        if (end == std::string_view::npos) end = text_.size();
+        line = text_.substr(pos_, end - pos_);
+        pos_ = end + 1;
+        ++line_no_;
+        return true;
+    }
+
+    void split(std::string_view s) {
+        size_t i = 0;
+        while (i < s.size()) {
+            while (i < s.size() && (s[i] == ' ' || s[i] == '\t')) ++i;
+            size_t j = i;
+            while (j < s.size() && s[j] != ' ' && s[j] != '\t') ++j;
+            if (j > i) words_.emplace_back(s.substr(i, j - i));
+            i = j;
+        }
+    }
+
+    void expect_args(size_t n) {
+        if (words_.size() != n + 1) {
+            fail("'" + words_[0] + "' takes " + std::to_string(n) + " value(s)");
+        }
+    }
+
+    long number(size_t i, long lo, long hi) {
+        const std::string& w = words_[i];
+        char* end = nullptr;
+        long v = std::strtol(w.c_str(), &end, 10);
+        if (w.empty() || *end != '\0') fail("expected a number, got '" + w + "'");
+        if (v < lo || v > hi) {
+            fail(w + " is out of range [" + std::to_string(lo) + ", " + std::to_string(hi) + "]");
+        }
+        return v;
+    }
+
+    EnemyKind kind(size_t i) {
+        for (size_t k = 0; k < std::size(kKindNames); ++k) {
+            if (words_[i] == kKindNames[k]) return static_cast<EnemyKind>(k);
+        }
+        fail("unknown enemy kind '" + words_[i] + "'");
+    }
+
+    // Grid lines run top row first; anything after the 16 tiles and some
+    // whitespace is a comment.
+    void parse_grid(LevelData& level) {
+        std::vector<std::array<Tile, kTowerColumns>> rows;
+        std::string_view line;
+        while (next_line(line)) {
+            std::string_view body = trim(line);
+            if (body.empty()) continue;
+            if (body.size() < static_cast<size_t>(kTowerColumns) ||
+                (body.size() > static_cast<size_t>(kTowerColumns) && body[kTowerColumns] != ' ' &&
+                 body[kTowerColumns] != '\t')) {
+                fail("grid rows must be exactly " + std::to_string(kTowerColumns) + " tiles");
+            }
+            std::array<Tile, kTowerColumns> row;
+            for (int c = 0; c < kTowerColumns; ++c) {
+                int t = tile_from_char(body[c]);
+                if (t < 0) fail(std::string("unknown tile '") + body[c] + "'");
+                row[c] = static_cast<Tile>(t);
+            }
+            rows.push_back(row);
+            if (rows.size() > static_cast<size_t>(kMaxTowerRows)) fail("tower is too tall");
+        }
+        if (rows.size() < 2) fail("grid needs at least two rows");
+        int n = static_cast<int>(rows.size());
+        level.grid = TowerGrid(n);
+        for (int r = 0; r < n; ++r) {
+            const auto& src = rows[n - 1 - r];
+            std::copy(src.begin(), src.end(), level.grid.row_data(r));
+        }
+    }
+
+    [[noreturn]] void fail(const std::string& what) {
+        throw LevelError(source_ + ":" + std::to_string(line_no_) + ": " + what);
+    }
+
+    std::string_view text_;
+    const std::string& source_;
+    size_t pos_ = 0;
+    int line_no_ = 0;
+    std::vector<std::string> words_;
+};
+
+}  // namespace
+
+char tile_char(Tile tile) {
+    size_t i = static_cast<size_t>(tile);
+    return i < kTileChars.size() ? kTileChars[i] : '?';
+}
+
+LevelData parse_level_text(std::string_view text, const std::string& source) {
+    return Parser(text, source).run();
+}
+
+LevelData load_level_text(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw LevelError(path + ": cannot open");
+    std::ostringstream buf;
+    buf << in.rdbuf();
+    return parse_level_text(buf.str(), path);
+}
+
+std::string format_level_text(const LevelData& level) {
+    std::string out;
+    char line[96];
+    out += "name " + level.name + "\n";
+    std::snprintf(line, sizeof line, "time %u\nstart %u %u\n", level.time_limit, level.start_row,
+                  level.start_column);
+    out += line;
+    for (const ElevatorDef& e : level.elevators) {
+        std::snprintf(line, sizeof line, "elevator %u %u %u\n", e.column, e.bottom, e.top);
+        out += line;
+    }
+    for (const EnemySpawn& s : level.spawns) {
+        std::snprintf(line, sizeof line, "spawn %s %u %u %u %u\n",
+                      kKindNames[static_cast<size_t>(s.kind)], s.row, s.column, s.range, s.period);
+        out += line;
+    }
+    out += "grid\n";
+    for (int r = level.grid.rows() - 1; r >= 0; --r) {
+        const Tile* row = level.grid.row_data(r);
+        for (int c = 0; c < kTowerColumns; ++c) out += tile_char(row[c]);
+        out += '\n';
+    }
+    return out;
+}
+
+}  // namespace toppler
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "tower/level.h"
+
+namespace toppler {
+
+// Human-editable tower source (.tower). Line oriented, '#' starts a comment:
+//
+//   name First Steps
+//   time 150                      # seconds
+//   start 1 0                     # standing height, column
+//   elevator 9 12 31              # column, bottom, top standing heights
+//   spawn ball 6 12 0 300         # kind, row, column, range, respawn ticks
+//   grid
+//   ......E.........              # top row first, 16 tiles per line
+//   ....====........
+//   ================              # row 0
+//
+// Tiles: . empty  = ledge  ~ crumble  - slippery  W wall  D door  | shaft
+//        ^ spike  E exit.  The grid runs to the end of
+// the file; grid lines may only carry comments after the tiles.
+//
+// This is the authoring format; the game loads binary packs built from it
+// (see level_pack.h).
+
+// Parses tower source. `source` names the file in error messages. Throws
+// LevelError with "source:line: ..." on malformed input, and runs
+// validate_level on the result.
+LevelData parse_level_text(std::string_view text, const std::string& source = "<text>");
+
+LevelData load_level_text(const std::string& path);
+
+// Inverse of parse_level_text.
+std::string format_level_text(const LevelData& level);
+
+char tile_char(Tile tile);
+
+}  // namespace toppler
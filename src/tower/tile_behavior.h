@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "tower/tower_grid.h"
+
+namespace toppler {
+
+// What each tile does to the player, as a bitmask per tile code. The sim
+// tests these flags instead of comparing tile codes, so a rule such as "can
+// be stood on" lives in one place and a check costs one byte load from a
+// nine-byte table instead of a switch. A new tile type that is left out of
+// tile_behavior() is a -Wswitch warning, not a tile that silently does
+// nothing.
+using TileFlags = uint8_t;
+
+constexpr TileFlags kTileSupports = 1u << 0;  // can be stood on
+constexpr TileFlags kTileBlocks = 1u << 1;    // stops walking, heads and shots
+constexpr TileFlags kTileCrumbles = 1u << 2;  // falls away after being stood on; reads as Empty once broken
+constexpr TileFlags kTileSlides = 1u << 3;    // keeps the player standing on it sliding
+constexpr TileFlags kTileHurts = 1u << 4;     // knocks a vulnerable player standing on it off
+constexpr TileFlags kTileTunnel = 1u << 5;    // Up walks through to the far side of the tower
+constexpr TileFlags kTileExit = 1u << 6;      // reaching it completes the tower
+
+constexpr TileFlags tile_behavior(Tile t) {
+    switch (t) {
+        case Tile::Empty:
+            return 0;
+        case Tile::Ledge:
+            return kTileSupports;
+        case Tile::Crumble:
+            return kTileSupports | kTileCrumbles;
+        case Tile::Slippery:
+            return kTileSupports | kTileSlides;
+        case Tile::Wall:
+            return kTileSupports | kTileBlocks;
+        case Tile::Door:
+            return kTileTunnel;
+        case Tile::Shaft:
+            return 0;  // support comes from the elevator car, not the tile
+        case Tile::Spike:
+            return kTileSupports | kTileHurts;
+        case Tile::Exit:
+            return kTileExit;
+        case Tile::kCount:
+            break;
+    }
+    return 0;
+}
+
+namespace detail {
+
+constexpr std::array<TileFlags, static_cast<size_t>(Tile::kCount)> make_tile_flags() {
+    std::array<TileFlags, static_cast<size_t>(Tile::kCount)> flags{};
+    for (size_t i = 0; i < flags.size(); ++i) flags[i] = tile_behavior(static_cast<Tile>(i));
+    return flags;
+}
+
+inline constexpr std::array<TileFlags, static_cast<size_t>(Tile::kCount)> kTileFlags = make_tile_flags();
+
+}  // namespace detail
+
+// Table lookup; `t` must be a valid tile (level loading checks every code).
+inline TileFlags tile_flags(Tile t) { return detail::kTileFlags[static_cast<size_t>(t)]; }
+
+}  // namespace toppler
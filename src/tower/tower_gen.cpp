@@ -0,0 +1,165 @@
+#include "tower/tower_gen.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+#include "core/rng.h"
+
+namespace toppler {
+
+namespace {
+
+constexpr int kMinRows = 16;
+constexpr int kSafeRows = 6;  // no enemies this close to the start
+
+// xorshift's first outputs from neighbouring seeds are close; scramble the
+// seed (murmur3's finalizer) so seeds 1, 2, 3 give unrelated towers.
+uint32_t mix_seed(uint32_t seed) {
+    seed ^= seed >> 16;
+    seed *= 0x85ebca6bu;
+    seed ^= seed >> 13;
+    seed *= 0xc2b2ae35u;
+    seed ^= seed >> 16;
+    return rng_seed(seed);
+}
+
+bool chance(uint32_t& rng, float p) { return static_cast<float>(rng_below(rng, 1u << 16)) < p * 65536.0f; }
+
+int between(uint32_t& rng, int lo, int hi) {
+    return lo + static_cast<int>(rng_below(rng, static_cast<uint32_t>(hi - lo + 1)));
+}
+
+int wrap(int col) { return col & kTowerColumnMask; }
+
+// The ledge the route is on: tile row `row`, columns [col, col + len).
+struct Step {
+    int row;
+    int col;
+    int len;
+};
+
+class Builder {
+public:
+    Builder(const TowerGenConfig& config, uint32_t seed) : config_(config), seed_(seed), rng_(mix_seed(seed)) {}
+
+    LevelData build() {
+        char name[24];
+        std::snprintf(name, sizeof name, "Tower %08x", seed_);
+        level_.name = name;
+        level_.grid = TowerGrid(config_.rows);
+        level_.time_limit = config_.time_limit;
+        level_.grid.fill_row(0, 0, kTowerColumns, Tile::Ledge);
+        level_.start_row = 1;
+        level_.start_column = static_cast<uint8_t>(rng_below(rng_, kTowerColumns));
+
+        int top = config_.rows - 2;  // the last step; the exit stands on it
+        Step step{0, level_.start_column, 1};
+        int dir = (rng_next(rng_) & 1) ? 1 : -1;
+        while (step.row < top) {
+            bool room = step.row > 0 && top - step.row >= 5 && level_.elevators.size() < size_t{kMaxElevators};
+            if (room && chance(rng_, config_.lifts)) {
+                step = lift(step, dir, top);
+            }
+            int flight = between(rng_, 4, 12);
+            for (int i = 0; i < flight && step.row < top; ++i) step = climb(step, dir);
+            if (rng_next(rng_) & 1) dir = -dir;
+        }
+
+        // A plain ledge to finish on, with the exit at its leading end.
+        level_.grid.fill_row(step.row, step.col, step.len, Tile::Ledge);
+        level_.grid.set(step.row + 1, wrap(dir > 0 ? step.col + step.len - 1 : step.col), Tile::Exit);
+        sort_spawns(level_.spawns);
+        validate_level(level_.view());
+        return std::move(level_);
+    }
+
+private:
+    // One row up and one to three columns along `dir`. Usually it overlaps
+    // the step below; a short step followed by a long shift leaves a gap
+    // that takes a running jump, or cannot be crossed at all.
+    Step climb(const Step& from, int dir) {
+        Step to;
+        to.row = from.row + 1;
+        to.len = between(rng_, 2, 5);
+        int shift = between(rng_, 1, 3);
+        to.col = wrap(dir > 0 ? from.col + shift : from.col + from.len - shift - to.len);
+
+        Tile kind = Tile::Ledge;
+        if (chance(rng_, config_.crumble)) {
+            kind = Tile::Crumble;
+        } else if (chance(rng_, config_.slippery)) {
+            kind = Tile::Slippery;
+        }
+        level_.grid.fill_row(to.row, to.col, to.len, kind);
+        if (to.len >= 4 && chance(rng_, config_.spikes)) {
+            level_.grid.set(to.row, wrap(dir > 0 ? to.col + to.len - 1 : to.col), Tile::Spike);
+        }
+        place_enemies(to);
+        return to;
+    }
+
+    // A lift in the column just past the step's leading end, riding up to a
+    // ledge level with the top of its travel on the far side of the shaft.
+    Step lift(const Step& from, int dir, int top) {
+        int edge = wrap(dir > 0 ? from.col + from.len - 1 : from.col);
+        if (level_.grid.at(from.row, edge) == Tile::Spike) level_.grid.set(from.row, edge, Tile::Ledge);
+        int column = wrap(edge + dir);
+        int ride = between(rng_, 6, std::min(16, top - from.row + 1));
+        for (int r = from.row; r < from.row + ride; ++r) level_.grid.set(r, column, Tile::Shaft);
+
+        ElevatorDef car;
+        car.column = static_cast<uint8_t>(column);
+        car.bottom = static_cast<uint16_t>(from.row + 1);
+        car.top = static_cast<uint16_t>(from.row + ride);
+        level_.elevators.push_back(car);
+
+        Step to;
+        to.row = from.row + ride - 1;
+        to.len = between(rng_, 3, 5);
+        to.col = wrap(dir > 0 ? column + 1 : column - to.len);
+        level_.grid.fill_row(to.row, to.col, to.len, Tile::Ledge);
+        return to;
+    }
+
+    void place_enemies(const Step& step) {
+        budget_ += config_.enemies / 8.0f;
+        if (step.row < kSafeRows || budget_ < 1.0f || level_.spawns.size() >= size_t{kMaxSpawns}) return;
+        budget_ -= 1.0f;
+
+        EnemySpawn s;
+        s.row = static_cast<uint16_t>(step.row + 1);
+        s.period = static_cast<uint16_t>(between(rng_, 240, 360));
+        uint32_t roll = rng_below(rng_, 10);
+        if (roll < 5) {
+            s.kind = EnemyKind::Ball;
+            s.column = static_cast<uint8_t>(wrap(step.col + between(rng_, 0, step.len - 1)));
+        } else if (roll < 8) {
+            s.kind = EnemyKind::Eye;
+            s.column = static_cast<uint8_t>(rng_below(rng_, kTowerColumns));
+            s.range = static_cast<uint16_t>(between(rng_, 3, 4));
+        } else {
+            s.kind = EnemyKind::Bouncer;
+            s.column = static_cast<uint8_t>(wrap(step.col + between(rng_, 0, step.len - 1)));
+            s.range = static_cast<uint16_t>(between(rng_, 3, 4));
+        }
+        level_.spawns.push_back(s);
+    }
+
+    const TowerGenConfig& config_;
+    uint32_t seed_;
+    uint32_t rng_;
+    float budget_ = 0.0f;
+    LevelData level_;
+};
+
+}  // namespace
+
+LevelData generate_tower(const TowerGenConfig& config, uint32_t seed) {
+    if (config.rows < kMinRows || config.rows > kMaxTowerRows) {
+        throw LevelError("tower generator: row count out of range");
+    }
+    return Builder(config, seed).build();
+}
+
+}  // namespace toppler
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+#include "tower/level.h"
+
+namespace toppler {
+
+// Procedural towers, e.g. for daily challenges. The same config and seed
+// always give the same tower, on any machine, so a challenge is published
+// as a seed and rebuilt wherever it is played or checked.
+//
+// A tower is a climb of flights: runs of short ledges stepping one row up
+// and a few columns sideways each, turning around the tower as they go.
+// Between flights there may be a lift ride. Steps can crumble, slide or
+// carry a spike at the end the route leaves from, and enemies are placed
+// along the route. Nothing here proves a tower can be climbed; screen
+// candidates with the planner (the tower_gen tool does, in parallel).
+
+struct TowerGenConfig {
+    int rows = 48;                // including the floor and the exit row
+    uint16_t time_limit = 90;     // seconds
+    // Chances in [0, 1]: per step for the tile kinds, per flight for a lift.
+    float crumble = 0.12f;
+    float slippery = 0.08f;
+    float spikes = 0.10f;
+    float lifts = 0.25f;
+    float enemies = 1.0f;         // spawns per 8 rows climbed
+};
+
+// Builds one tower; the result passes validate_level. Throws LevelError if
+// the config cannot describe a tower (too few or too many rows).
+LevelData generate_tower(const TowerGenConfig& config, uint32_t seed);
+
+}  // namespace toppler
@@ -0,0 +1,23 @@
+#include "tower/tower_grid.h"
+
+#include <stdexcept>
+
+namespace toppler {
+
+TowerGrid::TowerGrid(int rows, Tile fill) : rows_(rows) {
+    if (rows < 0 || rows > kMaxTowerRows) throw std::out_of_range("TowerGrid: bad row count");
+    tiles_.assign(static_cast<size_t>(rows) * kTowerColumns, fill);
+}
+
+void TowerGrid::set(int row, int col, Tile tile) {
+    if (static_cast<unsigned>(row) >= static_cast<unsigned>(rows_)) {
+        throw std::out_of_range("TowerGrid::set: row out of range");
+    }
+    tiles_[row * kTowerColumns + (col & kTowerColumnMask)] = tile;
+}
+
+void TowerGrid::fill_row(int row, int col, int count, Tile tile) {
+    for (int i = 0; i < count; ++i) set(row, col + i, tile);
+}
+
+}  // namespace toppler
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace toppler {
+
+// Angular resolution of every tower: one full turn is 16 brick columns.
+constexpr int kTowerColumns = 16;
+constexpr int kTowerColumnMask = kTowerColumns - 1;
+static_assert((kTowerColumns & kTowerColumnMask) == 0, "column count must be a power of two");
+
+// Tallest tower we accept. Keeps per-tower state (e.g. the crumble mask) bounded.
+constexpr int kMaxTowerRows = 512;
+
+// One byte per grid cell. Values are stored in level packs, so never reorder.
+enum class Tile : uint8_t {
+    Empty = 0,  // open air in front of the tower wall
+    Ledge,      // plain brick platform
+    Crumble,    // brick that falls away after it has been stood on
+    Slippery,   // ledge that keeps sliding the player
+    Wall,       // solid block, stops walking and supports from above
+    Door,       // tunnel mouth straight through the tower
+    Shaft,      // elevator shaft, only solid where an elevator car is
+    Spike,      // ledge that knocks the player off
+    Exit,       // goal door at the top of the tower
+    kCount
+};
+
+constexpr bool is_valid_tile(uint8_t code) { return code < static_cast<uint8_t>(Tile::kCount); }
+
+// Read-only view of a tower's tiles. Cheap to copy; this is what collision,
+// rendering and the AI take so the same code works on owned grids and on
+// tiles read straight out of a level pack.
+//
+// Layout: row r occupies tiles[r * kTowerColumns .. + kTowerColumns), so the
+// handful of rows around the player sit in one or two cache lines.
+struct TowerGridView {
+    const Tile* tiles = nullptr;
+    int rows = 0;
+
+    // Rows outside the tower read as Empty; columns wrap around the cylinder.
+    Tile at(int row, int col) const {
+        if (static_cast<unsigned>(row) >= static_cast<unsigned>(rows)) return Tile::Empty;
+        return tiles[row * kTowerColumns + (col & kTowerColumnMask)];
+    }
+
+    // Pointer to the kTowerColumns tiles of an in-range row.
+    const Tile* row_data(int row) const { return tiles + row * kTowerColumns; }
+
+    size_t size_bytes() const { return static_cast<size_t>(rows) * kTowerColumns; }
+};
+
+// Owning tower grid: a single contiguous allocation of rows * kTowerColumns
+// tile codes, sized once at construction.
+class TowerGrid {
+public:
+    TowerGrid() = default;
+    explicit TowerGrid(int rows, Tile fill = Tile::Empty);
+
+    int rows() const { return rows_; }
+    size_t size_bytes() const { return tiles_.size(); }
+
+    Tile at(int row, int col) const { return view().at(row, col); }
+    void set(int row, int col, Tile tile);
+
+    // Fills columns [col, col + count) of a row, wrapping around the tower.
+    void fill_row(int row, int col, int count, Tile tile);
+
+    Tile* row_data(int row) { return tiles_.data() + row * kTowerColumns; }
+    const Tile* row_data(int row) const { return tiles_.data() + row * kTowerColumns; }
+
+    TowerGridView view() const { return TowerGridView{tiles_.data(), rows_}; }
+
+private:
+    int rows_ = 0;
+    std::vector<Tile> tiles_;
+};
+
+}  // namespace toppler
@@ -0,0 +1,107 @@
+#include "tower/tower_streamer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+namespace toppler {
+
+// One background load, shared between the streamer and the loader job.
+struct TowerStreamer::Slot {
+    size_t index = 0;
+    std::atomic<bool> cancelled{false};
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    std::unique_ptr<ResidentTower> tower;
+    std::exception_ptr error;
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return done; });
+    }
+};
+
+TowerStreamer::TowerStreamer(const LevelPack& pack, BackgroundLoader& loader)
+    : pack_(pack), loader_(loader) {}
+
+TowerStreamer::~TowerStreamer() { cancel_pending(); }
+
+std::unique_ptr<ResidentTower> TowerStreamer::load(const LevelPack& pack, size_t index) {
+    pack.will_need(index);
+    auto tower = std::make_unique<ResidentTower>();
+    tower->index = index;
+    tower->name = std::string(pack.name(index));
+    tower->level = pack.tower(index);  // validation reads every tile, faulting the grid in
+    return tower;
+}
+
+void TowerStreamer::cancel_pending() {
+    if (!pending_) return;
+    pending_->cancelled.store(true, std::memory_order_relaxed);
+    pending_->wait();
+    pending_.reset();
+}
+
+void TowerStreamer::prefetch(size_t index) {
+    if (current_ && current_->index == index) return;
+    if (pending_ && pending_->index == index) return;
+    cancel_pending();
+
+    auto slot = std::make_shared<Slot>();
+    slot->index = index;
+    pending_ = slot;
+    const LevelPack* pack = &pack_;
+    loader_.submit([slot, pack] {
+        std::unique_ptr<ResidentTower> tower;
+        std::exception_ptr error;
+        if (!slot->cancelled.load(std::memory_order_relaxed)) {
+            try {
+                tower = load(*pack, slot->index);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        std::lock_guard<std::mutex> lock(slot->mutex);
+        slot->tower = std::move(tower);
+        slot->error = error;
+        slot->done = true;
+        slot->cv.notify_all();
+    });
+}
+
+bool TowerStreamer::ready(size_t index) const {
+    if (current_ && current_->index == index) return true;
+    if (!pending_ || pending_->index != index) return false;
+    std::lock_guard<std::mutex> lock(pending_->mutex);
+    return pending_->done;
+}
+
+const ResidentTower& TowerStreamer::enter(size_t index) {
+    if (current_ && current_->index == index) return *current_;
+
+    std::unique_ptr<ResidentTower> next;
+    if (pending_ && pending_->index == index) {
+        std::shared_ptr<Slot> slot = std::move(pending_);
+        bool was_done;
+        {
+            std::lock_guard<std::mutex> lock(slot->mutex);
+            was_done = slot->done;
+        }
+        if (!was_done) slot->wait();
+        ++(was_done ? stats_.prefetched : stats_.waited);
+        if (slot->error) std::rethrow_exception(slot->error);
+        next = std::move(slot->tower);
+    } else {
+        cancel_pending();
+        next = load(pack_, index);
+        ++stats_.inline_loads;
+    }
+
+    if (current_) pack_.dont_need(current_->index);
+    current_ = std::move(next);
+    return *current_;
+}
+
+}  // namespace toppler
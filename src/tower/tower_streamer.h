@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "core/background_loader.h"
+#include "tower/level_pack.h"
+
+namespace toppler {
+
+// A tower whose pack pages are resident and whose tiles have been checked,
+// so playing it never faults on storage.
+struct ResidentTower {
+    size_t index = 0;
+    std::string name;
+    Level level;  // points into the pack
+};
+
+// Keeps at most two towers of a mapped pack resident: the one being played
+// and the one after it. prefetch() pages the next tower in and validates it
+// on the loader thread while the current one is played; enter() then swaps
+// it in without touching storage, and drops the previous tower's pages so
+// memory stays flat however long the campaign is.
+class TowerStreamer {
+public:
+    // `pack` and `loader` must outlive the streamer.
+    TowerStreamer(const LevelPack& pack, BackgroundLoader& loader);
+    // Waits for an in-flight prefetch (it reads the pack).
+    ~TowerStreamer();
+
+    TowerStreamer(const TowerStreamer&) = delete;
+    TowerStreamer& operator=(const TowerStreamer&) = delete;
+
+    // Starts loading `index` in the background unless it is already current
+    // or pending. A newer request replaces a pending one that has not started.
+    void prefetch(size_t index);
+
+    // True once a prefetch of `index` has finished, i.e. enter(index) will
+    // not block. Lets the frame loop keep a transition running until then.
+    bool ready(size_t index) const;
+
+    // Makes `index` the current tower: takes the prefetched copy if there is
+    // one (waiting for it if still loading), otherwise loads inline. Throws
+    // LevelError if the tower is corrupt.
+    const ResidentTower& enter(size_t index);
+
+    const ResidentTower* current() const { return current_.get(); }
+
+    struct Stats {
+        uint32_t prefetched = 0;  // enters served by a finished prefetch
+        uint32_t waited = 0;      // enters that had to wait for one
+        uint32_t inline_loads = 0;
+    };
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Slot;
+
+    static std::unique_ptr<ResidentTower> load(const LevelPack& pack, size_t index);
+    void cancel_pending();
+
+    const LevelPack& pack_;
+    BackgroundLoader& loader_;
+    std::unique_ptr<ResidentTower> current_;
+    std::shared_ptr<Slot> pending_;
+    Stats stats_;
+};
+
+}  // namespace toppler
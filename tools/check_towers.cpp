@@ -0,0 +1,183 @@
+// Checks that towers can still be climbed within their time limit by planning
+// a route through each one with the headless planner.
+//
+//   check_towers [--threads N] [--beam W] [--seed S] [--replays DIR] TOWER...
+//
+// TOWER is a level pack (.ttpk), a text tower (.tower), or a directory
+// searched recursively for both. One line per tower comes out on stdout in
+// input order; with --replays, each route found is also written as a replay
+// that verify_replays accepts. Exits with 3 if any tower could not be
+// climbed.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ai/planner.h"
+#include "core/work_stealing_pool.h"
+#include "replay/replay.h"
+#include "sim/game_sim.h"
+#include "tower/level_pack.h"
+#include "tower/level_text.h"
+
+using namespace toppler;
+namespace fs = std::filesystem;
+
+namespace {
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: check_towers [--threads N] [--beam W] [--seed S] [--replays DIR] TOWER...\n"
+                 "       TOWER is a .ttpk pack, a .tower file, or a directory of them\n");
+    return 2;
+}
+
+struct Tower {
+    std::string name;
+    Level level;
+};
+
+// Owns whatever backs the towers' Level views.
+struct TowerSet {
+    std::vector<std::unique_ptr<LevelPack>> packs;
+    std::vector<std::unique_ptr<LevelData>> texts;
+    std::vector<Tower> towers;
+
+    void add_file(const std::string& path) {
+        if (fs::path(path).extension() == ".tower") {
+            texts.push_back(std::make_unique<LevelData>(load_level_text(path)));
+            towers.push_back(Tower{texts.back()->name, texts.back()->view()});
+            return;
+        }
+        packs.push_back(std::make_unique<LevelPack>(LevelPack::open(path)));
+        const LevelPack& pack = *packs.back();
+        for (size_t i = 0; i < pack.size(); ++i) towers.push_back(Tower{std::string(pack.name(i)), pack.tower(i)});
+    }
+
+    void add(const std::string& path) {
+        if (!fs::is_directory(path)) return add_file(path);
+        std::vector<std::string> found;
+        for (const auto& entry : fs::recursive_directory_iterator(path)) {
+            fs::path ext = entry.path().extension();
+            if (entry.is_regular_file() && (ext == ".tower" || ext == ".ttpk")) found.push_back(entry.path().string());
+        }
+        std::sort(found.begin(), found.end());
+        for (const std::string& f : found) add_file(f);
+    }
+};
+
+// Per-participant counters, one cache line each so workers never share.
+struct alignas(64) WorkerStats {
+    uint64_t towers = 0;
+    uint64_t failed = 0;
+    uint64_t ticks = 0;  // simulated while searching
+};
+
+std::string replay_path(const std::string& dir, size_t index, const std::string& name) {
+    std::string slug;
+    for (char c : name) {
+        bool keep = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+        slug += keep ? static_cast<char>(c | 0x20) : '_';
+    }
+    char prefix[16];
+    std::snprintf(prefix, sizeof prefix, "%04zu_", index);
+    return (fs::path(dir) / (prefix + slug + ".ttr")).string();
+}
+
+std::string check_one(const Tower& tower, size_t index, Planner& planner, const std::string& replay_dir,
+                      WorkerStats& stats) {
+    ++stats.towers;
+    char line[320];
+    PlanResult plan = planner.plan(tower.level);
+    stats.ticks += plan.stats.ticks;
+    if (!plan.solved) {
+        ++stats.failed;
+        std::snprintf(line, sizeof line, "FAIL  %-28s best row %d of %d  (%llu nodes)\n", tower.name.c_str(),
+                      plan.best_row, tower.level.grid.rows - 1, static_cast<unsigned long long>(plan.stats.expanded));
+        return line;
+    }
+    if (!replay_dir.empty()) {
+        ReplayRecorder recorder(tower.level, planner.config().seed);
+        SimState state;
+        sim_init(tower.level, planner.config().seed, state);
+        for (InputMask input : plan.inputs) {
+            sim_step(tower.level, state, input);
+            recorder.record(input, state);
+        }
+        write_replay(replay_path(replay_dir, index, tower.name), recorder.finish(state));
+    }
+    std::snprintf(line, sizeof line, "ok    %-28s %6.1fs of %us  score %u  (%llu nodes, %llu transpositions)\n",
+                  tower.name.c_str(), static_cast<double>(plan.ticks) / kTicksPerSecond, tower.level.time_limit,
+                  plan.score, static_cast<unsigned long long>(plan.stats.expanded),
+                  static_cast<unsigned long long>(plan.stats.transpositions));
+    return line;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> inputs;
+    std::string replay_dir;
+    unsigned threads = 0;
+    PlannerConfig config;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--beam") == 0 && i + 1 < argc) {
+            config.beam_width = std::max(1u, static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--replays") == 0 && i + 1 < argc) {
+            replay_dir = argv[++i];
+        } else if (argv[i][0] == '-') {
+            return usage();
+        } else {
+            inputs.emplace_back(argv[i]);
+        }
+    }
+    if (inputs.empty()) return usage();
+
+    TowerSet set;
+    try {
+        for (const std::string& p : inputs) set.add(p);
+        if (!replay_dir.empty()) fs::create_directories(replay_dir);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "check_towers: %s\n", e.what());
+        return 1;
+    }
+
+    WorkStealingPool pool(threads);
+    std::vector<WorkerStats> stats(pool.size());
+    std::vector<std::unique_ptr<Planner>> planners(pool.size());
+    std::vector<std::string> lines(set.towers.size());
+    auto start = std::chrono::steady_clock::now();
+    pool.for_each(set.towers.size(), [&](size_t i, unsigned worker) {
+        if (!planners[worker]) planners[worker] = std::make_unique<Planner>(config);
+        try {
+            lines[i] = check_one(set.towers[i], i, *planners[worker], replay_dir, stats[worker]);
+        } catch (const std::exception& e) {
+            ++stats[worker].failed;
+            lines[i] = "error " + set.towers[i].name + ": " + e.what() + "\n";
+        }
+    });
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (const std::string& l : lines) std::fwrite(l.data(), 1, l.size(), stdout);
+
+    WorkerStats total;
+    for (const WorkerStats& s : stats) {
+        total.towers += s.towers;
+        total.failed += s.failed;
+        total.ticks += s.ticks;
+    }
+    std::fprintf(stderr, "check_towers: %llu towers (%llu failed) in %.2f s on %u threads: %.0f towers/hour, %.2fM ticks/s\n",
+                 static_cast<unsigned long long>(total.towers), static_cast<unsigned long long>(total.failed), secs,
+                 pool.size(), secs > 0.0 ? static_cast<double>(total.towers) * 3600.0 / secs : 0.0,
+                 secs > 0.0 ? static_cast<double>(total.ticks) / secs / 1e6 : 0.0);
+    return total.failed ? 3 : 0;
+}
@@ -0,0 +1,116 @@
+// Renders a replay to raw video with the software rasterizer, faster than
+// real time and without a window.
+//
+//   replay_render --pack PACK [--pack PACK]... [--out FILE] [--every N]
+//                 [--scale S] [--threads T] REPLAY
+//
+// Writes YUV4MPEG2 to FILE, or to stdout (the default, or --out -) for
+// piping into an encoder:
+//
+//   replay_render --pack campaign.ttpk run.ttr | ffmpeg -i - -c:v libx264 run.mp4
+//
+// --every N renders every Nth tick (60 / N fps), --scale S draws at S times
+// 320x200, --threads T splits rasterizing each frame over T threads. A
+// summary of where the time went goes to stderr.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "render/replay_video.h"
+#include "replay/replay.h"
+#include "tower/level_pack.h"
+
+using namespace toppler;
+
+namespace {
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: replay_render --pack PACK [--pack PACK]... [--out FILE] [--every N] [--scale S] "
+                 "[--threads T] REPLAY\n");
+    return 2;
+}
+
+ScreenLayout scaled_screen(int scale) {
+    ScreenLayout s;
+    s.width *= scale;
+    s.height *= scale;
+    s.row_height *= scale;
+    s.tower.center_x *= scale;
+    s.tower.radius *= scale;
+    return s;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> pack_paths;
+    std::string replay_path, out_path = "-";
+    ReplayVideoOptions options;
+    int scale = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            pack_paths.emplace_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--every") == 0 && i + 1 < argc) {
+            options.frame_step = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.raster_threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            return usage();
+        } else if (replay_path.empty()) {
+            replay_path = argv[i];
+        } else {
+            return usage();
+        }
+    }
+    if (pack_paths.empty() || replay_path.empty() || options.frame_step == 0 || scale < 1 || scale > 8) {
+        return usage();
+    }
+    options.screen = scaled_screen(scale);
+
+    std::FILE* out = nullptr;
+    try {
+        Replay replay = read_replay(replay_path);
+        std::vector<std::unique_ptr<LevelPack>> packs;
+        const Level* level = nullptr;
+        Level found;
+        for (const std::string& p : pack_paths) {
+            packs.push_back(std::make_unique<LevelPack>(LevelPack::open(p)));
+            for (size_t i = 0; i < packs.back()->size() && !level; ++i) {
+                Level l = packs.back()->tower(i);
+                if (level_fingerprint(l) != replay.tower_id) continue;
+                found = l;
+                level = &found;
+                options.tower_number = static_cast<int>(i) + 1;
+            }
+        }
+        if (!level) throw ReplayError(replay_path + ": its tower is in none of the packs");
+
+        out = out_path == "-" ? stdout : std::fopen(out_path.c_str(), "wb");
+        if (!out) throw ReplayError("cannot create " + out_path);
+        ReplayVideoStats st = render_replay_video(*level, replay, out, options);
+        if (out != stdout) std::fclose(out);
+
+        double played = static_cast<double>(st.ticks) / kTicksPerSecond;
+        std::fprintf(stderr,
+                     "replay_render: %u frames (%.1f s of play, %dx%d) in %.2f s, %.1fx real time, %.1f MB; "
+                     "busy: sim %.2f s, raster %.2f s, encode %.2f s\n",
+                     st.frames, played, options.screen.width, options.screen.height, st.seconds,
+                     st.seconds > 0.0 ? played / st.seconds : 0.0, static_cast<double>(st.bytes) / 1e6,
+                     st.sim_seconds, st.raster_seconds, st.encode_seconds);
+    } catch (const std::exception& e) {
+        if (out && out != stdout) std::fclose(out);
+        std::fprintf(stderr, "replay_render: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Builds binary level packs from .tower sources, and lists existing packs.
+//
+//   toppler_pack -o campaign.ttpk levels/campaign/*.tower
+//   toppler_pack --list campaign.ttpk
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "tower/level_pack.h"
+#include "tower/level_text.h"
+
+using namespace toppler;
+
+namespace {
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: toppler_pack -o OUT.ttpk TOWER.tower...\n"
+                 "       toppler_pack --list PACK.ttpk...\n");
+    return 2;
+}
+
+int list(const std::vector<std::string>& paths) {
+    for (const std::string& path : paths) {
+        LevelPack pack = LevelPack::open(path);
+        std::printf("%s: %zu tower(s), %zu bytes\n", path.c_str(), pack.size(), pack.size_bytes());
+        for (size_t i = 0; i < pack.size(); ++i) {
+            Level t = pack.tower(i);
+            std::string name(pack.name(i));
+            std::printf("  %2zu  %-24s %3d rows  %2u lifts  %2u spawns  %4us\n", i, name.c_str(),
+                        t.grid.rows, t.elevator_count, t.spawn_count, t.time_limit);
+        }
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string out;
+    bool listing = false;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out = argv[++i];
+        } else if (std::strcmp(argv[i], "--list") == 0) {
+            listing = true;
+        } else if (argv[i][0] == '-') {
+            return usage();
+        } else {
+            inputs.emplace_back(argv[i]);
+        }
+    }
+    if (inputs.empty() || listing == !out.empty()) return usage();
+
+    try {
+        if (listing) return list(inputs);
+        std::vector<LevelData> towers;
+        for (const std::string& path : inputs) towers.push_back(load_level_text(path));
+        write_level_pack(out, towers);
+        // Read it back through the loader the game uses.
+        LevelPack pack = LevelPack::open(out);
+        for (size_t i = 0; i < pack.size(); ++i) pack.tower(i);
+        std::printf("wrote %s: %zu tower(s), %zu bytes\n", out.c_str(), pack.size(), pack.size_bytes());
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "toppler_pack: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,197 @@
+// Generates procedural towers and keeps the ones the planner can climb, e.g.
+// to build a pack of daily challenge towers.
+//
+//   tower_gen [--count N] [--keep K] [--seed S] [--rows R] [--time SECS]
+//             [--slack F] [--threads T] [--beam W] [--text DIR] -o OUT.ttpk
+//
+// Candidates are the towers of seeds S, S+1, ..., S+N-1. Each is generated
+// and planned on a work-stealing pool (one Planner per worker) and kept if
+// the planner climbs it with at least F of the time limit to spare (default
+// 0.25), so players get slack the planner did not need. The first K kept, in
+// seed order, go into the pack; candidates are screened in waves and
+// screening stops after the wave that fills the pack, so the output depends
+// on the arguments alone, never on the thread count. --text also writes each
+// kept tower as .tower source for review.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ai/planner.h"
+#include "core/work_stealing_pool.h"
+#include "tower/level_pack.h"
+#include "tower/level_text.h"
+#include "tower/tower_gen.h"
+
+using namespace toppler;
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: tower_gen [--count N] [--keep K] [--seed S] [--rows R] [--time SECS] [--slack F]\n"
+                 "                 [--threads T] [--beam W] [--text DIR] -o OUT.ttpk\n");
+    return 2;
+}
+
+double seconds_since(Clock::time_point t0) { return std::chrono::duration<double>(Clock::now() - t0).count(); }
+
+// Per-participant counters, one cache line each so workers never share.
+struct alignas(64) WorkerStats {
+    uint64_t candidates = 0;
+    uint64_t kept = 0;
+    uint64_t ticks = 0;  // simulated while planning
+    double generate_seconds = 0.0;
+    double plan_seconds = 0.0;
+};
+
+struct Candidate {
+    LevelData tower;
+    bool kept = false;
+    uint32_t ticks = 0;  // the planner's route, if kept
+};
+
+void screen(Candidate& c, uint32_t seed, const TowerGenConfig& gen, Planner& planner, WorkerStats& stats) {
+    ++stats.candidates;
+    auto t0 = Clock::now();
+    c.tower = generate_tower(gen, seed);
+    auto t1 = Clock::now();
+    PlanResult plan = planner.plan(c.tower.view());
+    stats.generate_seconds += std::chrono::duration<double>(t1 - t0).count();
+    stats.plan_seconds += seconds_since(t1);
+    stats.ticks += plan.stats.ticks;
+    c.kept = plan.solved;
+    c.ticks = plan.ticks;
+    if (c.kept) ++stats.kept;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string out_path, text_dir;
+    uint32_t count = 1000, keep = 30, seed = 1;
+    double slack = 0.25;
+    unsigned threads = 0;
+    TowerGenConfig gen;
+    PlannerConfig config;
+    for (int i = 1; i < argc; ++i) {
+        auto arg = [&](const char* flag) { return std::strcmp(argv[i], flag) == 0 && i + 1 < argc; };
+        if (arg("-o")) {
+            out_path = argv[++i];
+        } else if (arg("--count")) {
+            count = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg("--keep")) {
+            keep = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg("--seed")) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg("--rows")) {
+            gen.rows = std::atoi(argv[++i]);
+        } else if (arg("--time")) {
+            gen.time_limit = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg("--slack")) {
+            slack = std::atof(argv[++i]);
+        } else if (arg("--threads")) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg("--beam")) {
+            config.beam_width = std::max(1u, static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (arg("--text")) {
+            text_dir = argv[++i];
+        } else {
+            return usage();
+        }
+    }
+    if (out_path.empty() || count == 0 || keep == 0 || gen.time_limit == 0 || slack < 0.0 || slack >= 1.0) {
+        return usage();
+    }
+    // Routes slower than this are pruned inside the search, not afterwards.
+    config.max_ticks = std::max<uint32_t>(
+        1, static_cast<uint32_t>(gen.time_limit * kTicksPerSecond * (1.0 - slack)));
+
+    WorkStealingPool pool(threads);
+    std::vector<WorkerStats> stats(pool.size());
+    std::vector<std::unique_ptr<Planner>> planners(pool.size());
+    std::vector<Candidate> candidates(count);
+    std::vector<std::string> errors(count);
+    // A few candidates per participant per wave keeps stealing effective;
+    // the idle tail at each wave's end is one plan at most.
+    size_t wave = std::max<size_t>(64, size_t{pool.size()} * 16);
+    size_t screened = 0, kept = 0;
+    auto start = Clock::now();
+    while (screened < count && kept < keep) {
+        size_t n = std::min<size_t>(wave, count - screened);
+        pool.for_each(n, [&](size_t j, unsigned worker) {
+            size_t i = screened + j;
+            if (!planners[worker]) planners[worker] = std::make_unique<Planner>(config);
+            try {
+                screen(candidates[i], seed + static_cast<uint32_t>(i), gen, *planners[worker], stats[worker]);
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        });
+        for (size_t i = screened; i < screened + n; ++i) kept += candidates[i].kept;
+        screened += n;
+    }
+    double secs = seconds_since(start);
+
+    for (size_t i = 0; i < screened; ++i) {
+        if (!errors[i].empty()) {
+            std::fprintf(stderr, "tower_gen: seed %u: %s\n", seed + static_cast<uint32_t>(i), errors[i].c_str());
+            return 1;
+        }
+    }
+    std::vector<LevelData> towers;
+    for (size_t i = 0; i < screened && towers.size() < keep; ++i) {
+        Candidate& c = candidates[i];
+        if (!c.kept) continue;
+        std::printf("seed %-10u %-16s %3d rows  %2zu lifts  %3zu spawns  planned %6.1fs of %us\n",
+                    seed + static_cast<uint32_t>(i), c.tower.name.c_str(), c.tower.grid.rows(),
+                    c.tower.elevators.size(), c.tower.spawns.size(), static_cast<double>(c.ticks) / kTicksPerSecond,
+                    c.tower.time_limit);
+        towers.push_back(std::move(c.tower));
+    }
+    try {
+        write_level_pack(out_path, towers);
+        if (!text_dir.empty()) {
+            fs::create_directories(text_dir);
+            for (const LevelData& t : towers) {
+                std::ofstream out(fs::path(text_dir) / (t.name.substr(t.name.find(' ') + 1) + ".tower"));
+                out << format_level_text(t);
+                if (!out) throw LevelError("cannot write .tower files to " + text_dir);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "tower_gen: %s\n", e.what());
+        return 1;
+    }
+
+    WorkerStats total;
+    for (const WorkerStats& s : stats) {
+        total.candidates += s.candidates;
+        total.kept += s.kept;
+        total.ticks += s.ticks;
+        total.generate_seconds += s.generate_seconds;
+        total.plan_seconds += s.plan_seconds;
+    }
+    double per = total.candidates ? 1000.0 / static_cast<double>(total.candidates) : 0.0;
+    std::fprintf(stderr,
+                 "tower_gen: %llu candidates screened, %llu climbable, %zu written to %s in %.2f s on %u threads: "
+                 "%.0f candidates/min; generate %.3f ms, plan %.1f ms per candidate; %.2fM ticks/s\n",
+                 static_cast<unsigned long long>(total.candidates), static_cast<unsigned long long>(total.kept),
+                 towers.size(), out_path.c_str(), secs, pool.size(),
+                 secs > 0.0 ? static_cast<double>(total.candidates) * 60.0 / secs : 0.0,
+                 total.generate_seconds * per, total.plan_seconds * per,
+                 secs > 0.0 ? static_cast<double>(total.ticks) / secs / 1e6 : 0.0);
+    return towers.size() < keep ? 3 : 0;
+}
@@ -0,0 +1,163 @@
+// Headless dedicated server for head-to-head tower races.
+//
+//   tower_server --pack PACK [--port P] [--bind HOST] [--shards N]
+//                [--matches M] [--stats SECONDS] [--metrics PORT]
+//
+// Opens matches 1..M (default 4096): match m races on tower (m - 1) % towers
+// of the pack, from seed m. Players reach it by sending race packets for
+// that match to the port. Each desync the server catches is written to
+// stdout as one JSON line; a load summary goes to stderr every --stats
+// seconds (default 10). With --metrics, per-shard counters are served for
+// Prometheus at http://HOST:PORT/metrics. Runs until SIGINT or SIGTERM.
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/metrics.h"
+#include "net/metrics_server.h"
+#include "net/race_server.h"
+#include "tower/level_pack.h"
+
+using namespace toppler;
+
+namespace {
+
+std::atomic<bool> g_stop{false};
+
+void on_signal(int) { g_stop.store(true); }
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: tower_server --pack PACK [--port P] [--bind HOST] [--shards N] [--matches M] "
+                 "[--stats SECONDS] [--metrics PORT]\n");
+    return 2;
+}
+
+// One scrape: every shard's counters, labelled by shard, summed by nobody.
+std::string render_metrics(const RaceServer& server) {
+    std::vector<RaceServerStats> shards;
+    for (unsigned i = 0; i < server.shards(); ++i) shards.push_back(server.shard_stats(i));
+    auto label = [](unsigned i) { return "shard=\"" + std::to_string(i) + "\""; };
+    MetricsText m;
+    auto per_shard = [&](const char* name, const char* type, const char* help, auto value) {
+        m.family(name, type, help);
+        for (unsigned i = 0; i < shards.size(); ++i) m.sample(name, static_cast<double>(value(shards[i])), label(i));
+    };
+    per_shard("tower_server_packets_received_total", "counter", "Race packets received.",
+              [](const RaceServerStats& s) { return s.packets_in; });
+    per_shard("tower_server_packets_relayed_total", "counter", "Race packets relayed to the other player.",
+              [](const RaceServerStats& s) { return s.packets_relayed; });
+    per_shard("tower_server_packets_rejected_total", "counter", "Race packets dropped as malformed or unexpected.",
+              [](const RaceServerStats& s) { return s.packets_rejected; });
+    per_shard("tower_server_receive_batches_total", "counter", "recvmmsg calls that returned packets.",
+              [](const RaceServerStats& s) { return s.receive_batches; });
+    per_shard("tower_server_sim_ticks_total", "counter", "Ticks simulated checking players; rate() is ticks/s.",
+              [](const RaceServerStats& s) { return s.sim_ticks; });
+    per_shard("tower_server_desyncs_total", "counter", "Players caught out of sync with their own inputs.",
+              [](const RaceServerStats& s) { return s.desyncs; });
+    per_shard("tower_server_busy_seconds_total", "counter", "Shard thread CPU time spent handling events.",
+              [](const RaceServerStats& s) { return static_cast<double>(s.busy_ns) * 1e-9; });
+    per_shard("tower_server_matches", "gauge", "Matches open.",
+              [](const RaceServerStats& s) { return s.matches; });
+    per_shard("tower_server_active_matches", "gauge", "Matches with a player joined, as of the last second.",
+              [](const RaceServerStats& s) { return s.active_matches; });
+    m.family("tower_server_catchup_ticks", "histogram", "Ticks of new input simulated per packet.");
+    for (unsigned i = 0; i < shards.size(); ++i) {
+        m.histogram("tower_server_catchup_ticks", race_catchup_buckets(), shards[i].catchup, label(i));
+    }
+    m.family("tower_server_heap_bytes_in_use", "gauge", "Bytes the C heap allocator has handed out.");
+    m.sample("tower_server_heap_bytes_in_use", static_cast<double>(heap_bytes_in_use()));
+    return m.text();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string pack_path;
+    RaceServerConfig config;
+    unsigned matches = 4096;
+    unsigned stats_interval = 10;
+    long metrics_port = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            pack_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            config.port = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--bind") == 0 && i + 1 < argc) {
+            config.bind_host = argv[++i];
+        } else if (std::strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            config.shards = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+            matches = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            stats_interval = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metrics_port = std::strtol(argv[++i], nullptr, 10);
+        } else {
+            return usage();
+        }
+    }
+    if (pack_path.empty() || matches == 0 || matches > 65535 || metrics_port > 65535) return usage();
+
+    config.on_desync = [](const RaceDesync& d) {
+        std::printf("{\"match\":%u,\"player\":%u,\"desync_tick\":%u}\n", d.match, d.player, d.tick);
+        std::fflush(stdout);
+    };
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    try {
+        LevelPack pack = LevelPack::open(pack_path);
+        if (pack.size() == 0) throw std::runtime_error(pack_path + " has no towers");
+        RaceServer server(config);
+        for (unsigned m = 1; m <= matches; ++m) {
+            server.open_match(static_cast<uint16_t>(m), pack.tower((m - 1) % pack.size()), m);
+        }
+        std::fprintf(stderr, "tower_server: %u matches on port %u, %u shards\n", matches, server.port(),
+                     server.shards());
+        std::unique_ptr<MetricsServer> metrics;
+        if (metrics_port >= 0) {
+            metrics = std::make_unique<MetricsServer>(static_cast<uint16_t>(metrics_port), config.bind_host,
+                                                      [&server] { return render_metrics(server); });
+            std::fprintf(stderr, "tower_server: metrics on port %u\n", metrics->port());
+        }
+
+        using clock = std::chrono::steady_clock;
+        RaceServerStats last = server.stats();
+        auto last_time = clock::now();
+        while (!g_stop.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            auto now = clock::now();
+            double secs = std::chrono::duration<double>(now - last_time).count();
+            if (stats_interval == 0 || secs < stats_interval) continue;
+            RaceServerStats s = server.stats();
+            double in = static_cast<double>(s.packets_in - last.packets_in);
+            double batches = static_cast<double>(s.receive_batches - last.receive_batches);
+            std::fprintf(stderr,
+                         "tower_server: %llu matches, %.0f packets/s in, %.0f relayed/s, %.1f per batch, "
+                         "%llu rejected, %llu desyncs, %.1f%% of one core\n",
+                         static_cast<unsigned long long>(s.matches), in / secs,
+                         static_cast<double>(s.packets_relayed - last.packets_relayed) / secs,
+                         batches > 0 ? in / batches : 0.0, static_cast<unsigned long long>(s.packets_rejected),
+                         static_cast<unsigned long long>(s.desyncs),
+                         static_cast<double>(s.busy_ns - last.busy_ns) / (secs * 1e7));
+            last = s;
+            last_time = now;
+        }
+        metrics.reset();
+        server.stop();
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "tower_server: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,352 @@
+// Re-simulates submitted replays and writes one JSON verdict per line.
+//
+//   verify_replays --pack campaign.ttpk [--pack more.ttpk] [--threads N]
+//                  [--out verdicts.ndjson] [--metrics PORT] PATH...
+//
+// PATH is a replay file, a directory (searched recursively for *.ttr), or -
+// to read replay paths from stdin, one per line. Replays are verified in
+// batches across a work-stealing pool; verdicts come out in input order.
+// Runs of the submarine stage after each tower of the packs are verified
+// too; a stage depends only on the campaign position it follows, so they are
+// named "submarine stage <n>" whatever pack supplied the tower.
+// A throughput summary goes to stderr. With --metrics, per-worker counters
+// are served for Prometheus at http://HOST:PORT/metrics while the run lasts.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include "core/metrics.h"
+#include "core/work_stealing_pool.h"
+#include "net/metrics_server.h"
+#include "replay/replay.h"
+#include "replay/verify.h"
+#include "tower/level_pack.h"
+
+using namespace toppler;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kBatchSize = 4096;
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: verify_replays --pack PACK [--pack PACK]... [--threads N] [--out FILE] [--metrics PORT] "
+                 "PATH...\n"
+                 "       PATH is a .ttr file, a directory of them, or - for paths on stdin\n");
+    return 2;
+}
+
+// What a replay can have been recorded on: a tower, or the submarine stage
+// that follows one.
+struct Tower {
+    Level level;
+    std::string name;
+    bool sub_stage = false;
+    SubStage stage;
+};
+
+// Replay paths in argument order; directories expand sorted, stdin lazily.
+// A directory that cannot be read comes out as a path with an error, and is
+// reported like an unreadable file rather than ending the run.
+class PathSource {
+public:
+    explicit PathSource(std::vector<std::string> args) : args_(std::move(args)) {}
+
+    // `error` is empty, or why `path` could not be listed.
+    bool next(std::string& path, std::string& error) {
+        error.clear();
+        for (;;) {
+            if (pending_ < expanded_.size()) {
+                path = std::move(expanded_[pending_].path);
+                error = std::move(expanded_[pending_++].error);
+                return true;
+            }
+            if (reading_stdin_) {
+                while (std::getline(std::cin, path)) {
+                    if (!path.empty()) return true;
+                }
+                reading_stdin_ = false;
+            }
+            if (arg_ == args_.size()) return false;
+            const std::string& a = args_[arg_++];
+            expanded_.clear();
+            pending_ = 0;
+            std::error_code ec;
+            if (a == "-") {
+                reading_stdin_ = true;
+            } else if (fs::is_directory(a, ec)) {
+                expand(a);
+                std::sort(expanded_.begin(), expanded_.end(),
+                          [](const Entry& x, const Entry& y) { return x.path < y.path; });
+            } else {
+                expanded_.push_back(Entry{a, {}});
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        std::string path;
+        std::string error;
+    };
+
+    // Adds the .ttr files under `dir`, like recursive_directory_iterator
+    // (directory symlinks are not followed) but carrying on past a
+    // directory it cannot read.
+    void expand(const fs::path& dir) {
+        std::error_code ec;
+        std::vector<fs::path> subdirs;
+        fs::directory_iterator it(dir, ec);
+        for (; !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            std::error_code type_ec;
+            if (fs::is_directory(it->symlink_status(type_ec))) {
+                subdirs.push_back(it->path());
+            } else if (it->is_regular_file(type_ec) && it->path().extension() == ".ttr") {
+                expanded_.push_back(Entry{it->path().string(), {}});
+            }
+        }
+        if (ec) expanded_.push_back(Entry{dir.string(), dir.string() + ": " + ec.message()});
+        for (const fs::path& sub : subdirs) expand(sub);
+    }
+
+    std::vector<std::string> args_;
+    size_t arg_ = 0;
+    std::vector<Entry> expanded_;
+    size_t pending_ = 0;
+    bool reading_stdin_ = false;
+};
+
+void append_json_string(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (u < 0x20) {
+            char esc[8];
+            std::snprintf(esc, sizeof esc, "\\u%04x", u);
+            out += esc;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+const char* outcome_name(SimStatus s) {
+    switch (s) {
+        case SimStatus::Playing:
+            return "playing";
+        case SimStatus::Complete:
+            return "complete";
+        case SimStatus::GameOver:
+            return "game_over";
+    }
+    return "?";
+}
+
+// Wall time to read and verify one replay, in microseconds.
+const uint64_t kLatencyBounds[] = {100,    250,    500,     1000,    2500,    5000,    10000,
+                                   25000,  50000,  100000,  250000,  1000000, 10000000};
+const HistogramBuckets kLatencyBuckets{kLatencyBounds, sizeof kLatencyBounds / sizeof kLatencyBounds[0], 1e-6};
+
+// Per-participant counters, one cache line each so workers never share;
+// written by their worker only (bump()), read by metrics scrapes.
+struct alignas(64) WorkerStats {
+    std::atomic<uint64_t> replays{0};
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<uint64_t> failed{0};  // anything but "ok"
+    HistogramCells latency;
+};
+
+std::string render_metrics(const std::vector<WorkerStats>& stats, const WorkStealingPool& pool) {
+    auto label = [](size_t i) { return "worker=\"" + std::to_string(i) + "\""; };
+    MetricsText m;
+    auto per_worker = [&](const char* name, const char* help, std::atomic<uint64_t> WorkerStats::*field) {
+        m.family(name, "counter", help);
+        for (size_t i = 0; i < stats.size(); ++i) {
+            m.sample(name, static_cast<double>((stats[i].*field).load(std::memory_order_relaxed)), label(i));
+        }
+    };
+    per_worker("verify_replays_replays_total", "Replays verified.", &WorkerStats::replays);
+    per_worker("verify_replays_failed_total", "Replays with any verdict but ok.", &WorkerStats::failed);
+    per_worker("verify_replays_sim_ticks_total", "Ticks re-simulated; rate() is ticks/s.", &WorkerStats::ticks);
+    m.family("verify_replays_verify_seconds", "histogram", "Wall time to read and verify one replay.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+        HistogramTotals totals;
+        stats[i].latency.add_to(totals);
+        m.histogram("verify_replays_verify_seconds", kLatencyBuckets, totals, label(i));
+    }
+    m.family("verify_replays_steals_total", "counter", "Tasks taken from another worker's deque.");
+    m.sample("verify_replays_steals_total", static_cast<double>(pool.steals()));
+    m.family("verify_replays_heap_bytes_in_use", "gauge", "Bytes the C heap allocator has handed out.");
+    m.sample("verify_replays_heap_bytes_in_use", static_cast<double>(heap_bytes_in_use()));
+    return m.text();
+}
+
+std::string verify_one(const std::string& path, const std::string& list_error,
+                       const std::unordered_map<uint64_t, Tower>& towers, WorkerStats& stats) {
+    std::string line = "{\"replay\":";
+    append_json_string(line, path);
+    auto start = std::chrono::steady_clock::now();
+    bump(stats.replays);
+    try {
+        if (!list_error.empty()) throw std::runtime_error(list_error);
+        Replay replay = read_replay(path);
+        auto it = towers.find(replay.tower_id);
+        if (it == towers.end()) throw ReplayError("unknown tower");
+        const Tower& t = it->second;
+        Verdict v = t.sub_stage ? verify_replay(t.stage, replay) : verify_replay(t.level, replay);
+        bump(stats.ticks, v.ticks);
+        if (v.status != VerdictStatus::Ok) bump(stats.failed);
+
+        char buf[384];
+        double completion = v.completion_tick >= 0 ? static_cast<double>(v.completion_tick) / kTicksPerSecond : 0.0;
+        line += ",\"tower\":";
+        append_json_string(line, it->second.name);
+        std::snprintf(buf, sizeof buf,
+                      ",\"verdict\":\"%s\",\"score\":%u,\"claimed_score\":%u,\"outcome\":\"%s\",\"ticks\":%u",
+                      verdict_status_name(v.status), v.score, replay.result.score, outcome_name(v.outcome),
+                      v.ticks);
+        line += buf;
+        if (v.completion_tick >= 0) {
+            std::snprintf(buf, sizeof buf, ",\"completion_tick\":%lld,\"completion_time\":%.3f",
+                          static_cast<long long>(v.completion_tick), completion);
+        } else {
+            std::snprintf(buf, sizeof buf, ",\"completion_tick\":null,\"completion_time\":null");
+        }
+        line += buf;
+        if (v.desync_tick >= 0) {
+            std::snprintf(buf, sizeof buf, ",\"desync_tick\":%lld}", static_cast<long long>(v.desync_tick));
+        } else {
+            std::snprintf(buf, sizeof buf, ",\"desync_tick\":null}");
+        }
+        line += buf;
+    } catch (const std::exception& e) {
+        bump(stats.failed);
+        line += ",\"verdict\":\"error\",\"error\":";
+        append_json_string(line, e.what());
+        line += '}';
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    stats.latency.observe(kLatencyBuckets, static_cast<uint64_t>(elapsed.count()));
+    line += '\n';
+    return line;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> pack_paths, inputs;
+    std::string out_path;
+    unsigned threads = 0;
+    long metrics_port = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            pack_paths.emplace_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metrics_port = std::strtol(argv[++i], nullptr, 10);
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            return usage();
+        } else {
+            inputs.emplace_back(argv[i]);
+        }
+    }
+    if (pack_paths.empty() || inputs.empty() || metrics_port > 65535) return usage();
+
+    std::vector<std::unique_ptr<LevelPack>> packs;
+    std::unordered_map<uint64_t, Tower> towers;
+    try {
+        for (const std::string& p : pack_paths) {
+            packs.push_back(std::make_unique<LevelPack>(LevelPack::open(p)));
+            const LevelPack& pack = *packs.back();
+            for (size_t i = 0; i < pack.size(); ++i) {
+                Level level = pack.tower(i);
+                std::string name(pack.name(i));
+                towers.emplace(level_fingerprint(level), Tower{level, name, false, SubStage{}});
+                SubStage stage = sub_stage_after(static_cast<int>(i) + 1);
+                towers.emplace(sub_stage_fingerprint(stage),
+                               Tower{Level{}, "submarine stage " + std::to_string(stage.number), true, stage});
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "verify_replays: %s\n", e.what());
+        return 1;
+    }
+
+    std::FILE* out = stdout;
+    if (!out_path.empty() && !(out = std::fopen(out_path.c_str(), "w"))) {
+        std::fprintf(stderr, "verify_replays: cannot create %s\n", out_path.c_str());
+        return 1;
+    }
+
+    WorkStealingPool pool(threads);
+    std::vector<WorkerStats> stats(pool.size());
+    std::unique_ptr<MetricsServer> metrics;
+    if (metrics_port >= 0) {
+        try {
+            metrics = std::make_unique<MetricsServer>(static_cast<uint16_t>(metrics_port), nullptr,
+                                                      [&stats, &pool] { return render_metrics(stats, pool); });
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "verify_replays: %s\n", e.what());
+            return 1;
+        }
+        std::fprintf(stderr, "verify_replays: metrics on port %u\n", metrics->port());
+    }
+    PathSource source(inputs);
+    std::vector<std::string> batch, errors, lines;
+    auto start = std::chrono::steady_clock::now();
+    for (;;) {
+        batch.clear();
+        errors.clear();
+        std::string path, error;
+        while (batch.size() < kBatchSize && source.next(path, error)) {
+            batch.push_back(std::move(path));
+            errors.push_back(std::move(error));
+        }
+        if (batch.empty()) break;
+        lines.assign(batch.size(), std::string());
+        pool.for_each(batch.size(), [&](size_t i, unsigned worker) {
+            lines[i] = verify_one(batch[i], errors[i], towers, stats[worker]);
+        });
+        for (const std::string& l : lines) std::fwrite(l.data(), 1, l.size(), out);
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (out != stdout) std::fclose(out);
+    metrics.reset();
+
+    struct {
+        uint64_t replays = 0, ticks = 0, failed = 0;
+    } total;
+    for (const WorkerStats& s : stats) {
+        total.replays += s.replays.load(std::memory_order_relaxed);
+        total.ticks += s.ticks.load(std::memory_order_relaxed);
+        total.failed += s.failed.load(std::memory_order_relaxed);
+    }
+    double rate = secs > 0.0 ? static_cast<double>(total.replays) / secs : 0.0;
+    std::fprintf(stderr,
+                 "verify_replays: %llu replays (%llu failed) in %.3f s on %u threads: %.0f replays/s, "
+                 "%.0f replays/s/core, %.2fM ticks/s, %llu steals\n",
+                 static_cast<unsigned long long>(total.replays), static_cast<unsigned long long>(total.failed), secs,
+                 pool.size(), rate, rate / pool.size(), secs > 0.0 ? static_cast<double>(total.ticks) / secs / 1e6 : 0.0,
+                 static_cast<unsigned long long>(pool.steals()));
+    return total.failed ? 3 : 0;
+}